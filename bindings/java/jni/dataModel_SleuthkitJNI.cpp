@@ -23,6 +23,10 @@
 #include <string>
 #include <algorithm>
 #include <sstream>
+#include <climits>
+#include <list>
+#include <mutex>
+#include <tuple>
 
 using std::string;
 using std::vector;
@@ -41,9 +45,40 @@ typedef struct {
     uint32_t tag; 
     TSK_FS_FILE *fs_file; 
     TSK_FS_ATTR *fs_attr; 
+    struct TSK_JNI_FILE_ENTRY *entry;   // cache entry that owns fs_file
 } TSK_JNI_FILEHANDLE;
 #define TSK_JNI_FILEHANDLE_TAG 0x10101214
 
+/*
+* Files opened by openFileNat are kept in a cache so that opening the same
+* file and attribute again (which ingest modules do one after the other)
+* does not load the metadata and attributes again.  An entry is shared by
+* all of the open handles for it and files that no handle uses are kept
+* in LRU order until there are more than JNI_FILE_CACHE_IDLE_MAX of them.
+*/
+#define JNI_FILE_CACHE_IDLE_MAX 128
+
+// file system, metadata address, attribute type, attribute id
+typedef std::tuple<TSK_FS_INFO *, TSK_INUM_T, int, int> TSK_JNI_FILE_KEY;
+
+struct TSK_JNI_FILE_ENTRY {
+    TSK_JNI_FILE_KEY key;
+    TSK_FS_FILE *fs_file;
+    TSK_FS_ATTR *fs_attr;
+    int refCount;               // number of open handles
+    bool cached;                // false once removed from the cache (by closeFsNat)
+    std::list<TSK_JNI_FILE_ENTRY *>::iterator idlePos;  // place in idle if refCount is 0
+};
+
+static struct {
+    std::mutex lock;            // protects everything below
+    std::map<TSK_JNI_FILE_KEY, TSK_JNI_FILE_ENTRY *> files;
+    std::list<TSK_JNI_FILE_ENTRY *> idle;      // unused files, most recently used first
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} jniFileCache;
+
 //stack-allocated buffer size for read method
 #define FIXED_BUF_SIZE (16 * 1024)
 
@@ -1440,6 +1475,91 @@ JNIEXPORT jlong JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_openFsNat
 }
 
 
+/*
+ * Take a reference to a file in the cache.  jniFileCache.lock must be held.
+ * @param entry the file
+ */
+static void
+jniFileAcquire(TSK_JNI_FILE_ENTRY * entry)
+{
+    if (entry->refCount == 0)
+        jniFileCache.idle.erase(entry->idlePos);
+    entry->refCount++;
+}
+
+/*
+ * Close the files that are no longer needed.
+ * @param entries the files to close
+ */
+static void
+jniFileCloseEntries(const vector<TSK_JNI_FILE_ENTRY *> &entries)
+{
+    for (size_t i = 0; i < entries.size(); i++) {
+        tsk_fs_file_close(entries[i]->fs_file); //also closes the attribute
+        delete entries[i];
+    }
+}
+
+/*
+ * Release a reference to a file in the cache.  The file is kept open
+ * (and the least recently used unused files are closed if there are too
+ * many) unless it was removed from the cache.
+ * @param entry the file
+ */
+static void
+jniFileRelease(TSK_JNI_FILE_ENTRY * entry)
+{
+    vector<TSK_JNI_FILE_ENTRY *> toClose;
+
+    jniFileCache.lock.lock();
+    if (--entry->refCount == 0) {
+        if (entry->cached) {
+            jniFileCache.idle.push_front(entry);
+            entry->idlePos = jniFileCache.idle.begin();
+            while (jniFileCache.idle.size() > JNI_FILE_CACHE_IDLE_MAX) {
+                TSK_JNI_FILE_ENTRY *victim = jniFileCache.idle.back();
+                jniFileCache.idle.pop_back();
+                jniFileCache.files.erase(victim->key);
+                jniFileCache.evictions++;
+                toClose.push_back(victim);
+            }
+        }
+        else {
+            toClose.push_back(entry);
+        }
+    }
+    jniFileCache.lock.unlock();
+
+    jniFileCloseEntries(toClose);
+}
+
+/*
+ * Remove the files of a file system from the cache before it is closed.
+ * Files that still have open handles are closed with their last handle.
+ * @param fs_info the file system
+ */
+static void
+jniFileCachePurgeFs(TSK_FS_INFO * fs_info)
+{
+    vector<TSK_JNI_FILE_ENTRY *> toClose;
+
+    jniFileCache.lock.lock();
+    map<TSK_JNI_FILE_KEY, TSK_JNI_FILE_ENTRY *>::iterator it =
+        jniFileCache.files.lower_bound(TSK_JNI_FILE_KEY(fs_info, 0, INT_MIN, INT_MIN));
+    while ((it != jniFileCache.files.end()) && (std::get<0>(it->first) == fs_info)) {
+        TSK_JNI_FILE_ENTRY *entry = it->second;
+        entry->cached = false;
+        if (entry->refCount == 0) {
+            jniFileCache.idle.erase(entry->idlePos);
+            toClose.push_back(entry);
+        }
+        jniFileCache.files.erase(it++);
+    }
+    jniFileCache.lock.unlock();
+
+    jniFileCloseEntries(toClose);
+}
+
 /*
  * Open the file with the given id in the given file system
  * @return the created TSK_JNI_FILEHANDLE pointer, set throw exception on error
@@ -1460,36 +1580,79 @@ Java_org_sleuthkit_datamodel_SleuthkitJNI_openFileNat(JNIEnv * env,
         return 0;
     }
 
-    
-    TSK_FS_FILE *file_info;
-    //open file
-    file_info = tsk_fs_file_open_meta(fs_info, NULL, (TSK_INUM_T) file_id);
-    if (file_info == NULL) {
-        setThrowTskCoreError(env, tsk_error_get());
-        return 0;
+    TSK_JNI_FILE_KEY key(fs_info, (TSK_INUM_T) file_id, attr_type, attr_id);
+    TSK_JNI_FILE_ENTRY *entry = NULL;
+
+    // use the file if it is already open
+    jniFileCache.lock.lock();
+    map<TSK_JNI_FILE_KEY, TSK_JNI_FILE_ENTRY *>::iterator it =
+        jniFileCache.files.find(key);
+    if (it != jniFileCache.files.end()) {
+        entry = it->second;
+        jniFileAcquire(entry);
+        jniFileCache.hits++;
     }
+    else {
+        jniFileCache.misses++;
+    }
+    jniFileCache.lock.unlock();
 
-    //open attribute
-    const TSK_FS_ATTR * tsk_fs_attr = 
-        tsk_fs_file_attr_get_type(file_info, (TSK_FS_ATTR_TYPE_ENUM)attr_type, (uint16_t)attr_id, 1);
-    if (tsk_fs_attr == NULL) {
-        tsk_fs_file_close(file_info);
-        setThrowTskCoreError(env, tsk_error_get());
-        return 0;
+    if (entry == NULL) {
+        TSK_FS_FILE *file_info;
+        //open file
+        file_info = tsk_fs_file_open_meta(fs_info, NULL, (TSK_INUM_T) file_id);
+        if (file_info == NULL) {
+            setThrowTskCoreError(env, tsk_error_get());
+            return 0;
+        }
+
+        //open attribute
+        const TSK_FS_ATTR * tsk_fs_attr = 
+            tsk_fs_file_attr_get_type(file_info, (TSK_FS_ATTR_TYPE_ENUM)attr_type, (uint16_t)attr_id, 1);
+        if (tsk_fs_attr == NULL) {
+            tsk_fs_file_close(file_info);
+            setThrowTskCoreError(env, tsk_error_get());
+            return 0;
+        }
+
+        entry = new TSK_JNI_FILE_ENTRY;
+        entry->key = key;
+        entry->fs_file = file_info;
+        entry->fs_attr = const_cast<TSK_FS_ATTR*>(tsk_fs_attr);
+        entry->refCount = 1;
+        entry->cached = true;
+
+        // another thread could have opened the same file in the meantime
+        TSK_JNI_FILE_ENTRY *dup = NULL;
+        jniFileCache.lock.lock();
+        std::pair<map<TSK_JNI_FILE_KEY, TSK_JNI_FILE_ENTRY *>::iterator, bool> ins =
+            jniFileCache.files.insert(std::make_pair(key, entry));
+        if (ins.second == false) {
+            dup = entry;
+            entry = ins.first->second;
+            jniFileAcquire(entry);
+        }
+        jniFileCache.lock.unlock();
+
+        if (dup) {
+            tsk_fs_file_close(dup->fs_file);
+            delete dup;
+        }
     }
 
     //allocate file handle structure to encapsulate file and attribute
     TSK_JNI_FILEHANDLE * fileHandle = 
         (TSK_JNI_FILEHANDLE *) tsk_malloc(sizeof(TSK_JNI_FILEHANDLE));
     if (fileHandle == NULL) {
-        tsk_fs_file_close(file_info);
+        jniFileRelease(entry);
         setThrowTskCoreError(env, "Could not allocate memory for TSK_JNI_FILEHANDLE");
         return 0;
     }
 
     fileHandle->tag = TSK_JNI_FILEHANDLE_TAG;
-    fileHandle->fs_file = file_info;
-    fileHandle->fs_attr = const_cast<TSK_FS_ATTR*>(tsk_fs_attr);
+    fileHandle->fs_file = entry->fs_file;
+    fileHandle->fs_attr = entry->fs_attr;
+    fileHandle->entry = entry;
 
     return (jlong)fileHandle;
 }
@@ -1796,6 +1959,31 @@ typedef enum {
     TSK_FS_FILE_READ_OFFSET_TYPE_START_OF_SLACK = 0x01,
 } TSK_FS_FILE_READ_OFFSET_TYPE_ENUM;
 
+/**
+ * Read bytes from the attribute of a file handle
+ * @param file_handle the file handle to read from
+ * @param offset the offset in bytes to start at
+ * @param offset_type whether offset is from the start of the file or of the slack space (TSK_FS_FILE_READ_OFFSET_TYPE_ENUM)
+ * @param buf buffer to read into
+ * @param len number of bytes to read
+ * @returns number of bytes read or -1 on error
+ */
+static ssize_t
+readFileHandle(const TSK_JNI_FILEHANDLE * file_handle, jlong offset,
+    jint offset_type, char *buf, size_t len)
+{
+    TSK_FS_ATTR * tsk_fs_attr = file_handle->fs_attr;
+
+    TSK_FS_FILE_READ_FLAG_ENUM readFlag = TSK_FS_FILE_READ_FLAG_NONE;
+    TSK_OFF_T readOffset = (TSK_OFF_T) offset;
+    if(offset_type == TSK_FS_FILE_READ_OFFSET_TYPE_START_OF_SLACK){
+        readFlag = TSK_FS_FILE_READ_FLAG_SLACK;
+        readOffset += tsk_fs_attr->nrd.initsize;
+    }
+
+    return tsk_fs_attr_read(tsk_fs_attr, readOffset, buf, len, readFlag);
+}
+
 /*
  * Read bytes from the given file
  * @return number of bytes read, or -1 on error
@@ -1833,18 +2021,9 @@ Java_org_sleuthkit_datamodel_SleuthkitJNI_readFileNat(JNIEnv * env,
         return -1;
     }
 
-    TSK_FS_ATTR * tsk_fs_attr = file_handle->fs_attr;
-
-    TSK_FS_FILE_READ_FLAG_ENUM readFlag = TSK_FS_FILE_READ_FLAG_NONE;
-    TSK_OFF_T readOffset = (TSK_OFF_T) offset;
-    if(offset_type == TSK_FS_FILE_READ_OFFSET_TYPE_START_OF_SLACK){
-        readFlag = TSK_FS_FILE_READ_FLAG_SLACK;
-        readOffset += tsk_fs_attr->nrd.initsize;
-    }
-
     //read attribute
-    ssize_t bytesread = tsk_fs_attr_read(tsk_fs_attr,  readOffset, buf, (size_t) len,
-        readFlag);
+    ssize_t bytesread = readFileHandle(file_handle, offset, offset_type, buf,
+        (size_t) len);
     if (bytesread == -1) {
         if (dynBuf) {
             free(buf);
@@ -1871,6 +2050,223 @@ Java_org_sleuthkit_datamodel_SleuthkitJNI_readFileNat(JNIEnv * env,
 }
 
 
+/**
+ * Get the memory of a direct ByteBuffer to read into.
+ * @param env pointer to java environment
+ * @param jbuf the direct ByteBuffer
+ * @param buf_offset offset in the buffer where the data will go
+ * @param len number of bytes that will be read
+ * @returns pointer to buf_offset in the buffer or NULL on error (and throws exception)
+ */
+static char *
+getDirectBuf(JNIEnv * env, jobject jbuf, jint buf_offset, jlong len)
+{
+    char *buf = (char *) env->GetDirectBufferAddress(jbuf);
+    if (buf == NULL) {
+        setThrowTskCoreError(env, "Read buffer is not a direct ByteBuffer");
+        return NULL;
+    }
+
+    jlong capacity = env->GetDirectBufferCapacity(jbuf);
+    if ((buf_offset < 0) || (len < 0) || (buf_offset > capacity)
+        || (len > capacity - buf_offset)) {
+        setThrowTskCoreError(env, "Read is past the end of the ByteBuffer");
+        return NULL;
+    }
+    return buf + buf_offset;
+}
+
+/*
+ * Read bytes from the given image into a direct ByteBuffer
+ * @return number of bytes read from the image, -1 on error
+ * @param env pointer to java environment this was called from
+ * @param obj the java object this was called from
+ * @param a_img_info the pointer to the image object
+ * @param jbuf direct ByteBuffer to read to
+ * @param buf_offset offset in jbuf to read to
+ * @param offset the offset in bytes to start at
+ * @param len number of bytes to read
+ */
+JNIEXPORT jint JNICALL
+Java_org_sleuthkit_datamodel_SleuthkitJNI_readImgDirectNat(JNIEnv * env,
+    jclass obj, jlong a_img_info, jobject jbuf, jint buf_offset,
+    jlong offset, jlong len)
+{
+    TSK_IMG_INFO *img_info = castImgInfo(env, a_img_info);
+    if (img_info == 0) {
+        //exception already set
+        return -1;
+    }
+
+    char *buf = getDirectBuf(env, jbuf, buf_offset, len);
+    if (buf == NULL) {
+        //exception already set
+        return -1;
+    }
+
+    ssize_t bytesread =
+        tsk_img_read(img_info, (TSK_OFF_T) offset, buf, (size_t) len);
+    if (bytesread == -1) {
+        setThrowTskCoreError(env, tsk_error_get());
+        return -1;
+    }
+    return (jint) bytesread;
+}
+
+/*
+ * Read bytes from the given file system into a direct ByteBuffer
+ * @return number of bytes read from the file system, -1 on error
+ * @param env pointer to java environment this was called from
+ * @param obj the java object this was called from
+ * @param a_fs_info the pointer to the file system object
+ * @param jbuf direct ByteBuffer to read to
+ * @param buf_offset offset in jbuf to read to
+ * @param offset the offset in bytes to start at
+ * @param len number of bytes to read
+ */
+JNIEXPORT jint JNICALL
+Java_org_sleuthkit_datamodel_SleuthkitJNI_readFsDirectNat(JNIEnv * env,
+    jclass obj, jlong a_fs_info, jobject jbuf, jint buf_offset,
+    jlong offset, jlong len)
+{
+    TSK_FS_INFO *fs_info = castFsInfo(env, a_fs_info);
+    if (fs_info == 0) {
+        //exception already set
+        return -1;
+    }
+
+    char *buf = getDirectBuf(env, jbuf, buf_offset, len);
+    if (buf == NULL) {
+        //exception already set
+        return -1;
+    }
+
+    ssize_t bytesread =
+        tsk_fs_read(fs_info, (TSK_OFF_T) offset, buf, (size_t) len);
+    if (bytesread == -1) {
+        setThrowTskCoreError(env, tsk_error_get());
+        return -1;
+    }
+    return (jint) bytesread;
+}
+
+/*
+ * Read bytes from the given file into a direct ByteBuffer
+ * @return number of bytes read, or -1 on error
+ * @param env pointer to java environment this was called from
+ * @param obj the java object this was called from
+ * @param a_file_handle the pointer to the TSK_JNI_FILEHANDLE object
+ * @param jbuf direct ByteBuffer to read to
+ * @param buf_offset offset in jbuf to read to
+ * @param offset the offset in bytes to start at
+ * @param offset_type whether offset is from the start of the file or of the slack space
+ * @param len number of bytes to read
+ */
+JNIEXPORT jint JNICALL
+Java_org_sleuthkit_datamodel_SleuthkitJNI_readFileDirectNat(JNIEnv * env,
+    jclass obj, jlong a_file_handle, jobject jbuf, jint buf_offset,
+    jlong offset, jint offset_type, jlong len)
+{
+    const TSK_JNI_FILEHANDLE *file_handle = castJniFileHandle(env, a_file_handle);
+    if (file_handle == 0) {
+        //exception already set
+        return -1;
+    }
+
+    char *buf = getDirectBuf(env, jbuf, buf_offset, len);
+    if (buf == NULL) {
+        //exception already set
+        return -1;
+    }
+
+    ssize_t bytesread = readFileHandle(file_handle, offset, offset_type, buf,
+        (size_t) len);
+    if (bytesread == -1) {
+        setThrowTskCoreError(env, tsk_error_get());
+        return -1;
+    }
+    return (jint) bytesread;
+}
+
+/*
+ * Read several ranges of the given file into a direct ByteBuffer.  The
+ * data of each range goes right after the space for the previous range
+ * (which is as long as the length that was asked for).
+ * @return total number of bytes read, or -1 on error
+ * @param env pointer to java environment this was called from
+ * @param obj the java object this was called from
+ * @param a_file_handle the pointer to the TSK_JNI_FILEHANDLE object
+ * @param jbuf direct ByteBuffer to read to
+ * @param buf_offset offset in jbuf of the first range
+ * @param offsets the offset in bytes of each range
+ * @param lengths number of bytes to read for each range
+ * @param bytes_read set to the number of bytes read for each range
+ * @param offset_type whether the offsets are from the start of the file or of the slack space
+ */
+JNIEXPORT jint JNICALL
+Java_org_sleuthkit_datamodel_SleuthkitJNI_readFileRangesNat(JNIEnv * env,
+    jclass obj, jlong a_file_handle, jobject jbuf, jint buf_offset,
+    jlongArray offsets, jintArray lengths, jintArray bytes_read,
+    jint offset_type)
+{
+    const TSK_JNI_FILEHANDLE *file_handle = castJniFileHandle(env, a_file_handle);
+    if (file_handle == 0) {
+        //exception already set
+        return -1;
+    }
+
+    jsize count = env->GetArrayLength(offsets);
+    if ((env->GetArrayLength(lengths) != count)
+        || (env->GetArrayLength(bytes_read) != count)) {
+        setThrowTskCoreError(env, "Range arrays have different lengths");
+        return -1;
+    }
+
+    std::vector<jlong> rangeOffsets(count);
+    std::vector<jint> rangeLengths(count);
+    std::vector<jint> rangeRead(count);
+    if (count > 0) {
+        env->GetLongArrayRegion(offsets, 0, count, &rangeOffsets[0]);
+        env->GetIntArrayRegion(lengths, 0, count, &rangeLengths[0]);
+    }
+
+    // check the whole request before reading anything
+    jlong total = 0;
+    for (jsize i = 0; i < count; i++) {
+        if (rangeLengths[i] < 0) {
+            setThrowTskCoreError(env, "Negative range length");
+            return -1;
+        }
+        total += rangeLengths[i];
+    }
+    char *buf = getDirectBuf(env, jbuf, buf_offset, total);
+    if (buf == NULL) {
+        //exception already set
+        return -1;
+    }
+
+    jlong totalread = 0;
+    for (jsize i = 0; i < count; i++) {
+        ssize_t bytesread = 0;
+        if (rangeLengths[i] > 0) {
+            bytesread = readFileHandle(file_handle, rangeOffsets[i],
+                offset_type, buf, (size_t) rangeLengths[i]);
+            if (bytesread == -1) {
+                setThrowTskCoreError(env, tsk_error_get());
+                return -1;
+            }
+        }
+        rangeRead[i] = (jint) bytesread;
+        totalread += bytesread;
+        buf += rangeLengths[i];
+    }
+
+    if (count > 0)
+        env->SetIntArrayRegion(bytes_read, 0, count, &rangeRead[0]);
+    return (jint) totalread;
+}
+
+
 /**
  * Runs istat on a given file and saves the output to a temp file.
  *
@@ -1960,6 +2356,7 @@ JNIEXPORT void JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_closeFsNat
         //exception already set
         return;
     }
+    jniFileCachePurgeFs(fs_info);
     tsk_fs_close(fs_info);
 }
 
@@ -1979,15 +2376,45 @@ Java_org_sleuthkit_datamodel_SleuthkitJNI_closeFileNat(JNIEnv * env,
         return;
     }
     
-    TSK_FS_FILE * file_info = file_handle->fs_file;
-    tsk_fs_file_close(file_info); //also closes the attribute
+    jniFileRelease(file_handle->entry);
 
+    file_handle->entry = NULL;
     file_handle->fs_file = NULL;
     file_handle->fs_attr = NULL;
     file_handle->tag = 0;
     free (file_handle);
 }
 
+/*
+ * Get the statistics of the cache of files opened by openFileNat
+ * @return array with the number of hits, misses and evictions and the
+ * number of files in the cache and how many of those are not in use
+ * @param env pointer to java environment this was called from
+ * @param obj the java object this was called from
+ */
+JNIEXPORT jlongArray JNICALL
+Java_org_sleuthkit_datamodel_SleuthkitJNI_getFileHandleCacheStatsNat(JNIEnv * env,
+    jclass obj)
+{
+    jlong stats[5];
+
+    jniFileCache.lock.lock();
+    stats[0] = (jlong) jniFileCache.hits;
+    stats[1] = (jlong) jniFileCache.misses;
+    stats[2] = (jlong) jniFileCache.evictions;
+    stats[3] = (jlong) jniFileCache.files.size();
+    stats[4] = (jlong) jniFileCache.idle.size();
+    jniFileCache.lock.unlock();
+
+    jlongArray jstats = env->NewLongArray(5);
+    if (jstats == NULL) {
+        setThrowTskCoreError(env, "NewLongArray returned error while getting the cache statistics.");
+        return NULL;
+    }
+    env->SetLongArrayRegion(jstats, 0, 5, stats);
+    return jstats;
+}
+
 /*
  * Get the current Sleuthkit version number
  * @return the version string
@@ -343,6 +343,38 @@ JNIEXPORT jint JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_readFsNat
 JNIEXPORT jint JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_readFileNat
   (JNIEnv *, jclass, jlong, jbyteArray, jlong, jint, jlong);
 
+/*
+ * Class:     org_sleuthkit_datamodel_SleuthkitJNI
+ * Method:    readImgDirectNat
+ * Signature: (JLjava/nio/ByteBuffer;IJJ)I
+ */
+JNIEXPORT jint JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_readImgDirectNat
+  (JNIEnv *, jclass, jlong, jobject, jint, jlong, jlong);
+
+/*
+ * Class:     org_sleuthkit_datamodel_SleuthkitJNI
+ * Method:    readFsDirectNat
+ * Signature: (JLjava/nio/ByteBuffer;IJJ)I
+ */
+JNIEXPORT jint JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_readFsDirectNat
+  (JNIEnv *, jclass, jlong, jobject, jint, jlong, jlong);
+
+/*
+ * Class:     org_sleuthkit_datamodel_SleuthkitJNI
+ * Method:    readFileDirectNat
+ * Signature: (JLjava/nio/ByteBuffer;IJIJ)I
+ */
+JNIEXPORT jint JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_readFileDirectNat
+  (JNIEnv *, jclass, jlong, jobject, jint, jlong, jint, jlong);
+
+/*
+ * Class:     org_sleuthkit_datamodel_SleuthkitJNI
+ * Method:    readFileRangesNat
+ * Signature: (JLjava/nio/ByteBuffer;I[J[I[II)I
+ */
+JNIEXPORT jint JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_readFileRangesNat
+  (JNIEnv *, jclass, jlong, jobject, jint, jlongArray, jintArray, jintArray, jint);
+
 /*
  * Class:     org_sleuthkit_datamodel_SleuthkitJNI
  * Method:    saveFileMetaDataTextNat
@@ -383,6 +415,14 @@ JNIEXPORT void JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_closeFsNat
 JNIEXPORT void JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_closeFileNat
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     org_sleuthkit_datamodel_SleuthkitJNI
+ * Method:    getFileHandleCacheStatsNat
+ * Signature: ()[J
+ */
+JNIEXPORT jlongArray JNICALL Java_org_sleuthkit_datamodel_SleuthkitJNI_getFileHandleCacheStatsNat
+  (JNIEnv *, jclass);
+
 /*
  * Class:     org_sleuthkit_datamodel_SleuthkitJNI
  * Method:    findDeviceSizeNat
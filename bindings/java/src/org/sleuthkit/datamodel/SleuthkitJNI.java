@@ -21,6 +21,7 @@
 import java.io.BufferedReader;
 import java.io.FileReader;
 import java.io.IOException;
+import java.nio.ByteBuffer;
 import java.text.DateFormat;
 import java.text.SimpleDateFormat;
 import java.util.ArrayList;
@@ -943,6 +944,165 @@ public static int readFileSlack(long fileHandle, byte[] readBuffer, long offset,
 		}
 	}
 
+	/**
+	 * Check that a buffer can be given to the direct read methods.
+	 *
+	 * @param readBuffer buffer to read to
+	 *
+	 * @throws TskCoreException if the buffer is not a direct buffer
+	 */
+	private static void checkDirectBuffer(ByteBuffer readBuffer) throws TskCoreException {
+		if (!readBuffer.isDirect()) {
+			throw new TskCoreException("Read buffer is not a direct ByteBuffer");
+		}
+		if (readBuffer.isReadOnly()) {
+			throw new TskCoreException("Read buffer is read-only");
+		}
+	}
+
+	/**
+	 * reads data from an image straight into a direct buffer, without copying
+	 * it through a Java array. The data is put at the position of the buffer,
+	 * which is then moved past it.
+	 *
+	 * @param imgHandle
+	 * @param readBuffer direct buffer to read to
+	 * @param offset     byte offset in the image to start at
+	 * @param len        amount of data to read (at most the remaining space in
+	 *                   the buffer is used)
+	 *
+	 * @return the number of bytes read
+	 *
+	 * @throws TskCoreException exception thrown if critical error occurs within
+	 *                          TSK
+	 */
+	public static int readImg(long imgHandle, ByteBuffer readBuffer, long offset, long len) throws TskCoreException {
+		checkDirectBuffer(readBuffer);
+		getTSKReadLock();
+		try {
+			if (!imgHandleIsValid(imgHandle)) {
+				throw new TskCoreException("Image handle " + imgHandle + " is closed");
+			}
+			int bytesRead = readImgDirectNat(imgHandle, readBuffer, readBuffer.position(), offset, Math.min(len, readBuffer.remaining()));
+			readBuffer.position(readBuffer.position() + bytesRead);
+			return bytesRead;
+		} finally {
+			releaseTSKReadLock();
+		}
+	}
+
+	/**
+	 * reads data from a file system straight into a direct buffer, without
+	 * copying it through a Java array. The data is put at the position of the
+	 * buffer, which is then moved past it.
+	 *
+	 * @param fsHandle   pointer to a file system structure in the sleuthkit
+	 * @param readBuffer direct buffer to read to
+	 * @param offset     byte offset in the image to start at
+	 * @param len        amount of data to read (at most the remaining space in
+	 *                   the buffer is used)
+	 *
+	 * @return the number of bytes read
+	 *
+	 * @throws TskCoreException exception thrown if critical error occurs within
+	 *                          TSK
+	 */
+	public static int readFs(long fsHandle, ByteBuffer readBuffer, long offset, long len) throws TskCoreException {
+		checkDirectBuffer(readBuffer);
+		getTSKReadLock();
+		try {
+			int bytesRead = readFsDirectNat(fsHandle, readBuffer, readBuffer.position(), offset, Math.min(len, readBuffer.remaining()));
+			readBuffer.position(readBuffer.position() + bytesRead);
+			return bytesRead;
+		} finally {
+			releaseTSKReadLock();
+		}
+	}
+
+	/**
+	 * reads data from a file straight into a direct buffer, without copying it
+	 * through a Java array. The data is put at the position of the buffer,
+	 * which is then moved past it.
+	 *
+	 * @param fileHandle pointer to a file structure in the sleuthkit
+	 * @param readBuffer direct buffer to read to
+	 * @param offset     byte offset in the file to start at
+	 * @param len        amount of data to read (at most the remaining space in
+	 *                   the buffer is used)
+	 *
+	 * @return the number of bytes read
+	 *
+	 * @throws TskCoreException exception thrown if critical error occurs within
+	 *                          TSK
+	 */
+	public static int readFile(long fileHandle, ByteBuffer readBuffer, long offset, long len) throws TskCoreException {
+		checkDirectBuffer(readBuffer);
+		getTSKReadLock();
+		try {
+			if (!HandleCache.isValidFileHandle(fileHandle)) {
+				throw new TskCoreException(HandleCache.INVALID_FILE_HANDLE);
+			}
+
+			int bytesRead = readFileDirectNat(fileHandle, readBuffer, readBuffer.position(), offset,
+					TSK_FS_FILE_READ_OFFSET_TYPE_ENUM.START_OF_FILE.getValue(), Math.min(len, readBuffer.remaining()));
+			readBuffer.position(readBuffer.position() + bytesRead);
+			return bytesRead;
+		} finally {
+			releaseTSKReadLock();
+		}
+	}
+
+	/**
+	 * reads several ranges of a file into a direct buffer with one call into
+	 * the native library. Range i is read to the position of the buffer plus
+	 * the sum of the lengths of the ranges before it, and the position is then
+	 * moved past the space of all of the ranges. A range that ends past the
+	 * end of the file is read up to the end of the file.
+	 *
+	 * @param fileHandle pointer to a file structure in the sleuthkit
+	 * @param readBuffer direct buffer to read to
+	 * @param offsets    byte offset in the file of each range
+	 * @param lengths    amount of data to read for each range
+	 *
+	 * @return the number of bytes read for each range
+	 *
+	 * @throws TskCoreException exception thrown if critical error occurs within
+	 *                          TSK, if a range has a negative offset or
+	 *                          length or if the ranges do not fit in the
+	 *                          buffer
+	 */
+	public static int[] readFileRanges(long fileHandle, ByteBuffer readBuffer, long[] offsets, int[] lengths) throws TskCoreException {
+		checkDirectBuffer(readBuffer);
+		if (offsets.length != lengths.length) {
+			throw new TskCoreException("Range offsets and lengths have different sizes");
+		}
+		long total = 0;
+		for (int i = 0; i < lengths.length; i++) {
+			if (offsets[i] < 0 || lengths[i] < 0) {
+				throw new TskCoreException("Range " + i + " has a negative offset or length");
+			}
+			total += lengths[i];
+		}
+		if (total > readBuffer.remaining()) {
+			throw new TskCoreException("Ranges do not fit in the read buffer");
+		}
+
+		int[] bytesRead = new int[offsets.length];
+		getTSKReadLock();
+		try {
+			if (!HandleCache.isValidFileHandle(fileHandle)) {
+				throw new TskCoreException(HandleCache.INVALID_FILE_HANDLE);
+			}
+
+			readFileRangesNat(fileHandle, readBuffer, readBuffer.position(), offsets, lengths, bytesRead,
+					TSK_FS_FILE_READ_OFFSET_TYPE_ENUM.START_OF_FILE.getValue());
+			readBuffer.position(readBuffer.position() + (int) total);
+			return bytesRead;
+		} finally {
+			releaseTSKReadLock();
+		}
+	}
+
 	/**
 	 * Get human readable (some what) details about a file. This is the same as
 	 * the 'istat' TSK tool
@@ -1007,6 +1167,74 @@ public static void closeFile(long fileHandle) {
 		}
 	}
 
+	/**
+	 * Statistics of the native cache that keeps the files opened with
+	 * openFile() loaded so that opening the same file again is cheap.
+	 */
+	public static final class FileHandleCacheStats {
+
+		private final long hits;
+		private final long misses;
+		private final long evictions;
+		private final long cachedFiles;
+		private final long idleFiles;
+
+		private FileHandleCacheStats(long[] stats) {
+			this.hits = stats[0];
+			this.misses = stats[1];
+			this.evictions = stats[2];
+			this.cachedFiles = stats[3];
+			this.idleFiles = stats[4];
+		}
+
+		/**
+		 * @return number of opens that used a file that was already loaded
+		 */
+		public long getHits() {
+			return hits;
+		}
+
+		/**
+		 * @return number of opens that had to load the file
+		 */
+		public long getMisses() {
+			return misses;
+		}
+
+		/**
+		 * @return number of unused files that were closed to keep the cache
+		 *         bounded
+		 */
+		public long getEvictions() {
+			return evictions;
+		}
+
+		/**
+		 * @return number of files in the cache
+		 */
+		public long getCachedFiles() {
+			return cachedFiles;
+		}
+
+		/**
+		 * @return number of files in the cache that have no open handles
+		 */
+		public long getIdleFiles() {
+			return idleFiles;
+		}
+	}
+
+	/**
+	 * Get the statistics of the native cache of open files.
+	 *
+	 * @return the statistics
+	 *
+	 * @throws TskCoreException if a critical error occurs within TSK core
+	 */
+	public static FileHandleCacheStats getFileHandleCacheStats() throws TskCoreException {
+		return new FileHandleCacheStats(getFileHandleCacheStatsNat());
+	}
+
 	/**
 	 * Create an index for a hash database.
 	 *
@@ -1445,6 +1673,14 @@ public static void closeFs(long fsHandle) {
 
 	private static native int readFileNat(long fileHandle, byte[] readBuffer, long offset, int offset_type, long len) throws TskCoreException;
 
+	private static native int readImgDirectNat(long imgHandle, ByteBuffer readBuffer, int bufOffset, long offset, long len) throws TskCoreException;
+
+	private static native int readFsDirectNat(long fsHandle, ByteBuffer readBuffer, int bufOffset, long offset, long len) throws TskCoreException;
+
+	private static native int readFileDirectNat(long fileHandle, ByteBuffer readBuffer, int bufOffset, long offset, int offset_type, long len) throws TskCoreException;
+
+	private static native int readFileRangesNat(long fileHandle, ByteBuffer readBuffer, int bufOffset, long[] offsets, int[] lengths, int[] bytesRead, int offset_type) throws TskCoreException;
+
 	private static native int saveFileMetaDataTextNat(long fileHandle, String fileName) throws TskCoreException;
 
 	private static native void closeImgNat(long imgHandle);
@@ -1455,6 +1691,8 @@ public static void closeFs(long fsHandle) {
 
 	private static native void closeFileNat(long fileHandle);
 
+	private static native long[] getFileHandleCacheStatsNat() throws TskCoreException;
+
 	private static native long findDeviceSizeNat(String devicePath) throws TskCoreException;
 
 	private static native String getCurDirNat(long process);
@@ -49,6 +49,7 @@
 // C/C++ library includes
 #include <string>
 #include <cstring>
+#include <new>
 #include <sstream>
 #include <math.h>
 #include <assert.h>
@@ -67,14 +68,37 @@
 // Placing these functions in an anonymous namespace to give them static-linkage is one way to 
 // accomplish this.
 //
-// CAVEAT: Static data can be incompatible with multithreading, since each
-// thread will get its own copy of the data.
+// CAVEAT: Static data is shared by all of the instances of the module,
+// including those in the pipelines of different threads (see isThreadSafe()),
+// so it has to be protected if it can change.
 namespace
 {
     const char *MODULE_NAME = "tskEntropyModule";
     const char *MODULE_DESCRIPTION = "Performs an entropy calculation for the contents of a given file";
     const char *MODULE_VERSION = "1.0.0";
 
+    /**
+    * Calculates entropy from the number of times each byte value occurs.
+    *
+    * @param byteCounts Number of occurrences of each byte value.
+    * @param totalBytes Total number of bytes.
+    * @return The entropy.
+    */
+    double entropyFromCounts(const long byteCounts[256], long totalBytes)
+    {
+        double entropy = 0.0;
+        for (int i = 0; i<256; ++i)
+        {
+            double p = static_cast<double>(byteCounts[i]) / static_cast<double>(totalBytes);
+            if (p > 0.0)
+            {
+                entropy -= p * (log(p) / log(2.0));
+            }
+        }
+
+        return entropy;
+    }
+
     /**
     * Calculates the entropy of a file.
     *
@@ -108,18 +132,15 @@ namespace
         } 
         while (bytesRead > 0);
 
-        double entropy = 0.0;
-        for (int i = 0; i<256; ++i)
-        {
-            double p = static_cast<double>(byteCounts[i]) / static_cast<double>(totalBytes);
-            if (p > 0.0)
-            {
-                entropy -= p * (log(p) / log(2.0));
-            }
-        }
-
-        return entropy;
+        return entropyFromCounts(byteCounts, totalBytes);
     }
+
+    // Byte counts of the file being streamed to a module instance.
+    struct StreamContext
+    {
+        long byteCounts[256];
+        long totalBytes;
+    };
 }
 
 extern "C" 
@@ -169,6 +190,23 @@ extern "C"
         return MODULE_VERSION;
     }
 
+    /**
+    * Module thread safety function. The entropy of a file is calculated 
+    * from local data and the stream context, so files can be analyzed by 
+    * several threads at the same time.
+    *
+    * CAVEAT: This function is intended to be called by TSK Framework only. 
+    * Linux/OS-X modules should *not* call this function within the module 
+    * unless appropriate compiler/linker options are used to bind all 
+    * library-internal symbols at link time. 
+    *
+    * @return true
+    */
+    TSK_MODULE_EXPORT bool isThreadSafe()
+    {
+        return true;
+    }
+
     /**
     * Module initialization function. Receives a string of initialization arguments, 
     * typically read by the caller from a pipeline configuration file. 
@@ -316,6 +354,119 @@ extern "C"
         }
     }
 
+    /**
+    * Stream consumer function for file analysis modules. Called instead of 
+    * run() when the pipeline reads the content of a file once and streams 
+    * it to several modules. Prepares the module for the content of a file.
+    *
+    * CAVEAT: This function is intended to be called by TSK Framework only. 
+    *
+    * @param pFile A pointer to the file whose content will be streamed.
+    * @param context [in,out] State of the module instance for the stream. 
+    * Allocated here if it is NULL.
+    * @returns TskModule::OK to receive the content, TskModule::STOP if no 
+    * content is needed, or TskModule::FAIL on error.
+    */
+    TskModule::Status TSK_MODULE_EXPORT beginStream(TskFile *pFile, void **context)
+    {
+        if (*context == NULL)
+        {
+            *context = new (std::nothrow) StreamContext;
+            if (*context == NULL)
+            {
+                LOGERROR(std::string(MODULE_NAME) + "::beginStream : failed to allocate stream context");
+                return TskModule::FAIL;
+            }
+        }
+
+        StreamContext *streamContext = static_cast<StreamContext*>(*context);
+        memset(streamContext->byteCounts, 0, sizeof(long) * 256);
+        streamContext->totalBytes = 0;
+        return TskModule::OK;
+    }
+
+    /**
+    * Stream consumer function for file analysis modules. Receives each 
+    * consecutive chunk of the content of the file. 
+    *
+    * CAVEAT: This function is intended to be called by TSK Framework only. 
+    *
+    * @param pFile A pointer to the file being streamed.
+    * @param buffer File content.
+    * @param length Number of bytes in buffer.
+    * @param context State of the module instance for the stream.
+    * @returns TskModule::OK to receive more content, TskModule::STOP if 
+    * no more content is needed, or TskModule::FAIL on error.
+    */
+    TskModule::Status TSK_MODULE_EXPORT consumeStream(TskFile *pFile, const char *buffer, size_t length, void *context)
+    {
+        StreamContext *streamContext = static_cast<StreamContext*>(context);
+        for (size_t i = 0; i < length; ++i)
+        {
+            streamContext->byteCounts[static_cast<uint8_t>(buffer[i])]++;
+        }
+        streamContext->totalBytes += static_cast<long>(length);
+        return TskModule::OK;
+    }
+
+    /**
+    * Stream consumer function for file analysis modules. Called after the 
+    * content of the file has been streamed; does the work that run() would
+    * otherwise do. 
+    *
+    * CAVEAT: This function is intended to be called by TSK Framework only. 
+    *
+    * @param pFile A pointer to the file that was streamed.
+    * @param context State of the module instance for the stream.
+    * @returns TskModule::OK on success, TskModule::FAIL on error, or 
+    * TskModule::STOP.
+    */
+    TskModule::Status TSK_MODULE_EXPORT endStream(TskFile *pFile, void *context)
+    {
+        StreamContext *streamContext = static_cast<StreamContext*>(context);
+        std::ostringstream msgPrefix;
+        msgPrefix << MODULE_NAME << "::endStream : ";
+
+        try
+        {
+            double entropy = entropyFromCounts(streamContext->byteCounts, streamContext->totalBytes);
+            pFile->addGenInfoAttribute(TskBlackboardAttribute(TSK_ENTROPY, MODULE_NAME, "", entropy));
+            return TskModule::OK;
+        }
+        catch (TskException &ex)
+        {
+            std::ostringstream msg;
+            msg << msgPrefix.str() << "TskException: " << ex.message();
+            LOGERROR(msg.str());
+            return TskModule::FAIL;
+        }
+        catch (std::exception &ex)
+        {
+            std::ostringstream msg;
+            msg << msgPrefix.str() << "std::exception: " << ex.what();
+            LOGERROR(msg.str());
+            return TskModule::FAIL;
+        }
+        catch (...)
+        {
+            LOGERROR(msgPrefix.str() + "unrecognized exception");
+            return TskModule::FAIL;
+        }
+    }
+
+    /**
+    * Stream consumer function for file analysis modules. Frees the state 
+    * allocated by beginStream() when the module instance is destroyed.
+    *
+    * CAVEAT: This function is intended to be called by TSK Framework only. 
+    *
+    * @param context State of the module instance for the stream.
+    */
+    void TSK_MODULE_EXPORT freeStreamContext(void *context)
+    {
+        delete static_cast<StreamContext*>(context);
+    }
+
     //  /**
     //   * Module execution function for post-processing modules. 
     //   *
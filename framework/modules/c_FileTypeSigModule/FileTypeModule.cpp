@@ -19,6 +19,7 @@
 #include <sstream>
 #include <stdlib.h>
 #include <string.h>
+#include <new>
 
 // Framework includes
 #include "tsk/framework/utilities/TskModuleDev.h"
@@ -27,6 +28,7 @@
 #include "Poco/UnicodeConverter.h"
 #include "Poco/File.h"
 #include "Poco/Path.h"
+#include "Poco/Mutex.h"
 
 // Magic includes
 #include "magic.h"
@@ -39,7 +41,106 @@ namespace
 
   static const uint32_t FILE_BUFFER_SIZE = 1024;
 
+  // The magic handle is shared by all of the instances of the module (one
+  // per pipeline), so it is opened by the first call to initialize(), 
+  // closed by the last call to finalize() and used under the lock since
+  // libmagic handles are not thread safe.
   static magic_t magicHandle = NULL;
+  static int magicRefCount = 0;
+  static Poco::FastMutex magicLock;
+
+  // Start of the content of the file being streamed to a module instance.
+  struct StreamContext
+  {
+      char buffer[FILE_BUFFER_SIZE];
+      size_t len;
+      bool active;
+  };
+
+  /**
+   * Opens a magic handle and loads the magic database.
+   * @returns The handle, or NULL on error.
+   */
+  magic_t openMagic()
+  {
+      magic_t handle = magic_open(MAGIC_NONE);
+      if (handle == NULL) {
+          LOGERROR("FileTypeSigModule: Error allocating magic cookie.");
+          return NULL;
+      }
+
+//Attempt to load magic database from default places on Linux.
+//Don't bother trying magic_load() for defaults on win32 because it will always cause an exception instead of gracefully returning.
+#ifndef TSK_WIN32
+      /* Load the default magic database, which is found in this order:
+             1. MAGIC env variable
+             2. $HOME/.magic.mgc (or $HOME/.magic dir)
+             3. /usr/share/misc/magic.mgc (or /usr/share/misc/magic dir) (unless libmagic was build configured abnormally)
+      */
+      if (magic_load(handle, NULL)) {
+          std::stringstream msg;
+          msg << "FileTypeSigModule: Error loading default magic file: " << magic_error(handle);
+          LOGERROR(msg.str());
+          //don't return, just fall through to the default loading below
+      } else {
+          return handle;
+      }
+#endif
+      //Load the magic database file in the repo
+      std::string path = GetSystemProperty(TskSystemProperties::MODULE_CONFIG_DIR) + Poco::Path::separator() + MODULE_NAME + Poco::Path::separator() + "magic.mgc";
+
+      Poco::File magicFile = Poco::File(path);
+      if (magicFile.exists() == false) {
+          std::stringstream msg;
+          msg << "FileTypeSigModule: Magic file not found: " << path;
+          LOGERROR(msg.str());
+          magic_close(handle);
+          return NULL;
+      }
+
+      if (magic_load(handle, path.c_str())) {
+          std::stringstream msg;
+          msg << "FileTypeSigModule: Error loading magic file: " << magic_error(handle) << GetSystemProperty(TskSystemProperties::MODULE_CONFIG_DIR);
+          LOGERROR(msg.str());
+          magic_close(handle);
+          return NULL;
+      }
+
+      return handle;
+  }
+
+  /**
+   * Determines the type of a file from the start of its content and
+   * posts it to the blackboard.
+   * @param pFile File being analyzed.
+   * @param buffer Start of the file content.
+   * @param len Number of bytes in buffer.
+   * @returns TskModule::OK on success and TskModule::FAIL on error.
+   */
+  TskModule::Status addFileType(TskFile * pFile, const char * buffer, size_t len)
+  {
+      // clean up type -- we've seen invalid UTF-8 data being returned
+      char cleanType[1024];
+      cleanType[1023] = '\0';
+      {
+          // the type is only valid until the next call on the handle
+          Poco::FastMutex::ScopedLock lock(magicLock);
+          const char *type = magic_buffer(magicHandle, buffer, len);
+          if (type == NULL) {
+              std::stringstream msg;
+              msg << "FileTypeSigModule: Error getting file type: " << magic_error(magicHandle);
+              LOGERROR(msg.str());
+              return TskModule::FAIL;
+          }
+          strncpy(cleanType, type, 1023);
+      }
+      TskUtilities::cleanUTF8(cleanType);
+
+      // Add to blackboard
+      TskBlackboardAttribute attr(TSK_FILE_TYPE_SIG, MODULE_NAME, "", cleanType);
+      pFile->addGenInfoAttribute(attr);
+      return TskModule::OK;
+  }
 }
 
 extern "C" 
@@ -74,6 +175,18 @@ extern "C"
         return MODULE_VERSION;
     }
 
+    /**
+     * Module thread safety function. The magic handle is shared by the 
+     * instances of the module and used under a lock, so files can be 
+     * analyzed by several threads at the same time.
+     *
+     * @return true
+     */
+    TSK_MODULE_EXPORT bool isThreadSafe()
+    {
+        return true;
+    }
+
     /**
      * Module initialization function. Takes a string as input that allows
      * arguments to be passed into the module.
@@ -81,46 +194,16 @@ extern "C"
      */
     TskModule::Status TSK_MODULE_EXPORT initialize(const char* arguments)
     {
-        magicHandle = magic_open(MAGIC_NONE);
-        if (magicHandle == NULL) {
-            LOGERROR("FileTypeSigModule: Error allocating magic cookie.");
-            return TskModule::FAIL;
-        }
+        Poco::FastMutex::ScopedLock lock(magicLock);
 
-//Attempt to load magic database from default places on Linux.
-//Don't bother trying magic_load() for defaults on win32 because it will always cause an exception instead of gracefully returning.
-#ifndef TSK_WIN32
-        /* Load the default magic database, which is found in this order:
-               1. MAGIC env variable
-               2. $HOME/.magic.mgc (or $HOME/.magic dir)
-               3. /usr/share/misc/magic.mgc (or /usr/share/misc/magic dir) (unless libmagic was build configured abnormally)
-        */
-        if (magic_load(magicHandle, NULL)) {
-            std::stringstream msg;
-            msg << "FileTypeSigModule: Error loading default magic file: " << magic_error(magicHandle);
-            LOGERROR(msg.str());
-            //don't return, just fall through to the default loading below
-        } else {
+        // finalize() is called for each instance, even if this fails
+        magicRefCount++;
+        if (magicHandle != NULL)
             return TskModule::OK;
-        }
-#endif
-        //Load the magic database file in the repo
-        std::string path = GetSystemProperty(TskSystemProperties::MODULE_CONFIG_DIR) + Poco::Path::separator() + MODULE_NAME + Poco::Path::separator() + "magic.mgc";
 
-        Poco::File magicFile = Poco::File(path);
-        if (magicFile.exists() == false) {
-            std::stringstream msg;
-            msg << "FileTypeSigModule: Magic file not found: " << path;
-            LOGERROR(msg.str());
+        magicHandle = openMagic();
+        if (magicHandle == NULL)
             return TskModule::FAIL;
-        }
-
-        if (magic_load(magicHandle, path.c_str())) {
-            std::stringstream msg;
-            msg << "FileTypeSigModule: Error loading magic file: " << magic_error(magicHandle) << GetSystemProperty(TskSystemProperties::MODULE_CONFIG_DIR);
-            LOGERROR(msg.str());
-            return TskModule::FAIL;
-        }
 
         return TskModule::OK;
     }
@@ -157,23 +240,107 @@ extern "C"
                 return TskModule::FAIL;
             }
 
-            const char *type = magic_buffer(magicHandle, buffer, readLen);
-            if (type == NULL) {
-                std::stringstream msg;
-                msg << "FileTypeSigModule: Error getting file type: " << magic_error(magicHandle);
-                LOGERROR(msg.str());
+            if (addFileType(pFile, buffer, readLen) != TskModule::OK)
+                return TskModule::FAIL;
+        }
+        catch (TskException& tskEx)
+        {
+            std::stringstream msg;
+            msg << "FileTypeModule: Caught framework exception: " << tskEx.message();
+            LOGERROR(msg.str());
+            return TskModule::FAIL;
+        }
+        catch (std::exception& ex)
+        {
+            std::stringstream msg;
+            msg << "FileTypeModule: Caught exception: " << ex.what();
+            LOGERROR(msg.str());
+            return TskModule::FAIL;
+        }
+
+        return TskModule::OK;
+    }
+
+    /**
+     * Called instead of run() when the pipeline streams the content of 
+     * a file to the module. 
+     * @param pFile A pointer to the file whose content will be streamed.
+     * @param context [in,out] State of the module instance for the stream.
+     * Allocated here if it is NULL.
+     * @returns TskModule::OK if content is wanted, TskModule::STOP if not, 
+     * or TskModule::FAIL on error.
+     */
+    TskModule::Status TSK_MODULE_EXPORT beginStream(TskFile * pFile, void ** context)
+    {
+        if (*context == NULL) {
+            *context = new (std::nothrow) StreamContext;
+            if (*context == NULL) {
+                LOGERROR("FileTypeSigModule: Error allocating stream context.");
                 return TskModule::FAIL;
             }
+        }
 
-            // clean up type -- we've seen invalid UTF-8 data being returned
-            char cleanType[1024];
-            cleanType[1023] = '\0';
-            strncpy(cleanType, type, 1023);
-            TskUtilities::cleanUTF8(cleanType);
+        StreamContext *streamContext = static_cast<StreamContext *>(*context);
+        streamContext->len = 0;
+        streamContext->active = false;
 
-            // Add to blackboard
-            TskBlackboardAttribute attr(TSK_FILE_TYPE_SIG, MODULE_NAME, "", cleanType);
-            pFile->addGenInfoAttribute(attr);
+        if (pFile == NULL)
+        {
+            LOGERROR("FileTypeSigModule: Passed NULL file pointer.");
+            return TskModule::FAIL;
+        }
+
+        if (pFile->getSize() == 0)
+            return TskModule::STOP;
+
+        streamContext->active = true;
+        return TskModule::OK;
+    }
+
+    /**
+     * Receives the next chunk of file content. Only the start of the file
+     * is needed, so this stops the stream once it has been seen.
+     * @param pFile A pointer to the file being streamed.
+     * @param buffer File content.
+     * @param length Number of bytes in buffer.
+     * @param context State of the module instance for the stream.
+     * @returns TskModule::OK if more content is wanted, else TskModule::STOP.
+     */
+    TskModule::Status TSK_MODULE_EXPORT consumeStream(TskFile * pFile, const char * buffer, size_t length, void * context)
+    {
+        StreamContext *streamContext = static_cast<StreamContext *>(context);
+        size_t copyLen = FILE_BUFFER_SIZE - streamContext->len;
+        if (copyLen > length)
+            copyLen = length;
+        memcpy(streamContext->buffer + streamContext->len, buffer, copyLen);
+        streamContext->len += copyLen;
+
+        return (streamContext->len < FILE_BUFFER_SIZE) ? TskModule::OK : TskModule::STOP;
+    }
+
+    /**
+     * Determines the type of the streamed file.
+     * @param pFile A pointer to the file that was streamed.
+     * @param context State of the module instance for the stream.
+     * @returns TskModule::OK on success and TskModule::FAIL on error.
+     */
+    TskModule::Status TSK_MODULE_EXPORT endStream(TskFile * pFile, void * context)
+    {
+        StreamContext *streamContext = static_cast<StreamContext *>(context);
+        if (!streamContext->active)
+            return TskModule::OK;
+        streamContext->active = false;
+
+        if (streamContext->len == 0) {
+            std::stringstream msg;
+            msg << "FileTypeSigModule: Error reading file contents for file " << pFile->getId();
+            LOGERROR(msg.str());
+            return TskModule::FAIL;
+        }
+
+        try
+        {
+            return addFileType(pFile, streamContext->buffer, streamContext->len);
         }
         catch (TskException& tskEx)
         {
@@ -189,14 +356,35 @@ extern "C"
             LOGERROR(msg.str());
             return TskModule::FAIL;
         }
+    }
 
-        return TskModule::OK;
+    /**
+     * Drops the content of a stream that ended without endStream().
+     * @param pFile A pointer to the file that was being streamed.
+     * @param context State of the module instance for the stream.
+     */
+    void TSK_MODULE_EXPORT abortStream(TskFile * pFile, void * context)
+    {
+        if (context != NULL)
+            static_cast<StreamContext *>(context)->active = false;
+    }
+
+    /**
+     * Frees the stream state of a module instance.
+     * @param context State of the module instance for the stream.
+     */
+    void TSK_MODULE_EXPORT freeStreamContext(void * context)
+    {
+        delete static_cast<StreamContext *>(context);
     }
 
     TskModule::Status TSK_MODULE_EXPORT finalize()
     {
-        if (magicHandle != NULL) {
+        Poco::FastMutex::ScopedLock lock(magicLock);
+
+        if (magicRefCount > 0 && --magicRefCount == 0 && magicHandle != NULL) {
             magic_close(magicHandle);
+            magicHandle = NULL;
         }
         return TskModule::OK;
     }
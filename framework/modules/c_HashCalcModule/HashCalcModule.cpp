@@ -16,6 +16,7 @@
 #include <string>
 #include <sstream>
 #include <string.h>
+#include <new>
 
 // Framework includes
 #include "tsk/framework/utilities/TskModuleDev.h"
@@ -24,11 +25,54 @@
 static const std::string MD5_NAME("MD5");
 static const std::string SHA1_NAME("SHA1");
 
+// The hashes to calculate are shared by all of the instances of the module
+// (one per pipeline).  They are only set by initialize(), which is called
+// with the same arguments for each pipeline before files are analyzed.
 static bool calculateMD5 = true;
 static bool calculateSHA1 = false;
 
 static const char hexMap[] = "0123456789abcdef";
 
+// State of the hashes of the file being streamed to a module instance.
+struct StreamContext
+{
+    bool active;
+    TSK_MD5_CTX md5Ctx;
+    TSK_SHA_CTX sha1Ctx;
+};
+
+/**
+ * Post the final values of the hashes to the file.
+ */
+static void setHashes(TskFile * pFile, TSK_MD5_CTX * md5Ctx, TSK_SHA_CTX * sha1Ctx)
+{
+    if (calculateMD5) {
+        unsigned char md5Hash[16];
+        TSK_MD5_Final(md5Hash, md5Ctx);
+
+        char md5TextBuff[33];            
+        for (int i = 0; i < 16; i++) {
+            md5TextBuff[2 * i] = hexMap[(md5Hash[i] >> 4) & 0xf];
+            md5TextBuff[2 * i + 1] = hexMap[md5Hash[i] & 0xf];
+        }
+        md5TextBuff[32] = '\0';
+        pFile->setHash(TskImgDB::MD5, md5TextBuff);
+    }
+
+    if (calculateSHA1) {
+        unsigned char sha1Hash[20];
+        TSK_SHA_Final(sha1Hash, sha1Ctx);
+
+        char textBuff[41];            
+        for (int i = 0; i < 20; i++) {
+            textBuff[2 * i] = hexMap[(sha1Hash[i] >> 4) & 0xf];
+            textBuff[2 * i + 1] = hexMap[sha1Hash[i] & 0xf];
+        }
+        textBuff[40] = '\0';
+        pFile->setHash(TskImgDB::SHA1, textBuff);
+    }
+}
+
 extern "C" 
 {
     /**
@@ -61,6 +105,18 @@ extern "C"
         return "1.0.1";
     }
 
+    /**
+     * Module thread safety function. The hashes of a file are kept in
+     * local data or the stream context, so files can be analyzed by 
+     * several threads at the same time.
+     *
+     * @return true
+     */
+    TSK_MODULE_EXPORT bool isThreadSafe()
+    {
+        return true;
+    }
+
     /**
      * Module initialization function. Receives arguments, typically read by the
      * caller from a pipeline configuration file, that determine what hashes the 
@@ -165,32 +221,112 @@ extern "C"
                 }
             } while (bytesRead > 0);
 
-            if (calculateMD5) {
-                unsigned char md5Hash[16];
-                TSK_MD5_Final(md5Hash, &md5Ctx);
+            setHashes(pFile, &md5Ctx, &sha1Ctx);
+        }
+        catch (TskException& tskEx)
+        {
+            std::stringstream msg;
+            msg << "HashCalcModule - Error processing file id " << pFile->getId() << ": " << tskEx.what();
+            LOGERROR(msg.str());
+            return TskModule::FAIL;
+        }
+        catch (std::exception& ex)
+        {
+            std::stringstream msg;
+            msg << "HashCalcModule - Error processing file id " << pFile->getId() << ": " << ex.what();
+            LOGERROR(msg.str());
+            return TskModule::FAIL;
+        }
 
-                char md5TextBuff[33];            
-                for (int i = 0; i < 16; i++) {
-                    md5TextBuff[2 * i] = hexMap[(md5Hash[i] >> 4) & 0xf];
-                    md5TextBuff[2 * i + 1] = hexMap[md5Hash[i] & 0xf];
-                }
-                md5TextBuff[32] = '\0';
-                pFile->setHash(TskImgDB::MD5, md5TextBuff);
+        return TskModule::OK;
+    }
+
+    /**
+     * Called by a file analysis pipeline before it streams the content of a
+     * file to the module. This replaces run() when the pipeline reads the 
+     * content once for several modules.
+     *
+     * @param pFile A pointer to the file whose content will be streamed.
+     * @param context [in,out] State of the module instance for the stream.
+     * Allocated here if it is NULL.
+     * @returns TskModule::OK if the content should be streamed, 
+     * TskModule::STOP if no content is needed or TskModule::FAIL on error.
+     */
+    TskModule::Status TSK_MODULE_EXPORT beginStream(TskFile * pFile, void ** context)
+    {
+        if (*context == NULL)
+        {
+            *context = new (std::nothrow) StreamContext;
+            if (*context == NULL)
+            {
+                LOGERROR("HashCalcModule: failed to allocate stream context.");
+                return TskModule::FAIL;
             }
+        }
 
-            if (calculateSHA1) {
-                unsigned char sha1Hash[20];
-                TSK_SHA_Final(sha1Hash, &sha1Ctx);
+        StreamContext * streamContext = static_cast<StreamContext *>(*context);
+        streamContext->active = false;
 
-                char textBuff[41];            
-                for (int i = 0; i < 20; i++) {
-                    textBuff[2 * i] = hexMap[(sha1Hash[i] >> 4) & 0xf];
-                    textBuff[2 * i + 1] = hexMap[sha1Hash[i] & 0xf];
-                }
-                textBuff[40] = '\0';
-                pFile->setHash(TskImgDB::SHA1, textBuff);
-            }
+        if (pFile == NULL) 
+        {
+            LOGERROR("HashCalcModule: passed NULL file pointer.");
+            return TskModule::FAIL;
+        }
+
+        // We will not attempt to calculate hash values for "unused sector"
+        // files.
+        if (pFile->getTypeId() == TskImgDB::IMGDB_FILES_TYPE_UNUSED)
+            return TskModule::STOP;
+
+        if (calculateMD5)
+            TSK_MD5_Init(&streamContext->md5Ctx);
+
+        if (calculateSHA1)
+            TSK_SHA_Init(&streamContext->sha1Ctx);
+
+        streamContext->active = true;
+        return TskModule::OK;
+    }
+
+    /**
+     * Adds the next chunk of the content of a file to the hashes.
+     *
+     * @param pFile A pointer to the file being streamed.
+     * @param buffer File content.
+     * @param length Number of bytes in buffer.
+     * @param context State of the module instance for the stream.
+     * @returns TskModule::OK
+     */
+    TskModule::Status TSK_MODULE_EXPORT consumeStream(TskFile * pFile, const char * buffer, size_t length, void * context)
+    {
+        StreamContext * streamContext = static_cast<StreamContext *>(context);
+
+        if (calculateMD5)
+            TSK_MD5_Update(&streamContext->md5Ctx, (unsigned char *) buffer, (unsigned int) length);
+
+        if (calculateSHA1)
+            TSK_SHA_Update(&streamContext->sha1Ctx, (unsigned char *) buffer, (unsigned int) length);
 
+        return TskModule::OK;
+    }
+
+    /**
+     * Posts the hashes of the streamed content to the database.
+     *
+     * @param pFile A pointer to the file that was streamed.
+     * @param context State of the module instance for the stream.
+     * @returns TskModule::OK on success, TskModule::FAIL on error.
+     */
+    TskModule::Status TSK_MODULE_EXPORT endStream(TskFile * pFile, void * context)
+    {
+        StreamContext * streamContext = static_cast<StreamContext *>(context);
+        if (!streamContext->active)
+            return TskModule::OK;
+        streamContext->active = false;
+
+        try 
+        {
+            setHashes(pFile, &streamContext->md5Ctx, &streamContext->sha1Ctx);
         }
         catch (TskException& tskEx)
         {
@@ -210,6 +346,28 @@ extern "C"
         return TskModule::OK;
     }
 
+    /**
+     * Drops the hashes of a stream that ended without endStream().
+     *
+     * @param pFile A pointer to the file that was being streamed.
+     * @param context State of the module instance for the stream.
+     */
+    void TSK_MODULE_EXPORT abortStream(TskFile * pFile, void * context)
+    {
+        if (context != NULL)
+            static_cast<StreamContext *>(context)->active = false;
+    }
+
+    /**
+     * Frees the stream state of a module instance.
+     *
+     * @param context State of the module instance for the stream.
+     */
+    void TSK_MODULE_EXPORT freeStreamContext(void * context)
+    {
+        delete static_cast<StreamContext *>(context);
+    }
+
     /**
      * Module cleanup function. This module does not need to free any 
      * resources allocated during initialization or execution.
@@ -18,7 +18,7 @@
 
 #include "tsk/tsk_tools_i.h" // Needed for tsk_getopt
 #include "tsk/framework/framework.h"
-#include "tsk/framework/services/TskSchedulerQueue.h"
+#include "tsk/framework/services/TskSchedulerThreadPool.h"
 #include "tsk/framework/services/TskSystemPropertiesImpl.h"
 #include "tsk/framework/services/TskImgDBSqlite.h"
 #include "tsk/framework/file/TskFileManagerImpl.h"
@@ -36,6 +36,7 @@
 #endif
 
 #include "Poco/File.h"
+#include "Poco/Mutex.h"
 #include "Poco/UnicodeConverter.h"
 
 static uint8_t 
@@ -79,13 +80,50 @@ class StderrLog : public Log
     }
 };
 
+/**
+ * Runs the tasks of one thread of the scheduler, with a file analysis
+ * pipeline of its own. Carving is done by one thread at a time.
+ */
+class AnalysisTaskRunner : public TskSchedulerThreadPool::TaskRunner
+{
+public:
+    AnalysisTaskRunner(TskPipeline *filePipeline, TskCarveExtractScalpel *carver, Poco::FastMutex &carverLock)
+        : m_filePipeline(filePipeline), m_carver(carver), m_carverLock(carverLock) {
+    }
+
+    void runTask(const Scheduler::task_struct &task)
+    {
+        if (task.task == Scheduler::FileAnalysis && m_filePipeline && !m_filePipeline->isEmpty())
+        {
+            m_filePipeline->run(task.id);
+        }
+        else if (task.task == Scheduler::Carve && m_carver)
+        {
+            Poco::FastMutex::ScopedLock lock(m_carverLock);
+            m_carver->processFile(static_cast<int>(task.id));
+        }
+        else
+        {
+            std::stringstream msg;
+            msg << "WARNING: Skipping task: " << task.task;
+            LOGWARN(msg.str());
+        }
+    }
+
+private:
+    TskPipeline *m_filePipeline;
+    TskCarveExtractScalpel *m_carver;
+    Poco::FastMutex &m_carverLock;
+};
+
 void 
 usage(const char *program) 
 {
-    fprintf(stderr, "%s [-c framework_config_file] [-p pipeline_config_file] [-d outdir] [-C] [-v] [-V] [-L] image_name\n", program);
+    fprintf(stderr, "%s [-c framework_config_file] [-p pipeline_config_file] [-d outdir] [-t num_threads] [-C] [-v] [-V] [-L] image_name\n", program);
     fprintf(stderr, "\t-c framework_config_file: Path to XML framework config file\n");
     fprintf(stderr, "\t-p pipeline_config_file: Path to XML pipeline config file (overrides pipeline config specified with -c)\n");
     fprintf(stderr, "\t-d outdir: Path to output directory\n");
+    fprintf(stderr, "\t-t num_threads: Number of threads to analyze files with (default 1)\n");
     fprintf(stderr, "\t-C: Disable carving, overriding framework config file settings\n");
     fprintf(stderr, "\t-u: Enable unused sector file creation\n");
     fprintf(stderr, "\t-v: Enable verbose mode to get more debug information\n");
@@ -105,6 +143,7 @@ int main(int argc, char **argv1)
     bool suppressSTDERR = false;
     bool doCarving = true;
     bool createUnusedSectorFiles = false;
+    unsigned int numThreads = 1;
 
 #ifdef TSK_WIN32
     // On Windows, get the wide arguments (mingw doesn't support wmain)
@@ -118,7 +157,7 @@ int main(int argc, char **argv1)
 #endif
 
     while ((ch =
-        GETOPT(argc, argv, _TSK_T("d:c:p:vuVLC"))) > 0) {
+        GETOPT(argc, argv, _TSK_T("d:c:p:t:vuVLC"))) > 0) {
         switch (ch) {
         case _TSK_T('c'):
 #ifdef TSK_WIN32
@@ -155,6 +194,18 @@ int main(int argc, char **argv1)
 #endif
             break;
 
+        case _TSK_T('t'):
+            {
+                TSK_TCHAR *cp;
+                numThreads = (unsigned int) TSTRTOUL(OPTARG, &cp, 0);
+                if (*cp || *cp == *OPTARG || numThreads < 1) {
+                    TFPRINTF(stderr, _TSK_T("Invalid number of threads: %s\n"),
+                        OPTARG);
+                    usage(argv1[0]);
+                }
+            }
+            break;
+
         case _TSK_T('C'):
             doCarving = false;
             break;
@@ -302,7 +353,7 @@ int main(int argc, char **argv1)
         SetSystemProperty(TskSystemProperties::PIPELINE_CONFIG_FILE, pipeline_config);
 
     // Create a Scheduler and register it
-    TskSchedulerQueue scheduler;
+    TskSchedulerThreadPool scheduler;
     TskServices::Instance().setScheduler(scheduler);
 
     // Create a FileManager and register it with the framework.
@@ -389,36 +440,67 @@ int main(int argc, char **argv1)
         }
     }
 
-    TskSchedulerQueue::task_struct *task;
-    while ((task = scheduler.nextTask()) != NULL) 
+    // Modules that are not thread safe get one pipeline and one thread
+    if (numThreads > 1 && filePipeline && !filePipeline->isEmpty() && !filePipeline->isThreadSafe())
+    {
+        std::stringstream msg;
+        msg << "WARNING: Not all file analysis modules are thread safe, analyzing files with one thread";
+        LOGWARN(msg.str());
+        numThreads = 1;
+    }
+
+    Poco::FastMutex carverLock;
+    std::vector<TskPipeline *> filePipelines;
+    if (filePipeline)
+        filePipelines.push_back(filePipeline);
+
+    if (numThreads > 1 && filePipeline && !filePipeline->isEmpty())
     {
-        try
+        // Each thread needs its own pipeline (and module instances)
+        for (unsigned int i = 1; i < numThreads; i++)
         {
-            if (task->task == Scheduler::FileAnalysis && filePipeline && !filePipeline->isEmpty())
-            {
-                filePipeline->run(task->id);
+            try {
+                filePipelines.push_back(pipelineMgr.createPipeline(TskPipelineManager::FILE_ANALYSIS_PIPELINE));
+            }
+            catch (const TskException &e ) {
+                std::stringstream msg;
+                msg << "Error creating file analysis pipeline for thread " << i << ": " << e.message();
+                LOGERROR(msg.str());
+                break;
             }
-            else if (task->task == Scheduler::Carve && carver.get())
+        }
+
+        std::vector<AnalysisTaskRunner *> runners;
+        for (size_t i = 0; i < filePipelines.size(); i++)
+            runners.push_back(new AnalysisTaskRunner(filePipelines[i], carver.get(), carverLock));
+
+        scheduler.run(std::vector<TskSchedulerThreadPool::TaskRunner *>(runners.begin(), runners.end()));
+
+        for (size_t i = 0; i < runners.size(); i++)
+            delete runners[i];
+    }
+    else
+    {
+        AnalysisTaskRunner runner(filePipeline, carver.get(), carverLock);
+        Scheduler::task_struct *task;
+        while ((task = scheduler.nextTask()) != NULL) 
+        {
+            try
             {
-                carver->processFile(static_cast<int>(task->id));
+                runner.runTask(*task);
             }
-            else
+            catch (...) 
             {
-                std::stringstream msg;
-                msg << "WARNING: Skipping task: " << task->task;
-                LOGWARN(msg.str());
+                // Error message has been logged already.
             }
             delete task;
         }
-        catch (...) 
-        {
-            // Error message has been logged already.
-        }
     }
 
-    if (filePipeline && !filePipeline->isEmpty())
+    for (size_t i = 0; i < filePipelines.size(); i++)
     {
-        filePipeline->logModuleExecutionTimes();
+        if (!filePipelines[i]->isEmpty())
+            filePipelines[i]->logModuleExecutionTimes();
     }
 
     // Do image analysis tasks.
@@ -112,10 +112,15 @@ void TskImageFileTsk::close()
     m_images.clear();
 
     // Close the handles in m_openFiles and m_openFs
-    for (uint32_t i = 0; i < m_openFiles.size(); i++)
-        closeFile(i);
+    Poco::Mutex::ScopedLock lock(m_lock);
+    for (uint32_t i = 0; i < m_openFiles.size(); i++) {
+        if (m_openFiles[i] != NULL)
+            closeFile(i);
+    }
+    m_openFiles.clear();
 
     std::for_each(m_openFs.begin(), m_openFs.end(), (&TskImageFileTsk::closeFs));
+    m_openFs.clear();
 }
 
 /*
@@ -145,9 +150,12 @@ int TskImageFileTsk::getByteData(const uint64_t byte_start,
                                 const uint64_t byte_len, 
                                 char *buffer)
 {
-    if (m_img_info == NULL) {
-        if (open() != 0)
-            return -1;
+    {
+        Poco::Mutex::ScopedLock lock(m_lock);
+        if (m_img_info == NULL) {
+            if (open() != 0)
+                return -1;
+        }
     }
 
     int retval = tsk_img_read(m_img_info, byte_start, buffer, (size_t)(byte_len));
@@ -204,9 +212,12 @@ int TskImageFileTsk::extractFiles()
 
 int TskImageFileTsk::openFile(const uint64_t fileId)
 {
-    if (m_img_info == NULL) {
-        if (open() != 0)
-            return -1;
+    {
+        Poco::Mutex::ScopedLock lock(m_lock);
+        if (m_img_info == NULL) {
+            if (open() != 0)
+                return -1;
+        }
     }
 
     // Use ImgDb::getFileUniqueIdentifiers to get the four needed values.
@@ -222,22 +233,26 @@ int TskImageFileTsk::openFile(const uint64_t fileId)
     }
 
     // Check if the file system at the offset is already open (using m_openFs).  If not, open it (tsk_fs_open) and add it to the map.
-    TSK_FS_INFO * fsInfo = m_openFs[fsByteOffset];
-
-    if (fsInfo == NULL)
+    TSK_FS_INFO * fsInfo;
     {
-        // Open the file system and add it to the map.
-        fsInfo = tsk_fs_open_img(m_img_info, fsByteOffset, TSK_FS_TYPE_DETECT);
+        Poco::Mutex::ScopedLock lock(m_lock);
+        fsInfo = m_openFs[fsByteOffset];
 
         if (fsInfo == NULL)
         {
-            std::wstringstream errorMsg;
-            errorMsg << L"TskImageFileTsk::openFile - Error opening file system : " << tsk_error_get();
-            LOGERROR(errorMsg.str());
-            return -1;
+            // Open the file system and add it to the map.
+            fsInfo = tsk_fs_open_img(m_img_info, fsByteOffset, TSK_FS_TYPE_DETECT);
+
+            if (fsInfo == NULL)
+            {
+                std::wstringstream errorMsg;
+                errorMsg << L"TskImageFileTsk::openFile - Error opening file system : " << tsk_error_get();
+                LOGERROR(errorMsg.str());
+                return -1;
+            }
+
+            m_openFs[fsByteOffset] = fsInfo;
         }
-
-        m_openFs[fsByteOffset] = fsInfo;
     }
 
     // Find a new entry in m_openFiles and use tsk_fs_file_open to open the file and save the handle in m_openFiles. 
@@ -264,6 +279,7 @@ int TskImageFileTsk::openFile(const uint64_t fileId)
         std::wstringstream msg;
         msg << L"TskImageFileTsk::openFile - Error getting attribute : " << tsk_error_get();
         LOGERROR(msg.str());
+        tsk_fs_file_close(fsFile);
         return -1;
     }
 
@@ -271,6 +287,16 @@ int TskImageFileTsk::openFile(const uint64_t fileId)
     openFile->fsFile = fsFile;
     openFile->fsAttr = fsAttr;
 
+    // Reuse the entry of a closed file so that handles stay small.
+    Poco::Mutex::ScopedLock lock(m_lock);
+    for (size_t i = 0; i < m_openFiles.size(); i++)
+    {
+        if (m_openFiles[i] == NULL)
+        {
+            m_openFiles[i] = openFile;
+            return (int)i;
+        }
+    }
     m_openFiles.push_back(openFile);
 
     // Return the index into m_openFiles
@@ -282,7 +308,12 @@ int TskImageFileTsk::readFile(const int handle,
                               const size_t byte_len, 
                               char * buffer)
 {
-    TskImageFileTsk::OPEN_FILE * openFile = m_openFiles[handle];
+    TskImageFileTsk::OPEN_FILE * openFile = NULL;
+    {
+        Poco::Mutex::ScopedLock lock(m_lock);
+        if (handle >= 0 && (size_t)handle < m_openFiles.size())
+            openFile = m_openFiles[handle];
+    }
 
     if (openFile == NULL || openFile->fsFile == NULL)
     {
@@ -319,7 +350,10 @@ int TskImageFileTsk::readFile(const int handle,
 int TskImageFileTsk::closeFile(const int handle)
 {
     // get the handle from m_openFiles
-    TskImageFileTsk::OPEN_FILE * openFile = m_openFiles[handle];
+    Poco::Mutex::ScopedLock lock(m_lock);
+    TskImageFileTsk::OPEN_FILE * openFile = NULL;
+    if (handle >= 0 && (size_t)handle < m_openFiles.size())
+        openFile = m_openFiles[handle];
 
     if (openFile == NULL || openFile->fsFile == NULL)
     {
@@ -332,8 +366,8 @@ int TskImageFileTsk::closeFile(const int handle)
     // close the file
     tsk_fs_file_close(openFile->fsFile);
 
-    // remove the entry from m_openFiles
-    m_openFiles.erase(m_openFiles.begin() + handle);
+    // free the entry in m_openFiles (the other handles must not change)
+    m_openFiles[handle] = NULL;
 
     // delete the struct
     delete openFile;
@@ -21,6 +21,8 @@
 #include "tsk/framework/services/Log.h"
 #include "tsk/libtsk.h"
 
+#include "Poco/Mutex.h"
+
 #include <vector>
 #include <map>
 
@@ -98,8 +100,9 @@ class TSK_FRAMEWORK_API TskImageFileTsk : public TskImageFile
         const TSK_FS_ATTR * fsAttr;
     };
 
-    std::vector<OPEN_FILE *> m_openFiles; // maps handle returned from openFile() to the open TSK_FS_FILE object
+    std::vector<OPEN_FILE *> m_openFiles; // maps handle returned from openFile() to the open TSK_FS_FILE object (NULL once closed)
     std::map<uint64_t, TSK_FS_INFO *> m_openFs; // maps the byte offset of a file system to its open object.
+    Poco::Mutex m_lock; // protects m_openFiles, m_openFs and the opening of the images, which can be used by several threads
 
     int openImages(const TSK_IMG_TYPE_ENUM imageType = TSK_IMG_TYPE_DETECT,
                    const unsigned int sectorSize = 0);
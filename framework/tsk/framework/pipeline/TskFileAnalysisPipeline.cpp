@@ -28,6 +28,8 @@
 #include <sstream>
 #include <memory>
 
+const size_t TskFileAnalysisPipeline::STREAM_CHUNK_SIZE = 1024 * 1024;
+
 void TskFileAnalysisPipeline::run(const uint64_t fileId)
 {
     // Get a file object for the given fileId
@@ -57,6 +59,10 @@ void TskFileAnalysisPipeline::run(TskFile* file)
 
     TskImgDB& imgDB = TskServices::Instance().getImgDB();
 
+    // Modules that the content of the file is being streamed to. Each one
+    // gets either endStream() or abortStream() before we return.
+    std::vector<bool> streamBegun(m_modules.size(), false);
+
     try
     {
         // If this is an excluded file or the file is not ready for analysis
@@ -95,19 +101,56 @@ void TskFileAnalysisPipeline::run(TskFile* file)
 
         bool bModuleFailed = false;
 
+        // The file content is read once for all of the modules that can
+        // consume it as a stream, when the first of them is reached. The
+        // modules before it may stop the pipeline, in which case the
+        // content is not read at all.
+        std::vector<TskModule::Status> streamStatus(m_modules.size(), TskModule::OK);
+        bool bStreamed = false;
+
         Poco::Stopwatch stopWatch;
         for (size_t i = 0; i < m_modules.size(); i++)
         {
-            // we have no way of knowing if the file was closed by a module,
-            // so always make sure it is open
-            file->open();
+            TskModule::Status status;
 
-            // Reset the file offset to the beginning of the file.
-            file->seek(0);
+            if (m_modules[i]->isStreamConsumer())
+            {
+                if (!bStreamed)
+                {
+                    streamContent(file, i, streamStatus, streamBegun);
+                    bStreamed = true;
+                }
+
+                // The module has already seen the content, let it finish
+                // its analysis unless it failed while consuming it.
+                stopWatch.restart();
+                if (streamStatus[i] == TskModule::FAIL)
+                {
+                    status = TskModule::FAIL;
+                    if (streamBegun[i])
+                        m_modules[i]->abortStream(file);
+                }
+                else
+                {
+                    status = m_modules[i]->endStream(file);
+                }
+                streamBegun[i] = false;
+                stopWatch.stop();
+            }
+            else
+            {
+                // we have no way of knowing if the file was closed by a module,
+                // so always make sure it is open
+                file->open();
+
+                // Reset the file offset to the beginning of the file.
+                file->seek(0);
+
+                stopWatch.restart();
+                status = m_modules[i]->run(file);
+                stopWatch.stop();
+            }
 
-            stopWatch.restart();
-            TskModule::Status status = m_modules[i]->run(file);
-            stopWatch.stop();            
             updateModuleExecutionTime(m_modules[i]->getModuleId(), stopWatch.elapsed());
             
             imgDB.setModuleStatus(file->getId(), m_modules[i]->getModuleId(), (int)status);
@@ -122,6 +165,9 @@ void TskFileAnalysisPipeline::run(TskFile* file)
                 break;
         }
 
+        // The modules after a stop do not get to finish their streams.
+        abortStreams(file, streamBegun);
+
         // Delete the file if it exists. The file may have been created by us
         // above or by a module that required it to exist on disk.
         // Carved and derived files should not be deleted since the content is
@@ -150,6 +196,8 @@ void TskFileAnalysisPipeline::run(TskFile* file)
     }
     catch (std::exception& ex)
     {
+        abortStreams(file, streamBegun);
+
         std::stringstream msg;
         msg << MSG_PREFIX << "error while processing file id (" << file->getId() << ") : " << ex.what();
         LOGERROR(msg.str());
@@ -159,3 +207,90 @@ void TskFileAnalysisPipeline::run(TskFile* file)
         throw;
     }
 }
+
+void TskFileAnalysisPipeline::abortStreams(TskFile* file, std::vector<bool>& streamBegun)
+{
+    for (size_t i = 0; i < streamBegun.size(); i++)
+    {
+        if (!streamBegun[i])
+            continue;
+
+        streamBegun[i] = false;
+        Poco::Stopwatch stopWatch;
+        stopWatch.restart();
+        m_modules[i]->abortStream(file);
+        stopWatch.stop();
+        updateModuleExecutionTime(m_modules[i]->getModuleId(), stopWatch.elapsed());
+    }
+}
+
+void TskFileAnalysisPipeline::streamContent(TskFile* file, size_t first, std::vector<TskModule::Status>& streamStatus, std::vector<bool>& streamBegun)
+{
+    const std::string MSG_PREFIX = "TskFileAnalysisPipeline::streamContent : ";
+
+    // Find the modules that want the content of this file.
+    std::vector<size_t> consumers;
+    Poco::Stopwatch stopWatch;
+    for (size_t i = first; i < m_modules.size(); i++)
+    {
+        if (!m_modules[i]->isStreamConsumer())
+            continue;
+
+        stopWatch.restart();
+        streamBegun[i] = true;
+        TskModule::Status status = m_modules[i]->beginStream(file);
+        stopWatch.stop();
+        updateModuleExecutionTime(m_modules[i]->getModuleId(), stopWatch.elapsed());
+
+        if (status == TskModule::OK)
+            consumers.push_back(i);
+        else if (status == TskModule::FAIL)
+            streamStatus[i] = TskModule::FAIL;
+    }
+
+    if (consumers.empty())
+        return;
+
+    file->open();
+    file->seek(0);
+
+    std::vector<char> buffer(STREAM_CHUNK_SIZE);
+    while (!consumers.empty())
+    {
+        ssize_t bytesRead = file->read(&buffer[0], buffer.size());
+        if (bytesRead == 0)
+            break;
+
+        if (bytesRead < 0)
+        {
+            // Modules reading the file themselves would have failed here too.
+            std::stringstream msg;
+            msg << MSG_PREFIX << "error reading content of file id (" << file->getId() << ")";
+            LOGERROR(msg.str());
+            for (size_t j = 0; j < consumers.size(); j++)
+                streamStatus[consumers[j]] = TskModule::FAIL;
+            break;
+        }
+
+        // Pass the chunk to each module, dropping the ones that have
+        // seen enough of the file or that failed.
+        std::vector<size_t>::iterator it = consumers.begin();
+        while (it != consumers.end())
+        {
+            stopWatch.restart();
+            TskModule::Status status = m_modules[*it]->consumeStream(file, &buffer[0], (size_t)bytesRead);
+            stopWatch.stop();
+            updateModuleExecutionTime(m_modules[*it]->getModuleId(), stopWatch.elapsed());
+
+            if (status == TskModule::OK)
+            {
+                ++it;
+                continue;
+            }
+
+            if (status == TskModule::FAIL)
+                streamStatus[*it] = TskModule::FAIL;
+            it = consumers.erase(it);
+        }
+    }
+}
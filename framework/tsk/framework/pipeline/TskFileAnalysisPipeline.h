@@ -23,6 +23,7 @@
 
 // C/C++ library includes
 #include <string>
+#include <vector>
 
 /**
  * Controls the processing of a file analysis pipeline.  
@@ -47,6 +48,32 @@ class TSK_FRAMEWORK_API TskFileAnalysisPipeline : public TskPipeline
     { 
         return (new TskFileAnalysisPluginModule());
     }
+
+private:
+    /**
+     * Size of the chunks that file content is streamed to modules in.
+     */
+    static const size_t STREAM_CHUNK_SIZE;
+
+    /**
+     * Reads the content of a file once and passes it to each module in the 
+     * pipeline that is a stream consumer, starting at a given position.
+     * @param file File to stream.
+     * @param first Position in m_modules of the first module to stream to.
+     * @param streamStatus [out] Status of the streaming for each module,
+     * indexed in the same way as m_modules. 
+     * @param streamBegun [out] Set for each module whose beginStream() was
+     * called, indexed in the same way as m_modules.
+     */
+    void streamContent(TskFile* file, size_t first, std::vector<TskModule::Status>& streamStatus, std::vector<bool>& streamBegun);
+
+    /**
+     * Calls abortStream() on each module whose beginStream() was called 
+     * and whose endStream() was not, and clears its streamBegun entry.
+     * @param file File that was being streamed.
+     * @param streamBegun [in,out] Modules that the file is being streamed to.
+     */
+    void abortStreams(TskFile* file, std::vector<bool>& streamBegun);
 };
 
 #endif
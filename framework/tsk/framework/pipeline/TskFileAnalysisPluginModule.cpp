@@ -23,6 +23,18 @@
 // C/C++ library includes
 #include <sstream>
 
+TskFileAnalysisPluginModule::~TskFileAnalysisPluginModule()
+{
+    // The base class destructor unloads the library, so free the context first.
+    if (m_streamContext != NULL && hasSymbol(TskPluginModule::FREE_STREAM_CONTEXT_SYMBOL))
+    {
+        typedef void (*FreeContextFunc)(void*);
+        FreeContextFunc freeContext = (FreeContextFunc)getSymbol(TskPluginModule::FREE_STREAM_CONTEXT_SYMBOL);
+        freeContext(m_streamContext);
+        m_streamContext = NULL;
+    }
+}
+
 TskModule::Status TskFileAnalysisPluginModule::run(TskFile *fileToAnalyze)
 {
     const std::string MSG_PREFIX = "TskFileAnalysisPluginModule::run : ";
@@ -79,6 +91,97 @@ TskModule::Status TskFileAnalysisPluginModule::run(TskFile *fileToAnalyze)
     return status;
 }
 
+TskModule::Status TskFileAnalysisPluginModule::beginStream(TskFile *fileToAnalyze)
+{
+    return runStreamFunction(TskPluginModule::BEGIN_STREAM_SYMBOL, fileToAnalyze, NULL, 0);
+}
+
+TskModule::Status TskFileAnalysisPluginModule::consumeStream(TskFile *fileToAnalyze, const char *buffer, size_t length)
+{
+    return runStreamFunction(TskPluginModule::CONSUME_STREAM_SYMBOL, fileToAnalyze, buffer, length);
+}
+
+TskModule::Status TskFileAnalysisPluginModule::endStream(TskFile *fileToAnalyze)
+{
+    return runStreamFunction(TskPluginModule::END_STREAM_SYMBOL, fileToAnalyze, NULL, 0);
+}
+
+void TskFileAnalysisPluginModule::abortStream(TskFile *fileToAnalyze)
+{
+    if (m_isStreamConsumer && hasSymbol(TskPluginModule::ABORT_STREAM_SYMBOL))
+        runStreamFunction(TskPluginModule::ABORT_STREAM_SYMBOL, fileToAnalyze, NULL, 0);
+}
+
+TskModule::Status TskFileAnalysisPluginModule::runStreamFunction(const std::string &symbol, TskFile *fileToAnalyze, const char *buffer, size_t length)
+{
+    const std::string MSG_PREFIX = "TskFileAnalysisPluginModule::runStreamFunction : ";
+    TskModule::Status status = TskModule::OK;
+    try
+    {
+        if (!m_isStreamConsumer)
+        {
+            std::stringstream msg;
+            msg << MSG_PREFIX << getPath() << " is not a stream consumer";
+            throw TskException(msg.str());
+        }
+
+        if (symbol == TskPluginModule::BEGIN_STREAM_SYMBOL)
+        {
+            typedef TskModule::Status (*BeginFunc)(TskFile*, void**);
+            BeginFunc begin = (BeginFunc)getSymbol(symbol);
+            status = begin(fileToAnalyze, &m_streamContext);
+        }
+        else if (symbol == TskPluginModule::CONSUME_STREAM_SYMBOL)
+        {
+            typedef TskModule::Status (*ConsumeFunc)(TskFile*, const char*, size_t, void*);
+            ConsumeFunc consume = (ConsumeFunc)getSymbol(symbol);
+            status = consume(fileToAnalyze, buffer, length, m_streamContext);
+        }
+        else if (symbol == TskPluginModule::ABORT_STREAM_SYMBOL)
+        {
+            typedef void (*AbortFunc)(TskFile*, void*);
+            AbortFunc abort = (AbortFunc)getSymbol(symbol);
+            abort(fileToAnalyze, m_streamContext);
+        }
+        else
+        {
+            typedef TskModule::Status (*EndFunc)(TskFile*, void*);
+            EndFunc end = (EndFunc)getSymbol(symbol);
+            status = end(fileToAnalyze, m_streamContext);
+        }
+    }
+    catch (TskException &ex) 
+    {
+        std::stringstream msg;
+        msg << MSG_PREFIX << "TskException executing " << symbol << " function of " << getName() << ": " << ex.message();
+        LOGERROR(msg.str());
+        status = TskModule::FAIL;
+    }
+    catch (Poco::Exception &ex) 
+    {
+        std::stringstream msg;
+        msg << MSG_PREFIX <<  "Poco::Exception executing " << symbol << " function of "  << getName() << ": " << ex.displayText();
+        LOGERROR(msg.str());
+        status = TskModule::FAIL;
+    }
+    catch (std::exception &ex) 
+    {
+        std::stringstream msg;
+        msg << MSG_PREFIX <<  "std::exception executing " << symbol << " function of "  << getName() << ": " << ex.what();
+        LOGERROR(msg.str());
+        status = TskModule::FAIL;
+    }
+    catch (...)
+    {
+        std::stringstream msg;
+        msg << MSG_PREFIX << "unrecognized exception executing " << symbol << " function of "  << getName();
+        LOGERROR(msg.str());
+        status = TskModule::FAIL;
+    }
+
+    return status;
+}
+
 void TskFileAnalysisPluginModule::checkInterface()
 {
     const std::string MSG_PREFIX = "TskFileAnalysisPluginModule::checkInterface : ";
@@ -97,4 +200,11 @@ void TskFileAnalysisPluginModule::checkInterface()
         msg << MSG_PREFIX << getPath() << " does not define the required '" << TskPluginModule::RUN_SYMBOL << "' symbol";
         throw TskException(msg.str());
     }
+
+    // The streaming functions are optional, but a module must define all of them
+    // to be used as a stream consumer.
+    m_isStreamConsumer = hasSymbol(TskPluginModule::BEGIN_STREAM_SYMBOL) &&
+        hasSymbol(TskPluginModule::CONSUME_STREAM_SYMBOL) &&
+        hasSymbol(TskPluginModule::END_STREAM_SYMBOL) &&
+        hasSymbol(TskPluginModule::FREE_STREAM_CONTEXT_SYMBOL);
 }
@@ -21,11 +21,48 @@
 class TSK_FRAMEWORK_API TskFileAnalysisPluginModule: public TskPluginModule
 {
 public:
+    TskFileAnalysisPluginModule() : m_isStreamConsumer(false), m_streamContext(NULL) {}
+
+    /**
+     * Frees the stream state that the module library allocated for this
+     * instance.
+     */
+    virtual ~TskFileAnalysisPluginModule();
+
     // Doxygen comment in base class.
     virtual Status run(TskFile *fileToAnalyze);
 
+    /**
+     * Returns true if the module library defines the optional 'beginStream',
+     * 'consumeStream', 'endStream' and 'freeStreamContext' functions. Only 
+     * valid after checkInterface() has been called.
+     */
+    virtual bool isStreamConsumer() const { return m_isStreamConsumer; }
+
+    // Doxygen comment in base class.
+    virtual Status beginStream(TskFile *fileToAnalyze);
+
+    // Doxygen comment in base class.
+    virtual Status consumeStream(TskFile *fileToAnalyze, const char *buffer, size_t length);
+
+    // Doxygen comment in base class.
+    virtual Status endStream(TskFile *fileToAnalyze);
+
+    /**
+     * Calls the optional 'abortStream' function of the module library. The
+     * stream context is kept either way, since beginStream() resets it
+     * for the next file and it is freed when the module is destroyed.
+     */
+    virtual void abortStream(TskFile *fileToAnalyze);
+
     // Doxygen comment in base class.
     virtual void checkInterface();
+
+private:
+    Status runStreamFunction(const std::string &symbol, TskFile *fileToAnalyze, const char *buffer, size_t length);
+
+    bool m_isStreamConsumer;
+    void *m_streamContext;  ///< State of the module library for the file being streamed (allocated by beginStream)
 };
 
 #endif
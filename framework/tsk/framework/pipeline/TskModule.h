@@ -62,6 +62,63 @@ class TSK_FRAMEWORK_API TskModule
      */
     virtual Status report() { return TskModule::OK; };
 
+    /**
+     * Returns true if the module analyzes file content as a stream of chunks.
+     * For such modules a file analysis pipeline reads the content of each 
+     * file once and passes it to beginStream(), consumeStream() and 
+     * endStream() instead of calling run().
+     */
+    virtual bool isStreamConsumer() const { return false; }
+
+    /**
+     * Returns true if the module can analyze files in several threads at
+     * the same time. Each thread has its own pipeline, so a module is
+     * created and initialized once per thread and the module has to
+     * protect any state that these instances share. The instances of a
+     * plugin module share the globals and statics of the module library,
+     * which is only loaded once. Modules are assumed not to be thread safe.
+     */
+    virtual bool isThreadSafe() const { return false; }
+
+    /**
+     * Called before the content of a file is streamed to the module. 
+     * @param fileToAnalyze File whose content will be streamed.
+     * @returns OK if the module wants the content, STOP if it does not 
+     * need any content, or FAIL on error.
+     */
+    virtual Status beginStream(TskFile* fileToAnalyze) { return TskModule::STOP; }
+
+    /**
+     * Called with each consecutive chunk of the content of a file. 
+     * @param fileToAnalyze File that the content belongs to.
+     * @param buffer Content of the file.
+     * @param length Number of bytes in buffer.
+     * @returns OK if the module wants more content, STOP if it has seen
+     * enough of the file, or FAIL on error.
+     */
+    virtual Status consumeStream(TskFile* fileToAnalyze, const char* buffer, size_t length) { return TskModule::STOP; }
+
+    /**
+     * Called, in the position of the module in the pipeline, after the 
+     * content of a file has been streamed. The module does its analysis 
+     * of the file here. It is not called if a module before it in the 
+     * pipeline stops the processing of the file.
+     * @param fileToAnalyze File whose content was streamed.
+     * @returns Status of module, with the same meaning as for run().
+     */
+    virtual Status endStream(TskFile* fileToAnalyze) { return TskModule::OK; }
+
+    /**
+     * Called instead of endStream() when the streaming of a file to the 
+     * module ends without endStream() being called: an earlier module 
+     * stopped the processing of the file, the module failed while 
+     * consuming the content, or an error occurred. The module drops the 
+     * state that it keeps for the file. It is called for every module 
+     * whose beginStream() was called and whose endStream() was not.
+     * @param fileToAnalyze File whose content was being streamed.
+     */
+    virtual void abortStream(TskFile* fileToAnalyze) {}
+
     virtual void setPath(const std::string& location);
 
     /**
@@ -263,6 +263,16 @@ TskModule * TskPipeline::createModule(Poco::XML::Element *pElem)
 
 }
 
+bool TskPipeline::isThreadSafe() const
+{
+    for (size_t i = 0; i < m_modules.size(); i++)
+    {
+        if (!m_modules[i]->isThreadSafe())
+            return false;
+    }
+    return true;
+}
+
 void TskPipeline::logModuleExecutionTimes() const
 {
     for (std::map<int, Poco::Timespan>::const_iterator it = m_moduleExecTimes.begin(); it != m_moduleExecTimes.end(); ++it)
@@ -106,6 +106,13 @@ class TSK_FRAMEWORK_API TskPipeline
 
     virtual TskPluginModule * createPluginModule() = 0;
 
+    /**
+     * Returns true if all of the modules in the pipeline are thread safe
+     * (see TskModule::isThreadSafe()), so that several instances of the
+     * pipeline can be run at the same time.
+     */
+    bool isThreadSafe() const;
+
     /**
      * Logs the recorded execution times of the modules in the pipeline.
      */
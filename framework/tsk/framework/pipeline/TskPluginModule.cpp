@@ -40,8 +40,14 @@ const std::string TskPluginModule::DESCRIPTION_SYMBOL = "description";
 const std::string TskPluginModule::VERSION_SYMBOL = "version";
 const std::string TskPluginModule::RUN_SYMBOL = "run";
 const std::string TskPluginModule::REPORT_SYMBOL = "report";
+const std::string TskPluginModule::BEGIN_STREAM_SYMBOL = "beginStream";
+const std::string TskPluginModule::CONSUME_STREAM_SYMBOL = "consumeStream";
+const std::string TskPluginModule::END_STREAM_SYMBOL = "endStream";
+const std::string TskPluginModule::FREE_STREAM_CONTEXT_SYMBOL = "freeStreamContext";
+const std::string TskPluginModule::ABORT_STREAM_SYMBOL = "abortStream";
 const std::string TskPluginModule::INITIALIZE_SYMBOL = "initialize";
 const std::string TskPluginModule::FINALIZE_SYMBOL = "finalize";
+const std::string TskPluginModule::THREAD_SAFE_SYMBOL = "isThreadSafe";
 
 TskPluginModule::~TskPluginModule()
 {
@@ -175,6 +181,14 @@ void TskPluginModule::setPath(const std::string& location)
                     metaDataFunc = NULL;
                 }
             }
+
+            if (m_sharedLibrary.hasSymbol(TskPluginModule::THREAD_SAFE_SYMBOL))
+            {
+                typedef bool (*ThreadSafeFunc)();
+                ThreadSafeFunc threadSafeFunc = (ThreadSafeFunc)m_sharedLibrary.getSymbol(TskPluginModule::THREAD_SAFE_SYMBOL);
+                if (threadSafeFunc)
+                    m_isThreadSafe = threadSafeFunc();
+            }
         }
 
         if (m_name.empty())
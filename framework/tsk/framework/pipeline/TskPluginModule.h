@@ -24,6 +24,8 @@
 class TSK_FRAMEWORK_API TskPluginModule: public TskModule
 {
 public:
+    TskPluginModule() : m_isThreadSafe(false) {}
+
     /** 
      * Destructor that calls the finalize function of the module library and
      * unloads the library.
@@ -50,6 +52,12 @@ class TSK_FRAMEWORK_API TskPluginModule: public TskModule
      */
     virtual void checkInterface() = 0;
 
+    /**
+     * Returns the value of the isThreadSafe function of the module library,
+     * or false if the library does not define it.
+     */
+    virtual bool isThreadSafe() const { return m_isThreadSafe; }
+
 protected:
     static const std::string GET_COMPILER_SYMBOL;
     static const std::string GET_COMPILER_VERSION_SYMBOL;
@@ -60,8 +68,14 @@ class TSK_FRAMEWORK_API TskPluginModule: public TskModule
     static const std::string VERSION_SYMBOL;
     static const std::string RUN_SYMBOL;
     static const std::string REPORT_SYMBOL;
+    static const std::string BEGIN_STREAM_SYMBOL;
+    static const std::string CONSUME_STREAM_SYMBOL;
+    static const std::string END_STREAM_SYMBOL;
+    static const std::string FREE_STREAM_CONTEXT_SYMBOL;
+    static const std::string ABORT_STREAM_SYMBOL;
     static const std::string INITIALIZE_SYMBOL;
     static const std::string FINALIZE_SYMBOL;
+    static const std::string THREAD_SAFE_SYMBOL;
 
     /** 
      * Checks whether or not the module library is loaded.
@@ -97,6 +111,7 @@ class TSK_FRAMEWORK_API TskPluginModule: public TskModule
    void validateLibraryVersionInfo();
 
     Poco::SharedLibrary m_sharedLibrary;
+    bool m_isThreadSafe;
 };
 
 #endif
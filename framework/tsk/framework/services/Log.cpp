@@ -133,6 +133,7 @@ void Log::log(Channel a_channel, const std::string &a_msg)
         break;
     }
 
+    Poco::FastMutex::ScopedLock lock(m_lock);
     if (a_msg == m_previousMessage && m_messageRepeatCount < Log::REPEAT_THRESHOLD)
         m_messageRepeatCount++;
     else
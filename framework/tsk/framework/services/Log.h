@@ -16,6 +16,7 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include "Poco/Mutex.h"
 
 // @@@ TODO: Resolve circular references between TskServices.h and this header by replacing macros with inline functions in TskServices.h
 
@@ -131,6 +132,8 @@ class TSK_FRAMEWORK_API Log
     std::string m_filePath;
     std::ofstream m_outStream;
 
+    Poco::FastMutex m_lock;     ///< Serializes messages from several threads
+
     std::string m_previousMessage;
     unsigned int m_messageRepeatCount;
 
@@ -39,6 +39,21 @@
 #define IMGDB_MAX_RETRY_COUNT 50    // how many times will we retry a SQL statement
 #define IMGDB_RETRY_WAIT 100   // how long (in milliseconds) are we willing to wait between retries
 
+/**
+ * Holds the mutex of a database connection for the life of the object, so
+ * that the statements of other threads cannot run between an INSERT and
+ * the sqlite3_last_insert_rowid() call that gets its ID.
+ */
+class TskDbLock
+{
+public:
+    TskDbLock(sqlite3 *db) : m_mutex(sqlite3_db_mutex(db)) { sqlite3_mutex_enter(m_mutex); }
+    ~TskDbLock() { sqlite3_mutex_leave(m_mutex); }
+
+private:
+    sqlite3_mutex *m_mutex;
+};
+
 /**
  * Set the database location.  Must call
  * initialize() before the object can be used.
@@ -787,6 +802,7 @@ int TskImgDBSqlite::addFsFileInfo(int fileSystemID, const TSK_FS_FILE *fileSyste
         fileSystemFile->name->type, meta_type,
         fileSystemFile->name->flags, meta_flags, size, crtime, ctime, atime,
         mtime, meta_mode, gid, uid, fullpath.c_str());
+    TskDbLock dbLock(m_db);
     char *errmsg;
     if (sqlite3_exec(m_db, stmt, NULL, NULL, &errmsg) != SQLITE_OK) 
     {
@@ -1418,6 +1434,7 @@ int TskImgDBSqlite::addCarvedFileInfo(int vol_id, const char *name, uint64_t siz
         "VALUES (NULL, %d, '%q', NULL, %d, %d, %d, %d, %llu, 0, 0, 0, 0, NULL, NULL, NULL, %d, '%q')",
         IMGDB_FILES_TYPE_CARVED, name, (int)TSK_FS_NAME_TYPE_REG, (int)TSK_FS_META_TYPE_REG,
         (int)TSK_FS_NAME_FLAG_UNALLOC, (int)TSK_FS_META_FLAG_UNALLOC, size, IMGDB_FILES_STATUS_CREATED, name);
+    TskDbLock dbLock(m_db);
     // MAY-118 NOTE: addCarvedFileInfo insert entry into files table, but actual file on disk has not been created yet.
     if (sqlite3_exec(m_db, stmt, NULL, NULL, &errmsg) != SQLITE_OK) {
         infoMessage << L"TskImgDBSqlite::addCarvedFileInfo - Error adding data to file table for carved file: " << errmsg << L" " << stmt;
@@ -1504,6 +1521,7 @@ int TskImgDBSqlite::addDerivedFileInfo(const std::string& name, const uint64_t p
         "VALUES (NULL, %d, '%q', %llu, %d, %d, %llu, %d, %d, %d, %d, %d, '%q')",
         IMGDB_FILES_TYPE_DERIVED, name.c_str(), parentId, dirType, metaType, size, ctime, crtime, atime, mtime, IMGDB_FILES_STATUS_CREATED, path.c_str());
 
+    TskDbLock dbLock(m_db);
     if (sqlite3_exec(m_db, stmt, NULL, NULL, &errmsg) != SQLITE_OK) 
     {
         std::wstringstream msg;
@@ -2650,6 +2668,7 @@ int TskImgDBSqlite::addModule(const std::string& name, const std::string& descri
 
     sqlite3_stmt * statement;
     char stmt[1024];
+    TskDbLock dbLock(m_db);
     sqlite3_snprintf(1024, stmt, "SELECT module_id FROM modules WHERE name = '%q';",
                      name.c_str());
 
@@ -2879,6 +2898,7 @@ int TskImgDBSqlite::addUnallocImg(int & unallocImgId)
     std::stringstream stmt;
     stmt << "INSERT INTO unalloc_img_status (unalloc_img_id, status) VALUES (NULL, " << TskImgDB::IMGDB_UNALLOC_IMG_STATUS_CREATED << ")";
     char * errmsg;
+    TskDbLock dbLock(m_db);
     if (sqlite3_exec(m_db, stmt.str().c_str(), NULL, NULL, &errmsg) == SQLITE_OK) {
         unallocImgId = (int)sqlite3_last_insert_rowid(m_db);
         rc = 0;
@@ -3096,6 +3116,7 @@ int TskImgDBSqlite::addUnusedSector(uint64_t sectStart, uint64_t sectEnd, int vo
             << TSK_FS_NAME_FLAG_UNALLOC << ", " << TSK_FS_META_FLAG_UNALLOC << ", "
             << (thisSectEnd - thisSectStart) * 512 << ", NULL, NULL, NULL, NULL, NULL, NULL, NULL, " << IMGDB_FILES_STATUS_READY_FOR_ANALYSIS << "," << "'ufile'" << ")";
 
+        TskDbLock dbLock(m_db);
         if (sqlite3_exec(m_db, stmt.str().c_str(), NULL, NULL, NULL) == SQLITE_OK) {
 
             TskUnusedSectorsRecord record;
@@ -3580,6 +3601,7 @@ TskBlackboardArtifact TskImgDBSqlite::createBlackboardArtifact(uint64_t file_id,
     std::stringstream str;
     sqlite3_stmt * statement;
 
+    TskDbLock dbLock(m_db);
     str << "INSERT INTO blackboard_artifacts (artifact_id, obj_id, artifact_type_id) VALUES (NULL, " << file_id << ", " << artifactTypeID << ")";
 
     if (sqlite3_prepare_v2(m_db, str.str().c_str(), -1, &statement, 0) == SQLITE_OK) {
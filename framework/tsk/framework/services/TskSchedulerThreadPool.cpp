@@ -0,0 +1,264 @@
+/*
+ * The Sleuth Kit
+ *
+ * Contact: Brian Carrier [carrier <at> sleuthkit [dot] org]
+ * Copyright (c) 2012 Basis Technology Corporation. All Rights
+ * reserved.
+ *
+ * This software is distributed under the Common Public License 1.0
+ */
+
+/**
+ * \file TskSchedulerThreadPool.cpp
+ * Contains the implementation of the TskSchedulerThreadPool class.
+ */
+
+// Include the class definition first to ensure it does not depend on subsequent includes in this file.
+#include "TskSchedulerThreadPool.h"
+
+#include "Poco/Runnable.h"
+
+const uint64_t TskSchedulerThreadPool::DEFAULT_BATCH_SIZE = 16;
+
+// Milliseconds that an idle thread waits before it looks for tasks again.
+static const long IDLE_WAIT_MS = 50;
+
+/**
+ * Runs the tasks of one thread of the pool.
+ */
+class TskSchedulerThreadPool::Worker : public Poco::Runnable {
+public:
+    Worker(TskSchedulerThreadPool &pool, size_t queueIdx, TaskRunner *runner)
+        : m_pool(pool), m_queueIdx(queueIdx), m_runner(runner) {}
+
+    void run() {
+        m_pool.runWorker(m_queueIdx, m_runner);
+    }
+
+private:
+    TskSchedulerThreadPool &m_pool;
+    size_t m_queueIdx;
+    TaskRunner *m_runner;
+};
+
+TskSchedulerThreadPool::TskSchedulerThreadPool(uint64_t batchSize)
+    : m_batchSize(batchSize > 0 ? batchSize : 1), m_pending(0), m_nextQueue(0)
+{
+    m_queues.push_back(new TaskQueue());
+}
+
+TskSchedulerThreadPool::~TskSchedulerThreadPool()
+{
+    for (size_t i = 0; i < m_queues.size(); i++)
+        delete m_queues[i];
+}
+
+int TskSchedulerThreadPool::schedule(Scheduler::TaskType task, uint64_t startId, uint64_t endId)
+{
+    if (endId < startId) {
+        // @@@ Log a message
+        return -1;
+    }
+
+    // Tasks scheduled by a task go to the queue of the thread that runs it
+    size_t queueIdx;
+    {
+        Poco::FastMutex::ScopedLock lock(m_lock);
+        std::map<Poco::Thread *, size_t>::const_iterator it =
+            m_threadQueues.find(Poco::Thread::current());
+        if (it != m_threadQueues.end()) {
+            queueIdx = it->second;
+        }
+        else {
+            queueIdx = m_nextQueue;
+            m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+        }
+        m_pending += endId - startId + 1;
+    }
+
+    task_range range;
+    range.task = task;
+    range.startId = startId;
+    range.endId = endId;
+    {
+        Poco::FastMutex::ScopedLock lock(m_queues[queueIdx]->lock);
+        m_queues[queueIdx]->ranges.push_back(range);
+    }
+    m_workEvent.set();
+    return 0;
+}
+
+Scheduler::task_struct *TskSchedulerThreadPool::nextTask()
+{
+    for (size_t i = 0; i < m_queues.size(); i++) {
+        TaskQueue *queue = m_queues[i];
+        Poco::FastMutex::ScopedLock lock(queue->lock);
+        if (queue->ranges.empty())
+            continue;
+
+        task_range &range = queue->ranges.front();
+        task_struct *t = new(task_struct);
+        t->task = range.task;
+        t->id = range.startId;
+        if (range.startId == range.endId)
+            queue->ranges.pop_front();
+        else
+            range.startId++;
+
+        finishTasks(1);
+        return t;
+    }
+    return NULL;
+}
+
+void TskSchedulerThreadPool::run(const std::vector<TaskRunner *> &runners)
+{
+    if (runners.empty())
+        return;
+
+    while (m_queues.size() < runners.size())
+        m_queues.push_back(new TaskQueue());
+
+    std::vector<Poco::Thread *> threads;
+    std::vector<Worker *> workers;
+    for (size_t i = 0; i < runners.size(); i++) {
+        Poco::Thread *thread = new Poco::Thread();
+        {
+            Poco::FastMutex::ScopedLock lock(m_lock);
+            m_threadQueues[thread] = i;
+        }
+        threads.push_back(thread);
+        workers.push_back(new Worker(*this, i, runners[i]));
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i]->start(*workers[i]);
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i]->join();
+        delete threads[i];
+        delete workers[i];
+    }
+
+    Poco::FastMutex::ScopedLock lock(m_lock);
+    m_threadQueues.clear();
+    m_nextQueue = 0;
+}
+
+/**
+ * Take the next batch of IDs from a queue. The thread that owns the queue
+ * takes from its newest range, so that the tasks scheduled by a task are
+ * run soon after it.
+ * @param queueIdx Queue to take from
+ * @param batch [out] IDs to run
+ * @returns true if there was anything in the queue
+ */
+bool TskSchedulerThreadPool::takeBatch(size_t queueIdx, task_range &batch)
+{
+    TaskQueue *queue = m_queues[queueIdx];
+    Poco::FastMutex::ScopedLock lock(queue->lock);
+    if (queue->ranges.empty())
+        return false;
+
+    task_range &range = queue->ranges.back();
+    batch = range;
+    if (range.endId - range.startId < m_batchSize) {
+        queue->ranges.pop_back();
+    }
+    else {
+        batch.endId = range.startId + m_batchSize - 1;
+        range.startId = batch.endId + 1;
+    }
+    return true;
+}
+
+/**
+ * Move tasks from the queue of another thread to the queue of a thread.
+ * The oldest range of the other queue is taken, or the second half of it
+ * if it is the only one.
+ * @param queueIdx Queue of the thread that is looking for tasks
+ * @returns true if tasks were moved
+ */
+bool TskSchedulerThreadPool::stealRange(size_t queueIdx)
+{
+    for (size_t i = 1; i < m_queues.size(); i++) {
+        TaskQueue *victim = m_queues[(queueIdx + i) % m_queues.size()];
+        task_range stolen;
+        {
+            Poco::FastMutex::ScopedLock lock(victim->lock);
+            if (victim->ranges.empty())
+                continue;
+
+            task_range &range = victim->ranges.front();
+            if ((victim->ranges.size() > 1) || (range.startId == range.endId)) {
+                stolen = range;
+                victim->ranges.pop_front();
+            }
+            else {
+                stolen = range;
+                stolen.startId = range.startId + (range.endId - range.startId + 1) / 2;
+                range.endId = stolen.startId - 1;
+            }
+        }
+
+        Poco::FastMutex::ScopedLock lock(m_queues[queueIdx]->lock);
+        m_queues[queueIdx]->ranges.push_back(stolen);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Main loop of a thread of the pool. Runs tasks until there are none left
+ * in any queue and no task is running (that could schedule more).
+ * @param queueIdx Queue of the thread
+ * @param runner Runner of the thread
+ */
+void TskSchedulerThreadPool::runWorker(size_t queueIdx, TaskRunner *runner)
+{
+    while (true) {
+        task_range batch;
+        if (takeBatch(queueIdx, batch) || (stealRange(queueIdx) && takeBatch(queueIdx, batch))) {
+            for (uint64_t id = batch.startId; ; id++) {
+                task_struct t;
+                t.task = batch.task;
+                t.id = id;
+                try {
+                    runner->runTask(t);
+                }
+                catch (...) {
+                    // Error message has been logged already.
+                }
+                if (id == batch.endId)
+                    break;
+            }
+            finishTasks(batch.endId - batch.startId + 1);
+            continue;
+        }
+
+        {
+            Poco::FastMutex::ScopedLock lock(m_lock);
+            if (m_pending == 0)
+                break;
+        }
+        m_workEvent.tryWait(IDLE_WAIT_MS);
+    }
+
+    // wake up the next idle thread so that it also sees that we are done
+    m_workEvent.set();
+}
+
+/**
+ * Records that tasks were run.
+ * @param count Number of IDs that were run
+ */
+void TskSchedulerThreadPool::finishTasks(uint64_t count)
+{
+    bool done;
+    {
+        Poco::FastMutex::ScopedLock lock(m_lock);
+        m_pending -= count;
+        done = (m_pending == 0);
+    }
+    if (done)
+        m_workEvent.set();
+}
@@ -0,0 +1,110 @@
+/*
+ * The Sleuth Kit
+ *
+ * Contact: Brian Carrier [carrier <at> sleuthkit [dot] org]
+ * Copyright (c) 2012 Basis Technology Corporation. All Rights
+ * reserved.
+ *
+ * This software is distributed under the Common Public License 1.0
+ */
+
+#ifndef TSK_SCHEDULER_THREAD_POOL
+#define TSK_SCHEDULER_THREAD_POOL
+
+#include "Scheduler.h"
+
+#include "Poco/Event.h"
+#include "Poco/Mutex.h"
+#include "Poco/Thread.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+/**
+ * Implementation of the Scheduler interface that runs the tasks with a
+ * pool of threads. Each thread has its own queue of tasks and takes tasks
+ * from the queues of the other threads when its own queue is empty. The
+ * IDs of a range given to schedule() are kept together in a queue and a
+ * thread takes up to a batch of consecutive IDs at a time. A range is only
+ * split when a thread takes half of it from the queue of another thread.
+ *
+ * Tasks that are scheduled by a task go to the queue of the thread that
+ * runs it. Until run() is called, the tasks can also be taken one at a
+ * time with nextTask(), in the order that they were scheduled, as with
+ * TskSchedulerQueue.
+ */
+class TSK_FRAMEWORK_API TskSchedulerThreadPool : public Scheduler {
+public:
+    /**
+     * Interface for the classes that run the tasks of a thread. Each thread
+     * of the pool has its own runner, which can keep objects that are not
+     * shared with the other threads (such as a pipeline).
+     */
+    class TSK_FRAMEWORK_API TaskRunner {
+    public:
+        virtual ~TaskRunner() {}
+
+        /**
+         * Run a task. Exceptions are caught and ignored by the pool (the
+         * runner is expected to log errors).
+         * @param task Task to run
+         */
+        virtual void runTask(const Scheduler::task_struct &task) = 0;
+    };
+
+    /// Number of consecutive IDs that a thread takes from its queue by default.
+    static const uint64_t DEFAULT_BATCH_SIZE;
+
+    /**
+     * @param batchSize Maximum number of consecutive IDs that a thread
+     * takes from its queue at a time.
+     */
+    TskSchedulerThreadPool(uint64_t batchSize = DEFAULT_BATCH_SIZE);
+    virtual ~TskSchedulerThreadPool();
+
+    int schedule(Scheduler::TaskType task, uint64_t startId, uint64_t endId);
+    task_struct *nextTask();
+
+    /**
+     * Runs the scheduled tasks, and the tasks that they schedule, with one
+     * thread for each runner. Returns once all of them have been run.
+     * @param runners Runners of the threads (at least one)
+     */
+    void run(const std::vector<TaskRunner *> &runners);
+
+private:
+    /// Consecutive IDs to run the same task on.
+    typedef struct {
+        Scheduler::TaskType task;
+        uint64_t startId;
+        uint64_t endId;
+    } task_range;
+
+    /// Queue of a thread.
+    struct TaskQueue {
+        Poco::FastMutex lock;   ///< Protects ranges
+        std::deque<task_range> ranges;
+    };
+
+    class Worker;
+
+    // Disallow copying
+    TskSchedulerThreadPool(const TskSchedulerThreadPool&);
+    TskSchedulerThreadPool& operator=(const TskSchedulerThreadPool&);
+
+    bool takeBatch(size_t queueIdx, task_range &batch);
+    bool stealRange(size_t queueIdx);
+    void runWorker(size_t queueIdx, TaskRunner *runner);
+    void finishTasks(uint64_t count);
+
+    uint64_t m_batchSize;
+    std::vector<TaskQueue *> m_queues;  ///< Queue of each thread (one when run() is not running)
+    Poco::FastMutex m_lock;     ///< Protects the members below
+    uint64_t m_pending;         ///< Number of scheduled IDs that have not been run
+    size_t m_nextQueue;         ///< Queue for tasks scheduled by threads outside of the pool
+    std::map<Poco::Thread *, size_t> m_threadQueues;    ///< Queue of each thread of the pool
+    Poco::Event m_workEvent;    ///< Signaled when tasks are scheduled or all are done
+};
+
+#endif
@@ -0,0 +1,424 @@
+/*
+* The Sleuth Kit
+*
+* Brian Carrier [carrier <at> sleuthkit [dot] org]
+* Copyright (c) 2008-2011 Brian Carrier.  All Rights reserved
+*
+*
+* This software is distributed under the Common Public License 1.0
+*
+*/
+
+/* Add an image to a case database in different ways (interrupted and
+ * resumed, or with several threads, for example) and compare the
+ * databases that result */
+
+#include "tsk/tsk_tools_i.h"
+#include "tsk/auto/tsk_case_db.h"
+#include "tsk/auto/tsk_db_sqlite.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/* Number of files that are added between checkpoints */
+#define CHECKPOINT_INTERVAL 4
+
+/* Exit code of the process that is killed while it adds the image */
+#define INTERRUPT_EXIT 3
+
+/* Tables whose contents have to be the same in the compared databases */
+static const char *const compare_tables[] = {
+    "tsk_objects", "tsk_image_info", "tsk_vs_info", "tsk_vs_parts",
+    "tsk_fs_info", "tsk_files", "tsk_file_layout", NULL
+};
+
+/* Deleted and orphan files, whose metadata is loaded from a name that is
+ * not allocated.  They are compared on their own so that it is clear when
+ * they differ and when an image has none of them. */
+#define COMPARE_FILE_COLUMNS \
+    "parent_path, name, meta_addr, meta_seq, meta_flags, size, ctime, " \
+    "crtime, atime, mtime, mode, md5 FROM tsk_files WHERE type = 0 AND "
+
+static const char *const compare_files[][2] = {
+    { "deleted files", "SELECT " COMPARE_FILE_COLUMNS
+        "dir_flags = 2 AND parent_path NOT LIKE '/$OrphanFiles/%'" },
+    { "orphan files", "SELECT " COMPARE_FILE_COLUMNS
+        "parent_path LIKE '/$OrphanFiles/%'" },
+    { NULL, NULL }
+};
+
+/* Indexes that are created after the files have been added */
+static const char *const deferred_indexes[] = {
+    "parObjId", "layout_objID", "mime_type", "file_extension", NULL
+};
+
+static const TSK_TCHAR *progname;
+
+static void
+usage()
+{
+    TFPRINTF(stderr,
+        _TSK_T("usage: %s add db image [vol_threads [hash_threads]]\n")
+        _TSK_T("       %s interrupt db image num_files\n")
+        _TSK_T("       %s resume db image\n")
+        _TSK_T("       %s compare db1 db2 [unalloc]\n"), progname, progname,
+        progname, progname);
+    exit(1);
+}
+
+/* TskAutoDb that ends the process, without committing or closing
+ * anything, once it has added a number of files */
+class InterruptAutoDb:public TskAutoDb {
+  public:
+    InterruptAutoDb(TskDb * a_db, unsigned int a_numFiles)
+    :TskAutoDb(a_db, NULL, NULL), m_numFiles(a_numFiles), m_count(0) {
+    }
+
+    virtual TSK_RETVAL_ENUM processFile(TSK_FS_FILE * fs_file,
+        const char *path) {
+        TSK_RETVAL_ENUM retval = TskAutoDb::processFile(fs_file, path);
+        if (++m_count == m_numFiles) {
+            printf("Interrupted after %u files\n", m_count);
+            fflush(stdout);
+            std::_Exit(INTERRUPT_EXIT);
+        }
+        return retval;
+    }
+
+  private:
+    unsigned int m_numFiles;
+    unsigned int m_count;
+};
+
+/* Print the errors of an add image process
+* @returns 1 if there were errors
+*/
+static int
+print_errors(TskAutoDb * a_autoDb)
+{
+    std::vector < TskAuto::error_record > errors = a_autoDb->getErrorList();
+    for (size_t i = 0; i < errors.size(); i++) {
+        fprintf(stderr, "Error: %s\n",
+            TskAuto::errorRecordToString(errors[i]).c_str());
+    }
+    return errors.empty() ? 0 : 1;
+}
+
+/* Add the image to the database, starting a new add or resuming one.
+* The files are hashed.
+* @param a_numFiles Number of files after which to end the process (0 to
+* add all of them)
+* @param a_volThreads Number of volume threads (see setVolumeThreads())
+* @param a_hashThreads Number of hashing threads (see setHashThreads())
+* @returns 1 on error
+*/
+static int
+add_image(const TSK_TCHAR * a_db, const TSK_TCHAR * a_image, bool a_create,
+    bool a_resume, unsigned int a_numFiles, unsigned int a_volThreads,
+    unsigned int a_hashThreads)
+{
+    TskDbSqlite *db = new TskDbSqlite(a_db, true);
+    TskAutoDb *autoDb;
+    int retval = 0;
+
+    if (db->open(a_create)) {
+        tsk_error_print(stderr);
+        delete db;
+        return 1;
+    }
+
+    if (a_numFiles)
+        autoDb = new InterruptAutoDb(db, a_numFiles);
+    else
+        autoDb = new TskAutoDb(db, NULL, NULL);
+    autoDb->setAddUnallocSpace(true);
+    autoDb->hashFiles(true);
+    autoDb->setVolumeThreads(a_volThreads);
+    autoDb->setHashThreads(a_hashThreads);
+    if ((a_numFiles) || (a_resume))
+        autoDb->setCheckpointInterval(CHECKPOINT_INTERVAL);
+
+    // the image is the first object in the new database
+    if (a_resume)
+        retval = autoDb->resumeAddImage(1, 1, &a_image, TSK_IMG_TYPE_DETECT, 0);
+    else
+        retval = autoDb->startAddImage(1, &a_image, TSK_IMG_TYPE_DETECT, 0);
+    if ((retval) && (print_errors(autoDb) == 0))
+        tsk_error_print(stderr);
+
+    if (autoDb->commitAddImage() == -1) {
+        tsk_error_print(stderr);
+        retval = 1;
+    }
+    autoDb->closeImage();
+    delete autoDb;
+
+    if (db->close()) {
+        tsk_error_print(stderr);
+        retval = 1;
+    }
+    delete db;
+    return retval ? 1 : 0;
+}
+
+/* Open a database to compare it
+* @returns NULL on error
+*/
+static sqlite3 *
+open_db(const TSK_TCHAR * a_db)
+{
+    sqlite3 *db = NULL;
+#ifdef TSK_WIN32
+    int result = sqlite3_open16(a_db, &db);
+#else
+    int result = sqlite3_open(a_db, &db);
+#endif
+    if (result != SQLITE_OK) {
+        TFPRINTF(stderr, _TSK_T("Error opening database %s\n"), a_db);
+        sqlite3_close(db);
+        return NULL;
+    }
+    return db;
+}
+
+/* Get the rows of a query as sorted lines of text
+* @returns 1 on error
+*/
+static int
+get_rows(sqlite3 * a_db, const std::string & a_sql,
+    std::vector < std::string > &a_rows)
+{
+    sqlite3_stmt *stmt = NULL;
+    int result;
+
+    a_rows.clear();
+    if (sqlite3_prepare_v2(a_db, a_sql.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Error preparing %s: %s\n", a_sql.c_str(),
+            sqlite3_errmsg(a_db));
+        return 1;
+    }
+    while ((result = sqlite3_step(stmt)) == SQLITE_ROW) {
+        std::string row;
+        for (int i = 0; i < sqlite3_column_count(stmt); i++) {
+            const char *text = (const char *) sqlite3_column_text(stmt, i);
+            row += text ? text : "NULL";
+            row += '|';
+        }
+        a_rows.push_back(row);
+    }
+    sqlite3_finalize(stmt);
+    if (result != SQLITE_DONE) {
+        fprintf(stderr, "Error running %s: %s\n", a_sql.c_str(),
+            sqlite3_errmsg(a_db));
+        return 1;
+    }
+    std::sort(a_rows.begin(), a_rows.end());
+    return 0;
+}
+
+/* Check that the add image process finished with a database
+* @returns 1 if it did not
+*/
+static int
+check_finished(sqlite3 * a_db, const TSK_TCHAR * a_name)
+{
+    std::vector < std::string > rows;
+
+    for (int i = 0; deferred_indexes[i] != NULL; i++) {
+        if (get_rows(a_db,
+                std::string("SELECT name FROM sqlite_master WHERE type = 'index' AND name = '")
+                + deferred_indexes[i] + "'", rows))
+            return 1;
+        if (rows.empty()) {
+            TFPRINTF(stderr, _TSK_T("%s: index is missing: "), a_name);
+            fprintf(stderr, "%s\n", deferred_indexes[i]);
+            return 1;
+        }
+    }
+
+    if (get_rows(a_db,
+            "SELECT name FROM tsk_db_info_extended WHERE name = '"
+            TSK_DB_SQLITE_DEFERRED_INDEXES_KEY "'", rows))
+        return 1;
+    if (rows.empty() == false) {
+        TFPRINTF(stderr, _TSK_T("%s: indexes are still marked as pending\n"),
+            a_name);
+        return 1;
+    }
+
+    // tsk_add_image_checkpoints is only there if checkpoints were saved
+    if ((get_rows(a_db,
+                "SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'tsk_add_image_checkpoints'",
+                rows) == 0) && (rows.empty() == false)) {
+        if (get_rows(a_db, "SELECT obj_id FROM tsk_add_image_checkpoints",
+                rows))
+            return 1;
+        if (rows.empty() == false) {
+            TFPRINTF(stderr, _TSK_T("%s: checkpoint was not deleted\n"),
+                a_name);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Compare the rows of a query in two databases
+* @returns 1 if they are not the same
+*/
+static int
+compare_rows(sqlite3 * a_db1, sqlite3 * a_db2, const char *a_name,
+    const std::string & a_sql, size_t * a_count)
+{
+    std::vector < std::string > rows1, rows2;
+
+    if (get_rows(a_db1, a_sql, rows1) || get_rows(a_db2, a_sql, rows2))
+        return 1;
+    if (rows1.size() != rows2.size()) {
+        fprintf(stderr, "%s: %zu rows and %zu rows\n", a_name,
+            rows1.size(), rows2.size());
+        return 1;
+    }
+    for (size_t r = 0; r < rows1.size(); r++) {
+        if (rows1[r] != rows2[r]) {
+            fprintf(stderr, "%s: row %zu differs:\n  %s\n  %s\n", a_name,
+                r, rows1[r].c_str(), rows2[r].c_str());
+            return 1;
+        }
+    }
+    printf("%s: %zu rows\n", a_name, rows1.size());
+    *a_count = rows1.size();
+    return 0;
+}
+
+/* Compare the contents of two databases
+* @param a_unalloc Fail if there are no deleted or no orphan files with
+* metadata to compare
+* @returns 1 if they are not the same
+*/
+static int
+compare_dbs(const TSK_TCHAR * a_db1, const TSK_TCHAR * a_db2,
+    bool a_unalloc)
+{
+    sqlite3 *db1, *db2;
+    int retval = 0;
+
+    if ((db1 = open_db(a_db1)) == NULL)
+        return 1;
+    if ((db2 = open_db(a_db2)) == NULL) {
+        sqlite3_close(db1);
+        return 1;
+    }
+
+    if (check_finished(db1, a_db1) || check_finished(db2, a_db2))
+        retval = 1;
+
+    for (int i = 0; (retval == 0) && (compare_tables[i] != NULL); i++) {
+        size_t count;
+        if (compare_rows(db1, db2, compare_tables[i],
+                std::string("SELECT * FROM ") + compare_tables[i], &count))
+            retval = 1;
+    }
+
+    for (int i = 0; (retval == 0) && (compare_files[i][0] != NULL); i++) {
+        size_t count;
+        if (compare_rows(db1, db2, compare_files[i][0], compare_files[i][1],
+                &count)) {
+            retval = 1;
+            break;
+        }
+        if (a_unalloc == false)
+            continue;
+
+        // the single thread add gives these files their metadata, so
+        // there has to be some to compare
+        std::string name = std::string(compare_files[i][0]) +
+            " with metadata";
+        if (compare_rows(db1, db2, name.c_str(),
+                std::string(compare_files[i][1]) + " AND size > 0",
+                &count)) {
+            retval = 1;
+        }
+        else if (count == 0) {
+            fprintf(stderr, "%s: no rows\n", name.c_str());
+            retval = 1;
+        }
+    }
+
+    sqlite3_close(db1);
+    sqlite3_close(db2);
+    return retval;
+}
+
+int
+main(int argc, char **argv1)
+{
+    TSK_TCHAR **argv;
+    TSK_TCHAR *cp;
+    int retval;
+
+#ifdef TSK_WIN32
+    // On Windows, get the wide arguments (mingw doesn't support wmain)
+    argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv == NULL) {
+        fprintf(stderr, "Error getting wide arguments\n");
+        exit(1);
+    }
+#else
+    argv = (TSK_TCHAR **) argv1;
+#endif
+    progname = argv[0];
+
+    if (argc < 4)
+        usage();
+
+    if (TSTRCMP(argv[1], _TSK_T("add")) == 0) {
+        unsigned int threads[2] = { 0, 0 };
+        if (argc > 6)
+            usage();
+        for (int i = 4; i < argc; i++) {
+            threads[i - 4] = (unsigned int) TSTRTOUL(argv[i], &cp, 0);
+            if (*cp || *cp == *argv[i])
+                usage();
+        }
+        retval = add_image(argv[2], argv[3], true, false, 0, threads[0],
+            threads[1]);
+    }
+    else if (TSTRCMP(argv[1], _TSK_T("interrupt")) == 0) {
+        unsigned int numFiles;
+        if (argc != 5)
+            usage();
+        numFiles = (unsigned int) TSTRTOUL(argv[4], &cp, 0);
+        if (*cp || *cp == *argv[4] || numFiles < 1)
+            usage();
+        add_image(argv[2], argv[3], true, false, numFiles, 0, 0);
+
+        // the process should have ended while the image was being added
+        fprintf(stderr, "Image was added before it was interrupted\n");
+        retval = 1;
+    }
+    else if (TSTRCMP(argv[1], _TSK_T("resume")) == 0) {
+        if (argc != 4)
+            usage();
+        retval = add_image(argv[2], argv[3], false, true, 0, 0, 0);
+    }
+    else if (TSTRCMP(argv[1], _TSK_T("compare")) == 0) {
+        if ((argc == 5) && (TSTRCMP(argv[4], _TSK_T("unalloc")) == 0))
+            retval = compare_dbs(argv[2], argv[3], true);
+        else if (argc == 4)
+            retval = compare_dbs(argv[2], argv[3], false);
+        else {
+            usage();
+            retval = 1;
+        }
+    }
+    else {
+        usage();
+        retval = 1;
+    }
+
+    if (retval == 0)
+        printf("Tests Passed\n");
+    return retval;
+}
@@ -0,0 +1,77 @@
+#!/bin/bash
+
+# Interrupt the adding of an ext2 image to a database, resume it and
+# compare the database with one that the image was added to in one go.
+
+EXIT_SUCCESS=0;
+EXIT_FAILURE=1;
+EXIT_IGNORE=77;
+
+IMAGE=add_image_resume.img
+FULL_DB=add_image_resume_full.db
+RESUMED_DB=add_image_resume_resumed.db
+
+if ! which mke2fs > /dev/null 2>&1 || ! which debugfs > /dev/null 2>&1;
+then
+	echo "Missing mke2fs or debugfs";
+
+	exit ${EXIT_IGNORE};
+fi
+
+ADD_IMAGE_TEST="./add_image_db";
+
+if ! test -x ${ADD_IMAGE_TEST};
+then
+	ADD_IMAGE_TEST="./add_image_db.exe";
+fi
+
+if ! test -x ${ADD_IMAGE_TEST};
+then
+	echo "Missing test executable: add_image_db";
+
+	exit ${EXIT_IGNORE};
+fi
+
+rm -f ${IMAGE} ${IMAGE}.cmds ${FULL_DB} ${RESUMED_DB}
+dd if=/dev/zero of=${IMAGE} bs=1024 count=8192 2> /dev/null
+mke2fs -q -F -t ext2 -b 1024 ${IMAGE} || exit ${EXIT_FAILURE};
+
+for D in 0 1 2 3 4;
+do
+	echo "mkdir d${D}" >> ${IMAGE}.cmds;
+	for F in 0 1 2 3 4 5 6 7;
+	do
+		echo "write ${0} d${D}/f${F}" >> ${IMAGE}.cmds;
+	done;
+	echo "rm d${D}/f3" >> ${IMAGE}.cmds;
+done;
+debugfs -w -f ${IMAGE}.cmds ${IMAGE} > /dev/null 2>&1 || exit ${EXIT_FAILURE};
+
+RESULT=${EXIT_SUCCESS};
+
+${ADD_IMAGE_TEST} add ${FULL_DB} ${IMAGE} > /dev/null || RESULT=${EXIT_FAILURE};
+
+# The process ends in the middle of the third directory, after several
+# checkpoints were saved
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	${ADD_IMAGE_TEST} interrupt ${RESUMED_DB} ${IMAGE} 23
+	if test $? -ne 3;
+	then
+		RESULT=${EXIT_FAILURE};
+	fi
+fi
+
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	${ADD_IMAGE_TEST} resume ${RESUMED_DB} ${IMAGE} > /dev/null || RESULT=${EXIT_FAILURE};
+fi
+
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	${ADD_IMAGE_TEST} compare ${FULL_DB} ${RESUMED_DB} || RESULT=${EXIT_FAILURE};
+fi
+
+rm -f ${IMAGE} ${IMAGE}.cmds ${FULL_DB} ${RESUMED_DB}
+
+exit ${RESULT};
@@ -0,0 +1,118 @@
+#!/bin/bash
+
+# Add an image with several ext2 volumes, which have deleted and orphan
+# files, to a database with hashing threads and with volume and hashing
+# threads and compare the databases with one that was made with a single
+# thread.  The deleted and orphan files are compared on their own and
+# have to have their metadata.
+
+EXIT_SUCCESS=0;
+EXIT_FAILURE=1;
+EXIT_IGNORE=77;
+
+IMAGE=add_image_threads.img
+SINGLE_DB=add_image_threads_single.db
+HASH_DB=add_image_threads_hash.db
+THREADS_DB=add_image_threads_threads.db
+NTHREADS=3
+
+if ! which mke2fs > /dev/null 2>&1 || ! which debugfs > /dev/null 2>&1;
+then
+	echo "Missing mke2fs or debugfs";
+
+	exit ${EXIT_IGNORE};
+fi
+
+ADD_IMAGE_TEST="./add_image_db";
+
+if ! test -x ${ADD_IMAGE_TEST};
+then
+	ADD_IMAGE_TEST="./add_image_db.exe";
+fi
+
+if ! test -x ${ADD_IMAGE_TEST};
+then
+	echo "Missing test executable: add_image_db";
+
+	exit ${EXIT_IGNORE};
+fi
+
+# Write a 32-bit little endian value
+le32()
+{
+	for SHIFT in 0 8 16 24;
+	do
+		printf "\\$(printf %03o $(( ($1 >> ${SHIFT}) & 255 )))";
+	done;
+}
+
+# Three 4 MB Linux partitions in a DOS partition table, with a gap
+# between the first two for an unallocated volume
+START[1]=2048
+START[2]=12288
+START[3]=20480
+SIZE=8192
+
+rm -f ${IMAGE} ${IMAGE}.part ${IMAGE}.cmds ${SINGLE_DB} ${HASH_DB} ${THREADS_DB}
+dd if=/dev/zero of=${IMAGE} bs=512 count=30720 2> /dev/null
+
+for P in 1 2 3;
+do
+	dd if=/dev/zero of=${IMAGE}.part bs=512 count=${SIZE} 2> /dev/null
+	mke2fs -q -F -t ext2 -b 1024 ${IMAGE}.part || exit ${EXIT_FAILURE};
+
+	rm -f ${IMAGE}.cmds
+	for D in 0 1 2;
+	do
+		echo "mkdir p${P}d${D}" >> ${IMAGE}.cmds;
+		for F in 0 1 2 3 4 5;
+		do
+			echo "write ${0} p${P}d${D}/f${F}" >> ${IMAGE}.cmds;
+		done;
+		echo "rm p${P}d${D}/f2" >> ${IMAGE}.cmds;
+	done;
+
+	# An entry that starts a directory block is cleared when it is
+	# removed, which leaves its inode as an orphan file
+	echo "mkdir p${P}o" >> ${IMAGE}.cmds;
+	for F in 0 1 2 3 4;
+	do
+		echo "write ${0} p${P}o/$(printf "%0200d" ${F})" >> ${IMAGE}.cmds;
+	done;
+	echo "rm p${P}o/$(printf "%0200d" 4)" >> ${IMAGE}.cmds;
+	debugfs -w -f ${IMAGE}.cmds ${IMAGE}.part > /dev/null 2>&1 || exit ${EXIT_FAILURE};
+
+	dd if=${IMAGE}.part of=${IMAGE} bs=512 seek=${START[${P}]} conv=notrunc 2> /dev/null
+
+	( printf '\000\000\000\000\203\000\000\000'; le32 ${START[${P}]}; le32 ${SIZE} ) | \
+		dd of=${IMAGE} bs=1 seek=$(( 446 + 16 * (P - 1) )) conv=notrunc 2> /dev/null
+done;
+printf '\125\252' | dd of=${IMAGE} bs=1 seek=510 conv=notrunc 2> /dev/null
+
+RESULT=${EXIT_SUCCESS};
+
+${ADD_IMAGE_TEST} add ${SINGLE_DB} ${IMAGE} > /dev/null || RESULT=${EXIT_FAILURE};
+
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	${ADD_IMAGE_TEST} add ${HASH_DB} ${IMAGE} 0 ${NTHREADS} > /dev/null || RESULT=${EXIT_FAILURE};
+fi
+
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	${ADD_IMAGE_TEST} compare ${SINGLE_DB} ${HASH_DB} unalloc || RESULT=${EXIT_FAILURE};
+fi
+
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	${ADD_IMAGE_TEST} add ${THREADS_DB} ${IMAGE} ${NTHREADS} ${NTHREADS} > /dev/null || RESULT=${EXIT_FAILURE};
+fi
+
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	${ADD_IMAGE_TEST} compare ${SINGLE_DB} ${THREADS_DB} unalloc || RESULT=${EXIT_FAILURE};
+fi
+
+rm -f ${IMAGE} ${IMAGE}.part ${IMAGE}.cmds ${SINGLE_DB} ${HASH_DB} ${THREADS_DB}
+
+exit ${RESULT};
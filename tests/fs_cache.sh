@@ -0,0 +1,118 @@
+#!/bin/bash
+
+# List an ext2 image that has orphan files with fls and a sidecar cache
+# directory.  The second listing has to load the cache file and give the
+# same output as the first one and as a listing without the cache.  Once
+# the image is changed, the cache file has to be made again instead of
+# being loaded.
+
+EXIT_SUCCESS=0;
+EXIT_FAILURE=1;
+EXIT_IGNORE=77;
+
+IMAGE=fs_cache.img
+CACHE_DIR=fs_cache.dir
+
+if ! which mke2fs > /dev/null 2>&1 || ! which debugfs > /dev/null 2>&1;
+then
+	echo "Missing mke2fs or debugfs";
+
+	exit ${EXIT_IGNORE};
+fi
+
+FLS="../tools/fstools/fls";
+
+if ! test -x ${FLS};
+then
+	FLS="../tools/fstools/fls.exe";
+fi
+
+if ! test -x ${FLS};
+then
+	echo "Missing tool: fls";
+
+	exit ${EXIT_IGNORE};
+fi
+
+# Make orphan files by clearing the block of the directory that names them
+# @param $1 Name of the directory to make
+make_orphans()
+{
+	rm -f ${IMAGE}.cmds
+	echo "mkdir ${1}" >> ${IMAGE}.cmds;
+	for F in 0 1 2 3;
+	do
+		echo "write ${0} ${1}/f${F}" >> ${IMAGE}.cmds;
+	done;
+	echo "kill_file ${1}/f0" >> ${IMAGE}.cmds;
+	echo "kill_file ${1}/f1" >> ${IMAGE}.cmds;
+	echo "zap_block -f ${1} 0" >> ${IMAGE}.cmds;
+	debugfs -w -f ${IMAGE}.cmds ${IMAGE} > /dev/null 2>&1
+}
+
+# List the image with and without the cache and compare the listings
+# @param $1 Message that the verbose output of the cached listing has to have
+list_image()
+{
+	${FLS} -r -p -l ${IMAGE} > ${IMAGE}.base || return ${EXIT_FAILURE};
+	${FLS} -v -r -p -l -c ${CACHE_DIR} ${IMAGE} > ${IMAGE}.cache 2> ${IMAGE}.log || return ${EXIT_FAILURE};
+
+	if ! grep -q "tsk_fs_cache_open: ${1}" ${IMAGE}.log;
+	then
+		echo "Cache was not used as expected: ${1}";
+
+		return ${EXIT_FAILURE};
+	fi
+	if ! grep -q "OrphanFile-" ${IMAGE}.base;
+	then
+		echo "Image has no orphan files";
+
+		return ${EXIT_FAILURE};
+	fi
+	diff ${IMAGE}.base ${IMAGE}.cache || return ${EXIT_FAILURE};
+
+	return ${EXIT_SUCCESS};
+}
+
+rm -rf ${IMAGE} ${IMAGE}.cmds ${IMAGE}.base ${IMAGE}.cache ${IMAGE}.log ${CACHE_DIR}
+mkdir ${CACHE_DIR}
+dd if=/dev/zero of=${IMAGE} bs=1024 count=4096 2> /dev/null
+mke2fs -q -F -t ext2 -b 1024 ${IMAGE} || exit ${EXIT_FAILURE};
+make_orphans d0 || exit ${EXIT_FAILURE};
+
+RESULT=${EXIT_SUCCESS};
+
+# The first listing makes the cache file and the second one loads it
+list_image "No cache file" || RESULT=${EXIT_FAILURE};
+
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	list_image "Loaded cache file" || RESULT=${EXIT_FAILURE};
+fi
+
+# More orphan files in the same image file give a new key
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	make_orphans d1 || RESULT=${EXIT_FAILURE};
+fi
+
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	list_image "No cache file" || RESULT=${EXIT_FAILURE};
+fi
+
+if test ${RESULT} -eq ${EXIT_SUCCESS};
+then
+	list_image "Loaded cache file" || RESULT=${EXIT_FAILURE};
+fi
+
+if test ${RESULT} -eq ${EXIT_SUCCESS} && test $(ls ${CACHE_DIR} | wc -l) -ne 2;
+then
+	echo "Expected a cache file for each version of the image";
+
+	RESULT=${EXIT_FAILURE};
+fi
+
+rm -rf ${IMAGE} ${IMAGE}.cmds ${IMAGE}.base ${IMAGE}.cache ${IMAGE}.log ${CACHE_DIR}
+
+exit ${RESULT};
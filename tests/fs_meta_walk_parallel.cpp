@@ -0,0 +1,171 @@
+/*
+* The Sleuth Kit
+*
+* Brian Carrier [carrier <at> sleuthkit [dot] org]
+* Copyright (c) 2008-2011 Brian Carrier.  All Rights reserved
+*
+*
+* This software is distributed under the Common Public License 1.0
+*
+*/
+
+/* Compare the results of tsk_fs_meta_walk_parallel() with the results of
+ * tsk_fs_meta_walk() on a file system image */
+
+#include "tsk/tsk_tools_i.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+typedef struct {
+    std::vector < std::string > lines;
+    tsk_lock_t lock;            // taken when the walk calls the callback concurrently
+} WALK_DATA;
+
+
+/* Callback that records the metadata of each file as a line of text */
+static TSK_WALK_RET_ENUM
+walk_cb(TSK_FS_FILE * a_fs_file, void *a_ptr)
+{
+    WALK_DATA *data = (WALK_DATA *) a_ptr;
+    TSK_FS_META *meta = a_fs_file->meta;
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), "%" PRIuINUM "|%d|%d|%lo|%d|%" PRIuOFF
+        "|%" PRIu32 "|%" PRIu32 "|%" PRIu32 "|%" PRIu32 "|",
+        meta->addr, (int) meta->flags, (int) meta->type,
+        (unsigned long) meta->mode, meta->nlink, meta->size,
+        (uint32_t) meta->mtime, (uint32_t) meta->atime,
+        (uint32_t) meta->ctime, (uint32_t) meta->crtime);
+    std::string line(buf);
+    if (meta->name2)
+        line += meta->name2->name;
+
+    tsk_take_lock(&data->lock);
+    data->lines.push_back(line);
+    tsk_release_lock(&data->lock);
+    return TSK_WALK_CONT;
+}
+
+/* Compare the lines of two walks
+* @returns 1 if they are not the same
+*/
+static int
+compare_walks(const char *a_name, const WALK_DATA & a_serial,
+    const WALK_DATA & a_parallel)
+{
+    if (a_serial.lines.size() != a_parallel.lines.size()) {
+        fprintf(stderr, "%s: %zu entries from serial walk, %zu from parallel walk\n",
+            a_name, a_serial.lines.size(), a_parallel.lines.size());
+        return 1;
+    }
+    for (size_t i = 0; i < a_serial.lines.size(); i++) {
+        if (a_serial.lines[i] != a_parallel.lines[i]) {
+            fprintf(stderr, "%s: entry %zu differs:\n  %s\n  %s\n", a_name, i,
+                a_serial.lines[i].c_str(), a_parallel.lines[i].c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Walk the file system serially and in parallel with a set of flags and
+* compare the results.
+* @returns 1 if a test failed
+*/
+static int
+test_walk(TSK_FS_INFO * a_fs, TSK_FS_META_FLAG_ENUM a_flags,
+    unsigned int a_threads)
+{
+    WALK_DATA serial, ordered, unordered;
+
+    tsk_init_lock(&serial.lock);
+    tsk_init_lock(&ordered.lock);
+    tsk_init_lock(&unordered.lock);
+
+    if (tsk_fs_meta_walk(a_fs, a_fs->first_inum, a_fs->last_inum, a_flags,
+            walk_cb, &serial)) {
+        fprintf(stderr, "Error in serial walk (flags %x)\n", a_flags);
+        tsk_error_print(stderr);
+        return 1;
+    }
+
+    if (tsk_fs_meta_walk_parallel(a_fs, a_fs->first_inum, a_fs->last_inum,
+            a_flags, a_threads, TSK_FS_META_WALK_PARALLEL_ORDERED, walk_cb,
+            &ordered)) {
+        fprintf(stderr, "Error in ordered parallel walk (flags %x)\n",
+            a_flags);
+        tsk_error_print(stderr);
+        return 1;
+    }
+
+    if (tsk_fs_meta_walk_parallel(a_fs, a_fs->first_inum, a_fs->last_inum,
+            a_flags, a_threads, TSK_FS_META_WALK_PARALLEL_DEFAULT, walk_cb,
+            &unordered)) {
+        fprintf(stderr, "Error in unordered parallel walk (flags %x)\n",
+            a_flags);
+        tsk_error_print(stderr);
+        return 1;
+    }
+
+    tsk_deinit_lock(&serial.lock);
+    tsk_deinit_lock(&ordered.lock);
+    tsk_deinit_lock(&unordered.lock);
+
+    if (compare_walks("ordered", serial, ordered))
+        return 1;
+
+    // the unordered walk has the same entries in any order
+    std::sort(serial.lines.begin(), serial.lines.end());
+    std::sort(unordered.lines.begin(), unordered.lines.end());
+    if (compare_walks("unordered", serial, unordered))
+        return 1;
+
+    printf("flags %x: %zu entries\n", a_flags, serial.lines.size());
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    TSK_IMG_INFO *img;
+    TSK_FS_INFO *fs;
+    unsigned int threads = 4;
+    int retval = 0;
+
+    if ((argc != 2) && (argc != 3)) {
+        fprintf(stderr, "usage: %s image [threads]\n", argv[0]);
+        return 1;
+    }
+    if (argc == 3)
+        threads = (unsigned int) atoi(argv[2]);
+
+    if ((img = tsk_img_open_utf8_sing(argv[1], TSK_IMG_TYPE_DETECT, 0)) == NULL) {
+        fprintf(stderr, "Error opening image %s\n", argv[1]);
+        tsk_error_print(stderr);
+        return 1;
+    }
+
+    if ((fs = tsk_fs_open_img(img, 0, TSK_FS_TYPE_DETECT)) == NULL) {
+        fprintf(stderr, "Error opening file system in %s\n", argv[1]);
+        tsk_error_print(stderr);
+        tsk_img_close(img);
+        return 1;
+    }
+
+    if (test_walk(fs, (TSK_FS_META_FLAG_ENUM) (TSK_FS_META_FLAG_ALLOC |
+                TSK_FS_META_FLAG_UNALLOC), threads)
+        || test_walk(fs, TSK_FS_META_FLAG_ALLOC, threads)
+        || test_walk(fs, (TSK_FS_META_FLAG_ENUM) (TSK_FS_META_FLAG_UNALLOC |
+                TSK_FS_META_FLAG_ORPHAN), threads)) {
+        retval = 1;
+    }
+
+    tsk_fs_close(fs);
+    tsk_img_close(img);
+
+    if (retval == 0)
+        printf("Tests Passed\n");
+    return retval;
+}
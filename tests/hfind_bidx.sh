@@ -0,0 +1,128 @@
+#!/bin/bash
+
+# Check that hfind gives the same answers with the binary index (.bidx) of
+# a text hash database as with the text index alone, for batches of hashes
+# and for single hashes, and that an out of date binary index is made
+# again when the text index changes.
+
+EXIT_SUCCESS=0;
+EXIT_FAILURE=1;
+EXIT_IGNORE=77;
+
+DB=hfind_bidx.md5
+IDX=${DB}-md5.idx
+BIDX=${DB}-md5.bidx
+LOOKUP=hfind_bidx.lookup
+
+if ! which md5sum > /dev/null 2>&1;
+then
+	echo "Missing md5sum";
+
+	exit ${EXIT_IGNORE};
+fi
+
+HFIND="../tools/hashtools/hfind";
+
+if ! test -x ${HFIND};
+then
+	HFIND="../tools/hashtools/hfind.exe";
+fi
+
+if ! test -x ${HFIND};
+then
+	echo "Missing test executable: hfind";
+
+	exit ${EXIT_IGNORE};
+fi
+
+cleanup()
+{
+	rm -f ${DB} ${DB}-md5.* ${LOOKUP} hfind_bidx.*.out hfind_bidx.old.*
+}
+
+fail()
+{
+	echo "$1";
+	cleanup;
+
+	exit ${EXIT_FAILURE};
+}
+
+# Look up the hashes as a batch (-f) and one at a time (on the command
+# line) and check that both give the same answers.
+# $1: name of the output file
+lookup()
+{
+	${HFIND} -f ${LOOKUP} ${DB} > hfind_bidx.$1.out || fail "hfind -f failed ($1)";
+	${HFIND} ${DB} $(cat ${LOOKUP}) > hfind_bidx.$1.single.out || fail "hfind failed ($1)";
+	cmp -s hfind_bidx.$1.out hfind_bidx.$1.single.out || fail "Batch and single lookups differ ($1)";
+}
+
+# Look up the hashes with the text index alone and compare the answers
+# with those of lookup()
+# $1: name of the output file
+compare_text()
+{
+	mv ${BIDX} hfind_bidx.old.keep
+	lookup $1.text
+	test -f ${BIDX} && fail "Binary index was made by a lookup ($1)";
+	mv hfind_bidx.old.keep ${BIDX}
+	cmp -s hfind_bidx.$1.out hfind_bidx.$1.text.out || fail "Binary and text index lookups differ ($1)";
+}
+
+cleanup
+
+# Half of the hashes in the lookup file are in the database
+for I in $(seq 1 400);
+do
+	echo "$(echo f${I} | md5sum | cut -c1-32)  /dir/file${I}" >> ${DB};
+done;
+for I in $(seq 1 2 200) $(seq 1001 1100);
+do
+	echo "f${I}" | md5sum | cut -c1-32 >> ${LOOKUP};
+done;
+
+${HFIND} -i md5sum ${DB} > /dev/null || fail "hfind -i failed";
+test -f ${BIDX} || fail "Binary index was not made";
+
+# The first entry of the text index is edited below
+sed -n 3p ${IDX} | cut -c1-32 >> ${LOOKUP}
+
+lookup new
+compare_text new
+
+# A text index with a different modification time
+cp -p ${BIDX} hfind_bidx.old.bidx
+touch -d "2001-01-01 00:00:00" ${IDX}
+lookup mtime
+cmp -s ${BIDX} hfind_bidx.old.bidx && fail "Binary index was not made again (mtime)";
+compare_text mtime
+
+# A text index with the same size and modification time but different
+# contents: change the last digit of the hash of its first entry (which
+# keeps the entries sorted), so that the hash is no longer found
+cp -p ${BIDX} hfind_bidx.old.bidx
+cp -p ${IDX} hfind_bidx.old.idx
+{
+	sed -n 1,2p hfind_bidx.old.idx;
+	sed -n 3p hfind_bidx.old.idx | sed -e 's/^\(.\{31\}\)0|/\1X|/' -e 's/^\(.\{31\}\)[1-9A-F]|/\10|/' -e 's/^\(.\{31\}\)X|/\11|/';
+	sed -n '4,$p' hfind_bidx.old.idx;
+} > ${IDX}
+touch -r hfind_bidx.old.idx ${IDX}
+cmp -s hfind_bidx.old.idx ${IDX} && fail "Text index was not edited";
+test $(wc -c < ${IDX}) -eq $(wc -c < hfind_bidx.old.idx) || fail "Text index changed size";
+lookup sig
+cmp -s ${BIDX} hfind_bidx.old.bidx && fail "Binary index was not made again (signature)";
+compare_text sig
+cmp -s hfind_bidx.mtime.out hfind_bidx.sig.out && fail "Edited entries were not found (signature)";
+
+# A binary index whose entry table is cut short
+cp -p ${BIDX} hfind_bidx.old.bidx
+truncate -s -24 ${BIDX}
+lookup truncated
+cmp -s ${BIDX} hfind_bidx.old.bidx || fail "Binary index was not made again (truncated)";
+cmp -s hfind_bidx.sig.out hfind_bidx.truncated.out || fail "Answers changed (truncated)";
+
+cleanup
+
+exit ${EXIT_SUCCESS};
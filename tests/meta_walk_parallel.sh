@@ -0,0 +1,68 @@
+#!/bin/bash
+
+# Compare the parallel metadata walk with the serial walk on an ext2 image
+# that is made with mke2fs and debugfs.
+
+EXIT_SUCCESS=0;
+EXIT_FAILURE=1;
+EXIT_IGNORE=77;
+
+IMAGE=meta_walk_parallel.img
+NTHREADS=4
+
+if ! which mke2fs > /dev/null 2>&1 || ! which debugfs > /dev/null 2>&1;
+then
+	echo "Missing mke2fs or debugfs";
+
+	exit ${EXIT_IGNORE};
+fi
+
+META_WALK_TEST="./fs_meta_walk_parallel";
+
+if ! test -x ${META_WALK_TEST};
+then
+	META_WALK_TEST="./fs_meta_walk_parallel.exe";
+fi
+
+if ! test -x ${META_WALK_TEST};
+then
+	echo "Missing test executable: fs_meta_walk_parallel";
+
+	exit ${EXIT_IGNORE};
+fi
+
+# 80 MB with 1 KB blocks gives 10 block groups, so the walk has several
+# parts of at least 16384 inodes.
+rm -f ${IMAGE} ${IMAGE}.cmds
+dd if=/dev/zero of=${IMAGE} bs=1024 count=81920 2> /dev/null
+mke2fs -q -F -t ext2 -b 1024 -N 70000 ${IMAGE} || exit ${EXIT_FAILURE};
+
+# Directories are spread over the groups.  Delete some of the files so
+# that there are unallocated inodes.
+for D in 0 1 2 3 4 5 6 7 8 9;
+do
+	echo "mkdir d${D}" >> ${IMAGE}.cmds;
+	for F in 0 1 2 3 4 5 6 7 8 9;
+	do
+		echo "write ${0} d${D}/f${F}" >> ${IMAGE}.cmds;
+	done;
+	echo "rm d${D}/f3" >> ${IMAGE}.cmds;
+	echo "kill_file d${D}/f5" >> ${IMAGE}.cmds;
+done;
+# Files that no name points to once the directory block is cleared
+echo "kill_file d8/f0" >> ${IMAGE}.cmds;
+echo "kill_file d8/f1" >> ${IMAGE}.cmds;
+echo "zap_block -f d8 0" >> ${IMAGE}.cmds;
+debugfs -w -f ${IMAGE}.cmds ${IMAGE} > /dev/null 2>&1 || exit ${EXIT_FAILURE};
+
+${META_WALK_TEST} ${IMAGE} ${NTHREADS}
+RESULT=$?
+
+rm -f ${IMAGE} ${IMAGE}.cmds
+
+if test ${RESULT} -ne 0;
+then
+	exit ${EXIT_FAILURE};
+fi
+
+exit ${EXIT_SUCCESS};
@@ -20,16 +20,20 @@ usage()
 {
     TFPRINTF(stderr,
         _TSK_T
-        ("usage: %s [-ahkvV] [-i imgtype] [-b dev_sector_size] [-d database] [-z ZONE] image [image]\n"),
+        ("usage: %s [-ahkvV] [-i imgtype] [-b dev_sector_size] [-d database] [-c num_files] [-r image_id] [-t num_threads] [-H num_threads] [-z ZONE] image [image]\n"),
         progname);
     tsk_fprintf(stderr, "\t-a: Add image to existing database, instead of creating a new one (requires -d to specify database)\n");
     tsk_fprintf(stderr, "\t-k: Don't create block data table\n");
     tsk_fprintf(stderr, "\t-h: Calculate hash values for the files\n");
+    tsk_fprintf(stderr, "\t-H num_threads: Number of threads that calculate the hash values (with -h)\n");
     tsk_fprintf(stderr,
         "\t-i imgtype: The format of the image file (use '-i list' for supported types)\n");
     tsk_fprintf(stderr,
         "\t-b dev_sector_size: The size (in bytes) of the device sectors\n");
     tsk_fprintf(stderr, "\t-d database: Path for the database (default is the same directory as the image, with name derived from image name)\n");
+    tsk_fprintf(stderr, "\t-c num_files: Save a checkpoint after every num_files files so that the image can be resumed with -r\n");
+    tsk_fprintf(stderr, "\t-t num_threads: Number of threads that open and walk the volumes of a volume system at the same time (not used with -c or -r)\n");
+    tsk_fprintf(stderr, "\t-r image_id: Resume adding the image with this object ID from its last checkpoint (requires -a and -d)\n");
     tsk_fprintf(stderr, "\t-v: verbose output to stderr\n");
     tsk_fprintf(stderr, "\t-V: Print version\n");
     tsk_fprintf(stderr, "\t-z: Time zone of original machine (i.e. EST5EDT or GMT)\n");
@@ -53,6 +57,10 @@ main(int argc, char **argv1)
     bool blkMapFlag = true;   // true if we are going to write the block map
     bool createDbFlag = true; // true if we are going to create a new database
     bool calcHash = false;
+    unsigned int checkpointInterval = 0;
+    unsigned int volThreads = 0;
+    unsigned int hashThreads = 0;
+    int64_t resumeImgId = 0;  // object ID of the image to resume (0 to add a new image)
 
 #ifdef TSK_WIN32
     // On Windows, get the wide arguments (mingw doesn't support wmain)
@@ -68,7 +76,7 @@ main(int argc, char **argv1)
     progname = argv[0];
     setlocale(LC_ALL, "");
 
-    while ((ch = GETOPT(argc, argv, _TSK_T("ab:d:hi:kvVz:"))) > 0) {
+    while ((ch = GETOPT(argc, argv, _TSK_T("ab:c:d:hH:i:kr:t:vVz:"))) > 0) {
         switch (ch) {
         case _TSK_T('?'):
         default:
@@ -91,6 +99,17 @@ main(int argc, char **argv1)
             }
             break;
 
+        case _TSK_T('c'):
+            checkpointInterval = (unsigned int) TSTRTOUL(OPTARG, &cp, 0);
+            if (*cp || *cp == *OPTARG || checkpointInterval < 1) {
+                TFPRINTF(stderr,
+                    _TSK_T
+                    ("invalid argument: number of files must be positive: %s\n"),
+                    OPTARG);
+                usage();
+            }
+            break;
+
         case _TSK_T('i'):
             if (TSTRCMP(OPTARG, _TSK_T("list")) == 0) {
                 tsk_img_type_print(stderr);
@@ -112,10 +131,41 @@ main(int argc, char **argv1)
             calcHash = true;
             break;
 
+        case _TSK_T('H'):
+            hashThreads = (unsigned int) TSTRTOUL(OPTARG, &cp, 0);
+            if (*cp || *cp == *OPTARG || hashThreads < 1) {
+                TFPRINTF(stderr,
+                    _TSK_T
+                    ("invalid argument: number of threads must be positive: %s\n"),
+                    OPTARG);
+                usage();
+            }
+            break;
         case _TSK_T('d'):
             database = OPTARG;
             break;
 
+        case _TSK_T('r'):
+            resumeImgId = (int64_t) TSTRTOULL(OPTARG, &cp, 0);
+            if (*cp || *cp == *OPTARG || resumeImgId < 1) {
+                TFPRINTF(stderr,
+                    _TSK_T
+                    ("invalid argument: image ID must be positive: %s\n"),
+                    OPTARG);
+                usage();
+            }
+            break;
+
+        case _TSK_T('t'):
+            volThreads = (unsigned int) TSTRTOUL(OPTARG, &cp, 0);
+            if (*cp || *cp == *OPTARG || volThreads < 1) {
+                TFPRINTF(stderr,
+                    _TSK_T
+                    ("invalid argument: number of threads must be positive: %s\n"),
+                    OPTARG);
+                usage();
+            }
+            break;
         case _TSK_T('v'):
             tsk_verbose++;
             break;
@@ -152,6 +202,11 @@ main(int argc, char **argv1)
         TSNPRINTF(buff, 1024, _TSK_T("%s.db"), argv[OPTIND]);
         database = buff;
     }
+
+    if ((resumeImgId) && (createDbFlag)) {
+        fprintf(stderr, "Error: -r requires an existing database (-a and -d)\n");
+        usage();
+    }
     
     //tskRecover.setFileFilterFlags(TSK_FS_DIR_WALK_FLAG_UNALLOC);
 
@@ -172,8 +227,16 @@ main(int argc, char **argv1)
     autoDb->createBlockMap(blkMapFlag);
     autoDb->hashFiles(calcHash);
     autoDb->setAddUnallocSpace(true);
+    autoDb->setCheckpointInterval(checkpointInterval);
+    autoDb->setVolumeThreads(volThreads);
+    autoDb->setHashThreads(hashThreads);
 
-    if (autoDb->startAddImage(argc - OPTIND, &argv[OPTIND], imgtype, ssize)) {
+    uint8_t retval;
+    if (resumeImgId)
+        retval = autoDb->resumeAddImage(resumeImgId, argc - OPTIND, &argv[OPTIND], imgtype, ssize);
+    else
+        retval = autoDb->startAddImage(argc - OPTIND, &argv[OPTIND], imgtype, ssize);
+    if (retval) {
         std::vector<TskAuto::error_record> errors = autoDb->getErrorList();
         for (size_t i = 0; i < errors.size(); i++) {
             fprintf(stderr, "Error: %s\n", TskAuto::errorRecordToString(errors[i]).c_str());
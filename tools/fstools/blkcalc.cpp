@@ -224,12 +224,12 @@ main(int argc, char **argv1)
 
     if (-1 == tsk_fs_blkcalc(fs, (TSK_FS_BLKCALC_FLAG_ENUM) type, count)) {
         tsk_error_print(stderr);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
 
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
 
     exit(0);
@@ -319,7 +319,7 @@ main(int argc, char **argv1)
         tsk_fprintf(stderr,
             "Data unit address too large for image (%" PRIuDADDR ")\n",
             fs->last_block);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
@@ -327,7 +327,7 @@ main(int argc, char **argv1)
         tsk_fprintf(stderr,
             "Data unit address too small for image (%" PRIuDADDR ")\n",
             fs->first_block);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
@@ -335,12 +335,12 @@ main(int argc, char **argv1)
     if (tsk_fs_blkcat(fs, (TSK_FS_BLKCAT_FLAG_ENUM) format, addr,
             read_num_units)) {
         tsk_error_print(stderr);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
 
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
 
     exit(0);
@@ -322,12 +322,12 @@ main(int argc, char **argv1)
     if (tsk_fs_blkls(fs, (TSK_FS_BLKLS_FLAG_ENUM) lclflags, bstart, blast,
             (TSK_FS_BLOCK_WALK_FLAG_ENUM)flags)) {
         tsk_error_print(stderr);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
 
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
     exit(0);
 }
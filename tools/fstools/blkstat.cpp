@@ -167,7 +167,7 @@ main(int argc, char **argv1)
         tsk_fprintf(stderr,
             "Data unit address too large for image (%" PRIuDADDR ")\n",
             fs->last_block);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
@@ -175,7 +175,7 @@ main(int argc, char **argv1)
         tsk_fprintf(stderr,
             "Data unit address too small for image (%" PRIuDADDR ")\n",
             fs->first_block);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
@@ -183,12 +183,12 @@ main(int argc, char **argv1)
 
     if (tsk_fs_blkstat(fs, addr)) {
         tsk_error_print(stderr);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
 
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
     exit(0);
 }
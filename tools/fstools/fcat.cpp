@@ -178,14 +178,14 @@ main(int argc, char **argv1)
 
     if (-1 == (retval = tsk_fs_ifind_path(fs, path, &inum))) {
         tsk_error_print(stderr);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         free(path);
         exit(1);
     }
     else if (retval == 1) {
         tsk_fprintf(stderr, "File not found\n");
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         free(path);
         exit(1);
@@ -203,13 +203,13 @@ main(int argc, char **argv1)
         }
         else {
             tsk_error_print(stderr);
-            fs->close(fs);
+            tsk_fs_close(fs);
             img->close(img);
             exit(1);
         }
     }
 
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
     exit(0);
 }
@@ -209,12 +209,12 @@ main(int argc, char **argv1)
             type_used, id, id_used,
             (TSK_FS_DIR_WALK_FLAG_ENUM) dir_walk_flags)) {
         tsk_error_print(stderr);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
 
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
     exit(0);
 }
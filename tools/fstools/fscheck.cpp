@@ -144,12 +144,12 @@ main(int argc, char **argv)
 
     if (fs->fscheck(fs, stdout)) {
         tsk_error_print(stderr);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
 
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
 
     exit(0);
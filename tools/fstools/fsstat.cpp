@@ -167,13 +167,13 @@ main(int argc, char **argv1)
     else {
         if (fs->fsstat(fs, stdout)) {
             tsk_error_print(stderr);
-            fs->close(fs);
+            tsk_fs_close(fs);
             img->close(img);
             exit(1);
         }
     }
 
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
     exit(0);
 }
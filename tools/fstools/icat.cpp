@@ -196,7 +196,7 @@ main(int argc, char **argv1)
         tsk_fprintf(stderr,
             "Metadata address too large for image (%" PRIuINUM ")\n",
             fs->last_inum);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
@@ -204,7 +204,7 @@ main(int argc, char **argv1)
         tsk_fprintf(stderr,
             "Metadata address too small for image (%" PRIuINUM ")\n",
             fs->first_inum);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
@@ -219,12 +219,12 @@ main(int argc, char **argv1)
         }
         else {
             tsk_error_print(stderr);
-            fs->close(fs);
+            tsk_fs_close(fs);
             img->close(img);
             exit(1);
         }
     }
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
     exit(0);
 }
@@ -261,14 +261,14 @@ main(int argc, char **argv1)
                 "Block %" PRIuDADDR
                 " is larger than last block in image (%" PRIuDADDR
                 ")\n", block, fs->last_block);
-            fs->close(fs);
+            tsk_fs_close(fs);
             img->close(img);
             exit(1);
         }
         if (tsk_fs_ifind_data(fs, (TSK_FS_IFIND_FLAG_ENUM) localflags,
                 block)) {
             tsk_error_print(stderr);
-            fs->close(fs);
+            tsk_fs_close(fs);
             img->close(img);
             exit(1);
         }
@@ -277,7 +277,7 @@ main(int argc, char **argv1)
     else if (type == IFIND_PARENT) {
         if (TSK_FS_TYPE_ISNTFS(fs->ftype) == 0) {
             tsk_fprintf(stderr, "-p works only with NTFS file systems\n");
-            fs->close(fs);
+            tsk_fs_close(fs);
             img->close(img);
             exit(1);
         }
@@ -286,14 +286,14 @@ main(int argc, char **argv1)
                 "Meta data %" PRIuINUM
                 " is larger than last MFT entry in image (%" PRIuINUM
                 ")\n", parinode, fs->last_inum);
-            fs->close(fs);
+            tsk_fs_close(fs);
             img->close(img);
             exit(1);
         }
         if (tsk_fs_ifind_par(fs, (TSK_FS_IFIND_FLAG_ENUM) localflags,
                 parinode)) {
             tsk_error_print(stderr);
-            fs->close(fs);
+            tsk_fs_close(fs);
             img->close(img);
             exit(1);
         }
@@ -305,7 +305,7 @@ main(int argc, char **argv1)
 
         if (-1 == (retval = tsk_fs_ifind_path(fs, path, &inum))) {
             tsk_error_print(stderr);
-            fs->close(fs);
+            tsk_fs_close(fs);
             img->close(img);
             free(path);
             exit(1);
@@ -316,7 +316,7 @@ main(int argc, char **argv1)
         else
             tsk_printf("%" PRIuINUM "\n", inum);
     }
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
 
     exit(0);
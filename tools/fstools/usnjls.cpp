@@ -224,7 +224,7 @@ main(int argc, char **argv1)
         tsk_fprintf(stderr,
                     "Inode value is too large for image (%" PRIuINUM ")\n",
                     fs->last_inum);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
@@ -233,19 +233,19 @@ main(int argc, char **argv1)
         tsk_fprintf(stderr,
                     "Inode value is too small for image (%" PRIuINUM ")\n",
                     fs->first_inum);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
 
     if (tsk_fs_usnjls(fs, inum, flag)) {
         tsk_error_print(stderr);
-        fs->close(fs);
+        tsk_fs_close(fs);
         img->close(img);
         exit(1);
     }
 
-    fs->close(fs);
+    tsk_fs_close(fs);
     img->close(img);
     exit(0);
 }
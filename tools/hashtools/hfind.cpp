@@ -14,6 +14,12 @@
 #include "tsk/tsk_tools_i.h"
 #include <locale.h>
 
+#include <string>
+#include <vector>
+
+/** Number of hashes that are read from the lookup file before they are searched for */
+#define HFIND_BATCH_SIZE 4096
+
 static TSK_TCHAR *progname;
 
 /**
@@ -67,6 +73,98 @@ print_notfound(char *hash)
     tsk_fprintf(stdout, "%s\tHash Not Found\n", hash);
 }
 
+/**
+ * Convert a hash to binary if it is a valid MD5 or SHA-1 value.
+ * @returns 1 if the hash is not valid and 0 on success
+ */
+static int
+hash_to_bin(const std::string & hash, std::vector<uint8_t> & bin)
+{
+    if ((hash.size() != TSK_HDB_HTYPE_MD5_LEN) && (hash.size() != TSK_HDB_HTYPE_SHA1_LEN))
+        return 1;
+
+    for (size_t i = 0; i < hash.size(); i++) {
+        char c = hash[i];
+        int val;
+        if ((c >= '0') && (c <= '9'))
+            val = c - '0';
+        else if ((c >= 'a') && (c <= 'f'))
+            val = c - 'a' + 10;
+        else if ((c >= 'A') && (c <= 'F'))
+            val = c - 'A' + 10;
+        else
+            return 1;
+
+        if (i % 2 == 0)
+            bin.push_back((uint8_t) (val << 4));
+        else
+            bin.back() |= (uint8_t) val;
+    }
+    return 0;
+}
+
+/**
+ * Look up a set of hashes that were read from the lookup file and print 
+ * the results in the order of the file.  The valid hashes are first searched 
+ * for as a batch to find which ones are in the database.  Only those are 
+ * then looked up again to print their names.  Invalid hashes are passed to 
+ * tsk_hdb_lookup_str() so that they are reported as before.
+ * @returns 1 on error and 0 on success
+ */
+static int
+lookup_hashes(TSK_HDB_INFO * hdb_info, std::vector<std::string> & hashes,
+              int flags)
+{
+    // 0 for not found, 1 for found, -1 if it was not part of a batch
+    std::vector<int> found(hashes.size(), -1);
+    size_t hash_lens[] = { TSK_HDB_HTYPE_MD5_LEN / 2, TSK_HDB_HTYPE_SHA1_LEN / 2 };
+
+    for (int h = 0; h < 2; h++) {
+        std::vector<uint8_t> bins;
+        std::vector<size_t> lines;
+
+        for (size_t i = 0; i < hashes.size(); i++) {
+            std::vector<uint8_t> bin;
+            if ((hash_to_bin(hashes[i], bin) == 0) && (bin.size() == hash_lens[h])) {
+                bins.insert(bins.end(), bin.begin(), bin.end());
+                lines.push_back(i);
+            }
+        }
+        if (lines.empty())
+            continue;
+
+        std::vector<uint8_t> hits((lines.size() + 7) / 8);
+        if (tsk_hdb_lookup_batch(hdb_info, &bins[0], lines.size(),
+                (uint8_t) hash_lens[h], TSK_HDB_FLAG_QUICK, &hits[0], NULL,
+                NULL) == -1) {
+            // look them up one at a time, so the error is reported in order
+            tsk_error_reset();
+            continue;
+        }
+        for (size_t i = 0; i < lines.size(); i++) {
+            found[lines[i]] = (hits[i / 8] & (1 << (i % 8))) ? 1 : 0;
+        }
+    }
+
+    for (size_t i = 0; i < hashes.size(); i++) {
+        if (found[i] == 0) {
+            print_notfound((char *) hashes[i].c_str());
+            continue;
+        }
+
+        int retval = tsk_hdb_lookup_str(hdb_info, hashes[i].c_str(),
+                (TSK_HDB_FLAG_ENUM)flags, lookup_act, NULL);
+        if (retval == -1) {
+            tsk_error_print(stderr);
+            return 1;
+        }
+        else if (retval == 0) {
+            print_notfound((char *) hashes[i].c_str());
+        }
+    }
+    return 0;
+}
+
 int
 main(int argc, char ** argv1)
 {
@@ -284,6 +382,7 @@ main(int argc, char ** argv1)
     /* Hash were given from stdin or a file */
     else {
         char buf[100];
+        std::vector<std::string> batch;
 
         /* If the file was specified, use that - otherwise stdin */
 #ifdef TSK_WIN32
@@ -350,6 +449,16 @@ main(int argc, char ** argv1)
             /* Remove the newline */
             buf[strlen(buf) - 1] = '\0';
 
+            if ((flags & TSK_HDB_FLAG_QUICK) == 0) {
+                batch.push_back(buf);
+                if (batch.size() == HFIND_BATCH_SIZE) {
+                    if (lookup_hashes(hdb_info, batch, flags))
+                        return 1;
+                    batch.clear();
+                }
+                continue;
+            }
+
             retval =
                 tsk_hdb_lookup_str(hdb_info, (const char *)buf, 
                         (TSK_HDB_FLAG_ENUM)flags, lookup_act, NULL);
@@ -357,14 +466,12 @@ main(int argc, char ** argv1)
                 tsk_error_print(stderr);
                 return 1;
             }
-            if (flags & TSK_HDB_FLAG_QUICK) {
-                printf("%d\n", retval);
-                break;
-            }
-            else if (retval == 0) {
-                print_notfound(buf);
-            }
+            printf("%d\n", retval);
+            break;
         }
+
+        if ((batch.empty() == false) && (lookup_hashes(hdb_info, batch, flags)))
+            return 1;
         
 #ifdef TSK_WIN32
         if (lookup_file != NULL)
@@ -66,6 +66,13 @@
 
 #include <inttypes.h>
 
+/* Use SSE2 to classify 16 bytes at a time for the single-byte
+   encodings.  */
+#if defined(__SSE2__) && defined(__GNUC__)
+#define STRINGS_SSE2
+#include <emmintrin.h>
+#endif
+
 /* Some platforms need to put stdin into binary mode, to read
     binary files.  */
 #ifdef HAVE_SETMODE
@@ -244,11 +251,18 @@ static bfd_boolean print_filenames;
 static char encoding;
 static int encoding_bytes;
 
+/* Size of the blocks that are read from the input.  Must be a multiple
+   of the largest encoding_bytes.  */
+#define STRINGS_BLOCK_SIZE (1024 * 1024)
+
+/* STRING_ISGRAPHIC for each byte, filled in by main for the
+   single-byte encodings.  */
+static unsigned char graphic_table[256];
+
 static bfd_boolean strings_file (char *file);
 static int integer_arg (char *s);
-static void print_strings (const char *, FILE *, uint64_t, uint64_t, int, char *);
+static void print_strings (const char *, FILE *);
 static void usage (FILE *, int);
-static long get_char (FILE *, uint64_t *, int *, char **);
 
 int main (int, char **);
 
@@ -365,13 +379,16 @@ main (int argc, char **argv)
       usage (stderr, 1);
     }
 
+  for (optc = 0; optc < 256; optc++)
+    graphic_table[optc] = STRING_ISGRAPHIC (optc) != 0;
+
 
   if (optind >= argc)
     {
 #ifdef SET_BINARY
       SET_BINARY (fileno (stdin));
 #endif
-      print_strings ("{standard input}", stdin, 0, 0, 0, (char *) NULL);
+      print_strings ("{standard input}", stdin);
       files_given = TRUE;
     }
   else
@@ -436,7 +453,7 @@ strings_file (char *file)
 	  return FALSE;
 	}
 
-      print_strings (file, stream, (uint64_t) 0, 0, 0, (char *) 0);
+      print_strings (file, stream);
 
       if (fclose (stream) == EOF)
 	{
@@ -448,160 +465,234 @@ strings_file (char *file)
   return TRUE;
 }
 
-/* Read the next character, return EOF if none available.
-   Assume that STREAM is positioned so that the next byte read
-   is at address ADDRESS in the file.
-
-   If STREAM is NULL, do not read from it.
-   The caller can supply a buffer of characters
-   to be processed before the data in STREAM.
-   MAGIC is the address of the buffer and
-   MAGICCOUNT is how many characters are in it.  */
-
-static long
-get_char (FILE *stream, uint64_t *address, int *magiccount, char **magic)
+/* Return the character at P in the current encoding.  */
+
+static inline long
+decode_char (const unsigned char *p)
+{
+  switch (encoding)
+    {
+    case 'b':
+      return (p[0] << 8) | p[1];
+    case 'l':
+      return p[0] | (p[1] << 8);
+    case 'B':
+      return ((long) p[0] << 24) | ((long) p[1] << 16) |
+	((long) p[2] << 8) | p[3];
+    case 'L':
+      return p[0] | ((long) p[1] << 8) | ((long) p[2] << 16) |
+	((long) p[3] << 24);
+    default:
+      return p[0];
+    }
+}
+
+#ifdef STRINGS_SSE2
+/* Return a bit mask of the graphic bytes in the 16 bytes at P.  */
+
+static inline unsigned int
+graphic_mask_sse2 (const unsigned char *p)
 {
-  int c, i;
-  long r = EOF;
-  unsigned char buf[4];
+  __m128i v = _mm_loadu_si128 ((const __m128i *) p);
+  __m128i g;
 
-  for (i = 0; i < encoding_bytes; i++)
+  if (encoding == 'S')
     {
-      if (*magiccount)
-	{
-	  (*magiccount)--;
-	  c = *(*magic)++;
-	}
-      else
-	{
-	  if (stream == NULL)
-	    return EOF;
-#ifdef HAVE_GETC_UNLOCKED
-	  c = getc_unlocked (stream);
-#else
-	  c = getc (stream);
+      /* 0x20 - 0x7e and 0x80 - 0xff */
+      g = _mm_cmpgt_epi8 (_mm_xor_si128 (v, _mm_set1_epi8 ((char) 0x80)),
+			  _mm_set1_epi8 ((char) (0x1f ^ 0x80)));
+      g = _mm_andnot_si128 (_mm_cmpeq_epi8 (v, _mm_set1_epi8 (0x7f)), g);
+    }
+  else
+    {
+      /* 0x20 - 0x7e: move them to -128 .. -34 and compare signed */
+      g = _mm_cmplt_epi8 (_mm_add_epi8 (v, _mm_set1_epi8 (0x60)),
+			  _mm_set1_epi8 ((char) 0xdf));
+    }
+  g = _mm_or_si128 (g, _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('\t')));
+  return (unsigned int) _mm_movemask_epi8 (g);
+}
 #endif
-	  if (c == EOF)
-	    return EOF;
-	}
 
-      (*address)++;
-      buf[i] = c;
+/* Return the number of bytes at the start of the LEN bytes at BUF that
+   hold whole characters that are graphic (if WANT is TRUE) or not
+   graphic (if WANT is FALSE).  */
+
+static size_t
+span_chars (const unsigned char *buf, size_t len, bfd_boolean want)
+{
+  size_t i = 0;
+
+  if (encoding_bytes != 1)
+    {
+      for (; i + encoding_bytes <= len; i += encoding_bytes)
+	{
+	  long c = decode_char (buf + i);
+	  if ((STRING_ISGRAPHIC (c) != 0) != want)
+	    break;
+	}
+      return i;
     }
 
-  switch (encoding)
+#ifdef STRINGS_SSE2
+  for (; i + 16 <= len; i += 16)
     {
-    case 'S':
-    case 's':
-      r = buf[0];
-      break;
-    case 'b':
-      r = (buf[0] << 8) | buf[1];
-      break;
-    case 'l':
-      r = buf[0] | (buf[1] << 8);
-      break;
-    case 'B':
-      r = ((long) buf[0] << 24) | ((long) buf[1] << 16) |
-	((long) buf[2] << 8) | buf[3];
-      break;
-    case 'L':
-      r = buf[0] | ((long) buf[1] << 8) | ((long) buf[2] << 16) |
-	((long) buf[3] << 24);
+      unsigned int mask = graphic_mask_sse2 (buf + i);
+      if (! want)
+	mask = ~mask;
+      mask = ~mask & 0xffff;
+      if (mask)
+	return i + __builtin_ctz (mask);
+    }
+#endif
+
+  for (; i < len; i++)
+    if (graphic_table[buf[i]] != want)
       break;
+  return i;
+}
+
+/* Write the LEN bytes of characters at BUF to OUT as single bytes.
+   Return the number of characters.  */
+
+static size_t
+copy_chars (char *out, const unsigned char *buf, size_t len)
+{
+  size_t i, n = 0;
+
+  if (encoding_bytes == 1)
+    {
+      memcpy (out, buf, len);
+      return len;
     }
+  for (i = 0; i + encoding_bytes <= len; i += encoding_bytes)
+    out[n++] = (char) decode_char (buf + i);
+  return n;
+}
+
+/* Print the address and file name that come before a string.  */
 
-  if (r == EOF)
-    return 0;
+static void
+print_prefix (const char *filename, uint64_t start)
+{
+  if (print_filenames)
+    printf ("%s: ", filename);
+  if (print_addresses)
+    switch (address_radix)
+      {
+      case 8:
+	  printf ("%10"PRIo64" ", start);
+	break;
 
-  return r;
+      case 10:
+	  printf ("%10"PRId64" ", start);
+	break;
+
+      case 16:
+	  printf ("%10"PRIx64" ", start);
+	break;
+      }
 }
-
+
 /* Find the strings in file FILENAME, read from STREAM.
-   Assume that STREAM is positioned so that the next byte read
-   is at address ADDRESS in the file.
-   Stop reading at address STOP_POINT in the file, if nonzero.
 
-   If STREAM is NULL, do not read from it.
-   The caller can supply a buffer of characters
-   to be processed before the data in STREAM.
-   MAGIC is the address of the buffer and
-   MAGICCOUNT is how many characters are in it.
-   Those characters come at address ADDRESS and the data in STREAM follow.  */
+   The input is read in blocks of STRINGS_BLOCK_SIZE bytes and each
+   block is searched for runs of graphic characters, so a string can
+   start in one block and end in a later one.  The first STRING_MIN
+   characters of a run are kept in PENDING until we know that the run
+   is long enough to print.  */
 
 static void
-print_strings (const char *filename, FILE *stream, uint64_t address,
-	       uint64_t stop_point, int magiccount, char *magic)
+print_strings (const char *filename, FILE *stream)
 {
-  char *buf = (char *) malloc (sizeof (char) * (string_min + 1));
-  if (buf == NULL) {
+  unsigned char *buf;
+  char *pending, *out;
+  uint64_t address = 0;		/* address of buf[0] */
+  uint64_t start = 0;		/* address of the current run */
+  size_t run = 0;		/* characters in the current run */
+
+  buf = (unsigned char *) malloc (STRINGS_BLOCK_SIZE);
+  pending = (char *) malloc (string_min);
+  out = (char *) malloc (STRINGS_BLOCK_SIZE);
+  if ((buf == NULL) || (pending == NULL) || (out == NULL)) {
       fprintf(stderr, "Error allocating memory\n");
+      free (buf);
+      free (pending);
+      free (out);
       return;
   }
 
   while (1)
     {
-      uint64_t start;
-      int i;
-      long c;
+      size_t len, pos = 0;
 
-      /* See if the next `string_min' chars are all graphic chars.  */
-    tryline:
-      if (stop_point && address >= stop_point)
+      len = fread (buf, 1, STRINGS_BLOCK_SIZE, stream);
+      if (len == 0)
 	break;
-      start = address;
-      for (i = 0; i < string_min; i++)
-	{
-	  c = get_char (stream, &address, &magiccount, &magic);
-	  if (c == EOF) {
-            free(buf);
-	    return;
-          }
-	  if (! STRING_ISGRAPHIC (c))
-	    /* Found a non-graphic.  Try again starting with next char.  */
-	    goto tryline;
-	  buf[i] = c;
-	}
-
-      /* We found a run of `string_min' graphic characters.  Print up
-         to the next non-graphic character.  */
 
-      if (print_filenames)
-	printf ("%s: ", filename);
-      if (print_addresses)
-	switch (address_radix)
-	  {
-	  case 8:
-	      printf ("%10"PRIo64" ", start);
-	    break;
+      while (pos + encoding_bytes <= len)
+	{
+	  size_t n;
 
-	  case 10:
-	      printf ("%10"PRId64" ", start);
-	    break;
+	  if (run == 0)
+	    {
+	      pos += span_chars (buf + pos, len - pos, FALSE);
+	      if (pos + encoding_bytes > len)
+		break;
+	      start = address + pos;
+	    }
 
-	  case 16:
-	      printf ("%10"PRIx64" ", start);
-	    break;
-	  }
+	  n = span_chars (buf + pos, len - pos, TRUE);
 
-      buf[i] = '\0';
-      fputs (buf, stdout);
-      free(buf);
+	  if (run < (size_t) string_min)
+	    {
+	      size_t count = n / encoding_bytes;
+
+	      if (run + count < (size_t) string_min)
+		{
+		  if (pos + n + encoding_bytes <= len)
+		    {
+		      /* Found a non-graphic.  Try again with the next char.  */
+		      run = 0;
+		      pos += n + encoding_bytes;
+		      continue;
+		    }
+		  /* The run continues in the next block.  */
+		  run += copy_chars (pending + run, buf + pos, n);
+		  pos += n;
+		  break;
+		}
+
+	      /* We found a run of `string_min' graphic characters.  */
+	      print_prefix (filename, start);
+	      fwrite (pending, 1, run, stdout);
+	      run = string_min;
+	    }
 
-      while (1)
-	{
-	  c = get_char (stream, &address, &magiccount, &magic);
-	  if (c == EOF)
-	    break;
-	  if (! STRING_ISGRAPHIC (c))
-	    break;
-	  putchar (c);
+	  /* Print up to the next non-graphic character.  */
+	  fwrite (out, 1, copy_chars (out, buf + pos, n), stdout);
+	  pos += n;
+	  if (pos + encoding_bytes <= len)
+	    {
+	      putchar ('\n');
+	      run = 0;
+	      pos += encoding_bytes;
+	    }
 	}
 
-      putchar ('\n');
+      address += len;
+      if (len < STRINGS_BLOCK_SIZE)
+	break;
     }
+
+  if (run >= (size_t) string_min)
+    putchar ('\n');
+
+  free (buf);
+  free (pending);
+  free (out);
 }
-
+
 /* Parse string S as an integer, using decimal radix by default,
    but allowing octal and hex numbers as in C.
 
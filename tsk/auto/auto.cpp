@@ -32,6 +32,10 @@ TskAuto::TskAuto()
     m_curVsPartDescr = "";
     m_imageWriterEnabled = false;
     m_imageWriterPath = NULL;
+    m_useDirIter = false;
+    m_dirIter = NULL;
+    m_fileCopy = NULL;
+    m_volThreads = 0;
 }
 
 
@@ -208,6 +212,12 @@ TskAuto::filterFs(TSK_FS_INFO * /*fs_info*/)
     return TSK_FILTER_CONT;
 }
 
+TSK_RETVAL_ENUM
+TskAuto::finishFs(TSK_FS_INFO * /*fs_info*/)
+{
+    return TSK_OK;
+}
+
 
 
 /**
@@ -309,6 +319,15 @@ TskAuto::findFilesInVs(TSK_OFF_T a_start, TSK_VS_TYPE_ENUM a_vtype)
         if ((retval == TSK_FILTER_STOP) || (retval == TSK_FILTER_SKIP)|| (m_stopAllProcessing))
             return m_errors.empty() ? 0 : 1;
 
+#ifdef TSK_MULTITHREAD_LIB
+        // the iterators are used to save the position of a single walk
+        if ((m_volThreads > 1) && (m_useDirIter == false)) {
+            uint8_t retval2 = findFilesInVsThreads(vs_info);
+            tsk_vs_close(vs_info);
+            return (retval2 || (m_errors.empty() == false)) ? 1 : 0;
+        }
+#endif
+
         /* Walk the allocated volumes (skip metadata and unallocated volumes) */
         if (tsk_vs_part_walk(vs_info, 0, vs_info->part_count - 1,
                 m_volFilterFlags, vsWalkCb, this)) {
@@ -532,6 +551,119 @@ TSK_WALK_RET_ENUM
 }
 
 
+/** \internal
+ * Walks the files of a file system with a TSK_FS_DIR_ITER instead of
+ * tsk_fs_dir_walk() so that the sub-class can save the position of the
+ * walk from processFile() with tsk_fs_dir_iter_checkpoint() on m_dirIter.
+ * If m_dirIterResume is set, the walk continues from that checkpoint
+ * instead of starting at a_inum (and m_dirIterResume is cleared).
+ * @returns 1 on error (error values are set, but not registered) and 0 on success
+ */
+uint8_t
+    TskAuto::findFilesInFsIter(TSK_FS_INFO * a_fs_info, TSK_INUM_T a_inum)
+{
+    if (m_dirIterResume.empty() == false) {
+        m_dirIter = tsk_fs_dir_iter_resume(a_fs_info, &m_dirIterResume[0],
+            m_dirIterResume.size());
+        m_dirIterResume.clear();
+    }
+    else {
+        m_dirIter = tsk_fs_dir_iter_open(a_fs_info, a_inum,
+            (TSK_FS_DIR_WALK_FLAG_ENUM) (TSK_FS_DIR_WALK_FLAG_RECURSE |
+                m_fileFilterFlags), TSK_FS_DIR_ITER_ORDER_DEPTH);
+    }
+    if (m_dirIter == NULL)
+        return 1;
+
+    uint8_t retval = 0;
+    while (true) {
+        TSK_FS_FILE *fs_file;
+        const char *path;
+
+        if (tsk_fs_dir_iter_next(m_dirIter, &fs_file, &path)) {
+            retval = 1;
+            break;
+        }
+        if (fs_file == NULL)
+            break;
+
+        if ((processFile(fs_file, path) == TSK_STOP) || (getStopProcessing()))
+            break;
+    }
+
+    tsk_fs_dir_iter_close(m_dirIter);
+    m_dirIter = NULL;
+    return retval;
+}
+
+
+/**
+ * Make a copy of a file from a directory walk that stays valid after the
+ * walk callback returns.  Only the name is copied; use loadFileMeta() to
+ * load the metadata.  Close the copy with tsk_fs_file_close().
+ * @param a_fs_file File from the walk
+ * @returns NULL on error (error values are set, but not registered)
+ */
+TSK_FS_FILE *
+TskAuto::copyFile(const TSK_FS_FILE * a_fs_file)
+{
+    TSK_FS_FILE *fs_copy;
+    const TSK_FS_NAME *fs_name = a_fs_file->name;
+
+    if ((fs_copy = tsk_fs_file_alloc(a_fs_file->fs_info)) == NULL)
+        return NULL;
+
+    if (((fs_copy->name = tsk_fs_name_alloc(fs_name->name ? strlen(fs_name->name) + 1 : 0,
+                    fs_name->shrt_name ? strlen(fs_name->shrt_name) + 1 : 0)) == NULL)
+        || (tsk_fs_name_copy(fs_copy->name, fs_name))) {
+        tsk_fs_file_close(fs_copy);
+        return NULL;
+    }
+    return fs_copy;
+}
+
+/**
+ * Keep the file that processFile() was given after it returns, if it is a
+ * copy that was made by a volume thread (see setVolumeThreads()).  Such a
+ * copy already has its metadata loaded, so it does not have to be copied
+ * and loaded again.  Close a kept file with tsk_fs_file_close().
+ * @param a_fs_file File that processFile() was given
+ * @returns a_fs_file if it can be kept or NULL if it has to be copied
+ */
+TSK_FS_FILE *
+TskAuto::takeFile(TSK_FS_FILE * a_fs_file)
+{
+    if ((a_fs_file == NULL) || (a_fs_file != m_fileCopy))
+        return NULL;
+    m_fileCopy = NULL;
+    return a_fs_file;
+}
+
+/**
+ * Load the metadata for a copy of a file from the directory walk.  This
+ * follows what tsk_fs_dir_walk() does so that the copy has the same data
+ * as the file that the walk passed to the callback.  Like the walk, and
+ * unlike tsk_fs_dir_get(), it does not compare sequence numbers: deleted
+ * NTFS names and orphan files have one that is less than that of their
+ * metadata, and the NTFS code already uses the name to pick the entry.
+ * @param a_fs_file File with name loaded (see copyFile())
+ */
+void
+TskAuto::loadFileMeta(TSK_FS_FILE * a_fs_file)
+{
+    TSK_FS_INFO *fs = a_fs_file->fs_info;
+
+    if ((a_fs_file->name->meta_addr)
+        || (a_fs_file->name->flags & TSK_FS_NAME_FLAG_ALLOC)) {
+        if (fs->file_add_meta(fs, a_fs_file, a_fs_file->name->meta_addr)) {
+            if (tsk_verbose)
+                tsk_error_print(stderr);
+            tsk_error_reset();
+        }
+    }
+}
+
+
 /** \internal
  * Internal method that the other findFilesInFs can call after they
  * have opened FS_INFO.
@@ -548,15 +680,24 @@ TSK_RETVAL_ENUM
         return TSK_OK;
 
     /* Walk the files, starting at the given inum */
-    if (tsk_fs_dir_walk(a_fs_info, a_inum,
+    uint8_t walkErr;
+    if (m_useDirIter)
+        walkErr = findFilesInFsIter(a_fs_info, a_inum);
+    else
+        walkErr = tsk_fs_dir_walk(a_fs_info, a_inum,
             (TSK_FS_DIR_WALK_FLAG_ENUM) (TSK_FS_DIR_WALK_FLAG_RECURSE |
-                m_fileFilterFlags), dirWalkCb, this)) {
+                m_fileFilterFlags), dirWalkCb, this);
+    if (walkErr) {
 
         tsk_error_set_errstr2(
             "Error walking directory in file system at offset %" PRIuOFF, a_fs_info->offset);
         registerError();
+        finishFs(a_fs_info);
         return TSK_ERR;
     }
+
+    if (finishFs(a_fs_info) == TSK_STOP)
+        return TSK_STOP;
     
     if (m_stopAllProcessing)
         return TSK_STOP;
@@ -600,6 +741,23 @@ TskAuto::processAttribute(TSK_FS_FILE * /*fs_file*/,
 }
 
 
+/**
+ * Sets the number of threads that open and walk the file systems in the
+ * volumes of a volume system.  filterVol(), filterFs(), processFile() and
+ * finishFs() are still called from the calling thread and the files of
+ * each volume are passed to processFile() in the same order as with one
+ * thread, one volume after the other.  filterVol() and filterFs() are
+ * called on a volume when the files of the volumes before it have been
+ * processed, again as with one thread.  Volumes are walked one at a time
+ * if the file systems are walked with iterators.  Default is 0, which
+ * walks one volume at a time.
+ *
+ * @param a_numThreads Number of threads
+ */
+void TskAuto::setVolumeThreads(unsigned int a_numThreads) {
+    m_volThreads = a_numThreads;
+}
+
 void TskAuto::setStopProcessing() {
     m_stopAllProcessing = true;
 }
@@ -14,6 +14,7 @@
  */
 
 #include "tsk_case_db.h"
+#include "work_queue.h"
 #include "tsk/img/img_writer.h"
 #if HAVE_LIBEWF
 #include "tsk/img/ewf.h"
@@ -37,6 +38,7 @@ TskAutoDb::TskAutoDb(TskDb * a_db, TSK_HDB_INFO * a_NSRLDb, TSK_HDB_INFO * a_kno
     m_curImgId = 0;
     m_curVsId = 0;
     m_curVolId = 0;
+    m_curVolAddr = 0;
     m_curFsId = 0;
     m_curFileId = 0;
     m_curUnallocDirId = 0;
@@ -62,6 +64,14 @@ TskAutoDb::TskAutoDb(TskDb * a_db, TSK_HDB_INFO * a_NSRLDb, TSK_HDB_INFO * a_kno
     m_addUnallocSpace = false;
     m_minChunkSize = -1;
     m_maxChunkSize = -1;
+    m_hashThreads = 0;
+    m_hashQueue = NULL;
+    m_curHashJob = NULL;
+    m_checkpointInterval = 0;
+    m_filesSinceCheckpoint = 0;
+    m_checkpointSaved = false;
+    m_resuming = false;
+    m_curFsInfo = NULL;
     tsk_init_lock(&m_curDirPathLock);
 }
 
@@ -79,6 +89,15 @@ TskAutoDb::~TskAutoDb()
 void
  TskAutoDb::closeImage()
 {
+    if (m_hashQueue) {
+        HASH_JOB *job;
+        while ((job = (HASH_JOB *) m_hashQueue->getDone(true)) != NULL) {
+            tsk_fs_file_close(job->fs_file);
+            delete job;
+        }
+        delete m_hashQueue;
+        m_hashQueue = NULL;
+    }
     TskAuto::closeImage();
     m_NSRLDb = NULL;
     m_knownBadDb = NULL;
@@ -97,6 +116,16 @@ void
     m_fileHashFlag = flag;
 }
 
+void TskAutoDb::setHashThreads(unsigned int numThreads)
+{
+    m_hashThreads = numThreads;
+}
+
+void TskAutoDb::setCheckpointInterval(unsigned int numFiles)
+{
+    m_checkpointInterval = numFiles;
+}
+
 void TskAutoDb::setAddFileSystems(bool addFileSystems)
 {
     m_addFileSystems = addFileSystems;
@@ -287,6 +316,13 @@ TskAutoDb::addImageDetails(const char* deviceId)
 TSK_FILTER_ENUM TskAutoDb::filterVs(const TSK_VS_INFO * vs_info)
 {
     m_vsFound = true;
+
+    // the volume system was added before the checkpoint
+    if ((m_resuming) && (m_resumePos.vsFound)) {
+        m_curVsId = m_resumePos.vsId;
+        return TSK_FILTER_CONT;
+    }
+
     if (m_db->addVsInfo(vs_info, m_curImgId, m_curVsId)) {
         registerError();
         return TSK_FILTER_STOP;
@@ -300,6 +336,19 @@ TskAutoDb::filterVol(const TSK_VS_PART_INFO * vs_part)
 {
     m_volFound = true;
     m_foundStructure = true;
+    m_curVolAddr = vs_part->addr;
+
+    // the volumes before the one of the checkpoint are done
+    if ((m_resuming) && (m_resumePos.volFound)) {
+        if (vs_part->addr < m_resumePos.volAddr)
+            return TSK_FILTER_SKIP;
+        else if (vs_part->addr == m_resumePos.volAddr) {
+            m_curVolId = m_resumePos.volId;
+            return TSK_FILTER_CONT;
+        }
+        // the file system of the checkpoint was not found
+        m_resuming = false;
+    }
 
     if (m_db->addVolumeInfo(vs_part, m_curVsId, m_curVolId)) {
         registerError();
@@ -316,7 +365,24 @@ TskAutoDb::filterFs(TSK_FS_INFO * fs_info)
     TSK_FS_FILE *file_root;
     m_foundStructure = true;
 
-    if (m_volFound && m_vsFound) {
+    if (m_resuming) {
+        if (fs_info->offset != m_resumePos.fsOffset) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_AUTO);
+            tsk_error_set_errstr("filterFs: file system at offset %" PRIuOFF
+                " does not match the checkpoint (offset %" PRIuOFF ")",
+                fs_info->offset, m_resumePos.fsOffset);
+            registerError();
+            return TSK_FILTER_STOP;
+        }
+
+        // the file system and its root directory were added before the
+        // checkpoint, continue the walk from where it was
+        m_resuming = false;
+        m_curFsId = m_resumePos.fsId;
+        m_dirIterResume = m_resumePos.dirIter;
+    }
+    else if (m_volFound && m_vsFound) {
         // there's a volume system and volume
         if (m_db->addFsInfo(fs_info, m_curVolId, m_curFsId)) {
             registerError();
@@ -333,7 +399,8 @@ TskAutoDb::filterFs(TSK_FS_INFO * fs_info)
 
 
     // We won't hit the root directory on the walk, so open it now 
-    if ((file_root = tsk_fs_file_open(fs_info, NULL, "/")) != NULL) {
+    if ((m_dirIterResume.empty()) &&
+        ((file_root = tsk_fs_file_open(fs_info, NULL, "/")) != NULL)) {
         processFile(file_root, "");
         tsk_fs_file_close(file_root);
         file_root = NULL;
@@ -353,6 +420,12 @@ TskAutoDb::filterFs(TSK_FS_INFO * fs_info)
     }
 
     setFileFilterFlags(filterFlags);
+    m_filesSinceCheckpoint = 0;
+
+    // filterFs() is called for each file system before any files are
+    // processed when volumes are walked by several threads
+    m_fsIds[fs_info] = m_curFsId;
+    m_curFsInfo = fs_info;
 
     return TSK_FILTER_CONT;
 }
@@ -400,6 +473,10 @@ uint8_t TskAutoDb::addFilesInImgToDb()
     setVolFilterFlags((TSK_VS_PART_FLAG_ENUM) (TSK_VS_PART_FLAG_ALLOC |
             TSK_VS_PART_FLAG_UNALLOC));
 
+    // a checkpoint is the position of a TSK_FS_DIR_ITER, so file systems
+    // are walked with one when checkpoints are saved or resumed
+    m_useDirIter = (m_checkpointInterval > 0) || (m_resuming);
+
     uint8_t retVal = 0;
     if (findFilesInImg()) {
         // map the boolean return value from findFiles to the three-state return value we use
@@ -625,6 +702,78 @@ uint8_t
 #endif
 
 
+/**
+ * Continue an add image process from the last checkpoint that it saved
+ * (see setCheckpointInterval()).  The image is opened, but not added again,
+ * and the files after the checkpoint are added inside of a transaction.
+ * User must call either commitAddImage() to commit the changes,
+ * or revertAddImage() to revert them (back to the checkpoint).
+ *
+ * @param imgId Object ID of the image that was being added
+ * @param numImg Number of image parts
+ * @param imagePaths Array of paths to the image parts
+ * @param imgType Image type
+ * @param sSize Size of device sector in bytes (or 0 for default)
+ * @return 0 for success, 1 for failure
+ */
+uint8_t
+    TskAutoDb::resumeAddImage(int64_t imgId, int numImg,
+    const TSK_TCHAR * const imagePaths[], TSK_IMG_TYPE_ENUM imgType,
+    unsigned int sSize)
+{
+    if (tsk_verbose)
+        tsk_fprintf(stderr, "TskAutoDb::resumeAddImage: Resuming add image process\n");
+
+    if (m_db->inTransaction()) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_AUTO_DB);
+        tsk_error_set_errstr("TskAutoDb::resumeAddImage(): Already in a transaction, image might not be committed");
+        registerError();
+        return 1;
+    }
+
+    string state;
+    if (m_db->getAddImageCheckpoint(imgId, state) == TSK_ERR) {
+        registerError();
+        return 1;
+    }
+    if (state.empty()) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_AUTO_DB);
+        tsk_error_set_errstr("TskAutoDb::resumeAddImage(): No checkpoint for image %" PRId64, imgId);
+        registerError();
+        return 1;
+    }
+    if (checkpointFromString(state, m_resumePos) == false) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_AUTO_DB);
+        tsk_error_set_errstr("TskAutoDb::resumeAddImage(): Invalid checkpoint for image %" PRId64, imgId);
+        registerError();
+        return 1;
+    }
+
+    if (m_db->createSavepoint(TSK_ADD_IMAGE_SAVEPOINT)) {
+        registerError();
+        return 1;
+    }
+    m_imgTransactionOpen = true;
+
+    // the image details are already in the database
+    if (TskAuto::openImage(numImg, imagePaths, imgType, sSize)) {
+        tsk_error_set_errstr2("TskAutoDb::resumeAddImage");
+        registerError();
+        if (revertAddImage())
+            registerError();
+        return 1;
+    }
+
+    m_curImgId = imgId;
+    m_checkpointSaved = true;
+    m_resuming = true;
+    return addFilesInImgToDb();
+}
+
+
 /**
  * Cancel the running process.  Will not be handled immediately. 
  */
@@ -641,6 +790,8 @@ void
 
 /**
  * Revert all changes after the startAddImage() process has run successfully.
+ * If checkpoints were saved, only the changes since the last one are reverted
+ * and the process can be continued with resumeAddImage().
  * @returns 1 on error (error was NOT registered in list), 0 on success
  */
 int
@@ -686,6 +837,11 @@ TskAutoDb::commitAddImage()
         return -1;
     }
 
+    // the image is complete, so it can't be resumed anymore
+    if ((m_checkpointSaved) && (m_db->deleteAddImageCheckpoint(m_curImgId))) {
+        return -1;
+    }
+
     int retval = m_db->releaseSavepoint(TSK_ADD_IMAGE_SAVEPOINT);
     m_imgTransactionOpen = false;
     if (retval == 1) {
@@ -741,6 +897,149 @@ TskAutoDb::processFile(TSK_FS_FILE * fs_file, const char *path)
         tsk_release_lock(&m_curDirPathLock);
     }
 
+    if (fs_file->fs_info != m_curFsInfo) {
+        std::map<const TSK_FS_INFO *, int64_t>::const_iterator it = m_fsIds.find(fs_file->fs_info);
+        if (it != m_fsIds.end())
+            m_curFsId = it->second;
+        m_curFsInfo = fs_file->fs_info;
+    }
+
+    // hash the files in this file system on worker threads
+    if ((m_fileHashFlag) && (m_hashThreads > 1) && (m_hashQueue == NULL)) {
+        m_hashQueue = new TskWorkQueue(m_hashThreads, 4 * m_hashThreads,
+            hashJobCb, this);
+    }
+
+    // files are hashed and added later if we are using hashing threads
+    TSK_RETVAL_ENUM retval;
+    if (m_hashQueue)
+        retval = queueFile(fs_file, path);
+    else
+        retval = addFileToDb(fs_file, path);
+
+    // the root directory is added before the walk starts (and m_dirIter is set)
+    if ((retval == TSK_OK) && (m_checkpointInterval) && (m_dirIter)
+        && (++m_filesSinceCheckpoint >= m_checkpointInterval)) {
+        retval = addCheckpoint(fs_file->fs_info);
+    }
+    return retval;
+}
+
+/**
+ * Commit the files that were added so far together with the position of
+ * the walk, which is right after the file that was last returned by
+ * m_dirIter.
+ * @param a_fs_info File system that is being walked
+ * @returns STOP or OK. All errors have been registered.
+ */
+TSK_RETVAL_ENUM
+TskAutoDb::addCheckpoint(const TSK_FS_INFO * a_fs_info)
+{
+    m_filesSinceCheckpoint = 0;
+
+    // the files that are waiting to be hashed come before the position
+    if ((m_hashQueue) && (addQueuedFiles(true) == TSK_STOP))
+        return TSK_STOP;
+
+    ADD_IMAGE_CHECKPOINT pos;
+    uint8_t *buf;
+    size_t len;
+    if (tsk_fs_dir_iter_checkpoint(m_dirIter, &buf, &len)) {
+        registerError();
+        return TSK_OK;
+    }
+    pos.dirIter.assign(buf, buf + len);
+    free(buf);
+
+    pos.vsFound = m_vsFound;
+    pos.vsId = m_curVsId;
+    pos.volFound = m_volFound;
+    pos.volId = m_curVolId;
+    pos.volAddr = m_curVolAddr;
+    pos.fsId = m_curFsId;
+    pos.fsOffset = a_fs_info->offset;
+
+    if (m_db->saveAddImageCheckpoint(m_curImgId, checkpointToString(pos))) {
+        registerError();
+        return TSK_OK;
+    }
+
+    // we can't go on without the savepoint that revertAddImage() uses
+    if (m_db->commitSavepoint(TSK_ADD_IMAGE_SAVEPOINT)) {
+        tsk_error_set_errstr2("TskAutoDb::addCheckpoint");
+        registerError();
+        return TSK_STOP;
+    }
+    m_checkpointSaved = true;
+
+    if (tsk_verbose)
+        tsk_fprintf(stderr, "TskAutoDb::addCheckpoint: Saved checkpoint in %s\n",
+            getCurDir().c_str());
+    return TSK_OK;
+}
+
+/**
+ * Convert a checkpoint to the text that is stored in the database.
+ */
+std::string
+TskAutoDb::checkpointToString(const ADD_IMAGE_CHECKPOINT & a_pos)
+{
+    static const char hex[] = "0123456789abcdef";
+    stringstream ss;
+
+    ss << "1 " << (a_pos.vsFound ? 1 : 0) << " " << a_pos.vsId << " "
+        << (a_pos.volFound ? 1 : 0) << " " << a_pos.volId << " "
+        << a_pos.volAddr << " " << a_pos.fsId << " " << a_pos.fsOffset << " ";
+    for (size_t i = 0; i < a_pos.dirIter.size(); i++)
+        ss << hex[a_pos.dirIter[i] >> 4] << hex[a_pos.dirIter[i] & 0xf];
+    return ss.str();
+}
+
+/**
+ * Parse a checkpoint that was made by checkpointToString().
+ * @returns false if the text is not a valid checkpoint
+ */
+bool
+TskAutoDb::checkpointFromString(const std::string & a_str, ADD_IMAGE_CHECKPOINT & a_pos)
+{
+    stringstream ss(a_str);
+    int version, vsFound, volFound;
+    std::string dirIter;
+
+    if (!(ss >> version >> vsFound >> a_pos.vsId >> volFound >> a_pos.volId
+            >> a_pos.volAddr >> a_pos.fsId >> a_pos.fsOffset >> dirIter)
+        || (version != 1) || (dirIter.size() % 2))
+        return false;
+
+    a_pos.vsFound = (vsFound != 0);
+    a_pos.volFound = (volFound != 0);
+    a_pos.dirIter.resize(dirIter.size() / 2);
+    for (size_t i = 0; i < dirIter.size(); i++) {
+        char c = dirIter[i];
+        uint8_t val;
+        if ((c >= '0') && (c <= '9'))
+            val = c - '0';
+        else if ((c >= 'a') && (c <= 'f'))
+            val = c - 'a' + 10;
+        else
+            return false;
+        if (i % 2)
+            a_pos.dirIter[i / 2] |= val;
+        else
+            a_pos.dirIter[i / 2] = val << 4;
+    }
+    return true;
+}
+
+/**
+ * Add a file and its attributes to the database.
+ * @param fs_file File to add
+ * @param path Path of parent directory
+ * @returns STOP or OK. All errors have been registered.
+ */
+TSK_RETVAL_ENUM
+TskAutoDb::addFileToDb(TSK_FS_FILE * fs_file, const char *path)
+{
     /* process the attributes.  The case of having 0 attributes can occur
      * with virtual / sparse files and HFS directories.  
      * At some point, this can probably be cleaned
@@ -785,33 +1084,39 @@ TskAutoDb::processAttribute(TSK_FS_FILE * fs_file,
         TSK_DB_FILES_KNOWN_ENUM file_known = TSK_DB_FILES_KNOWN_UNKNOWN;
 
         if (m_fileHashFlag && isFile(fs_file)) {
-            if (md5HashAttr(hash, fs_attr)) {
-                // error was registered
-                return TSK_OK;
-            }
-            md5 = hash;
-
-            if (m_NSRLDb != NULL) {
-                int8_t retval = tsk_hdb_lookup_raw(m_NSRLDb, hash, 16, TSK_HDB_FLAG_QUICK, NULL, NULL);
-                if (retval == -1) {
+            if (m_curHashJob) {
+                // the file was already hashed by a worker thread
+                const HASH_RESULT *result = NULL;
+                for (size_t i = 0; i < m_curHashJob->results.size(); i++) {
+                    if (m_curHashJob->results[i].fs_attr == fs_attr) {
+                        result = &m_curHashJob->results[i];
+                        break;
+                    }
+                }
+                if (result == NULL) {
+                    tsk_error_reset();
+                    tsk_error_set_errno(TSK_ERR_AUTO);
+                    tsk_error_set_errstr("processAttribute: no hash for attribute %d of file %" PRIuINUM,
+                        fs_attr->id, fs_file->name->meta_addr);
                     registerError();
                     return TSK_OK;
-                } 
-                else if (retval) {
-                    file_known = TSK_DB_FILES_KNOWN_KNOWN;
                 }
-            }
-
-            if (m_knownBadDb != NULL) {
-                int8_t retval = tsk_hdb_lookup_raw(m_knownBadDb, hash, 16, TSK_HDB_FLAG_QUICK, NULL, NULL);
-                if (retval == -1) {
+                if (result->failed) {
+                    tsk_error_reset();
+                    tsk_error_set_errno(result->errNo);
+                    tsk_error_set_errstr("%s", result->errStr.c_str());
+                    tsk_error_set_errstr2("%s", result->errStr2.c_str());
                     registerError();
                     return TSK_OK;
-                } 
-                else if (retval) {
-                    file_known = TSK_DB_FILES_KNOWN_KNOWN_BAD;
                 }
+                memcpy(hash, result->md5, 16);
+                file_known = result->known;
             }
+            else if (hashAttr(fs_attr, hash, file_known)) {
+                registerError();
+                return TSK_OK;
+            }
+            md5 = hash;
         }
 
         if (insertFileData(fs_attr->fs_file, fs_attr, path, md5, file_known) == TSK_ERR) {
@@ -850,7 +1155,7 @@ TskAutoDb::processAttribute(TSK_FS_FILE * fs_file,
 
 
 /**
- * Helper for md5HashAttr
+ * Helper for hashAttr
  */
 TSK_WALK_RET_ENUM
 TskAutoDb::md5HashCallback(TSK_FS_FILE * /*file*/, TSK_OFF_T /*offset*/,
@@ -869,13 +1174,17 @@ TskAutoDb::md5HashCallback(TSK_FS_FILE * /*file*/, TSK_OFF_T /*offset*/,
 
 
 /**
- * MD5 hash an attribute and put the result in the given array
- * @param md5Hash array to write the hash to
+ * MD5 hash an attribute and look the hash up in the NSRL and known bad
+ * hash databases.  This is called from the hashing threads, so it does
+ * not register errors.
  * @param fs_attr attribute to hash the data of
- * @return Returns 1 on error (message has been registered)
+ * @param md5Hash array to write the hash to
+ * @param known [out] Known status of the hash
+ * @return Returns 1 on error (message has NOT been registered)
  */
 int
-TskAutoDb::md5HashAttr(unsigned char md5Hash[16], const TSK_FS_ATTR * fs_attr)
+TskAutoDb::hashAttr(const TSK_FS_ATTR * fs_attr, unsigned char md5Hash[16],
+    TSK_DB_FILES_KNOWN_ENUM & known)
 {
     TSK_MD5_CTX md;
 
@@ -883,46 +1192,196 @@ TskAutoDb::md5HashAttr(unsigned char md5Hash[16], const TSK_FS_ATTR * fs_attr)
 
     if (tsk_fs_attr_walk(fs_attr, TSK_FS_FILE_WALK_FLAG_NONE,
             md5HashCallback, (void *) &md)) {
-        registerError();
         return 1;
     }
 
     TSK_MD5_Final(md5Hash, &md);
+
+    known = TSK_DB_FILES_KNOWN_UNKNOWN;
+    if (m_NSRLDb != NULL) {
+        int8_t retval = tsk_hdb_lookup_raw(m_NSRLDb, md5Hash, 16, TSK_HDB_FLAG_QUICK, NULL, NULL);
+        if (retval == -1) {
+            return 1;
+        } 
+        else if (retval) {
+            known = TSK_DB_FILES_KNOWN_KNOWN;
+        }
+    }
+
+    if (m_knownBadDb != NULL) {
+        int8_t retval = tsk_hdb_lookup_raw(m_knownBadDb, md5Hash, 16, TSK_HDB_FLAG_QUICK, NULL, NULL);
+        if (retval == -1) {
+            return 1;
+        } 
+        else if (retval) {
+            known = TSK_DB_FILES_KNOWN_KNOWN_BAD;
+        }
+    }
     return 0;
 }
 
 /**
-* Callback invoked per every unallocated block in the filesystem
+ * Queue a file to be hashed by the worker threads and added to the
+ * database once it and all of the files before it are done.
+ * @param fs_file File from the directory walk (it is copied)
+ * @param path Path of parent directory
+ * @returns STOP or OK. All errors have been registered.
+ */
+TSK_RETVAL_ENUM
+TskAutoDb::queueFile(TSK_FS_FILE * fs_file, const char *path)
+{
+    // add the files that are ready so that the queue doesn't keep growing.
+    // If the files before them are still being hashed, wait for them,
+    // because add() would otherwise block on us.
+    if (addQueuedFiles(false) == TSK_STOP)
+        return TSK_STOP;
+    if ((m_hashQueue->full()) && (addQueuedFiles(true) == TSK_STOP))
+        return TSK_STOP;
+
+    bool needsHash = (isFile(fs_file) && (tsk_fs_file_attr_getsize(fs_file) > 0));
+
+    // files that are not hashed can be added now if they would not get
+    // ahead of files that are still being hashed.
+    if ((needsHash == false) && (m_hashQueue->size() == 0))
+        return addFileToDb(fs_file, path);
+
+    /* The walk closes fs_file when we return, so make our own copy of it.
+     * Files that are hashed get their metadata loaded by the worker thread.
+     * A copy from a volume thread already has its metadata, so keep it. */
+    TSK_FS_FILE *fs_copy;
+    bool loadMeta = false;
+    if ((fs_copy = takeFile(fs_file)) == NULL) {
+        if ((fs_copy = copyFile(fs_file)) == NULL) {
+            registerError();
+            return TSK_OK;
+        }
+        if (needsHash)
+            loadMeta = true;
+        else
+            loadFileMeta(fs_copy);
+    }
+
+    HASH_JOB *job = new HASH_JOB;
+    job->fs_file = fs_copy;
+    job->loadMeta = loadMeta;
+    job->path = path;
+    m_hashQueue->add(job, needsHash);
+    return TSK_OK;
+}
+
+/**
+ * Called by the hashing threads to load a queued file and hash its
+ * default attributes.
+ * @param a_job HASH_JOB to process
+ * @param a_ptr TskAutoDb object
+ */
+void
+TskAutoDb::hashJobCb(void *a_job, void *a_ptr)
+{
+    TskAutoDb *autoDb = (TskAutoDb *) a_ptr;
+    HASH_JOB *job = (HASH_JOB *) a_job;
+    TSK_FS_FILE *fs_file = job->fs_file;
+
+    if (job->loadMeta)
+        loadFileMeta(fs_file);
+
+    int count = tsk_fs_file_attr_getsize(fs_file);
+    for (int i = 0; i < count; i++) {
+        const TSK_FS_ATTR *fs_attr = tsk_fs_file_attr_get_idx(fs_file, i);
+        if ((fs_attr == NULL) || (autoDb->isDefaultType(fs_file, fs_attr) == 0))
+            continue;
+
+        HASH_RESULT result;
+        result.fs_attr = fs_attr;
+        result.known = TSK_DB_FILES_KNOWN_UNKNOWN;
+        result.failed = false;
+        result.errNo = 0;
+        if (autoDb->hashAttr(fs_attr, result.md5, result.known)) {
+            result.failed = true;
+            result.errNo = tsk_error_get_errno();
+            result.errStr = tsk_error_get_errstr();
+            result.errStr2 = tsk_error_get_errstr2();
+        }
+        job->results.push_back(result);
+    }
+    tsk_error_reset();
+}
+
+/**
+ * Add the queued files that are done being hashed to the database, in the
+ * order that they were queued.
+ * @param a_wait True to wait for all queued files to be hashed and added.
+ * @returns STOP or OK. All errors have been registered.
+ */
+TSK_RETVAL_ENUM
+TskAutoDb::addQueuedFiles(bool a_wait)
+{
+    TSK_RETVAL_ENUM retval = TSK_OK;
+    HASH_JOB *job;
+
+    while ((job = (HASH_JOB *) m_hashQueue->getDone(a_wait)) != NULL) {
+        // keep emptying the queue after a stop, but don't add anything else
+        if ((retval != TSK_STOP) && (m_stopped == false)) {
+            m_curHashJob = job;
+            if (addFileToDb(job->fs_file, job->path.c_str()) == TSK_STOP)
+                retval = TSK_STOP;
+            m_curHashJob = NULL;
+        }
+        tsk_fs_file_close(job->fs_file);
+        delete job;
+    }
+    if (m_stopped)
+        retval = TSK_STOP;
+    return retval;
+}
+
+/**
+ * Add the files that are still queued and stop the hashing threads before
+ * the file system is closed.
+ */
+TSK_RETVAL_ENUM
+TskAutoDb::finishFs(TSK_FS_INFO * fs_info)
+{
+    m_fsIds.erase(fs_info);
+    m_curFsInfo = NULL;
+
+    if (m_hashQueue == NULL)
+        return TSK_OK;
+
+    TSK_RETVAL_ENUM retval = addQueuedFiles(true);
+    delete m_hashQueue;
+    m_hashQueue = NULL;
+    return retval;
+}
+
+/**
+* Add an unallocated block to the ranges of the unallocated space files.
 * Creates file ranges and file entries 
 * A single file entry per consecutive range of blocks
-* @param a_block block being walked
-* @param a_ptr a pointer to an UNALLOC_BLOCK_WLK_TRACK struct
-* @returns TSK_WALK_CONT if continue, otherwise TSK_WALK_STOP if stop processing requested
+* @param a_track the unallocated block walk state
+* @param a_addr address of the block
 */
-TSK_WALK_RET_ENUM TskAutoDb::fsWalkUnallocBlocksCb(const TSK_FS_BLOCK *a_block, void *a_ptr) {
-    UNALLOC_BLOCK_WLK_TRACK * unallocBlockWlkTrack = (UNALLOC_BLOCK_WLK_TRACK *) a_ptr;
-
-    if (unallocBlockWlkTrack->tskAutoDb.m_stopAllProcessing)
-        return TSK_WALK_STOP;
+void TskAutoDb::addUnallocBlock(UNALLOC_BLOCK_WLK_TRACK * a_track, TSK_DADDR_T a_addr) {
+    UNALLOC_BLOCK_WLK_TRACK * unallocBlockWlkTrack = a_track;
 
     // initialize if this is the first block
     if (unallocBlockWlkTrack->isStart) {
         unallocBlockWlkTrack->isStart = false;
-        unallocBlockWlkTrack->curRangeStart = a_block->addr;
-        unallocBlockWlkTrack->prevBlock = a_block->addr;
+        unallocBlockWlkTrack->curRangeStart = a_addr;
+        unallocBlockWlkTrack->prevBlock = a_addr;
         unallocBlockWlkTrack->size = unallocBlockWlkTrack->fsInfo.block_size;
         unallocBlockWlkTrack->nextSequenceNo = 0;
-        return TSK_WALK_CONT;
+        return;
     }
 
     // We want to keep consecutive blocks in the same run, so simply update prevBlock and the size
     // if this one is consecutive with the last call. But, if we have hit the max chunk
     // size, then break up this set of consecutive blocks.
-    if ((a_block->addr == unallocBlockWlkTrack->prevBlock + 1) && ((unallocBlockWlkTrack->maxChunkSize <= 0) ||
+    if ((a_addr == unallocBlockWlkTrack->prevBlock + 1) && ((unallocBlockWlkTrack->maxChunkSize <= 0) ||
             (unallocBlockWlkTrack->size < unallocBlockWlkTrack->maxChunkSize))) {
-        unallocBlockWlkTrack->prevBlock = a_block->addr;
+        unallocBlockWlkTrack->prevBlock = a_addr;
 		unallocBlockWlkTrack->size += unallocBlockWlkTrack->fsInfo.block_size;
-        return TSK_WALK_CONT;
+        return;
     }
 
     // this block is not contiguous with the previous one or we've hit the maximum size; create and add a range object
@@ -943,9 +1402,9 @@ TSK_WALK_RET_ENUM TskAutoDb::fsWalkUnallocBlocksCb(const TSK_FS_BLOCK *a_block,
         (unallocBlockWlkTrack->size < unallocBlockWlkTrack->minChunkSize))) {
 
         unallocBlockWlkTrack->size += unallocBlockWlkTrack->fsInfo.block_size;
-        unallocBlockWlkTrack->curRangeStart = a_block->addr;
-        unallocBlockWlkTrack->prevBlock = a_block->addr;
-        return TSK_WALK_CONT;
+        unallocBlockWlkTrack->curRangeStart = a_addr;
+        unallocBlockWlkTrack->prevBlock = a_addr;
+        return;
     }
     
     // at this point we are either chunking and have reached the chunk limit
@@ -957,15 +1416,52 @@ TSK_WALK_RET_ENUM TskAutoDb::fsWalkUnallocBlocksCb(const TSK_FS_BLOCK *a_block,
     }
 
     // reset
-    unallocBlockWlkTrack->curRangeStart = a_block->addr;
-    unallocBlockWlkTrack->prevBlock = a_block->addr;
+    unallocBlockWlkTrack->curRangeStart = a_addr;
+    unallocBlockWlkTrack->prevBlock = a_addr;
     unallocBlockWlkTrack->size = unallocBlockWlkTrack->fsInfo.block_size; // The current block is part of the new range
     unallocBlockWlkTrack->ranges.clear();
     unallocBlockWlkTrack->nextSequenceNo = 0;
 
     //we don't know what the last unalloc block is in advance
     //and will handle the last range in addFsInfoUnalloc()
-    
+}
+
+/**
+* Callback invoked per every run of unallocated blocks in the filesystem
+* @param a_extent blocks being walked
+* @param a_ptr a pointer to an UNALLOC_BLOCK_WLK_TRACK struct
+* @returns TSK_WALK_CONT if continue, otherwise TSK_WALK_STOP if stop processing requested
+*/
+TSK_WALK_RET_ENUM TskAutoDb::fsWalkUnallocBlocksCb(const TSK_FS_BLOCK_EXTENT *a_extent, void *a_ptr) {
+    UNALLOC_BLOCK_WLK_TRACK * unallocBlockWlkTrack = (UNALLOC_BLOCK_WLK_TRACK *) a_ptr;
+    const TSK_DADDR_T blockSize = unallocBlockWlkTrack->fsInfo.block_size;
+    const TSK_DADDR_T endAddr = a_extent->addr + a_extent->len;
+
+    if (unallocBlockWlkTrack->tskAutoDb.m_stopAllProcessing)
+        return TSK_WALK_STOP;
+
+    for (TSK_DADDR_T addr = a_extent->addr; addr < endAddr; ) {
+        addUnallocBlock(unallocBlockWlkTrack, addr);
+        addr++;
+
+        // The following blocks are consecutive, so they are added to the
+        // current range until it reaches the max chunk size.
+        TSK_DADDR_T cnt = endAddr - addr;
+        if (unallocBlockWlkTrack->maxChunkSize > 0) {
+            if (unallocBlockWlkTrack->size >= unallocBlockWlkTrack->maxChunkSize) {
+                cnt = 0;
+            }
+            else {
+                TSK_DADDR_T fit = (unallocBlockWlkTrack->maxChunkSize - unallocBlockWlkTrack->size + blockSize - 1) / blockSize;
+                if (fit < cnt)
+                    cnt = fit;
+            }
+        }
+        unallocBlockWlkTrack->prevBlock += cnt;
+        unallocBlockWlkTrack->size += cnt * blockSize;
+        addr += cnt;
+    }
+
     return TSK_WALK_CONT;
 }
 
@@ -995,7 +1491,7 @@ TSK_RETVAL_ENUM TskAutoDb::addFsInfoUnalloc(const TSK_DB_FS_INFO & dbFsInfo) {
     //walk unalloc blocks on the fs and process them
     //initialize the unalloc block walk tracking 
     UNALLOC_BLOCK_WLK_TRACK unallocBlockWlkTrack(*this, *fsInfo, dbFsInfo.objId, m_minChunkSize, m_maxChunkSize);
-    uint8_t block_walk_ret = tsk_fs_block_walk(fsInfo, fsInfo->first_block, fsInfo->last_block, (TSK_FS_BLOCK_WALK_FLAG_ENUM)(TSK_FS_BLOCK_WALK_FLAG_UNALLOC | TSK_FS_BLOCK_WALK_FLAG_AONLY), 
+    uint8_t block_walk_ret = tsk_fs_block_extent_walk(fsInfo, fsInfo->first_block, fsInfo->last_block, (TSK_FS_BLOCK_WALK_FLAG_ENUM)(TSK_FS_BLOCK_WALK_FLAG_UNALLOC | TSK_FS_BLOCK_WALK_FLAG_AONLY), 
         fsWalkUnallocBlocksCb, &unallocBlockWlkTrack);
 
     if (block_walk_ret == 1) {
@@ -0,0 +1,341 @@
+/*
+ ** The Sleuth Kit
+ **
+ ** Brian Carrier [carrier <at> sleuthkit [dot] org]
+ ** Copyright (c) 2010-2013 Brian Carrier.  All Rights reserved
+ **
+ ** This software is distributed under the Common Public License 1.0
+ **
+ */
+
+/**
+ * \file auto_vs_threads.cpp
+ * Contains the code that TskAuto uses to open and walk the file systems
+ * of several volumes at the same time (see TskAuto::setVolumeThreads()).
+ */
+
+#include "tsk_auto_i.h"
+
+#ifdef TSK_MULTITHREAD_LIB
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/** \internal
+ * Number of files that a volume thread can find before it waits for
+ * them to be processed.
+ */
+#define VOL_WALK_MAX_FILES 4096
+
+/** \internal
+ * A file that was found by a volume thread.
+ */
+typedef struct {
+    TSK_FS_FILE *fs_file;       ///< Copy of the file (with metadata loaded)
+    std::string path;
+    bool inOrphanDir;           ///< True if the file is in the orphan files directory
+} VOL_FILE;
+
+/** \internal
+ * A volume that is being analyzed.  The file system is opened and walked
+ * by a volume thread and the files are processed in order by the thread
+ * that called findFilesInVsThreads().
+ */
+typedef struct {
+    const TSK_VS_PART_INFO *vs_part;
+    TSK_FS_INFO *fs_info;       ///< File system in the volume (or NULL)
+
+    // error from opening or walking the file system
+    bool failed;
+    uint32_t errNo;
+    std::string errStr;
+    std::string errStr2;
+
+    std::mutex lock;            ///< Protects fs_info, files and done
+    std::condition_variable cond;       ///< Signalled when fs_info, files, done or skip change
+    std::deque<VOL_FILE> files; ///< Files found, in walk order, that were not yet processed
+    bool done;                  ///< True once the walk is finished
+    std::atomic<bool> skip;     ///< Set when the files of the volume will not be processed
+    std::atomic<bool> *stop;    ///< Set when processing stops
+} VOL_WALK;
+
+/** \internal
+ * Save the current error values of the calling thread in a volume.
+ */
+static void
+volSaveError(VOL_WALK * a_vol)
+{
+    a_vol->failed = true;
+    a_vol->errNo = tsk_error_get_errno();
+    a_vol->errStr = tsk_error_get_errstr();
+    a_vol->errStr2 = tsk_error_get_errstr2();
+    tsk_error_reset();
+}
+
+/** \internal
+ * Set the error values of the calling thread to the ones saved in a volume.
+ */
+static void
+volRestoreError(const VOL_WALK * a_vol)
+{
+    tsk_error_reset();
+    tsk_error_set_errno(a_vol->errNo);
+    tsk_error_set_errstr("%s", a_vol->errStr.c_str());
+    tsk_error_set_errstr2("%s", a_vol->errStr2.c_str());
+}
+
+/** \internal
+ * Run a function on the numbers 0 to a_count - 1 with up to a_numThreads
+ * threads, in increasing order, and wait for them all to finish.
+ */
+static void
+volRunThreads(unsigned int a_numThreads, size_t a_count,
+    const std::function < void (size_t) > &a_func)
+{
+    std::atomic < size_t > next(0);
+    std::vector < std::thread > threads;
+
+    for (unsigned int i = 0; (i < a_numThreads) && (i < a_count); i++) {
+        threads.push_back(std::thread([&]() {
+            size_t idx;
+            while ((idx = next++) < a_count)
+                a_func(idx);
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+}
+
+/** \internal
+ * Analyzes the volumes of a volume system with m_volThreads threads.  The
+ * file systems are opened and walked at the same time while the calling
+ * thread goes through the volumes in order: it calls filterVol() and
+ * filterFs() on each one and then gives its files to processFile().  The
+ * objects are therefore added in the same order as with one thread.
+ *
+ * The walks start before filterFs() has picked the flags of a file system,
+ * so each one is walked with all files and the flags are applied to the
+ * files as they are processed.  Apart from which files are given to the
+ * callback, the flags only change whether the walk goes into the orphan
+ * files directory (TSK_FS_DIR_WALK_FLAG_NOORPHAN), so the same files are
+ * processed as with tsk_fs_dir_walk() and the flags.
+ * @returns 1 if an error occurred (messages will have been registered) and 0 on success
+ */
+uint8_t
+TskAuto::findFilesInVsThreads(TSK_VS_INFO * a_vs_info)
+{
+    std::atomic<bool> stop(false);
+    std::vector<VOL_WALK *> vols;
+
+    // find the volumes that tsk_vs_part_walk() would give us
+    for (TSK_PNUM_T i = 0; i < a_vs_info->part_count; i++) {
+        const TSK_VS_PART_INFO *vs_part = tsk_vs_part_get(a_vs_info, i);
+        if (vs_part == NULL) {
+            registerError();
+            continue;
+        }
+        if ((vs_part->flags & m_volFilterFlags) == 0)
+            continue;
+
+        VOL_WALK *vol = new VOL_WALK;
+        vol->vs_part = vs_part;
+        vol->fs_info = NULL;
+        vol->failed = false;
+        vol->errNo = 0;
+        vol->done = false;
+        vol->skip = false;
+        vol->stop = &stop;
+        vols.push_back(vol);
+    }
+
+    // queue a copy of each file for the thread that processes them.  The
+    // walk still uses a_fs_file->meta after we return, so the metadata
+    // is loaded once more for the copy here, in the volume thread, and
+    // the copy is then given to processFile() as it is.
+    TSK_WALK_RET_ENUM(*cb) (TSK_FS_FILE *, const char *, void *) =
+        [](TSK_FS_FILE * a_fs_file, const char *a_path, void *a_ptr) {
+        VOL_WALK *vol = (VOL_WALK *) a_ptr;
+        if ((*vol->stop) || (vol->skip))
+            return TSK_WALK_STOP;
+
+        VOL_FILE file;
+        if ((file.fs_file = copyFile(a_fs_file)) == NULL)
+            return TSK_WALK_ERROR;
+        loadFileMeta(file.fs_file);
+        file.path = a_path;
+        file.inOrphanDir = (strncmp(a_path, "$OrphanFiles/", 13) == 0);
+
+        std::unique_lock<std::mutex> lock(vol->lock);
+        while ((vol->files.size() >= VOL_WALK_MAX_FILES)
+            && (*vol->stop == false) && (vol->skip == false))
+            vol->cond.wait(lock);
+        vol->files.push_back(file);
+        vol->cond.notify_all();
+        return TSK_WALK_CONT;
+    };
+
+    // open and walk the file systems
+    TSK_IMG_INFO *img_info = m_img_info;
+    std::thread walker([&]() {
+        volRunThreads(m_volThreads, vols.size(), [&](size_t idx) {
+            VOL_WALK *vol = vols[idx];
+
+            if ((stop == false) && (vol->skip == false)) {
+                TSK_FS_INFO *fs_info = tsk_fs_open_img(img_info,
+                    vol->vs_part->start * vol->vs_part->vs->block_size,
+                    TSK_FS_TYPE_DETECT);
+                if (fs_info == NULL) {
+                    volSaveError(vol);
+                }
+                else {
+                    {
+                        std::unique_lock<std::mutex> lock(vol->lock);
+                        vol->fs_info = fs_info;
+                        vol->cond.notify_all();
+                    }
+                    if (tsk_fs_dir_walk(fs_info, fs_info->root_inum,
+                            (TSK_FS_DIR_WALK_FLAG_ENUM)
+                            (TSK_FS_DIR_WALK_FLAG_RECURSE |
+                                TSK_FS_DIR_WALK_FLAG_ALLOC |
+                                TSK_FS_DIR_WALK_FLAG_UNALLOC), cb, vol)) {
+                        volSaveError(vol);
+                    }
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(vol->lock);
+            vol->done = true;
+            vol->cond.notify_all();
+        });
+    });
+
+    // go through the volumes in order
+    for (size_t i = 0; i < vols.size(); i++) {
+        VOL_WALK *vol = vols[i];
+        bool process = false;
+        TSK_FS_DIR_WALK_FLAG_ENUM flags = TSK_FS_DIR_WALK_FLAG_NONE;
+
+        if (stop == false) {
+            setCurVsPart(vol->vs_part);
+            TSK_FILTER_ENUM retval = filterVol(vol->vs_part);
+            if ((retval == TSK_FILTER_STOP) || (getStopProcessing()))
+                stop = true;
+            else if (retval == TSK_FILTER_CONT)
+                process = true;
+        }
+
+        // wait for the file system to be opened
+        if (process) {
+            std::unique_lock<std::mutex> lock(vol->lock);
+            while ((vol->fs_info == NULL) && (vol->done == false))
+                vol->cond.wait(lock);
+        }
+
+        if ((process) && (vol->fs_info == NULL)) {
+            // same as findFilesInFsRet()
+            process = false;
+            if (getCurVsPartFlag() & TSK_VS_PART_FLAG_ALLOC) {
+                volRestoreError(vol);
+                tsk_error_set_errstr2(
+                    "Sector offset: %" PRIuOFF ", Partition Type: %s",
+                    vol->vs_part->start * vol->vs_part->vs->block_size / 512,
+                    getCurVsPartDescr().c_str());
+                registerError();
+            }
+        }
+        else if (process) {
+            TSK_FILTER_ENUM retval = filterFs(vol->fs_info);
+            if ((retval == TSK_FILTER_STOP) || (m_stopAllProcessing)) {
+                stop = true;
+                process = false;
+            }
+            else if (retval == TSK_FILTER_SKIP) {
+                process = false;
+            }
+            else {
+                flags = (TSK_FS_DIR_WALK_FLAG_ENUM)
+                    (TSK_FS_DIR_WALK_FLAG_RECURSE | m_fileFilterFlags);
+                if ((flags & TSK_FS_DIR_WALK_FLAG_ALLOC) == 0 &&
+                    (flags & TSK_FS_DIR_WALK_FLAG_UNALLOC) == 0) {
+                    flags = (TSK_FS_DIR_WALK_FLAG_ENUM) (flags |
+                        TSK_FS_DIR_WALK_FLAG_ALLOC |
+                        TSK_FS_DIR_WALK_FLAG_UNALLOC);
+                }
+            }
+        }
+
+        // wake up the walks that are waiting on a full queue
+        if (process == false) {
+            std::unique_lock<std::mutex> lock(vol->lock);
+            vol->skip = true;
+            vol->cond.notify_all();
+        }
+        if (stop) {
+            for (size_t j = i; j < vols.size(); j++) {
+                std::unique_lock<std::mutex> lock(vols[j]->lock);
+                vols[j]->cond.notify_all();
+            }
+        }
+
+        // keep emptying the queue when the files are not processed so
+        // that the walk finishes
+        while (true) {
+            VOL_FILE file;
+            {
+                std::unique_lock<std::mutex> lock(vol->lock);
+                while ((vol->files.empty()) && (vol->done == false))
+                    vol->cond.wait(lock);
+                if (vol->files.empty())
+                    break;
+                file = vol->files.front();
+                vol->files.pop_front();
+                vol->cond.notify_all();
+            }
+
+            // the file is closed here unless processFile() kept it
+            m_fileCopy = file.fs_file;
+            if ((process) && (stop == false)
+                && ((file.fs_file->name->flags & flags) ==
+                    file.fs_file->name->flags)
+                && (((flags & TSK_FS_DIR_WALK_FLAG_NOORPHAN) == 0)
+                    || (file.inOrphanDir == false))) {
+                TSK_RETVAL_ENUM retval = processFile(file.fs_file, file.path.c_str());
+                if ((retval == TSK_STOP) || (getStopProcessing())) {
+                    stop = true;
+                    for (size_t j = i; j < vols.size(); j++) {
+                        std::unique_lock<std::mutex> lock(vols[j]->lock);
+                        vols[j]->cond.notify_all();
+                    }
+                }
+            }
+            tsk_fs_file_close(m_fileCopy);
+            m_fileCopy = NULL;
+        }
+
+        if (process) {
+            if (vol->failed) {
+                volRestoreError(vol);
+                tsk_error_set_errstr2(
+                    "Error walking directory in file system at offset %" PRIuOFF,
+                    vol->fs_info->offset);
+                registerError();
+            }
+            if (finishFs(vol->fs_info) == TSK_STOP)
+                stop = true;
+        }
+    }
+    walker.join();
+
+    for (size_t i = 0; i < vols.size(); i++) {
+        if (vols[i]->fs_info)
+            tsk_fs_close(vols[i]->fs_info);
+        delete vols[i];
+    }
+    return 0;
+}
+
+#endif
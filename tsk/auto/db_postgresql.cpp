@@ -220,6 +220,9 @@ int TskDbPostgreSQL::close()
         PQfinish(conn);
         conn = NULL;
     }
+    if (tsk_verbose)
+        m_parentDirIdCache.printStats(stderr);
+    m_parentDirIdCache.clear();
     return 0;
 }
 
@@ -970,6 +973,9 @@ int TskDbPostgreSQL::addFsFile(TSK_FS_FILE * fs_file,
         return 0;
     }
 
+    // drop the cached directories that the walk is done with
+    m_parentDirIdCache.leaveDirs(fsObjId, path);
+
     // Find the object id for the parent folder.
 
     /* Root directory's parent should be the file system object.
@@ -1299,18 +1305,9 @@ int64_t TskDbPostgreSQL::findParObjId(const TSK_FS_FILE * fs_file, const char *p
     }
 
     //get from cache by parent meta addr, if available
-    map<TSK_INUM_T, map<uint32_t, map<uint32_t, int64_t> > > &fsMap = m_parentDirIdCache[fsObjId];
-    if (fsMap.count(fs_file->name->par_addr) > 0) {
-        map<uint32_t, map<uint32_t, int64_t> > &fileMap = fsMap[fs_file->name->par_addr];
-        if (fileMap.count(seq) > 0) {
-            map<uint32_t, int64_t> &pathMap = fileMap[seq];
-            if (pathMap.count(path_hash) > 0) {
-                return pathMap[path_hash];
-            }
-        }
-        else {
-            // printf("Miss: %d\n", fileMap.count(seq));
-        }
+    int64_t cachedObjId = m_parentDirIdCache.find(fsObjId, fs_file->name->par_addr, seq, path_hash);
+    if (cachedObjId != 0) {
+        return cachedObjId;
     }
 
     // Need to break up 'path' in to the parent folder to match in 'parent_path' and the folder
@@ -1401,7 +1398,7 @@ uint32_t TskDbPostgreSQL::hash(const unsigned char *str) {
 }
 
 /**
-* Store info about a directory in a complex map structure as a cache for the
+* Store info about a directory in the parent directory cache for the
 * files who are a child of this directory and want to know its object id.
 *
 * @param fsObjId fs id of this directory
@@ -1432,16 +1429,7 @@ void TskDbPostgreSQL::storeObjId(const int64_t & fsObjId, const TSK_FS_FILE *fs_
         seq = path_hash;
     }
 
-    map<TSK_INUM_T, map<uint32_t, map<uint32_t, int64_t> > > &fsMap = m_parentDirIdCache[fsObjId];
-    if (fsMap.count(fs_file->name->meta_addr) == 0) {
-        fsMap[fs_file->name->meta_addr][seq][path_hash] = objId;
-    }
-    else {
-        map<uint32_t, map<uint32_t, int64_t> > &fileMap = fsMap[fs_file->name->meta_addr];
-        if (fileMap.count(seq) == 0) {
-            fileMap[seq][path_hash] = objId;
-        }
-    }
+    m_parentDirIdCache.add(fsObjId, fs_file->name->meta_addr, seq, path_hash, path, objId);
 }
 
 
@@ -2173,6 +2161,94 @@ int TskDbPostgreSQL::releaseSavepoint(const char *name)
     return attempt_exec(buff, "Error committing transaction: %s\n");
 }
 
+// the checkpoint table is created on demand so that older databases can be used
+static const char *CHECKPOINT_TABLE_SQL =
+    "CREATE TABLE IF NOT EXISTS tsk_add_image_checkpoints (obj_id BIGINT PRIMARY KEY, state TEXT NOT NULL);";
+
+/**
+* Save the position of an add image process so that it can be resumed.
+* The state is written in the current transaction, so it is committed
+* with the files that were added before it.  Replaces an older state for
+* the image.
+* @param imgId Object ID of the image
+* @param state Position of the add image process (printable text)
+* @returns 1 on error, 0 on success
+*/
+int TskDbPostgreSQL::saveAddImageCheckpoint(int64_t imgId, const string & state)
+{
+    char buff[1024];
+
+    if (attempt_exec(CHECKPOINT_TABLE_SQL, "Error creating tsk_add_image_checkpoints table: %s\n")) {
+        return 1;
+    }
+
+    snprintf(buff, 1024, "DELETE FROM tsk_add_image_checkpoints WHERE obj_id = %" PRId64, imgId);
+    if (attempt_exec(buff, "Error deleting add image checkpoint: %s\n")) {
+        return 1;
+    }
+
+    char *state_sql = PQescapeLiteral(conn, state.c_str(), state.size());
+    if (!isEscapedStringValid(state_sql, "", "TskDbPostgreSQL::saveAddImageCheckpoint: Unable to escape checkpoint string%s: %s\n")) {
+        PQfreemem(state_sql);
+        return 1;
+    }
+
+    snprintf(buff, 1024, "INSERT INTO tsk_add_image_checkpoints (obj_id, state) VALUES (%" PRId64 ", ", imgId);
+    string sql = string(buff) + state_sql + ")";
+    PQfreemem(state_sql);
+
+    return attempt_exec(sql.c_str(), "Error adding data to tsk_add_image_checkpoints table: %s\n");
+}
+
+/**
+* Get the position that was saved by saveAddImageCheckpoint().
+* @param imgId Object ID of the image
+* @param state (out) Position of the add image process or an empty string if there is none
+* @returns TSK_ERR on error, TSK_OK on success
+*/
+TSK_RETVAL_ENUM TskDbPostgreSQL::getAddImageCheckpoint(int64_t imgId, string & state)
+{
+    char zSQL[1024];
+
+    state.clear();
+    if (attempt_exec(CHECKPOINT_TABLE_SQL, "Error creating tsk_add_image_checkpoints table: %s\n")) {
+        return TSK_ERR;
+    }
+
+    snprintf(zSQL, 1024, "SELECT state FROM tsk_add_image_checkpoints WHERE obj_id = %" PRId64, imgId);
+    PGresult* res = get_query_result_set(zSQL, "TskDbPostgreSQL::getAddImageCheckpoint: Error selecting from tsk_add_image_checkpoints: %s (result code %d)\n");
+
+    if (verifyResultSetSize(zSQL, res, 1, "TskDbPostgreSQL::getAddImageCheckpoint: Error selecting from tsk_add_image_checkpoints: %s")) {
+        return TSK_ERR;
+    }
+
+    if (PQntuples(res) > 0) {
+        state = PQgetvalue(res, 0, 0);
+    }
+
+    //cleanup
+    PQclear(res);
+
+    return TSK_OK;
+}
+
+/**
+* Delete the position that was saved by saveAddImageCheckpoint().
+* @param imgId Object ID of the image
+* @returns 1 on error, 0 on success
+*/
+int TskDbPostgreSQL::deleteAddImageCheckpoint(int64_t imgId)
+{
+    char buff[1024];
+
+    if (attempt_exec(CHECKPOINT_TABLE_SQL, "Error creating tsk_add_image_checkpoints table: %s\n")) {
+        return 1;
+    }
+
+    snprintf(buff, 1024, "DELETE FROM tsk_add_image_checkpoints WHERE obj_id = %" PRId64, imgId);
+    return attempt_exec(buff, "Error deleting add image checkpoint: %s\n");
+}
+
 /**
 * Returns true if database is opened.
 */
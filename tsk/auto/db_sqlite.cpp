@@ -36,6 +36,10 @@ TskDbSqlite::TskDbSqlite(const char *a_dbFilePathUtf8, bool a_blkMapFlag)
     m_db = NULL;
     m_selectFilePreparedStmt = NULL;
     m_insertObjectPreparedStmt = NULL;
+    m_insertFilePreparedStmt = NULL;
+    m_insertLayoutPreparedStmt = NULL;
+    m_insertLayoutBatchPreparedStmt = NULL;
+    m_deferredIndexes = false;
 }
 
 #ifdef TSK_WIN32
@@ -49,6 +53,10 @@ TskDbSqlite::TskDbSqlite(const TSK_TCHAR * a_dbFilePath, bool a_blkMapFlag)
     m_db = NULL;
     m_selectFilePreparedStmt = NULL;
     m_insertObjectPreparedStmt = NULL;
+    m_insertFilePreparedStmt = NULL;
+    m_insertLayoutPreparedStmt = NULL;
+    m_insertLayoutBatchPreparedStmt = NULL;
+    m_deferredIndexes = false;
 
 	strcpy(m_dbFilePathUtf8, "");
 
@@ -68,12 +76,22 @@ int
     TskDbSqlite::close()
 {
 
+    int retval = 0;
+
     if (m_db) {
+        // write anything that is still buffered and finish the bulk load
+        if (flushFileLayoutRanges() || createDeferredIndexes()) {
+            tsk_error_print(stderr);
+            retval = 1;
+        }
         cleanupFilePreparedStmt();
         sqlite3_close(m_db);
         m_db = NULL;
     }
-    return 0;
+    if (tsk_verbose)
+        m_parentDirIdCache.printStats(stderr);
+    m_parentDirIdCache.clear();
+    return retval;
 }
 
 
@@ -424,21 +442,74 @@ int
     if (createIndexes())
         return 1;
 
+    // the indexes on the tables that the first image is loaded into are
+    // created once it has been added (see createDeferredIndexes()).  The
+    // marker lets a later open() create them if we never get that far.
+    if (attempt_exec("INSERT INTO tsk_db_info_extended (name, value) VALUES ('" TSK_DB_SQLITE_DEFERRED_INDEXES_KEY "', 'true');",
+        "Error adding data to tsk_db_info_extended table: %s\n")) {
+        return 1;
+    }
+    m_deferredIndexes = true;
+
     return 0;
 }
 
 /**
-* Create indexes for the columns that are not primary keys and that we query on. 
+* Create the indexes on the tables that get most of their rows when an image
+* is added.  It is faster for SQLite to build these once after the rows are
+* in the table than to update them for each insert, so they are not created
+* with the rest of the tables.  This is called when the add image savepoint
+* is released and when the database is closed.  If a database is opened that
+* still has the marker from initialize() (the add was interrupted), they are
+* created when the resumed add is committed or the database is closed.
 * @returns 1 on error, 0 on success
 */
-int TskDbSqlite::createIndexes() {
+int TskDbSqlite::createDeferredIndexes() {
+    if (m_deferredIndexes == false)
+        return 0;
+    m_deferredIndexes = false;
+
 	return
 		// tsk_objects index
-		attempt_exec("CREATE INDEX parObjId ON tsk_objects(par_obj_id);",
+		attempt_exec("CREATE INDEX IF NOT EXISTS parObjId ON tsk_objects(par_obj_id);",
 			"Error creating tsk_objects index on par_obj_id: %s\n") ||
 		// file layout index
-		attempt_exec("CREATE INDEX layout_objID ON tsk_file_layout(obj_id);",
+		attempt_exec("CREATE INDEX IF NOT EXISTS layout_objID ON tsk_file_layout(obj_id);",
 			"Error creating layout_objID index on tsk_file_layout: %s\n") ||
+		//file type indexes
+		attempt_exec("CREATE INDEX IF NOT EXISTS mime_type ON tsk_files(dir_type,mime_type,type);", //mime type
+			"Error creating mime_type index on tsk_files: %s\n") ||
+		attempt_exec("CREATE INDEX IF NOT EXISTS file_extension ON tsk_files(extension);",  //file extenssion
+			"Error creating file_extension index on tsk_files: %s\n") ||
+		attempt_exec("DELETE FROM tsk_db_info_extended WHERE name = '" TSK_DB_SQLITE_DEFERRED_INDEXES_KEY "';",
+			"Error removing deferred index marker from tsk_db_info_extended: %s\n");
+}
+
+/**
+* Check if the indexes on the bulk loaded tables were never created for an
+* existing database (the process that added the image did not finish).
+* Databases without the tsk_db_info_extended table never defer them.
+* @returns true if the marker from initialize() is still there
+*/
+bool TskDbSqlite::hasPendingDeferredIndexes() {
+    sqlite3_stmt *stmt = NULL;
+    bool pending = false;
+
+    if (sqlite3_prepare_v2(m_db, "SELECT value FROM tsk_db_info_extended WHERE name = '" TSK_DB_SQLITE_DEFERRED_INDEXES_KEY "'",
+        -1, &stmt, NULL) == SQLITE_OK) {
+        pending = (sqlite3_step(stmt) == SQLITE_ROW);
+    }
+    sqlite3_finalize(stmt);
+    return pending;
+}
+
+/**
+* Create indexes for the columns that are not primary keys and that we query on. 
+* The indexes on the bulk loaded tables are created by createDeferredIndexes().
+* @returns 1 on error, 0 on success
+*/
+int TskDbSqlite::createIndexes() {
+	return
 		// blackboard indexes
 		attempt_exec("CREATE INDEX artifact_objID ON blackboard_artifacts(obj_id);",
 			"Error creating artifact_objID index on blackboard_artifacts: %s\n") ||
@@ -448,11 +519,6 @@ int TskDbSqlite::createIndexes() {
 			"Error creating artifact_objID index on blackboard_artifacts: %s\n") ||
 		attempt_exec("CREATE INDEX attrsArtifactID ON blackboard_attributes(artifact_id);",
 			"Error creating artifact_id index on blackboard_attributes: %s\n") ||
-		//file type indexes
-		attempt_exec("CREATE INDEX mime_type ON tsk_files(dir_type,mime_type,type);", //mime type
-			"Error creating mime_type index on tsk_files: %s\n") ||
-		attempt_exec("CREATE INDEX file_extension ON tsk_files(extension);",  //file extenssion
-			"Error creating file_extension index on tsk_files: %s\n") ||
 		attempt_exec("CREATE INDEX relationships_account1  ON account_relationships(account1_id);", 
 			"Error creating relationships_account1 index on account_relationships: %s\n") ||
 		attempt_exec("CREATE INDEX relationships_account2  ON account_relationships(account2_id);",
@@ -500,6 +566,14 @@ int
         if (initialize())
             return 1;
     }
+    // an add image was interrupted before its indexes were created.  They
+    // are created when the add is resumed and committed (see
+    // releaseSavepoint()) or when the database is closed.
+    else if (hasPendingDeferredIndexes()) {
+        if (tsk_verbose)
+            tsk_fprintf(stderr, "TskDbSqlite::open: Indexes of an interrupted add image are not created yet\n");
+        m_deferredIndexes = true;
+    }
 
     if (setupFilePreparedStmt()) {
         return 1;
@@ -524,6 +598,12 @@ int
         &m_insertObjectPreparedStmt)) {
             return 1;
     }
+    if (prepare_stmt
+        ("INSERT INTO tsk_files (fs_obj_id, obj_id, data_source_obj_id, type, attr_type, attr_id, name, meta_addr, meta_seq, dir_type, meta_type, dir_flags, meta_flags, size, crtime, ctime, atime, mtime, mode, gid, uid, md5, known, parent_path, extension) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+        &m_insertFilePreparedStmt)) {
+            return 1;
+    }
 
     return 0;
 }
@@ -543,6 +623,19 @@ void
         sqlite3_finalize(m_insertObjectPreparedStmt);
         m_insertObjectPreparedStmt = NULL;
     }
+    if (m_insertFilePreparedStmt != NULL) {
+        sqlite3_finalize(m_insertFilePreparedStmt);
+        m_insertFilePreparedStmt = NULL;
+    }
+    if (m_insertLayoutPreparedStmt != NULL) {
+        sqlite3_finalize(m_insertLayoutPreparedStmt);
+        m_insertLayoutPreparedStmt = NULL;
+    }
+    if (m_insertLayoutBatchPreparedStmt != NULL) {
+        sqlite3_finalize(m_insertLayoutBatchPreparedStmt);
+        m_insertLayoutBatchPreparedStmt = NULL;
+    }
+    m_layoutRanges.clear();
 }
 
 /**
@@ -749,6 +842,9 @@ int
     if (fs_file->name == NULL)
         return 0;
 
+    // drop the cached directories that the walk is done with
+    m_parentDirIdCache.leaveDirs(fsObjId, path);
+
     // Find the object id for the parent folder.
 
     /* Root directory's parent should be the file system object.
@@ -789,7 +885,7 @@ uint32_t TskDbSqlite::hash(const unsigned char *str) {
 }
 
 /**
-* Store info about a directory in a complex map structure as a cache for the
+* Store info about a directory in the parent directory cache for the
 * files who are a child of this directory and want to know its object id. 
 *
 * @param fsObjId fs id of this directory
@@ -820,16 +916,7 @@ void TskDbSqlite::storeObjId(const int64_t & fsObjId, const TSK_FS_FILE *fs_file
         seq = path_hash;
     }
 
-    map<TSK_INUM_T, map<uint32_t, map<uint32_t, int64_t> > > &fsMap = m_parentDirIdCache[fsObjId];
-    if (fsMap.count(fs_file->name->meta_addr) == 0) {
-        fsMap[fs_file->name->meta_addr][seq][path_hash] = objId;
-    }
-    else {
-        map<uint32_t, map<uint32_t, int64_t> > &fileMap = fsMap[fs_file->name->meta_addr];
-        if (fileMap.count(seq) == 0) {
-            fileMap[seq][path_hash] = objId;
-        }
-    }
+    m_parentDirIdCache.add(fsObjId, fs_file->name->meta_addr, seq, path_hash, path, objId);
 }
 
 /**
@@ -854,18 +941,9 @@ int64_t TskDbSqlite::findParObjId(const TSK_FS_FILE * fs_file, const char *paren
     }
 
     //get from cache by parent meta addr, if available
-    map<TSK_INUM_T, map<uint32_t, map<uint32_t, int64_t> > > &fsMap = m_parentDirIdCache[fsObjId];
-    if (fsMap.count(fs_file->name->par_addr) > 0) {
-        map<uint32_t, map<uint32_t, int64_t> > &fileMap = fsMap[fs_file->name->par_addr];
-        if (fileMap.count(seq) > 0) {
-            map<uint32_t, int64_t> &pathMap = fileMap[seq];
-            if (pathMap.count(path_hash) > 0) {
-                return pathMap[path_hash];
-            }
-        }
-        else {
-            // printf("Miss: %zu\n", fileMap.count(seq));
-        }
+    int64_t cachedObjId = m_parentDirIdCache.find(fsObjId, fs_file->name->par_addr, seq, path_hash);
+    if (cachedObjId != 0) {
+        return cachedObjId;
     }
 
     // fprintf(stderr, "Miss: %s (%" PRIu64  " - %" PRIu64 ")\n", fs_file->name->name, fs_file->name->meta_addr,
@@ -934,7 +1012,6 @@ int
 	int        uid = 0;
 	int        type = TSK_FS_ATTR_TYPE_NOT_FOUND;
 	int        idx = 0;
-	char *zSQL;
 
 	if (fs_file->name == NULL)
 		return 0;
@@ -1015,34 +1092,12 @@ int
 		return 1;
 	}
 
-	zSQL = sqlite3_mprintf(
-		"INSERT INTO tsk_files (fs_obj_id, obj_id, data_source_obj_id, type, attr_type, attr_id, name, meta_addr, meta_seq, dir_type, meta_type, dir_flags, meta_flags, size, crtime, ctime, atime, mtime, mode, gid, uid, md5, known, parent_path, extension) "
-		"VALUES ("
-		"%" PRId64 ",%" PRId64 ","
-		"%" PRId64 ","
-		"%d,"
-		"%d,%d,'%q',"
-		"%" PRIuINUM ",%d,"
-		"%d,%d,%d,%d,"
-		"%" PRIuOFF ","
-		"%llu,%llu,%llu,%llu,"
-		"%d,%d,%d,%Q,%d,"
-		"'%q','%q')",
-		fsObjId, objId,
-		dataSourceObjId,
-		TSK_DB_FILES_TYPE_FS,
-		type, idx, name,
-		fs_file->name->meta_addr, fs_file->name->meta_seq,
-		fs_file->name->type, meta_type, fs_file->name->flags, meta_flags,
-		size,
-		(unsigned long long)crtime, (unsigned long long)ctime, (unsigned long long) atime, (unsigned long long) mtime,
-		meta_mode, gid, uid, md5TextPtr, known,
-		escaped_path, extension);
-
-	if (attempt_exec(zSQL, "TskDbSqlite::addFile: Error adding data to tsk_files table: %s\n")) {
+	if (insertFileRow(TSK_DB_FILES_TYPE_FS, fsObjId, objId, dataSourceObjId,
+		type, idx, name, fs_file->name, fs_file->name->type, meta_type,
+		meta_flags, size, crtime, ctime, atime, mtime, meta_mode, gid, uid,
+		md5TextPtr, known, escaped_path, extension)) {
 		free(name);
 		free(escaped_path);
-		sqlite3_free(zSQL);
 		return 1;
 	}
 
@@ -1077,46 +1132,105 @@ int
 		}
 
 		// Run the same insert with the new name, size, and type
-		zSQL = sqlite3_mprintf(
-			"INSERT INTO tsk_files (fs_obj_id, obj_id, data_source_obj_id, type, attr_type, attr_id, name, meta_addr, meta_seq, dir_type, meta_type, dir_flags, meta_flags, size, crtime, ctime, atime, mtime, mode, gid, uid, md5, known, parent_path,extension) "
-			"VALUES ("
-			"%" PRId64 ",%" PRId64 ","
-			"%" PRId64 ","
-			"%d,"
-			"%d,%d,'%q',"
-			"%" PRIuINUM ",%d,"
-			"%d,%d,%d,%d,"
-			"%" PRIuOFF ","
-			"%llu,%llu,%llu,%llu,"
-			"%d,%d,%d,NULL,%d,"
-			"'%q','%q')",
-			fsObjId, objId,
-			dataSourceObjId,
-			TSK_DB_FILES_TYPE_SLACK,
-			type, idx, name,
-			fs_file->name->meta_addr, fs_file->name->meta_seq,
-			TSK_FS_NAME_TYPE_REG, TSK_FS_META_TYPE_REG, fs_file->name->flags, meta_flags,
-			slackSize,
-        (unsigned long long)crtime, (unsigned long long)ctime,(unsigned long long) atime,(unsigned long long) mtime, 
-			meta_mode, gid, uid, known,
-			escaped_path,extension);
-
-		if (attempt_exec(zSQL, "TskDbSqlite::addFile: Error adding data to tsk_files table: %s\n")) {
+		if (insertFileRow(TSK_DB_FILES_TYPE_SLACK, fsObjId, objId, dataSourceObjId,
+			type, idx, name, fs_file->name, TSK_FS_NAME_TYPE_REG,
+			TSK_FS_META_TYPE_REG, meta_flags, slackSize,
+			crtime, ctime, atime, mtime, meta_mode, gid, uid,
+			NULL, known, escaped_path, extension)) {
 			free(name);
 			free(escaped_path);
-			sqlite3_free(zSQL);
 			return 1;
 		}
 	}
 
-	sqlite3_free(zSQL);
-
 	free(name);
 	free(escaped_path);
 
 	return 0;
 }
 
+/**
+* Insert a row into tsk_files using the cached prepared statement.
+* @param md5Text Hex MD5 or NULL
+* @returns 1 on error, 0 on success
+*/
+int
+    TskDbSqlite::insertFileRow(TSK_DB_FILES_TYPE_ENUM dbFileType, int64_t fsObjId,
+    int64_t objId, int64_t dataSourceObjId, int attrType, int attrId,
+    const char *name, const TSK_FS_NAME * fs_name, int dirType,
+    int metaType, int metaFlags, TSK_OFF_T size, time_t crtime,
+    time_t ctime, time_t atime, time_t mtime, int mode, int gid,
+    int uid, const char *md5Text, TSK_DB_FILES_KNOWN_ENUM known,
+    const char *parentPath, const char *extension)
+{
+    sqlite3_stmt *stmt = m_insertFilePreparedStmt;
+
+    if (attempt(sqlite3_bind_int64(stmt, 1, fsObjId),
+            "TskDbSqlite::insertFileRow: Error binding fs_obj_id to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int64(stmt, 2, objId),
+            "TskDbSqlite::insertFileRow: Error binding obj_id to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int64(stmt, 3, dataSourceObjId),
+            "TskDbSqlite::insertFileRow: Error binding data_source_obj_id to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 4, dbFileType),
+            "TskDbSqlite::insertFileRow: Error binding type to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 5, attrType),
+            "TskDbSqlite::insertFileRow: Error binding attr_type to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 6, attrId),
+            "TskDbSqlite::insertFileRow: Error binding attr_id to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_text(stmt, 7, name, -1, SQLITE_STATIC),
+            "TskDbSqlite::insertFileRow: Error binding name to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int64(stmt, 8, fs_name->meta_addr),
+            "TskDbSqlite::insertFileRow: Error binding meta_addr to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 9, fs_name->meta_seq),
+            "TskDbSqlite::insertFileRow: Error binding meta_seq to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 10, dirType),
+            "TskDbSqlite::insertFileRow: Error binding dir_type to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 11, metaType),
+            "TskDbSqlite::insertFileRow: Error binding meta_type to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 12, fs_name->flags),
+            "TskDbSqlite::insertFileRow: Error binding dir_flags to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 13, metaFlags),
+            "TskDbSqlite::insertFileRow: Error binding meta_flags to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int64(stmt, 14, size),
+            "TskDbSqlite::insertFileRow: Error binding size to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int64(stmt, 15, (int64_t) crtime),
+            "TskDbSqlite::insertFileRow: Error binding crtime to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int64(stmt, 16, (int64_t) ctime),
+            "TskDbSqlite::insertFileRow: Error binding ctime to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int64(stmt, 17, (int64_t) atime),
+            "TskDbSqlite::insertFileRow: Error binding atime to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int64(stmt, 18, (int64_t) mtime),
+            "TskDbSqlite::insertFileRow: Error binding mtime to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 19, mode),
+            "TskDbSqlite::insertFileRow: Error binding mode to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 20, gid),
+            "TskDbSqlite::insertFileRow: Error binding gid to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 21, uid),
+            "TskDbSqlite::insertFileRow: Error binding uid to statement: %s (result code %d)\n")
+        || attempt(md5Text ? sqlite3_bind_text(stmt, 22, md5Text, -1, SQLITE_STATIC) : sqlite3_bind_null(stmt, 22),
+            "TskDbSqlite::insertFileRow: Error binding md5 to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_int(stmt, 23, known),
+            "TskDbSqlite::insertFileRow: Error binding known to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_text(stmt, 24, parentPath, -1, SQLITE_STATIC),
+            "TskDbSqlite::insertFileRow: Error binding parent_path to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_text(stmt, 25, extension, -1, SQLITE_STATIC),
+            "TskDbSqlite::insertFileRow: Error binding extension to statement: %s (result code %d)\n")
+        || attempt(sqlite3_step(stmt), SQLITE_DONE,
+            "TskDbSqlite::insertFileRow: Error adding data to tsk_files table: %s (result code %d)\n"))
+    {
+        // Statement may be used again, even after error
+        sqlite3_reset(stmt);
+        return 1;
+    }
+
+    if (attempt(sqlite3_reset(stmt),
+        "TskDbSqlite::insertFileRow: Error resetting 'insert file' statement: %s\n")) {
+            return 1;
+    }
+
+    return 0;
+}
+
 
 
 /**
@@ -1131,6 +1245,9 @@ int
     char
         buff[1024];
 
+    if (flushFileLayoutRanges())
+        return 1;
+
     snprintf(buff, 1024, "SAVEPOINT %s", name);
 
     return attempt_exec(buff, "Error setting savepoint: %s\n");
@@ -1147,6 +1264,9 @@ int
     char
         buff[1024];
 
+    if (flushFileLayoutRanges())
+        return 1;
+
     snprintf(buff, 1024, "ROLLBACK TO SAVEPOINT %s", name);
 
     if (attempt_exec(buff, "Error rolling back savepoint: %s\n"))
@@ -1166,13 +1286,47 @@ int
     char
         buff[1024];
 
+    if (flushFileLayoutRanges())
+        return 1;
+
     snprintf(buff, 1024, "RELEASE SAVEPOINT %s", name);
 
-    return attempt_exec(buff, "Error releasing savepoint: %s\n");
+    if (attempt_exec(buff, "Error releasing savepoint: %s\n"))
+        return 1;
+
+    // the bulk load is done once the outermost savepoint is committed
+    if (inTransaction() == false)
+        return createDeferredIndexes();
+    return 0;
 }
 
 
 
+/**
+* Commit everything that was done since a savepoint was created and create
+* the savepoint again.  Unlike releasing the outermost savepoint, this does
+* not finish the bulk load, so the deferred indexes are still created later.
+* @param name Name of savepoint
+* @returns 1 on error, 0 on success
+*/
+int
+    TskDbSqlite::commitSavepoint(const char *name)
+{
+    char
+        buff[1024];
+
+    if (flushFileLayoutRanges())
+        return 1;
+
+    snprintf(buff, 1024, "RELEASE SAVEPOINT %s", name);
+    if (attempt_exec(buff, "Error releasing savepoint: %s\n"))
+        return 1;
+
+    snprintf(buff, 1024, "SAVEPOINT %s", name);
+    return attempt_exec(buff, "Error setting savepoint: %s\n");
+}
+
+
 /**
 * Add file layout info to the database.  This table stores the run information for each file so that we
 * can map which parts of an image are used by what files.
@@ -1186,15 +1340,84 @@ int
     TskDbSqlite::addFileLayoutRange(int64_t a_fileObjId,
     uint64_t a_byteStart, uint64_t a_byteLen, int a_sequence)
 {
-    char
-        foo[1024];
+    // rows are buffered and written in batches by flushFileLayoutRanges()
+    m_layoutRanges.push_back(TSK_DB_FILE_LAYOUT_RANGE(a_byteStart, a_byteLen, a_sequence));
+    m_layoutRanges.back().fileObjId = a_fileObjId;
 
-    snprintf(foo, 1024,
-        "INSERT INTO tsk_file_layout(obj_id, byte_start, byte_len, sequence) VALUES (%" PRId64 ", %" PRIu64 ", %" PRIu64 ", %d)",
-        a_fileObjId, a_byteStart, a_byteLen, a_sequence);
+    if (m_layoutRanges.size() >= TSK_DB_SQLITE_LAYOUT_BATCH)
+        return flushFileLayoutRanges();
+    return 0;
+}
+
+/**
+* Write the buffered file layout rows to the database.  Full batches are
+* written with one multi-row INSERT and the rest one row at a time, both
+* with cached prepared statements.  This must be called before the 
+* tsk_file_layout table is queried and before savepoints are changed.
+* @returns 1 on error
+*/
+int
+    TskDbSqlite::flushFileLayoutRanges()
+{
+    size_t idx = 0;
+    int retval = 0;
+
+    while ((retval == 0) && (idx < m_layoutRanges.size())) {
+        sqlite3_stmt *stmt;
+        size_t rows;
+
+        if (m_layoutRanges.size() - idx >= TSK_DB_SQLITE_LAYOUT_BATCH) {
+            if (m_insertLayoutBatchPreparedStmt == NULL) {
+                string sql = "INSERT INTO tsk_file_layout(obj_id, byte_start, byte_len, sequence) VALUES (?, ?, ?, ?)";
+                for (int i = 1; i < TSK_DB_SQLITE_LAYOUT_BATCH; i++)
+                    sql += ", (?, ?, ?, ?)";
+                if (prepare_stmt(sql.c_str(), &m_insertLayoutBatchPreparedStmt)) {
+                    retval = 1;
+                    break;
+                }
+            }
+            stmt = m_insertLayoutBatchPreparedStmt;
+            rows = TSK_DB_SQLITE_LAYOUT_BATCH;
+        }
+        else {
+            if ((m_insertLayoutPreparedStmt == NULL)
+                && (prepare_stmt("INSERT INTO tsk_file_layout(obj_id, byte_start, byte_len, sequence) VALUES (?, ?, ?, ?)",
+                        &m_insertLayoutPreparedStmt))) {
+                retval = 1;
+                break;
+            }
+            stmt = m_insertLayoutPreparedStmt;
+            rows = 1;
+        }
 
-    return attempt_exec(foo,
-        "Error adding data to tsk_file_layout table: %s\n");
+        for (size_t i = 0; i < rows; i++) {
+            const TSK_DB_FILE_LAYOUT_RANGE & range = m_layoutRanges[idx + i];
+            int col = (int) (i * 4);
+            if (attempt(sqlite3_bind_int64(stmt, col + 1, range.fileObjId),
+                    "TskDbSqlite::flushFileLayoutRanges: Error binding obj_id to statement: %s (result code %d)\n")
+                || attempt(sqlite3_bind_int64(stmt, col + 2, range.byteStart),
+                    "TskDbSqlite::flushFileLayoutRanges: Error binding byte_start to statement: %s (result code %d)\n")
+                || attempt(sqlite3_bind_int64(stmt, col + 3, range.byteLen),
+                    "TskDbSqlite::flushFileLayoutRanges: Error binding byte_len to statement: %s (result code %d)\n")
+                || attempt(sqlite3_bind_int(stmt, col + 4, range.sequence),
+                    "TskDbSqlite::flushFileLayoutRanges: Error binding sequence to statement: %s (result code %d)\n")) {
+                retval = 1;
+                break;
+            }
+        }
+
+        if ((retval == 0) && (attempt(sqlite3_step(stmt), SQLITE_DONE,
+                    "Error adding data to tsk_file_layout table: %s (result code %d)\n"))) {
+            retval = 1;
+        }
+
+        // Statement may be used again, even after error
+        sqlite3_reset(stmt);
+        idx += rows;
+    }
+
+    m_layoutRanges.clear();
+    return retval;
 }
 
 /**
@@ -1532,6 +1755,9 @@ TSK_RETVAL_ENUM TskDbSqlite::addFileWithLayoutRange(const TSK_DB_FILES_TYPE_ENUM
 */
 TSK_RETVAL_ENUM TskDbSqlite::getFileLayouts(vector<TSK_DB_FILE_LAYOUT_RANGE> & fileLayouts) {
     sqlite3_stmt * fileLayoutsStatement = NULL;
+    if (flushFileLayoutRanges()) {
+        return TSK_ERR;
+    }
     if (prepare_stmt("SELECT obj_id, byte_start, byte_len, sequence FROM tsk_file_layout", 
         &fileLayoutsStatement) ) {
             return TSK_ERR;
@@ -1890,3 +2116,105 @@ TSK_RETVAL_ENUM TskDbSqlite::getFsRootDirObjectInfo(const int64_t fsObjId, TSK_D
 }
 
 
+// the checkpoint table is created on demand so that older databases can be used
+static const char *CHECKPOINT_TABLE_SQL =
+    "CREATE TABLE IF NOT EXISTS tsk_add_image_checkpoints (obj_id INTEGER PRIMARY KEY, state TEXT NOT NULL);";
+
+/**
+* Save the position of an add image process so that it can be resumed.
+* The state is written in the current transaction, so it is committed
+* with the files that were added before it.  Replaces an older state for
+* the image.
+* @param imgId Object ID of the image
+* @param state Position of the add image process (printable text)
+* @returns 1 on error, 0 on success
+*/
+int TskDbSqlite::saveAddImageCheckpoint(int64_t imgId, const string & state) {
+    char buff[1024];
+    sqlite3_stmt * stmt = NULL;
+
+    if (attempt_exec(CHECKPOINT_TABLE_SQL,
+        "Error creating tsk_add_image_checkpoints table: %s\n")) {
+            return 1;
+    }
+
+    snprintf(buff, 1024, "DELETE FROM tsk_add_image_checkpoints WHERE obj_id = %" PRId64, imgId);
+    if (attempt_exec(buff, "Error deleting add image checkpoint: %s\n")) {
+        return 1;
+    }
+
+    if (prepare_stmt("INSERT INTO tsk_add_image_checkpoints (obj_id, state) VALUES (?, ?)", &stmt)) {
+        return 1;
+    }
+
+    if (attempt(sqlite3_bind_int64(stmt, 1, imgId),
+        "TskDbSqlite::saveAddImageCheckpoint: Error binding objId to statement: %s (result code %d)\n")
+        || attempt(sqlite3_bind_text(stmt, 2, state.c_str(), (int) state.size(), SQLITE_STATIC),
+        "TskDbSqlite::saveAddImageCheckpoint: Error binding state to statement: %s (result code %d)\n")
+        || attempt(sqlite3_step(stmt), SQLITE_DONE,
+        "TskDbSqlite::saveAddImageCheckpoint: Error inserting checkpoint: %s (result code %d)\n")) {
+            sqlite3_finalize(stmt);
+            return 1;
+    }
+
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+/**
+* Get the position that was saved by saveAddImageCheckpoint().
+* @param imgId Object ID of the image
+* @param state (out) Position of the add image process or an empty string if there is none
+* @returns TSK_ERR on error, TSK_OK on success
+*/
+TSK_RETVAL_ENUM TskDbSqlite::getAddImageCheckpoint(int64_t imgId, string & state) {
+    sqlite3_stmt * stmt = NULL;
+
+    state.clear();
+    if (attempt_exec(CHECKPOINT_TABLE_SQL,
+        "Error creating tsk_add_image_checkpoints table: %s\n")) {
+            return TSK_ERR;
+    }
+
+    if (prepare_stmt("SELECT state FROM tsk_add_image_checkpoints WHERE obj_id = ?", &stmt)) {
+        return TSK_ERR;
+    }
+
+    if (attempt(sqlite3_bind_int64(stmt, 1, imgId),
+        "TskDbSqlite::getAddImageCheckpoint: Error binding objId to statement: %s (result code %d)\n")) {
+            sqlite3_finalize(stmt);
+            return TSK_ERR;
+    }
+
+    int result = sqlite3_step(stmt);
+    if (result == SQLITE_ROW) {
+        const char *text = (const char *) sqlite3_column_text(stmt, 0);
+        if (text)
+            state.assign(text, sqlite3_column_bytes(stmt, 0));
+    }
+    else if (attempt(result, SQLITE_DONE,
+        "TskDbSqlite::getAddImageCheckpoint: Error selecting checkpoint: %s (result code %d)\n")) {
+            sqlite3_finalize(stmt);
+            return TSK_ERR;
+    }
+
+    sqlite3_finalize(stmt);
+    return TSK_OK;
+}
+
+/**
+* Delete the position that was saved by saveAddImageCheckpoint().
+* @param imgId Object ID of the image
+* @returns 1 on error, 0 on success
+*/
+int TskDbSqlite::deleteAddImageCheckpoint(int64_t imgId) {
+    char buff[1024];
+
+    if (attempt_exec(CHECKPOINT_TABLE_SQL,
+        "Error creating tsk_add_image_checkpoints table: %s\n")) {
+            return 1;
+    }
+
+    snprintf(buff, 1024, "DELETE FROM tsk_add_image_checkpoints WHERE obj_id = %" PRId64, imgId);
+    return attempt_exec(buff, "Error deleting add image checkpoint: %s\n");
+}
@@ -0,0 +1,242 @@
+/*
+ ** The Sleuth Kit
+ **
+ ** Brian Carrier [carrier <at> sleuthkit [dot] org]
+ ** Copyright (c) 2010-2013 Brian Carrier.  All Rights reserved
+ **
+ ** This software is distributed under the Common Public License 1.0
+ **
+ */
+
+/**
+ * \file parent_dir_cache.cpp
+ * Contains the implementation of the cache that maps directories to their
+ * database object IDs while an image is being added.
+ */
+
+#include "parent_dir_cache.h"
+
+/** Initial number of slots in the hash table (must be a power of 2) */
+#define TSK_PARENT_DIR_CACHE_INIT 1024
+
+TskParentDirCache::TskParentDirCache()
+{
+    m_count = 0;
+    m_hits = 0;
+    m_misses = 0;
+    m_evictions = 0;
+    m_maxCount = 0;
+}
+
+/**
+ * @returns The slot that the key hashes to
+ */
+size_t
+TskParentDirCache::slot(int64_t a_fsObjId, TSK_INUM_T a_metaAddr,
+    uint32_t a_seq) const
+{
+    uint64_t h = (uint64_t) a_metaAddr;
+    h ^= ((uint64_t) a_seq << 32) | (uint32_t) a_fsObjId;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (size_t) h & (m_table.size() - 1);
+}
+
+/**
+ * @returns The slot with the key or the empty slot where it should be added
+ */
+size_t
+TskParentDirCache::findSlot(int64_t a_fsObjId, TSK_INUM_T a_metaAddr,
+    uint32_t a_seq) const
+{
+    size_t mask = m_table.size() - 1;
+    size_t i = slot(a_fsObjId, a_metaAddr, a_seq);
+
+    while (m_table[i].objId != 0) {
+        const CACHE_ENT & ent = m_table[i];
+        if ((ent.metaAddr == a_metaAddr) && (ent.seq == a_seq)
+            && (ent.fsObjId == a_fsObjId))
+            break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/**
+ * Double the size of the hash table.
+ */
+void
+TskParentDirCache::grow()
+{
+    std::vector<CACHE_ENT> old;
+    old.swap(m_table);
+
+    CACHE_ENT empty;
+    memset(&empty, 0, sizeof(empty));
+    m_table.assign(old.empty() ? TSK_PARENT_DIR_CACHE_INIT : old.size() * 2,
+        empty);
+
+    for (size_t i = 0; i < old.size(); i++) {
+        if (old[i].objId == 0)
+            continue;
+        m_table[findSlot(old[i].fsObjId, old[i].metaAddr, old[i].seq)] =
+            old[i];
+    }
+}
+
+/**
+ * Add a directory to the cache.  Nothing is done if the directory is
+ * already in the cache.  Directories must be added in the order of the
+ * directory walk (see leaveDirs()).
+ * @param a_fsObjId Object ID of the file system
+ * @param a_metaAddr Meta address of the directory
+ * @param a_seq Sequence of the directory (or path hash if the file system
+ * does not have sequences)
+ * @param a_pathHash Hash of the full path of the directory
+ * @param a_fullPath Full path of the directory (parent path and name)
+ * @param a_objId Object ID of the directory
+ */
+void
+TskParentDirCache::add(int64_t a_fsObjId, TSK_INUM_T a_metaAddr,
+    uint32_t a_seq, uint32_t a_pathHash, const char *a_fullPath,
+    int64_t a_objId)
+{
+    if ((m_count + 1) * 4 >= m_table.size() * 3)
+        grow();
+
+    size_t i = findSlot(a_fsObjId, a_metaAddr, a_seq);
+    if (m_table[i].objId != 0)
+        return;
+
+    m_table[i].fsObjId = a_fsObjId;
+    m_table[i].metaAddr = a_metaAddr;
+    m_table[i].seq = a_seq;
+    m_table[i].pathHash = a_pathHash;
+    m_table[i].objId = a_objId;
+    m_count++;
+    if (m_count > m_maxCount)
+        m_maxCount = m_count;
+
+    WALK_ENT walkEnt;
+    walkEnt.fsObjId = a_fsObjId;
+    walkEnt.metaAddr = a_metaAddr;
+    walkEnt.seq = a_seq;
+    walkEnt.fullPath = a_fullPath;
+    m_walkStack.push_back(walkEnt);
+}
+
+/**
+ * Find the object ID of a directory.
+ * @param a_fsObjId Object ID of the file system
+ * @param a_metaAddr Meta address of the directory
+ * @param a_seq Sequence of the directory (or path hash)
+ * @param a_pathHash Hash of the full path of the directory
+ * @returns Object ID or 0 if it is not in the cache
+ */
+int64_t
+TskParentDirCache::find(int64_t a_fsObjId, TSK_INUM_T a_metaAddr,
+    uint32_t a_seq, uint32_t a_pathHash)
+{
+    if (m_count > 0) {
+        const CACHE_ENT & ent = m_table[findSlot(a_fsObjId, a_metaAddr, a_seq)];
+        if ((ent.objId != 0) && (ent.pathHash == a_pathHash)) {
+            m_hits++;
+            return ent.objId;
+        }
+    }
+    m_misses++;
+    return 0;
+}
+
+/**
+ * Remove a key from the hash table.  Linear probing is used, so the
+ * entries after it are shifted back instead of leaving a marker.
+ */
+void
+TskParentDirCache::remove(int64_t a_fsObjId, TSK_INUM_T a_metaAddr,
+    uint32_t a_seq)
+{
+    size_t mask = m_table.size() - 1;
+    size_t i = findSlot(a_fsObjId, a_metaAddr, a_seq);
+    if (m_table[i].objId == 0)
+        return;
+
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (m_table[j].objId == 0)
+            break;
+
+        // move the entry if the empty slot is between its home and j
+        size_t k = slot(m_table[j].fsObjId, m_table[j].metaAddr, m_table[j].seq);
+        if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j)))
+            continue;
+        m_table[i] = m_table[j];
+        i = j;
+    }
+    m_table[i].objId = 0;
+    m_count--;
+    m_evictions++;
+}
+
+/**
+ * Remove the directories whose subtree has been walked.  The walk is depth
+ * first, so once a file with a parent outside of a directory is seen, the
+ * directory will not have any more children.  Call this before each file
+ * is added.
+ * @param a_fsObjId Object ID of the file system of the file being added
+ * @param a_parentPath Parent path of the file being added
+ */
+void
+TskParentDirCache::leaveDirs(int64_t a_fsObjId, const char *a_parentPath)
+{
+    size_t plen = strlen(a_parentPath);
+
+    while (m_walkStack.empty() == false) {
+        const WALK_ENT & walkEnt = m_walkStack.back();
+
+        // stop at the first directory that the file is in
+        if (walkEnt.fsObjId == a_fsObjId) {
+            size_t dlen = walkEnt.fullPath.size();
+            if ((dlen == 0) || ((plen > dlen)
+                    && (a_parentPath[dlen] == '/')
+                    && (walkEnt.fullPath.compare(0, dlen, a_parentPath, dlen) == 0)))
+                break;
+        }
+
+        remove(walkEnt.fsObjId, walkEnt.metaAddr, walkEnt.seq);
+        m_walkStack.pop_back();
+    }
+}
+
+/**
+ * Remove all entries from the cache.
+ */
+void
+TskParentDirCache::clear()
+{
+    std::vector<CACHE_ENT>().swap(m_table);
+    std::vector<WALK_ENT>().swap(m_walkStack);
+    m_count = 0;
+}
+
+/**
+ * Print the hit, miss and memory statistics of the cache.
+ */
+void
+TskParentDirCache::printStats(FILE * a_fd)
+{
+    size_t pathBytes = 0;
+    for (size_t i = 0; i < m_walkStack.size(); i++)
+        pathBytes += sizeof(WALK_ENT) + m_walkStack[i].fullPath.capacity();
+
+    tsk_fprintf(a_fd,
+        "parent dir cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64
+        " evictions, %" PRIuSIZE " entries (%" PRIuSIZE " max), %" PRIuSIZE
+        " table bytes, %" PRIuSIZE " walk stack bytes\n", m_hits, m_misses,
+        m_evictions, m_count, m_maxCount,
+        m_table.size() * sizeof(CACHE_ENT), pathBytes);
+}
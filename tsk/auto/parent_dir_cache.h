@@ -0,0 +1,81 @@
+/*
+ ** The Sleuth Kit
+ **
+ ** Brian Carrier [carrier <at> sleuthkit [dot] org]
+ ** Copyright (c) 2010-2013 Brian Carrier.  All Rights reserved
+ **
+ ** This software is distributed under the Common Public License 1.0
+ **
+ */
+
+/**
+ * \file parent_dir_cache.h
+ * Contains the interface of the cache that maps directories to their
+ * database object IDs while an image is being added.
+ */
+
+#ifndef _TSK_PARENT_DIR_CACHE_H
+#define _TSK_PARENT_DIR_CACHE_H
+
+#include "tsk/fs/tsk_fs_i.h"
+
+#include <string>
+#include <vector>
+
+/** \internal
+ * Cache of directory object IDs that is used to find the parent object of
+ * each file as it is added to the database.  Entries are keyed on the file
+ * system object ID, directory meta address and sequence (or path hash) and
+ * are kept in a single open addressing hash table.
+ *
+ * The directories are added in the order of the directory walk, so the
+ * cache also keeps the stack of directories that are being walked.  Once
+ * a file from outside of a directory's subtree is added, all of the
+ * directory's children have been added and its entry is removed.  Lookups
+ * that miss must fall back to the database.
+ */
+class TskParentDirCache {
+  public:
+    TskParentDirCache();
+
+    void add(int64_t a_fsObjId, TSK_INUM_T a_metaAddr, uint32_t a_seq,
+        uint32_t a_pathHash, const char *a_fullPath, int64_t a_objId);
+    int64_t find(int64_t a_fsObjId, TSK_INUM_T a_metaAddr, uint32_t a_seq,
+        uint32_t a_pathHash);
+    void leaveDirs(int64_t a_fsObjId, const char *a_parentPath);
+    void clear();
+    void printStats(FILE * a_fd);
+
+  private:
+    typedef struct {
+        int64_t fsObjId;
+        TSK_INUM_T metaAddr;
+        uint32_t seq;
+        uint32_t pathHash;
+        int64_t objId;          ///< 0 if the slot is empty
+    } CACHE_ENT;
+
+    typedef struct {
+        int64_t fsObjId;
+        TSK_INUM_T metaAddr;
+        uint32_t seq;
+        std::string fullPath;
+    } WALK_ENT;
+
+    std::vector<CACHE_ENT> m_table;     ///< Hash table (size is a power of 2)
+    size_t m_count;             ///< Number of used slots in m_table
+    std::vector<WALK_ENT> m_walkStack;  ///< Cached directories whose subtree is being walked
+
+    // statistics
+    uint64_t m_hits;
+    uint64_t m_misses;
+    uint64_t m_evictions;
+    size_t m_maxCount;
+
+    size_t slot(int64_t a_fsObjId, TSK_INUM_T a_metaAddr, uint32_t a_seq) const;
+    size_t findSlot(int64_t a_fsObjId, TSK_INUM_T a_metaAddr, uint32_t a_seq) const;
+    void remove(int64_t a_fsObjId, TSK_INUM_T a_metaAddr, uint32_t a_seq);
+    void grow();
+};
+
+#endif
@@ -95,6 +95,7 @@ class TskAuto {
 
     void setFileFilterFlags(TSK_FS_DIR_WALK_FLAG_ENUM);
     void setVolFilterFlags(TSK_VS_PART_FLAG_ENUM);
+    void setVolumeThreads(unsigned int a_numThreads);
 
     /**
      * TskAuto calls this method before it processes the volume system that is found in an 
@@ -139,6 +140,15 @@ class TskAuto {
     virtual TSK_RETVAL_ENUM processFile(TSK_FS_FILE * fs_file,
         const char *path) = 0;
 
+    /**
+     * TskAuto calls this method after it has walked the files in a file system and
+     * before the file system is closed.  Implementations of processFile() that defer
+     * work on the files can use it to finish that work. 
+     * @param fs_info file system details
+     * @returns STOP or OK. All error must have been registered. 
+     */
+    virtual TSK_RETVAL_ENUM finishFs(TSK_FS_INFO * fs_info);
+
 	/**
 	 * Enables image writer, which creates a copy of the image as it is being processed.
 	 * @param imagePath UTF8 version of path to write the image to
@@ -215,6 +225,7 @@ class TskAuto {
   private:
     TSK_VS_PART_FLAG_ENUM m_volFilterFlags;
     TSK_FS_DIR_WALK_FLAG_ENUM m_fileFilterFlags;
+    unsigned int m_volThreads;  ///< Number of threads that walk the volumes of a volume system (0 or 1 to walk them in order)
     
     std::vector<error_record> m_errors;
 
@@ -228,6 +239,8 @@ class TskAuto {
         const TSK_VS_PART_INFO * vs_part, void *ptr);
 
     TSK_RETVAL_ENUM findFilesInFsInt(TSK_FS_INFO *, TSK_INUM_T inum);
+    uint8_t findFilesInFsIter(TSK_FS_INFO *, TSK_INUM_T inum);
+    uint8_t findFilesInVsThreads(TSK_VS_INFO * vs_info);
 
     std::string m_curVsPartDescr; ///< description string of the current volume being processed
     TSK_VS_PART_FLAG_ENUM m_curVsPartFlag; ///< Flag of the current volume being processed
@@ -252,11 +265,19 @@ class TskAuto {
     uint8_t isNonResident(const TSK_FS_ATTR * fs_attr);
 	bool m_imageWriterEnabled;
     TSK_TCHAR * m_imageWriterPath;
+    bool m_useDirIter;          ///< True to walk file systems with a TSK_FS_DIR_ITER instead of tsk_fs_dir_walk()
+    TSK_FS_DIR_ITER * m_dirIter;        ///< Iterator that is walking the current file system (only set if m_useDirIter is true)
+    std::vector<uint8_t> m_dirIterResume;       ///< Iterator checkpoint that the next file system walk continues from (if not empty)
+    TSK_FS_FILE * m_fileCopy;   ///< Copy of a file, with its metadata loaded, that processFile() is being given by a volume thread walk (it can be kept with takeFile())
 
     
     TSK_RETVAL_ENUM processAttributes(TSK_FS_FILE * fs_file,
         const char *path);
 
+    static TSK_FS_FILE *copyFile(const TSK_FS_FILE * fs_file);
+    TSK_FS_FILE *takeFile(TSK_FS_FILE * fs_file);
+    static void loadFileMeta(TSK_FS_FILE * fs_file);
+
     /** 
      * Method that is called from processAttributes() for each attribute that a file
      * has.  processAttributes() is not called by default.  It exists so that implementations
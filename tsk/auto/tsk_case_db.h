@@ -17,6 +17,7 @@
 #ifndef _TSK_AUTO_CASE_H
 #define _TSK_AUTO_CASE_H
 
+#include <map>
 #include <string>
 using std::string;
 
@@ -27,6 +28,8 @@ using std::string;
 
 #define TSK_ADD_IMAGE_SAVEPOINT "ADDIMAGE"
 
+class TskWorkQueue;
+
 /** \internal
  * C++ class that implements TskAuto to load file metadata into a database. 
  * This is used by the TskCaseDb class. 
@@ -48,6 +51,7 @@ class TskAutoDb:public TskAuto {
     virtual TSK_FILTER_ENUM filterFs(TSK_FS_INFO * fs_info);
     virtual TSK_RETVAL_ENUM processFile(TSK_FS_FILE * fs_file,
         const char *path);
+    virtual TSK_RETVAL_ENUM finishFs(TSK_FS_INFO * fs_info);
     virtual void createBlockMap(bool flag);
     const std::string getCurDir();
     
@@ -65,6 +69,31 @@ class TskAutoDb:public TskAuto {
      */
     virtual void hashFiles(bool flag);
 
+    /**
+     * Sets the number of threads that calculate hash values and look them up
+     * while files are added.  The file system is still walked and the database
+     * is still written by the calling thread, in the same order as with a single
+     * thread, so object IDs do not depend on this setting.
+     * Default is 0, which hashes files on the calling thread.
+     *
+     * @param numThreads Number of hashing threads.
+     */
+    void setHashThreads(unsigned int numThreads);
+
+    /**
+     * Sets how often the add image process saves a checkpoint.  A checkpoint
+     * commits the files that were added so far together with the position of
+     * the walk (volume, file system and directory), so that an add image
+     * process that was killed can be continued with resumeAddImage().  Once a
+     * checkpoint has been saved, revertAddImage() only reverts the changes
+     * that were made after it.  File systems are walked with a
+     * TSK_FS_DIR_ITER while checkpoints are enabled.
+     * Default is 0, which does not save checkpoints.
+     *
+     * @param numFiles Number of files to add between checkpoints.
+     */
+    void setCheckpointInterval(unsigned int numFiles);
+
     /**
      * Sets whether or not the file systems for an image should be added when 
      * the image is added to the case database. The default value is true. 
@@ -117,6 +146,9 @@ class TskAutoDb:public TskAuto {
     uint8_t startAddImage(int numImg, const char *const imagePaths[],
         TSK_IMG_TYPE_ENUM imgType, unsigned int sSize, const char* deviceId = NULL);
 #endif
+    uint8_t resumeAddImage(int64_t imgId, int numImg,
+        const TSK_TCHAR * const imagePaths[], TSK_IMG_TYPE_ENUM imgType,
+        unsigned int sSize);
     void stopAddImage();
     int revertAddImage();
     int64_t commitAddImage();
@@ -126,7 +158,10 @@ class TskAutoDb:public TskAuto {
     int64_t m_curImgId;     ///< Object ID of image currently being processed
     int64_t m_curVsId;      ///< Object ID of volume system currently being processed
     int64_t m_curVolId;     ///< Object ID of volume currently being processed
+    TSK_PNUM_T m_curVolAddr;    ///< Address of volume currently being processed
     int64_t m_curFsId;      ///< Object ID of file system currently being processed
+    const TSK_FS_INFO * m_curFsInfo;    ///< File system of m_curFsId
+    std::map<const TSK_FS_INFO *, int64_t> m_fsIds;  ///< Object IDs of the file systems that are open
     int64_t m_curFileId;    ///< Object ID of file currently being processed
     TSK_INUM_T m_curDirAddr;		///< Meta address the directory currently being processed
     int64_t m_curUnallocDirId;	
@@ -148,6 +183,47 @@ class TskAutoDb:public TskAuto {
     int64_t m_maxChunkSize; ///< Max number of unalloc bytes to process before writing to the database, even if there is no natural break. -1 for no chunking
     bool m_foundStructure;  ///< Set to true when we find either a volume or file system
     bool m_attributeAdded; ///< Set to true when an attribute was added by processAttributes
+    unsigned int m_hashThreads; ///< Number of threads to hash files with (0 or 1 to hash in processAttribute())
+    TskWorkQueue * m_hashQueue; ///< Files waiting to be hashed and added, in walk order (NULL unless hashing in threads)
+    unsigned int m_checkpointInterval; ///< Number of files between checkpoints (0 for no checkpoints)
+    unsigned int m_filesSinceCheckpoint; ///< Number of files that were added since the last checkpoint
+    bool m_checkpointSaved; ///< True if the database has a checkpoint for the current image
+
+    // position of the add image process that is saved in a checkpoint
+    typedef struct {
+        bool vsFound;
+        int64_t vsId;
+        bool volFound;
+        int64_t volId;
+        TSK_PNUM_T volAddr;     ///< Address of the volume in the volume system
+        int64_t fsId;
+        TSK_OFF_T fsOffset;     ///< Byte offset of the file system in the image
+        std::vector<uint8_t> dirIter;   ///< Checkpoint of the directory walk (see tsk_fs_dir_iter_checkpoint())
+    } ADD_IMAGE_CHECKPOINT;
+
+    ADD_IMAGE_CHECKPOINT m_resumePos; ///< Checkpoint that is being resumed
+    bool m_resuming;    ///< True until the walk gets to the file system of m_resumePos
+
+    // results of hashing the attributes of a queued file
+    typedef struct {
+        const TSK_FS_ATTR * fs_attr;
+        unsigned char md5[16];
+        TSK_DB_FILES_KNOWN_ENUM known;
+        bool failed;
+        uint32_t errNo;
+        std::string errStr;
+        std::string errStr2;
+    } HASH_RESULT;
+
+    // a file waiting in m_hashQueue
+    typedef struct {
+        TSK_FS_FILE * fs_file;  ///< Copy of the file owned by the job
+        bool loadMeta;          ///< True if the metadata of fs_file still has to be loaded
+        std::string path;
+        vector<HASH_RESULT> results;
+    } HASH_JOB;
+
+    const HASH_JOB * m_curHashJob;  ///< Queued file that is being added (its hashes are used by processAttribute())
 
     // prevent copying until we add proper logic to handle it
     TskAutoDb(const TskAutoDb&);
@@ -180,9 +256,18 @@ class TskAutoDb:public TskAuto {
     static TSK_WALK_RET_ENUM md5HashCallback(TSK_FS_FILE * file,
         TSK_OFF_T offset, TSK_DADDR_T addr, char *buf, size_t size,
         TSK_FS_BLOCK_FLAG_ENUM a_flags, void *ptr);
-    int md5HashAttr(unsigned char md5Hash[16], const TSK_FS_ATTR * fs_attr);
+    int hashAttr(const TSK_FS_ATTR * fs_attr, unsigned char md5Hash[16],
+        TSK_DB_FILES_KNOWN_ENUM & known);
+    TSK_RETVAL_ENUM addFileToDb(TSK_FS_FILE * fs_file, const char *path);
+    TSK_RETVAL_ENUM queueFile(TSK_FS_FILE * fs_file, const char *path);
+    TSK_RETVAL_ENUM addQueuedFiles(bool a_wait);
+    TSK_RETVAL_ENUM addCheckpoint(const TSK_FS_INFO * fs_info);
+    static std::string checkpointToString(const ADD_IMAGE_CHECKPOINT & a_pos);
+    static bool checkpointFromString(const std::string & a_str, ADD_IMAGE_CHECKPOINT & a_pos);
+    static void hashJobCb(void *a_job, void *a_ptr);
 
-    static TSK_WALK_RET_ENUM fsWalkUnallocBlocksCb(const TSK_FS_BLOCK *a_block, void *a_ptr);
+    static void addUnallocBlock(UNALLOC_BLOCK_WLK_TRACK * a_track, TSK_DADDR_T a_addr);
+    static TSK_WALK_RET_ENUM fsWalkUnallocBlocksCb(const TSK_FS_BLOCK_EXTENT *a_extent, void *a_ptr);
     TSK_RETVAL_ENUM addFsInfoUnalloc(const TSK_DB_FS_INFO & dbFsInfo);
     TSK_RETVAL_ENUM addUnallocFsSpaceToDb(size_t & numFs);
     TSK_RETVAL_ENUM addUnallocVsSpaceToDb(size_t & numVsP);
@@ -40,6 +40,19 @@ TSK_RETVAL_ENUM TskDb::setConnectionInfo(CaseDbConnectionInfo * /*info*/){
     return TSK_OK;
 }
 
+/**
+* Commit everything that was done since a savepoint was created and create
+* the savepoint again, so that a later revert only goes back to this point.
+* @param name Name of savepoint
+* @returns 1 on error, 0 on success
+*/
+int TskDb::commitSavepoint(const char *name)
+{
+    if (releaseSavepoint(name))
+        return 1;
+    return createSavepoint(name);
+}
+
 /*
 * Utility method to break up path into parent folder and folder/file name. 
 * @param path Path of folder that we want to analyze
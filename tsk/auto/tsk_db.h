@@ -196,6 +196,7 @@ class TskDb {
     virtual int createSavepoint(const char *name) = 0;
     virtual int revertSavepoint(const char *name) = 0;
     virtual int releaseSavepoint(const char *name) = 0;
+    virtual int commitSavepoint(const char *name);
     virtual bool inTransaction() = 0;
     virtual bool dbExists() = 0;
 
@@ -211,6 +212,11 @@ class TskDb {
     virtual TSK_RETVAL_ENUM getParentImageId (const int64_t objId, int64_t & imageId) = 0;
     virtual TSK_RETVAL_ENUM getFsRootDirObjectInfo(const int64_t fsObjId, TSK_DB_OBJECT & rootDirObjInfo) = 0;
 
+    // add image checkpoints
+    virtual int saveAddImageCheckpoint(int64_t imgId, const string & state) = 0;
+    virtual TSK_RETVAL_ENUM getAddImageCheckpoint(int64_t imgId, string & state) = 0;
+    virtual int deleteAddImageCheckpoint(int64_t imgId) = 0;
+
   protected:
 	
 	  /**
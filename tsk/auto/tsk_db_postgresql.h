@@ -19,6 +19,7 @@
 #define _TSK_DB_POSTGRESQL_H
 
 #include "tsk_db.h"
+#include "parent_dir_cache.h"
 #ifdef HAVE_LIBPQ_
 #if defined(TSK_WIN32) || defined(HAVE_LIBPQ_FE_H)
     #include "libpq-fe.h"
@@ -92,6 +93,10 @@ class TskDbPostgreSQL : public TskDb {
     TSK_RETVAL_ENUM getParentImageId (const int64_t objId, int64_t & imageId);
     TSK_RETVAL_ENUM getFsRootDirObjectInfo(const int64_t fsObjId, TSK_DB_OBJECT & rootDirObjInfo);
 
+    int saveAddImageCheckpoint(int64_t imgId, const string & state);
+    TSK_RETVAL_ENUM getAddImageCheckpoint(int64_t imgId, string & state);
+    int deleteAddImageCheckpoint(int64_t imgId);
+
 private:
 
     PGconn *conn;
@@ -125,7 +130,7 @@ class TskDbPostgreSQL : public TskDb {
     void storeObjId(const int64_t & fsObjId, const TSK_FS_FILE *fs_file, const char *path, const int64_t & objId);
     int64_t findParObjId(const TSK_FS_FILE * fs_file, const char *path, const int64_t & fsObjId);
     uint32_t hash(const unsigned char *str);
-    map<int64_t, map<TSK_INUM_T, map<uint32_t, map<uint32_t, int64_t> > > > m_parentDirIdCache; //maps a file system ID to a map, which maps a directory file system meta address to a map, which maps a sequence ID to a map, which maps a hash of a path to its object ID in the database
+    TskParentDirCache m_parentDirIdCache; ///< maps a directory (file system ID, meta address, sequence or path hash) to its object ID in the database
 
     TSK_RETVAL_ENUM addFileWithLayoutRange(const TSK_DB_FILES_TYPE_ENUM dbFileType, const int64_t parentObjId, const int64_t fsObjId,
         const uint64_t size, vector<TSK_DB_FILE_LAYOUT_RANGE> & ranges, int64_t & objId, int64_t dataSourceObjId);
@@ -20,6 +20,7 @@
 #include <map>
 
 #include "tsk_db.h"
+#include "parent_dir_cache.h"
 
 #ifdef HAVE_LIBSQLITE3
   #include <sqlite3.h>
@@ -30,6 +31,19 @@
 using std::map;
 using std::vector;
 
+/** \internal
+ * Number of tsk_file_layout rows that are buffered and written with a 
+ * single multi-row INSERT.  4 values are bound per row, so this must stay
+ * below SQLITE_MAX_VARIABLE_NUMBER / 4.
+ */
+#define TSK_DB_SQLITE_LAYOUT_BATCH 128
+
+/** \internal
+ * Name of the tsk_db_info_extended row that is there while the indexes on
+ * the bulk loaded tables have not been created yet.
+ */
+#define TSK_DB_SQLITE_DEFERRED_INDEXES_KEY "DEFERRED_INDEXES_PENDING"
+
 /** \internal
  * C++ class that wraps the database internals. 
  */
@@ -74,6 +88,7 @@ class TskDbSqlite : public TskDb {
     int createSavepoint(const char *name);
     int revertSavepoint(const char *name);
     int releaseSavepoint(const char *name);
+    int commitSavepoint(const char *name);
     bool inTransaction();
     bool dbExists();
 
@@ -87,6 +102,10 @@ class TskDbSqlite : public TskDb {
     TSK_RETVAL_ENUM getParentImageId (const int64_t objId, int64_t & imageId);
     TSK_RETVAL_ENUM getFsRootDirObjectInfo(const int64_t fsObjId, TSK_DB_OBJECT & rootDirObjInfo);
 
+    int saveAddImageCheckpoint(int64_t imgId, const string & state);
+    TSK_RETVAL_ENUM getAddImageCheckpoint(int64_t imgId, string & state);
+    int deleteAddImageCheckpoint(int64_t imgId);
+
 
   private:
     // prevent copying until we add proper logic to handle it
@@ -97,6 +116,16 @@ class TskDbSqlite : public TskDb {
     int setupFilePreparedStmt();
     void cleanupFilePreparedStmt();
     int createIndexes();
+    int createDeferredIndexes();
+    bool hasPendingDeferredIndexes();
+    int flushFileLayoutRanges();
+    int insertFileRow(TSK_DB_FILES_TYPE_ENUM dbFileType, int64_t fsObjId,
+        int64_t objId, int64_t dataSourceObjId, int attrType, int attrId,
+        const char *name, const TSK_FS_NAME * fs_name, int dirType,
+        int metaType, int metaFlags, TSK_OFF_T size, time_t crtime,
+        time_t ctime, time_t atime, time_t mtime, int mode, int gid,
+        int uid, const char *md5Text, TSK_DB_FILES_KNOWN_ENUM known,
+        const char *parentPath, const char *extension);
     int attempt(int resultCode, const char *errfmt);
     int attempt(int resultCode, int expectedResultCode,
         const char *errfmt);
@@ -123,7 +152,12 @@ class TskDbSqlite : public TskDb {
     bool m_utf8; //encoding used for the database file name, not the actual database
     sqlite3_stmt *m_selectFilePreparedStmt;
     sqlite3_stmt *m_insertObjectPreparedStmt;
-    map<int64_t, map<TSK_INUM_T, map<uint32_t, map<uint32_t, int64_t> > > > m_parentDirIdCache; //maps a file system ID to a map, which maps a directory file system meta address to a map, which maps a sequence ID to a map, which maps a hash of a path to its object ID in the database
+    sqlite3_stmt *m_insertFilePreparedStmt;
+    sqlite3_stmt *m_insertLayoutPreparedStmt;       ///< Inserts a single tsk_file_layout row (prepared on first use)
+    sqlite3_stmt *m_insertLayoutBatchPreparedStmt;  ///< Inserts TSK_DB_SQLITE_LAYOUT_BATCH tsk_file_layout rows (prepared on first use)
+    vector<TSK_DB_FILE_LAYOUT_RANGE> m_layoutRanges;        ///< Layout rows that have not been written yet
+    bool m_deferredIndexes;     ///< True if the indexes on the bulk loaded tables still need to be created
+    TskParentDirCache m_parentDirIdCache; ///< maps a directory (file system ID, meta address, sequence or path hash) to its object ID in the database
 };
 
 #endif
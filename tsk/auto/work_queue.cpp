@@ -0,0 +1,189 @@
+/*
+ ** The Sleuth Kit
+ **
+ ** Brian Carrier [carrier <at> sleuthkit [dot] org]
+ ** Copyright (c) 2010-2013 Brian Carrier.  All Rights reserved
+ **
+ ** This software is distributed under the Common Public License 1.0
+ **
+ */
+
+/**
+ * \file work_queue.cpp
+ * Contains the implementation of a queue that runs jobs on a pool of worker
+ * threads and returns them in the order that they were added.
+ */
+
+#include "work_queue.h"
+
+/* Number of jobs, as a multiple of the jobs that can wait for a worker,
+ * that can be waiting to be returned by getDone() before add() blocks.
+ * Jobs that are done stay in the queue until the jobs before them are,
+ * and jobs that need no work are not limited by a_maxQueued. */
+#define TSK_WORK_QUEUE_ORDER_MULT 4
+
+/**
+ * @param a_numThreads Number of worker threads to start
+ * @param a_maxQueued Number of jobs that can wait for a worker before add() blocks
+ * @param a_work Function to run on each job
+ * @param a_ptr Pointer to pass to a_work
+ */
+TskWorkQueue::TskWorkQueue(unsigned int a_numThreads, size_t a_maxQueued,
+    TSK_WORK_FUNC a_work, void *a_ptr)
+{
+    m_work = a_work;
+    m_ptr = a_ptr;
+    m_maxQueued = (a_maxQueued > 0) ? a_maxQueued : 1;
+    m_maxOrder = TSK_WORK_QUEUE_ORDER_MULT * m_maxQueued;
+#ifdef TSK_MULTITHREAD_LIB
+    m_shutdown = false;
+    for (unsigned int i = 0; i < a_numThreads; i++) {
+        m_threads.push_back(std::thread(&TskWorkQueue::workerLoop, this));
+    }
+#endif
+}
+
+/**
+ * Waits for the workers to finish the jobs that they have been given and
+ * stops them.  Jobs that were not returned by getDone() are not freed.
+ */
+TskWorkQueue::~TskWorkQueue()
+{
+#ifdef TSK_MULTITHREAD_LIB
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_shutdown = true;
+    }
+    m_todoCond.notify_all();
+    for (size_t i = 0; i < m_threads.size(); i++) {
+        m_threads[i].join();
+    }
+#endif
+    while (m_order.empty() == false) {
+        delete m_order.front();
+        m_order.pop_front();
+    }
+}
+
+/**
+ * Add a job to the queue.  Blocks while the maximum number of jobs are
+ * waiting for a worker or while full() is true.  Because only getDone()
+ * makes room for the latter, a thread that both adds and gets jobs should
+ * get them until full() is false before adding another.
+ * @param a_job Job to add
+ * @param a_needsWork False if the job should only be kept in order and
+ * returned by getDone() without being passed to the work function.
+ */
+void
+TskWorkQueue::add(void *a_job, bool a_needsWork)
+{
+    WORK_ENTRY *entry = new WORK_ENTRY;
+    entry->job = a_job;
+    entry->done = (a_needsWork == false);
+
+#ifdef TSK_MULTITHREAD_LIB
+    if (m_threads.empty() == false) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        while (m_order.size() >= m_maxOrder)
+            m_orderCond.wait(lock);
+        m_order.push_back(entry);
+        if (a_needsWork) {
+            while (m_todo.size() >= m_maxQueued)
+                m_spaceCond.wait(lock);
+            m_todo.push_back(entry);
+            lock.unlock();
+            m_todoCond.notify_one();
+        }
+        return;
+    }
+#endif
+
+    // no workers, so do the work now
+    if (a_needsWork) {
+        m_work(a_job, m_ptr);
+        entry->done = true;
+    }
+    m_order.push_back(entry);
+}
+
+/**
+ * Return the oldest job that has not been returned yet, once it is done.
+ * @param a_wait True to wait for the job to be done.
+ * @returns The job or NULL if there are no jobs in the queue or if a_wait
+ * is false and the oldest job is not done yet.
+ */
+void *
+TskWorkQueue::getDone(bool a_wait)
+{
+#ifdef TSK_MULTITHREAD_LIB
+    std::unique_lock<std::mutex> lock(m_lock);
+    while ((m_order.empty() == false) && (m_order.front()->done == false)) {
+        if (a_wait == false)
+            return NULL;
+        m_doneCond.wait(lock);
+    }
+#endif
+    if (m_order.empty())
+        return NULL;
+
+    WORK_ENTRY *entry = m_order.front();
+    m_order.pop_front();
+#ifdef TSK_MULTITHREAD_LIB
+    lock.unlock();
+    m_orderCond.notify_one();
+#endif
+    void *job = entry->job;
+    delete entry;
+    return job;
+}
+
+/**
+ * @returns Number of jobs that have been added but not yet returned by getDone()
+ */
+size_t
+TskWorkQueue::size()
+{
+#ifdef TSK_MULTITHREAD_LIB
+    std::unique_lock<std::mutex> lock(m_lock);
+#endif
+    return m_order.size();
+}
+
+/**
+ * @returns True if add() would block until getDone() returns a job
+ */
+bool
+TskWorkQueue::full()
+{
+#ifdef TSK_MULTITHREAD_LIB
+    std::unique_lock<std::mutex> lock(m_lock);
+    return (m_threads.empty() == false) && (m_order.size() >= m_maxOrder);
+#else
+    return false;
+#endif
+}
+
+#ifdef TSK_MULTITHREAD_LIB
+void
+TskWorkQueue::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (true) {
+        while (m_todo.empty() && (m_shutdown == false))
+            m_todoCond.wait(lock);
+        if (m_todo.empty())
+            break;
+
+        WORK_ENTRY *entry = m_todo.front();
+        m_todo.pop_front();
+        m_spaceCond.notify_one();
+
+        lock.unlock();
+        m_work(entry->job, m_ptr);
+        lock.lock();
+
+        entry->done = true;
+        m_doneCond.notify_all();
+    }
+}
+#endif
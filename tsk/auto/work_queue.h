@@ -0,0 +1,86 @@
+/*
+ ** The Sleuth Kit
+ **
+ ** Brian Carrier [carrier <at> sleuthkit [dot] org]
+ ** Copyright (c) 2010-2013 Brian Carrier.  All Rights reserved
+ **
+ ** This software is distributed under the Common Public License 1.0
+ **
+ */
+
+/**
+ * \file work_queue.h
+ * Contains the interface of a queue that runs jobs on a pool of worker
+ * threads and returns them in the order that they were added.
+ */
+
+#ifndef _TSK_WORK_QUEUE_H
+#define _TSK_WORK_QUEUE_H
+
+#include "tsk/base/tsk_base_i.h"
+
+#include <deque>
+#include <vector>
+
+#ifdef TSK_MULTITHREAD_LIB
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+/**
+ * Runs jobs on a pool of worker threads.  Jobs are returned by getDone()
+ * in the order they were passed to add(), regardless of the order in which
+ * the workers finish them, so that the results can be consumed in a
+ * deterministic order by a single thread.  Without multithreading support
+ * the jobs are run by add().
+ */
+class TskWorkQueue {
+  public:
+    /**
+     * Function run by the workers on each job.  It must be thread safe.
+     * @param a_job Job passed to add()
+     * @param a_ptr Pointer passed to the constructor
+     */
+    typedef void (*TSK_WORK_FUNC) (void *a_job, void *a_ptr);
+
+    TskWorkQueue(unsigned int a_numThreads, size_t a_maxQueued,
+        TSK_WORK_FUNC a_work, void *a_ptr);
+    ~TskWorkQueue();
+
+    void add(void *a_job, bool a_needsWork);
+    void *getDone(bool a_wait);
+    size_t size();
+    bool full();
+
+  private:
+    typedef struct {
+        void *job;
+        bool done;
+    } WORK_ENTRY;
+
+    TSK_WORK_FUNC m_work;
+    void *m_ptr;
+    size_t m_maxQueued;
+    size_t m_maxOrder;
+    std::deque<WORK_ENTRY *> m_order;   ///< Jobs not yet returned by getDone(), in the order they were added
+    std::deque<WORK_ENTRY *> m_todo;    ///< Jobs waiting for a worker
+
+#ifdef TSK_MULTITHREAD_LIB
+    std::vector<std::thread> m_threads;
+    std::mutex m_lock;          ///< protects m_order, m_todo, m_shutdown and WORK_ENTRY.done
+    std::condition_variable m_todoCond;     ///< signalled when a job is added to m_todo or on shutdown
+    std::condition_variable m_spaceCond;    ///< signalled when a job is taken from m_todo
+    std::condition_variable m_doneCond;     ///< signalled when a job is finished
+    std::condition_variable m_orderCond;    ///< signalled when getDone() returns a job
+    bool m_shutdown;
+
+    void workerLoop();
+#endif
+
+    // prevent copying
+    TskWorkQueue(const TskWorkQueue&);
+    TskWorkQueue & operator=(const TskWorkQueue&);
+};
+
+#endif
@@ -39,6 +39,26 @@ extern "C" {
     extern void tsk_take_lock(tsk_lock_t *);
     extern void tsk_release_lock(tsk_lock_t *);
 
+/* Read and publish a pointer that other threads can read without taking
+ * a lock.  tsk_atomic_load_ptr() has acquire and tsk_atomic_store_ptr()
+ * release semantics, so the object that a pointer refers to is fully
+ * initialized before other threads can see the pointer.  They are used
+ * to build caches once (under a lock) and to read them without one. */
+#ifndef TSK_MULTITHREAD_LIB
+#define tsk_atomic_load_ptr(a_ptr) (*(void **) (a_ptr))
+#define tsk_atomic_store_ptr(a_ptr, a_val) (*(void **) (a_ptr) = (void *) (a_val))
+#elif defined(_MSC_VER)
+#define tsk_atomic_load_ptr(a_ptr) \
+    InterlockedCompareExchangePointer((PVOID volatile *) (a_ptr), NULL, NULL)
+#define tsk_atomic_store_ptr(a_ptr, a_val) \
+    InterlockedExchangePointer((PVOID volatile *) (a_ptr), (PVOID) (a_val))
+#else
+#define tsk_atomic_load_ptr(a_ptr) \
+    __atomic_load_n((void **) (a_ptr), __ATOMIC_ACQUIRE)
+#define tsk_atomic_store_ptr(a_ptr, a_val) \
+    __atomic_store_n((void **) (a_ptr), (void *) (a_val), __ATOMIC_RELEASE)
+#endif
+
 #ifndef rounddown
 #define rounddown(x, y)	\
     ((((x) % (y)) == 0) ? (x) : \
@@ -69,24 +69,30 @@ print_list_head(TSK_FS_INFO * fs)
 }
 
 static TSK_WALK_RET_ENUM
-print_list(const TSK_FS_BLOCK * fs_block, void *ptr)
+print_list(const TSK_FS_BLOCK_EXTENT * fs_extent, void *ptr)
 {
-    tsk_printf("%" PRIuDADDR "|%s\n", fs_block->addr,
-        (fs_block->flags & TSK_FS_BLOCK_FLAG_ALLOC) ? "a" : "f");
+    TSK_DADDR_T addr;
+
+    for (addr = fs_extent->addr; addr < fs_extent->addr + fs_extent->len;
+        addr++) {
+        tsk_printf("%" PRIuDADDR "|%s\n", addr,
+            (fs_extent->flags & TSK_FS_BLOCK_FLAG_ALLOC) ? "a" : "f");
+    }
     return TSK_WALK_CONT;
 }
 
 
 
-/* print_block - write data block to stdout */
+/* print_block - write data blocks to stdout */
 static TSK_WALK_RET_ENUM
-print_block(const TSK_FS_BLOCK * fs_block, void *ptr)
+print_block(const TSK_FS_BLOCK_EXTENT * fs_extent, void *ptr)
 {
     if (tsk_verbose)
-        tsk_fprintf(stderr, "write block %" PRIuDADDR "\n",
-            fs_block->addr);
+        tsk_fprintf(stderr, "write blocks %" PRIuDADDR "-%" PRIuDADDR
+            "\n", fs_extent->addr, fs_extent->addr + fs_extent->len - 1);
 
-    if (fwrite(fs_block->buf, fs_block->fs_info->block_size, 1,
+    if (fwrite(fs_extent->buf,
+            (size_t) fs_extent->len * fs_extent->fs_info->block_size, 1,
             stdout) != 1) {
         tsk_error_reset();
         tsk_error_set_errno(TSK_ERR_FS_WRITE);
@@ -220,8 +226,8 @@ tsk_fs_blkls(TSK_FS_INFO * fs, TSK_FS_BLKLS_FLAG_ENUM a_blklsflags,
             return 1;
 
         a_block_flags |= TSK_FS_BLOCK_WALK_FLAG_AONLY;
-        if (tsk_fs_block_walk(fs, bstart, blast, a_block_flags, print_list,
-                &data))
+        if (tsk_fs_block_extent_walk(fs, bstart, blast, a_block_flags,
+                print_list, &data))
             return 1;
     }
     else {
@@ -235,7 +241,7 @@ tsk_fs_blkls(TSK_FS_INFO * fs, TSK_FS_BLKLS_FLAG_ENUM a_blklsflags,
             return 1;
         }
 #endif
-        if (tsk_fs_block_walk(fs, bstart, blast, a_block_flags,
+        if (tsk_fs_block_extent_walk(fs, bstart, blast, a_block_flags,
                 print_block, &data))
             return 1;
     }
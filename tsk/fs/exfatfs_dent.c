@@ -65,7 +65,7 @@ exfatfs_reset_name_info(EXFATFS_FS_NAME_INFO *a_name_info)
     assert(a_name_info != NULL);
     assert(a_name_info->fs_name != NULL);
     assert(a_name_info->fs_name->name != NULL);
-    assert(a_name_info->fs_name->name_size == FATFS_MAXNAMLEN_UTF8);
+    assert(a_name_info->fs_name->name_size >= FATFS_MAXNAMLEN_UTF8);
 
     a_name_info->last_dentry_type = EXFATFS_DIR_ENTRY_TYPE_NONE;
     a_name_info->expected_secondary_entry_count = 0;
@@ -96,7 +96,7 @@ exfatfs_add_name_to_dir_and_reset_info(EXFATFS_FS_NAME_INFO *a_name_info)
     assert(a_name_info != NULL);
     assert(a_name_info->fs_name != NULL);
     assert(a_name_info->fs_name->name != NULL);
-    assert(a_name_info->fs_name->name_size == FATFS_MAXNAMLEN_UTF8);
+    assert(a_name_info->fs_name->name_size >= FATFS_MAXNAMLEN_UTF8);
     assert(a_name_info->fs_dir != NULL);
 
     /* If the name has not been converted to UTF8 yet, do it now */
@@ -142,7 +142,7 @@ exfats_parse_file_dentry(EXFATFS_FS_NAME_INFO *a_name_info, FATFS_DENTRY *a_dent
     assert(a_name_info->fatfs != NULL);
     assert(a_name_info->fs_name != NULL);
     assert(a_name_info->fs_name->name != NULL);
-    assert(a_name_info->fs_name->name_size == FATFS_MAXNAMLEN_UTF8);
+    assert(a_name_info->fs_name->name_size >= FATFS_MAXNAMLEN_UTF8);
     assert(a_name_info->fs_dir != NULL);
     assert(dentry != NULL);
     assert(exfatfs_get_enum_from_type(dentry->entry_type) == EXFATFS_DIR_ENTRY_TYPE_FILE);
@@ -202,7 +202,7 @@ exfats_parse_file_stream_dentry(EXFATFS_FS_NAME_INFO *a_name_info, FATFS_DENTRY
     assert(a_name_info->fatfs != NULL);
     assert(a_name_info->fs_name != NULL);
     assert(a_name_info->fs_name->name != NULL);
-    assert(a_name_info->fs_name->name_size == FATFS_MAXNAMLEN_UTF8);
+    assert(a_name_info->fs_name->name_size >= FATFS_MAXNAMLEN_UTF8);
     assert(a_name_info->fs_dir != NULL);
     assert(dentry != NULL);
     assert(exfatfs_get_enum_from_type(dentry->entry_type) == EXFATFS_DIR_ENTRY_TYPE_FILE_STREAM);
@@ -263,7 +263,7 @@ exfats_parse_file_name_dentry(EXFATFS_FS_NAME_INFO *a_name_info, FATFS_DENTRY *a
     assert(a_name_info->fatfs != NULL);
     assert(a_name_info->fs_name != NULL);
     assert(a_name_info->fs_name->name != NULL);
-    assert(a_name_info->fs_name->name_size == FATFS_MAXNAMLEN_UTF8);
+    assert(a_name_info->fs_name->name_size >= FATFS_MAXNAMLEN_UTF8);
     assert(a_name_info->fs_dir != NULL);
     assert(dentry != NULL);
     assert(exfatfs_get_enum_from_type(dentry->entry_type) == EXFATFS_DIR_ENTRY_TYPE_FILE_NAME);
@@ -335,7 +335,7 @@ exfats_parse_vol_label_dentry(EXFATFS_FS_NAME_INFO *a_name_info, FATFS_DENTRY *a
     assert(a_name_info->fatfs != NULL);
     assert(a_name_info->fs_name != NULL);
     assert(a_name_info->fs_name->name != NULL);
-    assert(a_name_info->fs_name->name_size == FATFS_MAXNAMLEN_UTF8);
+    assert(a_name_info->fs_name->name_size >= FATFS_MAXNAMLEN_UTF8);
     assert(a_name_info->fs_dir != NULL);
     assert(dentry != NULL);
     assert(exfatfs_get_enum_from_type(dentry->entry_type) == EXFATFS_DIR_ENTRY_TYPE_VOLUME_LABEL);
@@ -408,7 +408,7 @@ exfats_parse_special_file_dentry(EXFATFS_FS_NAME_INFO *a_name_info, FATFS_DENTRY
     assert(a_name_info->fatfs != NULL);
     assert(a_name_info->fs_name != NULL);
     assert(a_name_info->fs_name->name != NULL);
-    assert(a_name_info->fs_name->name_size == FATFS_MAXNAMLEN_UTF8);
+    assert(a_name_info->fs_name->name_size >= FATFS_MAXNAMLEN_UTF8);
     assert(a_name_info->fs_dir != NULL);
     assert(a_dentry != NULL);
     assert(fatfs_inum_is_in_range(a_name_info->fatfs, a_inum));
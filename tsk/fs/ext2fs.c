@@ -304,6 +304,12 @@ ext2fs_print_map(uint8_t * map, int len)
     putc('\n', stderr);
 }
 
+/** \internal
+ * Maximum number of bytes of an inode table that ext2fs_inode_walk()
+ * reads at a time.
+ */
+#define EXT2FS_ITABLE_READ_SIZE (1024 * 1024)
+
 #define INODE_TABLE_SIZE(ext2fs) \
     ((tsk_getu32(ext2fs->fs_info.endian, ext2fs->fs->s_inodes_per_group) * ext2fs->inode_size - 1) \
            / ext2fs->fs_info.block_size + 1)
@@ -448,6 +454,36 @@ static uint8_t
     return 0;
 }
 
+/* ext2fs_group_inode_uninit - check if the inode table of the cached group
+ * has not been initialized (ext4 uninit_bg).  Like the kernel, we treat the
+ * inodes in these tables as zero-filled instead of reading them.
+ *
+ * Note: This routine assumes &ext2fs->lock is locked by the caller and that
+ * the group descriptor has been loaded.
+ *
+ * return 1 if the table is not initialized and 0 if it is
+ * */
+static uint8_t
+ext2fs_group_inode_uninit(EXT2FS_INFO * ext2fs)
+{
+    TSK_FS_INFO *fs = (TSK_FS_INFO *) & ext2fs->fs_info;
+    ext4fs_gd *gd;
+
+    if ((EXT2FS_HAS_RO_COMPAT_FEATURE(fs, ext2fs->fs,
+                EXT2FS_FEATURE_RO_COMPAT_GDT_CSUM) == 0)
+        && (EXT2FS_HAS_RO_COMPAT_FEATURE(fs, ext2fs->fs,
+                EXT4FS_FEATURE_RO_COMPAT_METADATA_CSUM) == 0))
+        return 0;
+
+    // the flags are at the same offset in the 32-bit descriptor
+    if (ext2fs->ext4_grp_buf != NULL)
+        gd = ext2fs->ext4_grp_buf;
+    else
+        gd = (ext4fs_gd *) ext2fs->grp_buf;
+
+    return EXT4BG_HAS_FLAG(fs, gd, EXT4_BG_INODE_UNINIT) ? 1 : 0;
+}
+
 /* ext2fs_dinode_load - look up disk inode & load into ext2fs_inode structure
  * @param ext2fs A ext2fs file system information structure
  * @param dino_inum Metadata address
@@ -499,6 +535,12 @@ ext2fs_dinode_load(EXT2FS_INFO * ext2fs, TSK_INUM_T dino_inum,
         return 1;
     }
 
+    if (ext2fs_group_inode_uninit(ext2fs)) {
+        tsk_release_lock(&ext2fs->lock);
+        memset((char *) dino_buf, 0, ext2fs->inode_size);
+        return 0;
+    }
+
     /*
      * Look up the inode table block for this inode.
      */
@@ -575,6 +617,99 @@ ext2fs_dinode_load(EXT2FS_INFO * ext2fs, TSK_INUM_T dino_inum,
     return 0;
 }
 
+/* ext2fs_dinode_load_run - load consecutive disk inodes from an inode table
+ * with a single read.  The run ends at the end of the group, at last_inum or
+ * when the buffer is full.  If the run cannot be read, only the first inode
+ * is loaded (with the same error handling as ext2fs_dinode_load).
+ * @param ext2fs A ext2fs file system information structure
+ * @param dino_inum Metadata address of the first inode to load
+ * @param last_inum Metadata address of the last inode that is needed
+ * @param buf The buffer to store the inodes in (must be size of
+ * ext2fs->inode_size and sizeof(ext2fs_inode) or larger)
+ * @param buf_len Size of buf in bytes
+ * @param a_count Set to the number of inodes that were loaded
+ *
+ * return 1 on error and 0 on success
+ * */
+static uint8_t
+ext2fs_dinode_load_run(EXT2FS_INFO * ext2fs, TSK_INUM_T dino_inum,
+    TSK_INUM_T last_inum, char *buf, size_t buf_len, size_t * a_count)
+{
+    TSK_FS_INFO *fs = (TSK_FS_INFO *) & ext2fs->fs_info;
+    uint32_t inodes_per_group =
+        tsk_getu32(fs->endian, ext2fs->fs->s_inodes_per_group);
+    EXT2_GRPNUM_T grp_num;
+    TSK_INUM_T rel_inum;
+    TSK_DADDR_T itable;
+    TSK_OFF_T addr;
+    size_t count;
+    ssize_t cnt;
+
+    grp_num = (EXT2_GRPNUM_T) ((dino_inum - fs->first_inum) /
+        inodes_per_group);
+    rel_inum = (dino_inum - 1) - inodes_per_group * grp_num;
+
+    count = buf_len / ext2fs->inode_size;
+    if (count > inodes_per_group - rel_inum)
+        count = (size_t) (inodes_per_group - rel_inum);
+    if (count > last_inum - dino_inum + 1)
+        count = (size_t) (last_inum - dino_inum + 1);
+
+    /* lock access to grp_buf */
+    tsk_take_lock(&ext2fs->lock);
+
+    if (ext2fs_group_load(ext2fs, grp_num)) {
+        tsk_release_lock(&ext2fs->lock);
+        return 1;
+    }
+
+    if (ext2fs_group_inode_uninit(ext2fs)) {
+        tsk_release_lock(&ext2fs->lock);
+        memset(buf, 0, count * ext2fs->inode_size);
+        *a_count = count;
+        return 0;
+    }
+
+    if (ext2fs->ext4_grp_buf != NULL)
+        itable = ext4_getu64(fs->endian,
+            ext2fs->ext4_grp_buf->bg_inode_table_hi,
+            ext2fs->ext4_grp_buf->bg_inode_table_lo);
+    else
+        itable = tsk_getu32(fs->endian, ext2fs->grp_buf->bg_inode_table);
+    tsk_release_lock(&ext2fs->lock);
+
+    addr = (TSK_OFF_T) itable * (TSK_OFF_T) fs->block_size +
+        rel_inum * (TSK_OFF_T) ext2fs->inode_size;
+
+    // do not read past the blocks that are in a partial image
+    if ((fs->last_block_act > 0) && (fs->last_block_act < fs->last_block)) {
+        TSK_OFF_T img_end =
+            (TSK_OFF_T) (fs->last_block_act + 1) * fs->block_size;
+        if (addr + (TSK_OFF_T) (count * ext2fs->inode_size) > img_end)
+            count = (addr < img_end) ?
+                (size_t) ((img_end - addr) / ext2fs->inode_size) : 0;
+    }
+
+    if ((count > 1) && (itable < LLONG_MAX / fs->block_size)) {
+        cnt = tsk_fs_read(fs, addr, buf, count * ext2fs->inode_size);
+
+        // use what could be read if the run goes past the end of the image
+        if (cnt >= (ssize_t) ext2fs->inode_size) {
+            *a_count = (size_t) cnt / ext2fs->inode_size;
+            if (tsk_verbose)
+                tsk_fprintf(stderr,
+                    "ext2fs_dinode_load_run: Loaded inodes %" PRIuINUM
+                    " to %" PRIuINUM "\n", dino_inum,
+                    dino_inum + *a_count - 1);
+            return 0;
+        }
+        tsk_error_reset();
+    }
+
+    *a_count = 1;
+    return ext2fs_dinode_load(ext2fs, dino_inum, (ext2fs_inode *) buf);
+}
+
 /* ext2fs_dinode_copy - copy cached disk inode into generic inode
  *
  * returns 1 on error and 0 on success
@@ -943,6 +1078,12 @@ ext2fs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
     unsigned int myflags;
     ext2fs_inode *dino_buf = NULL;
     unsigned int size = 0;
+    char *ibuf = NULL;          /* inodes read from the inode table */
+    size_t ibuf_len;
+    size_t ibuf_cnt = 0;        /* number of inodes in ibuf */
+    TSK_INUM_T ibuf_inum = 0;   /* first inode in ibuf */
+    uint8_t *imap = NULL;       /* copy of the inode bitmap of imap_grp */
+    EXT2_GRPNUM_T imap_grp = 0;
 
     // clean up any error messages that are lying around
     tsk_error_reset();
@@ -1027,6 +1168,32 @@ ext2fs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         return 1;
     }
 
+    /* The inode tables are read in large runs instead of an inode at
+     * a time. */
+    ibuf_len = EXT2FS_ITABLE_READ_SIZE - EXT2FS_ITABLE_READ_SIZE %
+        ext2fs->inode_size;
+    if (end_inum_tmp < start_inum)
+        ibuf_len = 0;
+    else if ((end_inum_tmp - start_inum + 1) <
+        ibuf_len / ext2fs->inode_size)
+        ibuf_len =
+            (size_t) (end_inum_tmp - start_inum + 1) * ext2fs->inode_size;
+    if (ibuf_len < size)
+        ibuf_len = size;
+    if ((ibuf = (char *) tsk_malloc(ibuf_len)) == NULL) {
+        free(dino_buf);
+        return 1;
+    }
+
+    /* The inode bitmap is copied so that the shared cache does not need
+     * to be locked for each inode (and is not reloaded for each inode
+     * when other threads walk other groups). */
+    if ((imap = (uint8_t *) tsk_malloc(fs->block_size)) == NULL) {
+        free(dino_buf);
+        free(ibuf);
+        return 1;
+    }
+
     for (inum = start_inum; inum <= end_inum_tmp; inum++) {
         int retval;
         EXT2_GRPNUM_T grp_num;
@@ -1039,13 +1206,21 @@ ext2fs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
             (EXT2_GRPNUM_T) ((inum - 1) / tsk_getu32(fs->endian,
                 ext2fs->fs->s_inodes_per_group));
 
-        /* lock access to imap_buf */
-        tsk_take_lock(&ext2fs->lock);
+        if ((inum == start_inum) || (grp_num != imap_grp)) {
+            /* lock access to imap_buf */
+            tsk_take_lock(&ext2fs->lock);
+
+            if (ext2fs_imap_load(ext2fs, grp_num)) {
+                tsk_release_lock(&ext2fs->lock);
+                free(dino_buf);
+                free(ibuf);
+                free(imap);
+                return 1;
+            }
+            memcpy(imap, ext2fs->imap_buf, fs->block_size);
+            imap_grp = grp_num;
 
-        if (ext2fs_imap_load(ext2fs, grp_num)) {
             tsk_release_lock(&ext2fs->lock);
-            free(dino_buf);
-            return 1;
         }
         ibase =
             grp_num * tsk_getu32(fs->endian,
@@ -1054,19 +1229,26 @@ ext2fs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         /*
          * Apply the allocated/unallocated restriction.
          */
-        myflags = (isset(ext2fs->imap_buf, inum - ibase) ?
+        myflags = (isset(imap, inum - ibase) ?
             TSK_FS_META_FLAG_ALLOC : TSK_FS_META_FLAG_UNALLOC);
 
-        tsk_release_lock(&ext2fs->lock);
-
         if ((flags & myflags) != myflags)
             continue;
 
-        if (ext2fs_dinode_load(ext2fs, inum, dino_buf)) {
-            tsk_fs_file_close(fs_file);
-            free(dino_buf);
-            return 1;
+        if ((inum < ibuf_inum) || (inum >= ibuf_inum + ibuf_cnt)) {
+            if (ext2fs_dinode_load_run(ext2fs, inum, end_inum_tmp, ibuf,
+                    ibuf_len, &ibuf_cnt)) {
+                tsk_fs_file_close(fs_file);
+                free(dino_buf);
+                free(ibuf);
+                free(imap);
+                return 1;
+            }
+            ibuf_inum = inum;
         }
+        memcpy((char *) dino_buf,
+            ibuf + (size_t) (inum - ibuf_inum) * ext2fs->inode_size,
+            ext2fs->inode_size);
 
 
         /*
@@ -1095,6 +1277,8 @@ ext2fs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         if (ext2fs_dinode_copy(ext2fs, fs_file->meta, inum, dino_buf)) {
             tsk_fs_meta_close(fs_file->meta);
             free(dino_buf);
+            free(ibuf);
+            free(imap);
             return 1;
         }
 
@@ -1102,11 +1286,15 @@ ext2fs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         if (retval == TSK_WALK_STOP) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(imap);
             return 0;
         }
         else if (retval == TSK_WALK_ERROR) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(imap);
             return 1;
         }
     }
@@ -1120,6 +1308,8 @@ ext2fs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         if (tsk_fs_dir_make_orphan_dir_meta(fs, fs_file->meta)) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(imap);
             return 1;
         }
         /* call action */
@@ -1127,11 +1317,15 @@ ext2fs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         if (retval == TSK_WALK_STOP) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(imap);
             return 0;
         }
         else if (retval == TSK_WALK_ERROR) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(imap);
             return 1;
         }
     }
@@ -1141,6 +1335,8 @@ ext2fs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
      */
     tsk_fs_file_close(fs_file);
     free(dino_buf);
+    free(ibuf);
+    free(imap);
 
     return 0;
 }
@@ -1252,6 +1448,104 @@ ext2fs_block_getflags(TSK_FS_INFO * a_fs, TSK_DADDR_T a_addr)
 }
 
 
+/* ext2fs_block_getflags_run - get the flags of a block and the number of
+ * blocks after it with the same flags.  The runs end at the end of the 
+ * group and at the meta data areas that ext2fs_block_getflags() uses.
+ *
+ * Return 0 on error (never happens, the flags are 0 if the bitmap
+ * cannot be loaded, as with ext2fs_block_getflags())
+ */
+static TSK_DADDR_T
+ext2fs_block_getflags_run(TSK_FS_INFO * a_fs, TSK_DADDR_T a_addr,
+    TSK_DADDR_T a_last, TSK_FS_BLOCK_FLAG_ENUM * a_flags)
+{
+    EXT2FS_INFO *ext2fs = (EXT2FS_INFO *) a_fs;
+    EXT2_GRPNUM_T grp_num;
+    TSK_DADDR_T dbase;          /* first block number in group */
+    TSK_DADDR_T dmin;           /* first block after inodes */
+    TSK_DADDR_T bmap, imap, itab;
+    TSK_DADDR_T last;
+    TSK_DADDR_T bounds[7];
+    int flags;
+    int i;
+
+    if ((a_addr == 0) || (a_addr < ext2fs->first_data_block)) {
+        *a_flags = ext2fs_block_getflags(a_fs, a_addr);
+        return 1;
+    }
+
+    grp_num = ext2_dtog_lcl(a_fs, ext2fs->fs, a_addr);
+
+    /* lock access to bmap_buf */
+    tsk_take_lock(&ext2fs->lock);
+
+    if (ext2fs_bmap_load(ext2fs, grp_num)) {
+        tsk_release_lock(&ext2fs->lock);
+        *a_flags = (TSK_FS_BLOCK_FLAG_ENUM) 0;
+        return 1;
+    }
+
+    dbase = ext2_cgbase_lcl(a_fs, ext2fs->fs, grp_num);
+    if (ext2fs->ext4_grp_buf != NULL) {
+        bmap = ext4_getu64(a_fs->endian,
+            ext2fs->ext4_grp_buf->bg_block_bitmap_hi,
+            ext2fs->ext4_grp_buf->bg_block_bitmap_lo);
+        imap = ext4_getu64(a_fs->endian,
+            ext2fs->ext4_grp_buf->bg_inode_bitmap_hi,
+            ext2fs->ext4_grp_buf->bg_inode_bitmap_lo);
+        itab = ext4_getu64(a_fs->endian,
+            ext2fs->ext4_grp_buf->bg_inode_table_hi,
+            ext2fs->ext4_grp_buf->bg_inode_table_lo);
+    }
+    else {
+        bmap = tsk_getu32(a_fs->endian, ext2fs->grp_buf->bg_block_bitmap);
+        imap = tsk_getu32(a_fs->endian, ext2fs->grp_buf->bg_inode_bitmap);
+        itab = tsk_getu32(a_fs->endian, ext2fs->grp_buf->bg_inode_table);
+    }
+    dmin = itab + INODE_TABLE_SIZE(ext2fs);
+
+    // same tests as ext2fs_block_getflags()
+    flags = (isset(ext2fs->bmap_buf, a_addr - dbase) ?
+        TSK_FS_BLOCK_FLAG_ALLOC : TSK_FS_BLOCK_FLAG_UNALLOC);
+    if ((a_addr >= dbase && a_addr < bmap) || (a_addr == bmap)
+        || (a_addr == imap) || (a_addr >= itab && a_addr < dmin))
+        flags |= TSK_FS_BLOCK_FLAG_META;
+    else
+        flags |= TSK_FS_BLOCK_FLAG_CONT;
+
+    // end the run at the end of the group or where the tests change
+    last = dbase + tsk_getu32(a_fs->endian,
+        ext2fs->fs->s_blocks_per_group) - 1;
+    if (last > a_last)
+        last = a_last;
+    bounds[0] = dbase;
+    bounds[1] = bmap;
+    bounds[2] = bmap + 1;
+    bounds[3] = imap;
+    bounds[4] = imap + 1;
+    bounds[5] = itab;
+    bounds[6] = dmin;
+    for (i = 0; i < 7; i++) {
+        if ((bounds[i] > a_addr) && (bounds[i] - 1 < last))
+            last = bounds[i] - 1;
+    }
+
+    // the bitmap is one block
+    if (last - dbase >= (TSK_DADDR_T) a_fs->block_size * 8) {
+        last = dbase + (TSK_DADDR_T) a_fs->block_size * 8 - 1;
+        if (last < a_addr)
+            last = a_addr;
+    }
+
+    last = a_addr + tsk_fs_bitmap_run(ext2fs->bmap_buf,
+        (size_t) (a_addr - dbase), (size_t) (last - dbase + 1)) - 1;
+
+    tsk_release_lock(&ext2fs->lock);
+    *a_flags = (TSK_FS_BLOCK_FLAG_ENUM) flags;
+    return last - a_addr + 1;
+}
+
+
 /* ext2fs_block_walk - block iterator
  *
  * flags: TSK_FS_BLOCK_FLAG_ALLOC, TSK_FS_BLOCK_FLAG_UNALLOC, TSK_FS_BLOCK_FLAG_CONT,
@@ -3414,6 +3708,7 @@ ext2fs_open(TSK_IMG_INFO * img_info, TSK_OFF_T offset,
     fs->inode_walk = ext2fs_inode_walk;
     fs->block_walk = ext2fs_block_walk;
     fs->block_getflags = ext2fs_block_getflags;
+    fs->block_getflags_run = ext2fs_block_getflags_run;
 
     fs->get_default_attr_type = tsk_fs_unix_get_default_attr_type;
     //fs->load_attrs = tsk_fs_unix_make_data_run;
@@ -30,6 +30,11 @@
 #include "tsk_fs_i.h"
 #include "tsk_ffs.h"
 
+/** \internal
+ * Maximum number of bytes of an inode table that ffs_inode_walk() reads
+ * at a time.
+ */
+#define FFS_ITABLE_READ_SIZE (1024 * 1024)
 
 
 /* ffs_group_load - load cylinder group descriptor info into cache
@@ -237,6 +242,109 @@ ffs_dinode_load(FFS_INFO * ffs, TSK_INUM_T inum, ffs_inode * dino_buf)
 }
 
 
+/*
+ * ffs_dinode_load_run - read consecutive disk inodes from the inode table of
+ * a cylinder group with a single read.  The run ends at the end of the
+ * group, at last_inum or when the buffer is full.  UFS2 inodes that have
+ * not been initialized are zero-filled.  If the run cannot be read, only
+ * the first inode is loaded (with the same error handling as
+ * ffs_dinode_load).
+ * @param ffs File system to read from
+ * @param inum Address of the first inode to load
+ * @param last_inum Address of the last inode that is needed
+ * @param buf Buffer to store the inodes in (must be sizeof(ffs_inode2) or
+ * larger)
+ * @param buf_len Size of buf in bytes
+ * @param a_count Set to the number of inodes that were loaded
+ *
+ * Return 0 on success and 1 on error
+ */
+static uint8_t
+ffs_dinode_load_run(FFS_INFO * ffs, TSK_INUM_T inum, TSK_INUM_T last_inum,
+    char *buf, size_t buf_len, size_t * a_count)
+{
+    TSK_FS_INFO *fs = (TSK_FS_INFO *) & ffs->fs_info;
+    FFS_GRPNUM_T grp_num;
+    TSK_INUM_T rel_inum;
+    TSK_INUM_T grp_inodes;
+    TSK_OFF_T addr;
+    size_t isize;
+    size_t count;
+    ssize_t cnt;
+
+    grp_num = itog_lcl(fs, ffs->fs.sb1, inum);
+    grp_inodes = tsk_gets32(fs->endian, ffs->fs.sb1->cg_inode_num);
+    rel_inum = inum - grp_num * grp_inodes;
+
+    if (fs->ftype == TSK_FS_TYPE_FFS2) {
+        isize = sizeof(ffs_inode2);
+        addr = (TSK_OFF_T) itod_lcl(fs, ffs->fs.sb1, inum) * fs->block_size +
+            itoo_lcl(fs, ffs->fs.sb2, inum) * isize;
+    }
+    else {
+        isize = sizeof(ffs_inode1);
+        addr = (TSK_OFF_T) itod_lcl(fs, ffs->fs.sb1, inum) * fs->block_size +
+            itoo_lcl(fs, ffs->fs.sb1, inum) * isize;
+    }
+
+    count = buf_len / isize;
+    if (count > grp_inodes - rel_inum)
+        count = (size_t) (grp_inodes - rel_inum);
+    if (count > last_inum - inum + 1)
+        count = (size_t) (last_inum - inum + 1);
+
+    /* UFS2 does not initialize all inodes when the file system is
+     * created, so only read the ones in the valid range */
+    if (fs->ftype == TSK_FS_TYPE_FFS2) {
+        TSK_INUM_T inited;
+
+        tsk_take_lock(&ffs->lock);
+        if (ffs_group_load(ffs, grp_num)) {
+            tsk_release_lock(&ffs->lock);
+            return 1;
+        }
+        inited = tsk_getu32(fs->endian,
+            ((ffs_cgd2 *) ffs->grp_buf)->cg_initediblk);
+        tsk_release_lock(&ffs->lock);
+
+        if (rel_inum >= inited) {
+            memset(buf, 0, count * isize);
+            *a_count = count;
+            return 0;
+        }
+        if (count > inited - rel_inum)
+            count = (size_t) (inited - rel_inum);
+    }
+
+    // do not read past the blocks that are in a partial image
+    if ((fs->last_block_act > 0) && (fs->last_block_act < fs->last_block)) {
+        TSK_OFF_T img_end =
+            (TSK_OFF_T) (fs->last_block_act + 1) * fs->block_size;
+        if (addr + (TSK_OFF_T) (count * isize) > img_end)
+            count = (addr < img_end) ?
+                (size_t) ((img_end - addr) / isize) : 0;
+    }
+
+    if (count > 1) {
+        cnt = tsk_fs_read(fs, addr, buf, count * isize);
+
+        // use what could be read if the run goes past the end of the image
+        if (cnt >= (ssize_t) isize) {
+            *a_count = (size_t) cnt / isize;
+            if (tsk_verbose)
+                tsk_fprintf(stderr,
+                    "ffs_dinode_load_run: Loaded inodes %" PRIuINUM
+                    " to %" PRIuINUM "\n", inum, inum + *a_count - 1);
+            return 0;
+        }
+        tsk_error_reset();
+    }
+
+    *a_count = 1;
+    return ffs_dinode_load(ffs, inum, (ffs_inode *) buf);
+}
+
+
 static TSK_FS_META_TYPE_ENUM
 ffsmode2tsktype(uint16_t a_mode)
 {
@@ -848,12 +956,19 @@ ffs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
     FFS_INFO *ffs = (FFS_INFO *) fs;
     ffs_cgd *cg = NULL;
     TSK_INUM_T inum;
-    unsigned char *inosused = NULL;
+    unsigned char *inosused = NULL;     /* copy of the inode bitmap of inosused_grp */
+    size_t inosused_len;
+    FFS_GRPNUM_T inosused_grp = 0;
     TSK_FS_FILE *fs_file;
     unsigned int myflags;
     TSK_INUM_T ibase = 0;
     TSK_INUM_T end_inum_tmp;
     ffs_inode *dino_buf;
+    char *ibuf = NULL;          /* inodes read from the inode table */
+    size_t ibuf_len;
+    size_t ibuf_cnt = 0;        /* number of inodes in ibuf */
+    TSK_INUM_T ibuf_inum = 0;   /* first inode in ibuf */
+    size_t isize;
 
     // clean up any error messages that are lying around
     tsk_error_reset();
@@ -929,6 +1044,33 @@ ffs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
     if ((dino_buf = (ffs_inode *) tsk_malloc(sizeof(ffs_inode2))) == NULL)
         return 1;
 
+    /* The inode tables are read in large runs instead of a block at
+     * a time. */
+    isize = (fs->ftype == TSK_FS_TYPE_FFS2) ?
+        sizeof(ffs_inode2) : sizeof(ffs_inode1);
+    ibuf_len = FFS_ITABLE_READ_SIZE - FFS_ITABLE_READ_SIZE % isize;
+    if (end_inum_tmp < start_inum)
+        ibuf_len = 0;
+    else if ((end_inum_tmp - start_inum + 1) < ibuf_len / isize)
+        ibuf_len = (size_t) (end_inum_tmp - start_inum + 1) * isize;
+    if (ibuf_len < sizeof(ffs_inode2))
+        ibuf_len = sizeof(ffs_inode2);
+    if ((ibuf = (char *) tsk_malloc(ibuf_len)) == NULL) {
+        free(dino_buf);
+        return 1;
+    }
+
+    /* The inode bitmap is copied so that the shared cache does not need
+     * to be locked for each inode (and is not reloaded for each inode
+     * when other threads walk other groups). */
+    inosused_len =
+        (tsk_gets32(fs->endian, ffs->fs.sb1->cg_inode_num) + 7) / 8;
+    if ((inosused = (unsigned char *) tsk_malloc(inosused_len)) == NULL) {
+        free(dino_buf);
+        free(ibuf);
+        return 1;
+    }
+
     /*
      * Iterate. This is easy because inode numbers are contiguous, unlike
      * data blocks which are interleaved with cylinder group blocks.
@@ -942,14 +1084,20 @@ ffs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
          */
         grp_num = itog_lcl(fs, ffs->fs.sb1, inum);
 
-        tsk_take_lock(&ffs->lock);
-        if (ffs_group_load(ffs, grp_num)) {
+        if ((inum == start_inum) || (grp_num != inosused_grp)) {
+            tsk_take_lock(&ffs->lock);
+            if (ffs_group_load(ffs, grp_num)) {
+                tsk_release_lock(&ffs->lock);
+                free(dino_buf);
+                free(ibuf);
+                free(inosused);
+                return 1;
+            }
+            cg = (ffs_cgd *) ffs->grp_buf;
+            memcpy(inosused, cg_inosused_lcl(fs, cg), inosused_len);
+            inosused_grp = grp_num;
             tsk_release_lock(&ffs->lock);
-            free(dino_buf);
-            return 1;
         }
-        cg = (ffs_cgd *) ffs->grp_buf;
-        inosused = (unsigned char *) cg_inosused_lcl(fs, cg);
         ibase =
             grp_num * tsk_gets32(fs->endian, ffs->fs.sb1->cg_inode_num);
 
@@ -959,17 +1107,23 @@ ffs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         myflags = (isset(inosused, inum - ibase) ?
             TSK_FS_META_FLAG_ALLOC : TSK_FS_META_FLAG_UNALLOC);
 
-        tsk_release_lock(&ffs->lock);
-
         if ((a_flags & myflags) != myflags)
             continue;
 
 
-        if (ffs_dinode_load(ffs, inum, dino_buf)) {
-            tsk_fs_file_close(fs_file);
-            free(dino_buf);
-            return 1;
+        if ((inum < ibuf_inum) || (inum >= ibuf_inum + ibuf_cnt)) {
+            if (ffs_dinode_load_run(ffs, inum, end_inum_tmp, ibuf,
+                    ibuf_len, &ibuf_cnt)) {
+                tsk_fs_file_close(fs_file);
+                free(dino_buf);
+                free(ibuf);
+                free(inosused);
+                return 1;
+            }
+            ibuf_inum = inum;
         }
+        memcpy((char *) dino_buf, ibuf + (size_t) (inum - ibuf_inum) * isize,
+            isize);
 
 
         if ((fs->ftype == TSK_FS_TYPE_FFS1)
@@ -1014,6 +1168,8 @@ ffs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         if (ffs_dinode_copy(ffs, fs_file->meta, inum, dino_buf)) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(inosused);
             return 1;
         }
 
@@ -1021,11 +1177,15 @@ ffs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         if (retval == TSK_WALK_STOP) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(inosused);
             return 0;
         }
         else if (retval == TSK_WALK_ERROR) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(inosused);
             return 1;
         }
     }
@@ -1039,6 +1199,8 @@ ffs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         if (tsk_fs_dir_make_orphan_dir_meta(fs, fs_file->meta)) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(inosused);
             return 1;
         }
         /* call action */
@@ -1046,11 +1208,15 @@ ffs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         if (retval == TSK_WALK_STOP) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(inosused);
             return 0;
         }
         else if (retval == TSK_WALK_ERROR) {
             tsk_fs_file_close(fs_file);
             free(dino_buf);
+            free(ibuf);
+            free(inosused);
             return 1;
         }
     }
@@ -1060,6 +1226,8 @@ ffs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
      */
     tsk_fs_file_close(fs_file);
     free(dino_buf);
+    free(ibuf);
+    free(inosused);
 
     return 0;
 }
@@ -34,6 +34,156 @@
  */
 #include "tsk_fs_i.h"
 
+/* Number of runs that tsk_fs_attr_read() will step over in the linked
+ * list before it builds a run index for the attribute. */
+#define TSK_FS_ATTR_RUN_IDX_MIN 16
+
+/**
+ * \internal
+ * Sorted index of the runs in a non-resident attribute.  Entries are
+ * in the same order as the linked list and run_end[i] is the block offset
+ * just after run i.  An index with a NULL run array means that the runs
+ * are not in order and the linked list must be searched.  An index is not
+ * changed once it has been published in the attribute, so threads can
+ * search it without a lock.
+ */
+struct TSK_FS_ATTR_RUN_IDX {
+    size_t count;               ///< Number of runs in the index
+    TSK_DADDR_T *run_end;       ///< Offset (in blocks) of the end of each run
+    TSK_FS_ATTR_RUN **run;      ///< Pointer to each run
+};
+
+
+/**
+ * \internal
+ * Free the run index of an attribute.  Must be called whenever the run
+ * list of the attribute changes.
+ *
+ * @param a_fs_attr Attribute with index to free
+ */
+static void
+tsk_fs_attr_run_idx_free(TSK_FS_ATTR * a_fs_attr)
+{
+    TSK_FS_ATTR_RUN_IDX *run_idx = a_fs_attr->run_idx;
+
+    if (run_idx == NULL)
+        return;
+
+    free(run_idx->run_end);
+    free(run_idx->run);
+    free(run_idx);
+    a_fs_attr->run_idx = NULL;
+}
+
+/**
+ * \internal
+ * Free the state that the special read function of an attribute kept
+ * between calls.  Must be called whenever the run list of the attribute
+ * changes.
+ *
+ * @param a_fs_attr Attribute with state to free
+ */
+static void
+tsk_fs_attr_r_cache_free(TSK_FS_ATTR * a_fs_attr)
+{
+    if (a_fs_attr->r_cache == NULL)
+        return;
+
+    if (a_fs_attr->r_cache_free)
+        a_fs_attr->r_cache_free(a_fs_attr->r_cache);
+    a_fs_attr->r_cache = NULL;
+    a_fs_attr->r_cache_free = NULL;
+}
+
+/**
+ * \internal
+ * Build the run index for an attribute.  If the runs are not in order,
+ * an index with no entries is returned so that we do not try again.
+ *
+ * @param a_fs_attr Attribute to index
+ * @returns NULL on error
+ */
+static TSK_FS_ATTR_RUN_IDX *
+tsk_fs_attr_run_idx_build(const TSK_FS_ATTR * a_fs_attr)
+{
+    TSK_FS_ATTR_RUN_IDX *run_idx;
+    TSK_FS_ATTR_RUN *fs_attr_run;
+    size_t i;
+
+    if ((run_idx =
+            (TSK_FS_ATTR_RUN_IDX *) tsk_malloc(sizeof(TSK_FS_ATTR_RUN_IDX)))
+        == NULL)
+        return NULL;
+
+    for (fs_attr_run = a_fs_attr->nrd.run; fs_attr_run;
+        fs_attr_run = fs_attr_run->next)
+        run_idx->count++;
+
+    if (((run_idx->run_end =
+                (TSK_DADDR_T *) tsk_malloc(run_idx->count *
+                    sizeof(TSK_DADDR_T))) == NULL)
+        || ((run_idx->run =
+                (TSK_FS_ATTR_RUN **) tsk_malloc(run_idx->count *
+                    sizeof(TSK_FS_ATTR_RUN *))) == NULL)) {
+        free(run_idx->run_end);
+        free(run_idx);
+        return NULL;
+    }
+
+    for (fs_attr_run = a_fs_attr->nrd.run, i = 0; fs_attr_run;
+        fs_attr_run = fs_attr_run->next, i++) {
+        run_idx->run[i] = fs_attr_run;
+        run_idx->run_end[i] = fs_attr_run->offset + fs_attr_run->len;
+
+        // a binary search will not give the same answer as the list
+        if ((i > 0) && (run_idx->run_end[i] < run_idx->run_end[i - 1])) {
+            if (tsk_verbose)
+                tsk_fprintf(stderr,
+                    "tsk_fs_attr_run_idx_build: runs are out of order, not indexing\n");
+            free(run_idx->run_end);
+            free(run_idx->run);
+            run_idx->run_end = NULL;
+            run_idx->run = NULL;
+            run_idx->count = 0;
+            break;
+        }
+    }
+
+    return run_idx;
+}
+
+/**
+ * \internal
+ * Find the first run in the index that ends after a given block offset.
+ * This is the run that the linked list search in tsk_fs_attr_read()
+ * would stop at.
+ *
+ * @param a_run_idx Index to search
+ * @param a_blk_off Block offset in the attribute
+ * @returns Run or NULL if the offset is past the last run
+ */
+static TSK_FS_ATTR_RUN *
+tsk_fs_attr_run_idx_find(const TSK_FS_ATTR_RUN_IDX * a_run_idx,
+    TSK_DADDR_T a_blk_off)
+{
+    size_t lo, hi;
+
+    lo = 0;
+    hi = a_run_idx->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a_run_idx->run_end[mid] <= a_blk_off)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == a_run_idx->count)
+        return NULL;
+
+    return a_run_idx->run[lo];
+}
+
 
 /**
  * \internal
@@ -44,9 +194,14 @@
 TSK_FS_ATTR_RUN *
 tsk_fs_attr_run_alloc()
 {
-    TSK_FS_ATTR_RUN *fs_attr_run =
-        (TSK_FS_ATTR_RUN *) tsk_malloc(sizeof(TSK_FS_ATTR_RUN));
-    if (fs_attr_run == NULL)
+    TSK_FS_ATTR_RUN *fs_attr_run;
+
+    if ((fs_attr_run =
+            (TSK_FS_ATTR_RUN *) tsk_fs_pool_get(TSK_FS_POOL_RUN)) != NULL)
+        memset(fs_attr_run, 0, sizeof(TSK_FS_ATTR_RUN));
+    else if ((fs_attr_run =
+            (TSK_FS_ATTR_RUN *) tsk_malloc(sizeof(TSK_FS_ATTR_RUN))) ==
+        NULL)
         return NULL;
 
     return fs_attr_run;
@@ -64,8 +219,7 @@ tsk_fs_attr_run_free(TSK_FS_ATTR_RUN * fs_attr_run)
     while (fs_attr_run) {
         TSK_FS_ATTR_RUN *fs_attr_run_prev = fs_attr_run;
         fs_attr_run = fs_attr_run->next;
-        fs_attr_run_prev->next = NULL;
-        free(fs_attr_run_prev);
+        tsk_fs_pool_put(TSK_FS_POOL_RUN, fs_attr_run_prev);
     }
 }
 
@@ -82,26 +236,53 @@ tsk_fs_attr_run_free(TSK_FS_ATTR_RUN * fs_attr_run)
 TSK_FS_ATTR *
 tsk_fs_attr_alloc(TSK_FS_ATTR_FLAG_ENUM type)
 {
-    TSK_FS_ATTR *fs_attr = (TSK_FS_ATTR *) tsk_malloc(sizeof(TSK_FS_ATTR));
-    if (fs_attr == NULL) {
+    TSK_FS_ATTR *fs_attr;
+    char *name = NULL;
+    size_t name_size = 0;
+    uint8_t *buf = NULL;
+    size_t buf_size = 0;
+
+    /* Reuse a freed structure if there is one and keep its
+     * name and resident data buffers. */
+    if ((fs_attr =
+            (TSK_FS_ATTR *) tsk_fs_pool_get(TSK_FS_POOL_ATTR)) != NULL) {
+        name = fs_attr->name;
+        name_size = fs_attr->name_size;
+        buf = fs_attr->rd.buf;
+        buf_size = fs_attr->rd.buf_size;
+        memset(fs_attr, 0, sizeof(TSK_FS_ATTR));
+    }
+    else if ((fs_attr =
+            (TSK_FS_ATTR *) tsk_malloc(sizeof(TSK_FS_ATTR))) == NULL) {
         return NULL;
     }
 
-    fs_attr->name_size = 128;
-    if ((fs_attr->name = (char *) tsk_malloc(fs_attr->name_size)) == NULL) {
-        free(fs_attr);
-        return NULL;
+    if (name == NULL) {
+        name_size = 128;
+        if ((name = (char *) tsk_malloc(name_size)) == NULL) {
+            free(buf);
+            free(fs_attr);
+            return NULL;
+        }
     }
+    name[0] = '\0';
+    fs_attr->name = name;
+    fs_attr->name_size = name_size;
+    fs_attr->rd.buf = buf;
+    fs_attr->rd.buf_size = (buf ? buf_size : 0);
 
     if (type == TSK_FS_ATTR_NONRES) {
         fs_attr->flags = (TSK_FS_ATTR_NONRES | TSK_FS_ATTR_INUSE);
     }
     else if (type == TSK_FS_ATTR_RES) {
-        fs_attr->rd.buf_size = 1024;
-        fs_attr->rd.buf = (uint8_t *) tsk_malloc(fs_attr->rd.buf_size);
         if (fs_attr->rd.buf == NULL) {
-            free(fs_attr->name);
-            return NULL;
+            fs_attr->rd.buf_size = 1024;
+            fs_attr->rd.buf = (uint8_t *) tsk_malloc(fs_attr->rd.buf_size);
+            if (fs_attr->rd.buf == NULL) {
+                fs_attr->rd.buf_size = 0;
+                tsk_fs_attr_free(fs_attr);
+                return NULL;
+            }
         }
         fs_attr->flags = (TSK_FS_ATTR_RES | TSK_FS_ATTR_INUSE);
     }
@@ -110,6 +291,7 @@ tsk_fs_attr_alloc(TSK_FS_ATTR_FLAG_ENUM type)
         tsk_error_set_errno(TSK_ERR_FS_ARG);
         tsk_error_set_errstr("tsk_fs_attr_alloc: Invalid Type: %d\n",
             type);
+        tsk_fs_attr_free(fs_attr);
         return NULL;
     }
 
@@ -129,17 +311,14 @@ tsk_fs_attr_free(TSK_FS_ATTR * a_fs_attr)
     if (a_fs_attr == NULL)
         return;
 
+    tsk_fs_attr_run_idx_free(a_fs_attr);
+    tsk_fs_attr_r_cache_free(a_fs_attr);
     if (a_fs_attr->nrd.run)
         tsk_fs_attr_run_free(a_fs_attr->nrd.run);
     a_fs_attr->nrd.run = NULL;
 
-    free(a_fs_attr->rd.buf);
-    a_fs_attr->rd.buf = NULL;
-
-    free(a_fs_attr->name);
-    a_fs_attr->name = NULL;
-
-    free(a_fs_attr);
+    // the name and resident data buffers stay with the structure in the pool
+    tsk_fs_pool_put(TSK_FS_POOL_ATTR, a_fs_attr);
 }
 
 
@@ -154,6 +333,8 @@ tsk_fs_attr_clear(TSK_FS_ATTR * a_fs_attr)
 {
     a_fs_attr->size = a_fs_attr->type =
         a_fs_attr->id = a_fs_attr->flags = 0;
+    tsk_fs_attr_run_idx_free(a_fs_attr);
+    tsk_fs_attr_r_cache_free(a_fs_attr);
     if (a_fs_attr->nrd.run) {
         tsk_fs_attr_run_free(a_fs_attr->nrd.run);
         a_fs_attr->nrd.run = NULL;
@@ -297,6 +478,9 @@ tsk_fs_attr_set_run(TSK_FS_FILE * a_fs_file, TSK_FS_ATTR * a_fs_attr,
         return 1;
     }
 
+    tsk_fs_attr_run_idx_free(a_fs_attr);
+    tsk_fs_attr_r_cache_free(a_fs_attr);
+
     a_fs_attr->fs_file = a_fs_file;
     a_fs_attr->flags = (TSK_FS_ATTR_INUSE | TSK_FS_ATTR_NONRES | flags);
     a_fs_attr->type = type;
@@ -500,6 +684,9 @@ tsk_fs_attr_add_run(TSK_FS_INFO * a_fs, TSK_FS_ATTR * a_fs_attr,
         return 1;
     }
 
+    tsk_fs_attr_run_idx_free(a_fs_attr);
+    tsk_fs_attr_r_cache_free(a_fs_attr);
+
     run_len = 0;
     data_run_cur = a_data_run_new;
     while (data_run_cur) {
@@ -716,6 +903,9 @@ tsk_fs_attr_append_run(TSK_FS_INFO * a_fs, TSK_FS_ATTR * a_fs_attr,
         return;
     }
 
+    tsk_fs_attr_run_idx_free(a_fs_attr);
+    tsk_fs_attr_r_cache_free(a_fs_attr);
+
     if (a_fs_attr->nrd.run == NULL) {
         a_fs_attr->nrd.run = a_data_run;
         a_data_run->offset = 0;
@@ -1146,6 +1336,7 @@ tsk_fs_attr_read(const TSK_FS_ATTR * a_fs_attr, TSK_OFF_T a_offset,
     /* For non-resident data, load the needed block and copy the data */
     else if (a_fs_attr->flags & TSK_FS_ATTR_NONRES) {
         TSK_FS_ATTR_RUN *data_run_cur;
+        TSK_FS_ATTR_RUN_IDX *run_idx;
         TSK_DADDR_T blkoffset_toread;   // block offset of where we want to start reading from
         size_t byteoffset_toread;       // byte offset in blkoffset_toread of where we want to start reading from
         ssize_t len_remain;      // length remaining to copy
@@ -1181,9 +1372,42 @@ tsk_fs_attr_read(const TSK_FS_ATTR * a_fs_attr, TSK_OFF_T a_offset,
 
         len_remain = len_toread;
 
+        /* Find the run that has the starting offset.  Long run lists
+         * (fragmented files) get an index so that we do not walk the
+         * list on every read.  The index is built once, under the lock,
+         * and is then searched without it. */
+        data_run_cur = a_fs_attr->nrd.run;
+        run_idx = (TSK_FS_ATTR_RUN_IDX *)
+            tsk_atomic_load_ptr(&a_fs_attr->run_idx);
+        if (run_idx == NULL) {
+            size_t run_cnt = 0;
+            while ((data_run_cur)
+                && (data_run_cur->offset + data_run_cur->len <=
+                    blkoffset_toread)) {
+                data_run_cur = data_run_cur->next;
+                run_cnt++;
+            }
+            // this is only a cache, so errors are ignored
+            if (run_cnt >= TSK_FS_ATTR_RUN_IDX_MIN) {
+                tsk_take_lock(&fs->attr_run_idx_lock);
+                if (a_fs_attr->run_idx == NULL) {
+                    run_idx = tsk_fs_attr_run_idx_build(a_fs_attr);
+                    if (run_idx == NULL)
+                        tsk_error_reset();
+                    else
+                        tsk_atomic_store_ptr(&((TSK_FS_ATTR *)
+                                a_fs_attr)->run_idx, run_idx);
+                }
+                tsk_release_lock(&fs->attr_run_idx_lock);
+            }
+        }
+        else if (run_idx->run) {
+            data_run_cur = tsk_fs_attr_run_idx_find(run_idx,
+                blkoffset_toread);
+        }
+
         // cycle through the run until we find where we can start to process the clusters
-        for (data_run_cur = a_fs_attr->nrd.run; data_run_cur;
-            data_run_cur = data_run_cur->next) {
+        for (; data_run_cur; data_run_cur = data_run_cur->next) {
             TSK_DADDR_T blkoffset_inrun;
             size_t len_inrun;
 
@@ -27,6 +27,10 @@ tsk_fs_attrlist_alloc()
     TSK_FS_ATTRLIST *fs_attrlist;
 
     if ((fs_attrlist =
+            (TSK_FS_ATTRLIST *) tsk_fs_pool_get(TSK_FS_POOL_ATTRLIST)) !=
+        NULL)
+        fs_attrlist->head = NULL;
+    else if ((fs_attrlist =
             (TSK_FS_ATTRLIST *) tsk_malloc(sizeof(TSK_FS_ATTRLIST))) ==
         NULL)
         return NULL;
@@ -49,7 +53,7 @@ tsk_fs_attrlist_free(TSK_FS_ATTRLIST * a_fs_attrlist)
         tsk_fs_attr_free(fs_attr_cur);
         fs_attr_cur = fs_attr_tmp;
     }
-    free(a_fs_attrlist);
+    tsk_fs_pool_put(TSK_FS_POOL_ATTRLIST, a_fs_attrlist);
 }
 
 /** \internal
@@ -205,3 +205,349 @@ tsk_fs_block_walk(TSK_FS_INFO * a_fs,
     return a_fs->block_walk(a_fs, a_start_blk, a_end_blk, a_flags,
         a_action, a_ptr);
 }
+
+
+/**
+ * \internal
+ * Find the length of a run of bits in a bitmap that have the same value as 
+ * the first bit of the run.  Bit i is bit (i % 8) of byte (i / 8), which is
+ * the order that isset() uses.  Whole bytes and 64-bit words are compared 
+ * at a time, so large runs of allocated or unallocated blocks are found 
+ * without testing each bit.
+ *
+ * @param a_map Bitmap
+ * @param a_start Bit to start at
+ * @param a_end Bit after the last bit to include in the run (must be larger than a_start)
+ * @returns Number of bits from a_start that have the same value
+ */
+size_t
+tsk_fs_bitmap_run(const uint8_t * a_map, size_t a_start, size_t a_end)
+{
+    size_t i = a_start;
+    int set = isset(a_map, a_start) ? 1 : 0;
+    uint8_t fill = set ? 0xff : 0x00;
+    uint64_t fill64 = set ? 0xffffffffffffffffULL : 0;
+
+    // bits up to the first byte boundary
+    while ((i < a_end) && (i % NBBY)) {
+        if ((isset(a_map, i) ? 1 : 0) != set)
+            return i - a_start;
+        i++;
+    }
+
+    // whole words and then whole bytes
+    while (i + 64 <= a_end) {
+        uint64_t word;
+        memcpy(&word, &a_map[i / NBBY], sizeof(word));
+        if (word != fill64)
+            break;
+        i += 64;
+    }
+    while ((i + NBBY <= a_end) && (a_map[i / NBBY] == fill))
+        i += NBBY;
+
+    // the bits in the byte where the run ends
+    while ((i < a_end) && ((isset(a_map, i) ? 1 : 0) == set))
+        i++;
+
+    return i - a_start;
+}
+
+
+/** \internal
+ * Number of bytes of content that tsk_fs_block_extent_walk() reads at a time.
+ */
+#define TSK_FS_BLOCK_EXTENT_READ_SIZE (1024 * 1024)
+
+/** \internal
+ * State of a tsk_fs_block_extent_walk(). 
+ */
+typedef struct {
+    TSK_FS_INFO *fs;
+    TSK_FS_BLOCK_WALK_FLAG_ENUM flags;
+    TSK_FS_BLOCK_EXTENT_WALK_CB action;
+    void *ptr;
+    TSK_FS_BLOCK_EXTENT extent; ///< Extent that is being built (len is 0 if there is none)
+    char *buf;                  ///< Buffer for the content (NULL if AONLY)
+    TSK_DADDR_T buf_blocks;     ///< Number of blocks that fit in buf
+    uint8_t stopped;            ///< Set when the callback returned TSK_WALK_STOP or TSK_WALK_ERROR
+} TSK_FS_BLOCK_EXTENT_WALK;
+
+/** \internal
+ * Call the callback with the extent that has been built.  If the content
+ * is needed, it is read and the extent is split into buffer sized parts.
+ * @returns Value returned by the callback (or TSK_WALK_ERROR)
+ */
+static TSK_WALK_RET_ENUM
+tsk_fs_block_extent_walk_flush(TSK_FS_BLOCK_EXTENT_WALK * a_walk)
+{
+    TSK_FS_INFO *fs = a_walk->fs;
+    TSK_FS_BLOCK_EXTENT extent = a_walk->extent;
+    TSK_DADDR_T start = extent.addr;
+    TSK_DADDR_T end = extent.addr + extent.len;
+
+    a_walk->extent.len = 0;
+    if (extent.len == 0)
+        return TSK_WALK_CONT;
+
+    if (a_walk->flags & TSK_FS_BLOCK_WALK_FLAG_AONLY) {
+        extent.buf = NULL;
+        return a_walk->action(&extent, a_walk->ptr);
+    }
+
+    for (extent.addr = start; extent.addr < end; extent.addr += extent.len) {
+        TSK_WALK_RET_ENUM retval;
+        ssize_t cnt;
+        size_t len;
+
+        if (extent.addr > fs->last_block_act) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_FS_READ);
+            if (extent.addr <= fs->last_block)
+                tsk_error_set_errstr
+                    ("tsk_fs_block_extent_walk: Address missing in partial image: %"
+                    PRIuDADDR ")", extent.addr);
+            else
+                tsk_error_set_errstr
+                    ("tsk_fs_block_extent_walk: Address is too large for image: %"
+                    PRIuDADDR ")", extent.addr);
+            return TSK_WALK_ERROR;
+        }
+
+        extent.len = end - extent.addr;
+        if (extent.len > a_walk->buf_blocks)
+            extent.len = a_walk->buf_blocks;
+        if (extent.addr + extent.len - 1 > fs->last_block_act)
+            extent.len = fs->last_block_act - extent.addr + 1;
+
+        len = (size_t) extent.len * fs->block_size;
+        cnt = tsk_img_read(fs->img_info,
+            fs->offset + (TSK_OFF_T) extent.addr * fs->block_size,
+            a_walk->buf, len);
+        if ((cnt != (ssize_t) len) && (extent.len > 1)) {
+            // give the blocks before the one that could not be read.  The
+            // error is reset first so that one from the single block read
+            // below is kept.
+            tsk_error_reset();
+            if (cnt >= (ssize_t) fs->block_size) {
+                extent.len = cnt / fs->block_size;
+                len = (size_t) extent.len * fs->block_size;
+            }
+            else {
+                extent.len = 1;
+                len = fs->block_size;
+                cnt = tsk_img_read(fs->img_info,
+                    fs->offset + (TSK_OFF_T) extent.addr * fs->block_size,
+                    a_walk->buf, len);
+            }
+        }
+        if (cnt < (ssize_t) len) {
+            if (cnt >= 0) {
+                tsk_error_reset();
+                tsk_error_set_errno(TSK_ERR_FS_READ);
+            }
+            tsk_error_set_errstr2("tsk_fs_block_extent_walk: block %"
+                PRIuDADDR, extent.addr);
+            return TSK_WALK_ERROR;
+        }
+
+        extent.buf = a_walk->buf;
+        retval = a_walk->action(&extent, a_walk->ptr);
+        if (retval != TSK_WALK_CONT)
+            return retval;
+    }
+    return TSK_WALK_CONT;
+}
+
+/** \internal
+ * Add blocks to the extent that is being built.  The extent is passed to
+ * the callback when the blocks do not continue it.
+ * @returns Value returned by the callback (or TSK_WALK_CONT if it was not called)
+ */
+static TSK_WALK_RET_ENUM
+tsk_fs_block_extent_walk_add(TSK_FS_BLOCK_EXTENT_WALK * a_walk,
+    TSK_DADDR_T a_addr, TSK_DADDR_T a_len, TSK_FS_BLOCK_FLAG_ENUM a_flags)
+{
+    TSK_WALK_RET_ENUM retval;
+
+    if ((a_walk->extent.len > 0) && (a_walk->extent.flags == a_flags)
+        && (a_walk->extent.addr + a_walk->extent.len == a_addr)) {
+        a_walk->extent.len += a_len;
+        return TSK_WALK_CONT;
+    }
+
+    retval = tsk_fs_block_extent_walk_flush(a_walk);
+    if (retval != TSK_WALK_CONT)
+        a_walk->stopped = 1;
+
+    a_walk->extent.addr = a_addr;
+    a_walk->extent.len = a_len;
+    a_walk->extent.flags = a_flags;
+    return retval;
+}
+
+/** \internal
+ * Block walk callback that is used for file systems that cannot find runs
+ * of blocks with the same flags.  Each block is added to the extent.
+ */
+static TSK_WALK_RET_ENUM
+tsk_fs_block_extent_walk_cb(const TSK_FS_BLOCK * a_block, void *a_ptr)
+{
+    TSK_FS_BLOCK_EXTENT_WALK *walk = (TSK_FS_BLOCK_EXTENT_WALK *) a_ptr;
+    int flags = a_block->flags;
+
+    // the content is read by the extent walk, not the block walk
+    if ((walk->flags & TSK_FS_BLOCK_WALK_FLAG_AONLY) == 0)
+        flags &= ~TSK_FS_BLOCK_FLAG_AONLY;
+
+    return tsk_fs_block_extent_walk_add(walk, a_block->addr, 1,
+        (TSK_FS_BLOCK_FLAG_ENUM) flags);
+}
+
+/** 
+ * \ingroup fslib
+ *
+ * Cycle through a range of file system blocks and call the callback function
+ * with each set of consecutive blocks that have the same flags.  This gives
+ * the same blocks as tsk_fs_block_walk(), but with far fewer callbacks.
+ * For file systems with allocation bitmaps, the bitmaps are searched for
+ * runs of blocks instead of testing each block.  Unless the AONLY flag is 
+ * given, the content is read in large parts and long extents are passed to 
+ * the callback in more than one call.
+ *
+ * @param a_fs File system to analyze
+ * @param a_start_blk Block address to start walking from
+ * @param a_end_blk Block address to walk to
+ * @param a_flags Flags used during walk to determine which blocks to call callback with
+ * @param a_action Callback function
+ * @param a_ptr Pointer that will be passed to callback
+ * @returns 1 on error and 0 on success
+ */
+uint8_t
+tsk_fs_block_extent_walk(TSK_FS_INFO * a_fs,
+    TSK_DADDR_T a_start_blk, TSK_DADDR_T a_end_blk,
+    TSK_FS_BLOCK_WALK_FLAG_ENUM a_flags,
+    TSK_FS_BLOCK_EXTENT_WALK_CB a_action, void *a_ptr)
+{
+    TSK_FS_BLOCK_EXTENT_WALK walk;
+    TSK_WALK_RET_ENUM retval = TSK_WALK_CONT;
+
+    if ((a_fs == NULL) || (a_fs->tag != TSK_FS_INFO_TAG)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr
+            ("tsk_fs_block_extent_walk: FS_INFO structure is not allocated");
+        return 1;
+    }
+
+    memset(&walk, 0, sizeof(walk));
+    walk.fs = a_fs;
+    walk.flags = a_flags;
+    walk.action = a_action;
+    walk.ptr = a_ptr;
+    walk.extent.fs_info = a_fs;
+
+    if ((a_flags & TSK_FS_BLOCK_WALK_FLAG_AONLY) == 0) {
+        walk.buf_blocks = TSK_FS_BLOCK_EXTENT_READ_SIZE / a_fs->block_size;
+        if (walk.buf_blocks == 0)
+            walk.buf_blocks = 1;
+        if ((walk.buf =
+                (char *) tsk_malloc((size_t) walk.buf_blocks *
+                    a_fs->block_size)) == NULL)
+            return 1;
+    }
+
+    if (a_fs->block_getflags_run == NULL) {
+        // use the block walk of the file system to get the flags
+        if (a_fs->block_walk(a_fs, a_start_blk, a_end_blk,
+                (TSK_FS_BLOCK_WALK_FLAG_ENUM) (a_flags |
+                    TSK_FS_BLOCK_WALK_FLAG_AONLY),
+                tsk_fs_block_extent_walk_cb, &walk)) {
+            // give the blocks before the error, as the block walk does
+            if (walk.stopped == 0)
+                tsk_fs_block_extent_walk_flush(&walk);
+            free(walk.buf);
+            return 1;
+        }
+    }
+    else {
+        TSK_DADDR_T addr;
+
+        if (a_start_blk < a_fs->first_block
+            || a_start_blk > a_fs->last_block) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_FS_WALK_RNG);
+            tsk_error_set_errstr("tsk_fs_block_extent_walk: start block: %"
+                PRIuDADDR, a_start_blk);
+            free(walk.buf);
+            return 1;
+        }
+        if (a_end_blk < a_fs->first_block || a_end_blk > a_fs->last_block
+            || a_end_blk < a_start_blk) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_FS_WALK_RNG);
+            tsk_error_set_errstr("tsk_fs_block_extent_walk: end block: %"
+                PRIuDADDR, a_end_blk);
+            free(walk.buf);
+            return 1;
+        }
+
+        /* Sanity check on a_flags -- make sure at least one ALLOC is set */
+        if (((a_flags & TSK_FS_BLOCK_WALK_FLAG_ALLOC) == 0) &&
+            ((a_flags & TSK_FS_BLOCK_WALK_FLAG_UNALLOC) == 0)) {
+            a_flags |=
+                (TSK_FS_BLOCK_WALK_FLAG_ALLOC |
+                TSK_FS_BLOCK_WALK_FLAG_UNALLOC);
+        }
+        if (((a_flags & TSK_FS_BLOCK_WALK_FLAG_META) == 0) &&
+            ((a_flags & TSK_FS_BLOCK_WALK_FLAG_CONT) == 0)) {
+            a_flags |=
+                (TSK_FS_BLOCK_WALK_FLAG_CONT | TSK_FS_BLOCK_WALK_FLAG_META);
+        }
+
+        for (addr = a_start_blk; addr <= a_end_blk;) {
+            TSK_FS_BLOCK_FLAG_ENUM myflags;
+            TSK_DADDR_T len;
+
+            len = a_fs->block_getflags_run(a_fs, addr, a_end_blk, &myflags);
+            if (len == 0) {
+                free(walk.buf);
+                return 1;
+            }
+
+            // test if we should call the callback with these
+            if (((myflags & TSK_FS_BLOCK_FLAG_META)
+                    && (!(a_flags & TSK_FS_BLOCK_WALK_FLAG_META)))
+                || ((myflags & TSK_FS_BLOCK_FLAG_CONT)
+                    && (!(a_flags & TSK_FS_BLOCK_WALK_FLAG_CONT)))
+                || ((myflags & TSK_FS_BLOCK_FLAG_ALLOC)
+                    && (!(a_flags & TSK_FS_BLOCK_WALK_FLAG_ALLOC)))
+                || ((myflags & TSK_FS_BLOCK_FLAG_UNALLOC)
+                    && (!(a_flags & TSK_FS_BLOCK_WALK_FLAG_UNALLOC)))) {
+                addr += len;
+                continue;
+            }
+
+            myflags |= TSK_FS_BLOCK_FLAG_RAW;
+            if (a_flags & TSK_FS_BLOCK_WALK_FLAG_AONLY)
+                myflags |= TSK_FS_BLOCK_FLAG_AONLY;
+
+            retval = tsk_fs_block_extent_walk_add(&walk, addr, len, myflags);
+            if (retval == TSK_WALK_ERROR) {
+                free(walk.buf);
+                return 1;
+            }
+            else if (retval == TSK_WALK_STOP) {
+                break;
+            }
+            addr += len;
+        }
+    }
+
+    // the last extent
+    if (walk.stopped == 0) {
+        retval = tsk_fs_block_extent_walk_flush(&walk);
+    }
+    free(walk.buf);
+    return (retval == TSK_WALK_ERROR) ? 1 : 0;
+}
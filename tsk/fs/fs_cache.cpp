@@ -0,0 +1,916 @@
+/*
+** The Sleuth Kit
+**
+** Brian Carrier [carrier <at> sleuthkit [dot] org]
+** Copyright (c) 2011-2013 Brian Carrier.  All Rights reserved
+**
+** This software is distributed under the Common Public License 1.0
+*/
+
+/**
+ * \file fs_cache.cpp
+ * Contains the code that saves the data that is found while looking for
+ * orphan files to a sidecar cache file, so that it can be loaded instead
+ * of found again the next time that the file system is opened.
+ */
+
+#include "tsk_fs_i.h"
+#include "tsk_ntfs.h"
+
+#include <vector>
+
+#ifdef TSK_WIN32
+#include <io.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifndef S_IFMT
+#define S_IFMT __S_IFMT
+#endif
+
+#ifndef S_IFDIR
+#define S_IFDIR __S_IFDIR
+#endif
+
+/*
+ * The cache file is named after a key that identifies the file system and
+ * is made up of sections.  The values are in the byte order of the system
+ * that made the file and every structure is a multiple of 8 bytes so that
+ * the file can be used directly from a memory map.  Layout:
+ *   FS_CACHE_HEAD
+ *   FS_CACHE_SECT header and data, repeated FS_CACHE_HEAD.sect_count times
+ *
+ * Section data:
+ *   FS_CACHE_SECT_NAMED: TSK_LIST runs of list_inum_named as (key, len)
+ *      uint64_t pairs in list order
+ *   FS_CACHE_SECT_ORPHANS: FS_CACHE_DIR followed by one FS_CACHE_NAME for
+ *      each name in orphan_dir.  Each FS_CACHE_NAME is followed by the
+ *      name and the short name (without NULL) and padded to 8 bytes.
+ *   FS_CACHE_SECT_NTFS_PARENTS: FS_CACHE_NTFS followed by the
+ *      NTFS_PAR_MAP_ENT entries of the NTFS orphan map
+ */
+static const char FS_CACHE_MAGIC[8] = { 'T', 'S', 'K', 'F', 'S', 'C', 'H', '1' };
+static const uint32_t FS_CACHE_BYTE_ORDER = 0x01020304;
+static const uint32_t FS_CACHE_VERSION = 1;
+
+/** \internal
+ * Number of bytes that are hashed at the start of the file system and at
+ * the end of the image to make the key.
+ */
+#define FS_CACHE_KEY_READ 65536
+
+#define FS_CACHE_SECT_NAMED 1
+#define FS_CACHE_SECT_ORPHANS 2
+#define FS_CACHE_SECT_NTFS_PARENTS 3
+
+typedef struct {
+    char magic[8];              // FS_CACHE_MAGIC
+    uint32_t byte_order;        // FS_CACHE_BYTE_ORDER
+    uint32_t version;           // FS_CACHE_VERSION
+    uint8_t key[TSK_MD5_DIGEST_LENGTH];
+    uint64_t sect_count;        // Number of sections
+} FS_CACHE_HEAD;
+
+typedef struct {
+    uint32_t type;              // FS_CACHE_SECT_*
+    uint32_t pad;
+    uint64_t len;               // Number of bytes of data (multiple of 8)
+} FS_CACHE_SECT;
+
+typedef struct {
+    uint64_t addr;
+    uint32_t seq;
+    uint32_t pad;
+    uint64_t count;             // Number of names
+} FS_CACHE_DIR;
+
+typedef struct {
+    uint64_t meta_addr;
+    uint64_t par_addr;
+    uint32_t meta_seq;
+    uint32_t par_seq;
+    uint32_t type;
+    uint32_t flags;
+    uint32_t name_len;
+    uint32_t shrt_name_len;
+} FS_CACHE_NAME;
+
+typedef struct {
+    int64_t alloc_file_count;
+    uint64_t count;             // Number of NTFS_PAR_MAP_ENT entries
+} FS_CACHE_NTFS;
+
+/** \internal
+ * Values that are hashed with the file system data to make the key.
+ */
+typedef struct {
+    uint32_t tsk_version;
+    uint32_t cache_version;
+    uint64_t img_size;
+    int64_t offset;
+    uint32_t ftype;
+    uint32_t block_size;
+    uint64_t block_count;
+    uint64_t first_inum;
+    uint64_t last_inum;
+    uint64_t root_inum;
+    uint64_t fs_id_used;
+    uint8_t fs_id[TSK_FS_INFO_FS_ID_LEN];
+} FS_CACHE_KEY_INFO;
+
+/** \internal
+ * State of the cache for an open file system (TSK_FS_INFO::cache).
+ */
+struct TSK_FS_CACHE {
+    TSK_TCHAR *fname;           // Path of the cache file
+    uint8_t key[TSK_MD5_DIGEST_LENGTH];
+    int loaded;                 // Bit (1 << FS_CACHE_SECT_*) is set for each section that was loaded from the file
+};
+
+/* Directory that the cache files are in.  NULL if the cache is not used. */
+static TSK_TCHAR *fs_cache_dir = NULL;
+
+
+/**
+ * \ingroup fslib
+ * Set the directory to save the sidecar cache files in.  When it is set,
+ * the data that is found while looking for orphan files (the unallocated
+ * metadata addresses that have names, the contents of the $OrphanFiles
+ * directory and, for NTFS, the parent directory of each MFT entry) is
+ * saved in this directory when a file system is closed.  It is loaded when
+ * the same file system is opened again instead of walking the file system
+ * to find it.  The file is named after a hash of the file system layout,
+ * the start of the file system and the end of the image, so one directory
+ * can be used for many images.  This is not thread safe and should be
+ * called before file systems are opened.
+ *
+ * @param a_dir Directory to use or NULL to stop using the cache
+ * @returns 1 on error and 0 on success
+ */
+uint8_t
+tsk_fs_cache_set_dir(const TSK_TCHAR * a_dir)
+{
+    struct STAT_STR sb;
+    TSK_TCHAR *dir;
+    size_t len;
+
+    free(fs_cache_dir);
+    fs_cache_dir = NULL;
+    if (a_dir == NULL)
+        return 0;
+
+    if ((TSTAT(a_dir, &sb) < 0) || ((sb.st_mode & S_IFMT) != S_IFDIR)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr("tsk_fs_cache_set_dir: %" PRIttocTSK
+            " is not a directory", a_dir);
+        return 1;
+    }
+
+    len = TSTRLEN(a_dir) + 1;
+    if ((dir = (TSK_TCHAR *) tsk_malloc(len * sizeof(TSK_TCHAR))) == NULL)
+        return 1;
+    TSTRNCPY(dir, a_dir, len);
+    fs_cache_dir = dir;
+    return 0;
+}
+
+
+/** \internal
+ * Add the size and modification time of each image file to a key.  This
+ * makes a new key when an image file is changed or acquired again.
+ */
+static void
+fs_cache_key_img_files(TSK_IMG_INFO * a_img, TSK_MD5_CTX * a_md5)
+{
+    int i;
+
+    for (i = 0; i < a_img->num_img; i++) {
+        struct STAT_STR sb;
+        int64_t vals[2];
+
+        if ((a_img->images == NULL) || (a_img->images[i] == NULL)
+            || (TSTAT(a_img->images[i], &sb) < 0))
+            continue;
+        vals[0] = (int64_t) sb.st_size;
+        vals[1] = (int64_t) sb.st_mtime;
+        TSK_MD5_Update(a_md5, (unsigned char *) vals, sizeof(vals));
+    }
+}
+
+/** \internal
+ * Add the NTFS data that changes when MFT entries are changed to a key:
+ * the $LogFile sequence number of the $MFT entry and the $BITMAP of $MFT.
+ * The boot sectors that are in the rest of the key do not change when
+ * files are added or removed.
+ * @returns 1 on error and 0 on success
+ */
+static uint8_t
+fs_cache_key_ntfs(TSK_FS_INFO * a_fs, TSK_MD5_CTX * a_md5, char *a_buf)
+{
+    NTFS_INFO *ntfs = (NTFS_INFO *) a_fs;
+    const TSK_FS_ATTR *fs_attr;
+    TSK_OFF_T off;
+    ssize_t cnt;
+
+    if ((ntfs->mft_data == NULL) || (ntfs->mft_file == NULL)
+        || (ntfs->mft_file->meta == NULL)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr("fs_cache_key_ntfs: $MFT is not loaded");
+        return 1;
+    }
+
+    // the LSN is in the first sector of the entry, before any fixup value
+    cnt = tsk_fs_attr_read(ntfs->mft_data, 0, a_buf, sizeof(ntfs_mft),
+        TSK_FS_FILE_READ_FLAG_NONE);
+    if (cnt != (ssize_t) sizeof(ntfs_mft))
+        return 1;
+    TSK_MD5_Update(a_md5, ((ntfs_mft *) a_buf)->lsn,
+        sizeof(((ntfs_mft *) a_buf)->lsn));
+
+    if ((fs_attr = tsk_fs_attrlist_get(ntfs->mft_file->meta->attr,
+                (TSK_FS_ATTR_TYPE_ENUM) NTFS_ATYPE_BITMAP)) == NULL)
+        return 1;
+    for (off = 0; off < fs_attr->size; off += cnt) {
+        size_t len = FS_CACHE_KEY_READ;
+        if ((TSK_OFF_T) len > fs_attr->size - off)
+            len = (size_t) (fs_attr->size - off);
+        cnt = tsk_fs_attr_read(fs_attr, off, a_buf, len,
+            TSK_FS_FILE_READ_FLAG_NONE);
+        if (cnt != (ssize_t) len)
+            return 1;
+        TSK_MD5_Update(a_md5, (unsigned char *) a_buf, (unsigned int) len);
+    }
+    return 0;
+}
+
+
+/** \internal
+ * Make the key that identifies the file system.
+ * @returns 1 on error and 0 on success
+ */
+static uint8_t
+fs_cache_make_key(TSK_FS_INFO * a_fs, uint8_t * a_key)
+{
+    TSK_IMG_INFO *img = a_fs->img_info;
+    FS_CACHE_KEY_INFO info;
+    TSK_MD5_CTX md5;
+    char *buf;
+    size_t len;
+    ssize_t cnt;
+
+    memset(&info, 0, sizeof(info));
+    info.tsk_version = TSK_VERSION_NUM;
+    info.cache_version = FS_CACHE_VERSION;
+    info.img_size = img->size;
+    info.offset = a_fs->offset;
+    info.ftype = a_fs->ftype;
+    info.block_size = a_fs->block_size;
+    info.block_count = a_fs->block_count;
+    info.first_inum = a_fs->first_inum;
+    info.last_inum = a_fs->last_inum;
+    info.root_inum = a_fs->root_inum;
+    info.fs_id_used = a_fs->fs_id_used;
+    memcpy(info.fs_id, a_fs->fs_id, sizeof(info.fs_id));
+
+    TSK_MD5_Init(&md5);
+    TSK_MD5_Update(&md5, (unsigned char *) &info, sizeof(info));
+
+    if ((buf = (char *) tsk_malloc(FS_CACHE_KEY_READ)) == NULL)
+        return 1;
+
+    // the start of the file system has the boot sector or superblock
+    len = FS_CACHE_KEY_READ;
+    if ((TSK_OFF_T) len > img->size - a_fs->offset)
+        len = (size_t) (img->size - a_fs->offset);
+    cnt = tsk_fs_read(a_fs, 0, buf, len);
+    if (cnt != (ssize_t) len) {
+        free(buf);
+        return 1;
+    }
+    TSK_MD5_Update(&md5, (unsigned char *) buf, (unsigned int) len);
+
+    // the end of the image tells apart images with the same start
+    len = FS_CACHE_KEY_READ;
+    if ((TSK_OFF_T) len > img->size)
+        len = (size_t) img->size;
+    cnt = tsk_img_read(img, img->size - len, buf, len);
+    if (cnt != (ssize_t) len) {
+        free(buf);
+        return 1;
+    }
+    TSK_MD5_Update(&md5, (unsigned char *) buf, (unsigned int) len);
+
+    if (TSK_FS_TYPE_ISNTFS(a_fs->ftype) && fs_cache_key_ntfs(a_fs, &md5, buf)) {
+        free(buf);
+        return 1;
+    }
+    free(buf);
+
+    fs_cache_key_img_files(img, &md5);
+
+    TSK_MD5_Final(a_key, &md5);
+    return 0;
+}
+
+
+/** \internal
+ * Memory map a cache file.
+ * @param a_fname File to map
+ * @param a_size [out] Size of the file
+ * @param a_handle [out] Handle that must be passed to fs_cache_unmap()
+ * @returns Start of the map or NULL if the file does not exist or could
+ * not be mapped
+ */
+static uint8_t *
+fs_cache_map(const TSK_TCHAR * a_fname, size_t * a_size, void **a_handle)
+{
+    uint8_t *map = NULL;
+    uint64_t map_size = 0;
+
+    *a_handle = NULL;
+#ifdef TSK_WIN32
+    {
+        HANDLE hWin;
+        HANDLE hMap;
+        DWORD szLow, szHi;
+
+        if ((hWin = CreateFile(a_fname, GENERIC_READ, FILE_SHARE_READ, 0,
+                    OPEN_EXISTING, 0, 0)) == INVALID_HANDLE_VALUE) {
+            return NULL;
+        }
+
+        szLow = GetFileSize(hWin, &szHi);
+        map_size = szLow | ((uint64_t) szHi << 32);
+        if ((szLow == 0xffffffff) || (map_size < sizeof(FS_CACHE_HEAD))
+            || (map_size != (size_t) map_size)) {
+            CloseHandle(hWin);
+            return NULL;
+        }
+
+        hMap = CreateFileMapping(hWin, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(hWin);
+        if (hMap == NULL) {
+            return NULL;
+        }
+
+        if ((map = (uint8_t *) MapViewOfFile(hMap, FILE_MAP_READ, 0, 0,
+                    0)) == NULL) {
+            CloseHandle(hMap);
+            return NULL;
+        }
+        *a_handle = hMap;
+    }
+#else
+    {
+        struct stat sb;
+        int fd;
+
+        if (stat(a_fname, &sb) < 0) {
+            return NULL;
+        }
+        map_size = sb.st_size;
+        if ((map_size < sizeof(FS_CACHE_HEAD))
+            || (map_size != (size_t) map_size)) {
+            return NULL;
+        }
+
+        if ((fd = open(a_fname, O_RDONLY)) < 0) {
+            return NULL;
+        }
+
+        map = (uint8_t *) mmap(NULL, (size_t) map_size, PROT_READ,
+            MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            return NULL;
+        }
+    }
+#endif
+
+    *a_size = (size_t) map_size;
+    return map;
+}
+
+/** \internal
+ * Unmap a file that was mapped with fs_cache_map().
+ */
+static void
+fs_cache_unmap(uint8_t * a_map, size_t a_size, void *a_handle)
+{
+#ifdef TSK_WIN32
+    UnmapViewOfFile(a_map);
+    CloseHandle((HANDLE) a_handle);
+#else
+    munmap(a_map, a_size);
+#endif
+}
+
+
+/** \internal
+ * Load list_inum_named from a FS_CACHE_SECT_NAMED section.
+ * @returns 1 if the section is not valid and 0 on success
+ */
+static uint8_t
+fs_cache_load_named(TSK_FS_INFO * a_fs, const uint8_t * a_data,
+    uint64_t a_len)
+{
+    const uint64_t *runs = (const uint64_t *) a_data;
+    TSK_LIST *head = NULL;
+    TSK_LIST *tail = NULL;
+    uint64_t i;
+
+    if ((a_len % (2 * sizeof(uint64_t))) || (a_len == 0))
+        return 1;
+
+    /* The runs are in the order of the list (largest first), so the
+     * nodes are made directly instead of with tsk_list_add(). */
+    for (i = 0; i < a_len / sizeof(uint64_t); i += 2) {
+        TSK_LIST *ent;
+
+        if ((runs[i + 1] == 0) || (runs[i + 1] - 1 > runs[i])
+            || ((tail != NULL) && (runs[i] >= tail->key - (tail->len - 1)))) {
+            tsk_list_free(head);
+            return 1;
+        }
+        if ((ent = (TSK_LIST *) tsk_malloc(sizeof(TSK_LIST))) == NULL) {
+            tsk_list_free(head);
+            return 1;
+        }
+        ent->key = runs[i];
+        ent->len = runs[i + 1];
+        if (tail == NULL)
+            head = ent;
+        else
+            tail->next = ent;
+        tail = ent;
+    }
+
+    tsk_take_lock(&a_fs->list_inum_named_lock);
+    if (a_fs->list_inum_named == NULL) {
+        a_fs->list_inum_named = head;
+        head = NULL;
+    }
+    tsk_release_lock(&a_fs->list_inum_named_lock);
+    if (head)
+        tsk_list_free(head);
+    return 0;
+}
+
+/** \internal
+ * Load orphan_dir from a FS_CACHE_SECT_ORPHANS section.
+ * @returns 1 if the section is not valid and 0 on success
+ */
+static uint8_t
+fs_cache_load_orphans(TSK_FS_INFO * a_fs, const uint8_t * a_data,
+    uint64_t a_len)
+{
+    const FS_CACHE_DIR *cdir = (const FS_CACHE_DIR *) a_data;
+    TSK_FS_DIR *fs_dir;
+    TSK_FS_NAME *fs_name;
+    uint64_t off;
+    uint64_t i;
+
+    if ((a_len < sizeof(FS_CACHE_DIR))
+        || (cdir->count > (a_len - sizeof(FS_CACHE_DIR)) / sizeof(FS_CACHE_NAME)))
+        return 1;
+
+    if ((fs_dir = tsk_fs_dir_alloc(a_fs, cdir->addr,
+                (size_t) cdir->count + 1)) == NULL)
+        return 1;
+    fs_dir->seq = cdir->seq;
+
+    if ((fs_name = tsk_fs_name_alloc(256, 32)) == NULL) {
+        tsk_fs_dir_close(fs_dir);
+        return 1;
+    }
+
+    off = sizeof(FS_CACHE_DIR);
+    for (i = 0; i < cdir->count; i++) {
+        const FS_CACHE_NAME *cname = (const FS_CACHE_NAME *) &a_data[off];
+        uint64_t ent_len;
+
+        if (a_len - off < sizeof(FS_CACHE_NAME))
+            break;
+        ent_len = sizeof(FS_CACHE_NAME) + (uint64_t) cname->name_len +
+            cname->shrt_name_len;
+        ent_len = (ent_len + 7) & ~((uint64_t) 7);
+        if (ent_len > a_len - off)
+            break;
+
+        // make sure that the names fit
+        if ((cname->name_len >= fs_name->name_size)
+            || (cname->shrt_name_len >= fs_name->shrt_name_size)) {
+            tsk_fs_name_free(fs_name);
+            if ((fs_name = tsk_fs_name_alloc(cname->name_len + 1,
+                        cname->shrt_name_len + 1)) == NULL) {
+                tsk_fs_dir_close(fs_dir);
+                return 1;
+            }
+        }
+
+        memcpy(fs_name->name, &cname[1], cname->name_len);
+        fs_name->name[cname->name_len] = '\0';
+        memcpy(fs_name->shrt_name,
+            (const char *) &cname[1] + cname->name_len,
+            cname->shrt_name_len);
+        fs_name->shrt_name[cname->shrt_name_len] = '\0';
+        fs_name->meta_addr = cname->meta_addr;
+        fs_name->meta_seq = cname->meta_seq;
+        fs_name->par_addr = cname->par_addr;
+        fs_name->par_seq = cname->par_seq;
+        fs_name->type = (TSK_FS_NAME_TYPE_ENUM) cname->type;
+        fs_name->flags = (TSK_FS_NAME_FLAG_ENUM) cname->flags;
+
+        if (tsk_fs_dir_add(fs_dir, fs_name)) {
+            tsk_fs_name_free(fs_name);
+            tsk_fs_dir_close(fs_dir);
+            return 1;
+        }
+        off += ent_len;
+    }
+    tsk_fs_name_free(fs_name);
+
+    if (i != cdir->count) {
+        tsk_fs_dir_close(fs_dir);
+        return 1;
+    }
+
+    tsk_take_lock(&a_fs->orphan_dir_lock);
+    if (a_fs->orphan_dir == NULL) {
+        a_fs->orphan_dir = fs_dir;
+        fs_dir = NULL;
+    }
+    tsk_release_lock(&a_fs->orphan_dir_lock);
+    if (fs_dir)
+        tsk_fs_dir_close(fs_dir);
+    return 0;
+}
+
+/** \internal
+ * Load the NTFS orphan map from a FS_CACHE_SECT_NTFS_PARENTS section.
+ * @returns 1 if the section is not valid and 0 on success
+ */
+static uint8_t
+fs_cache_load_ntfs(TSK_FS_INFO * a_fs, const uint8_t * a_data,
+    uint64_t a_len)
+{
+    const FS_CACHE_NTFS *cntfs = (const FS_CACHE_NTFS *) a_data;
+
+    if ((TSK_FS_TYPE_ISNTFS(a_fs->ftype) == 0)
+        || (a_len < sizeof(FS_CACHE_NTFS))
+        || (cntfs->count != (a_len - sizeof(FS_CACHE_NTFS)) / sizeof(NTFS_PAR_MAP_ENT)))
+        return 1;
+
+    return ntfs_parent_map_import((NTFS_INFO *) a_fs,
+        (const NTFS_PAR_MAP_ENT *) &cntfs[1], (size_t) cntfs->count,
+        (int) cntfs->alloc_file_count);
+}
+
+
+/** \internal
+ * Called when a file system has been opened.  Loads the data in the
+ * sidecar cache file for the file system, if there is one.  Errors are not
+ * returned; the data is found from the file system if it is not loaded.
+ * @param a_fs File system that was opened
+ */
+void
+tsk_fs_cache_open(TSK_FS_INFO * a_fs)
+{
+    TSK_FS_CACHE *cache;
+    char hex[2 * TSK_MD5_DIGEST_LENGTH + 1];
+    size_t flen;
+    uint8_t *map;
+    size_t map_size = 0;
+    void *map_handle = NULL;
+    const FS_CACHE_HEAD *head;
+    uint64_t off;
+    uint64_t i;
+    int i2;
+
+    /* FAT records the parent directories that it sees during the walks
+     * that make this data, so it needs to do the walks. */
+    if ((fs_cache_dir == NULL) || (a_fs->cache != NULL)
+        || TSK_FS_TYPE_ISFAT(a_fs->ftype) || TSK_FS_TYPE_ISRAW(a_fs->ftype)
+        || TSK_FS_TYPE_ISSWAP(a_fs->ftype))
+        return;
+
+    if ((cache = (TSK_FS_CACHE *) tsk_malloc(sizeof(TSK_FS_CACHE))) == NULL) {
+        tsk_error_reset();
+        return;
+    }
+
+    if (fs_cache_make_key(a_fs, cache->key)) {
+        if (tsk_verbose)
+            tsk_fprintf(stderr,
+                "tsk_fs_cache_open: Error making cache key, not using cache\n");
+        tsk_error_reset();
+        free(cache);
+        return;
+    }
+
+    for (i2 = 0; i2 < TSK_MD5_DIGEST_LENGTH; i2++)
+        snprintf(&hex[2 * i2], 3, "%02x", cache->key[i2]);
+
+    flen = TSTRLEN(fs_cache_dir) + sizeof(hex) + 16;
+    if ((cache->fname =
+            (TSK_TCHAR *) tsk_malloc(flen * sizeof(TSK_TCHAR))) == NULL) {
+        tsk_error_reset();
+        free(cache);
+        return;
+    }
+    TSNPRINTF(cache->fname, flen, _TSK_T("%s/%") PRIcTSK _TSK_T(".tskfs"),
+        fs_cache_dir, hex);
+    a_fs->cache = cache;
+
+    if ((map = fs_cache_map(cache->fname, &map_size, &map_handle)) == NULL) {
+        if (tsk_verbose)
+            tsk_fprintf(stderr, "tsk_fs_cache_open: No cache file %"
+                PRIttocTSK "\n", cache->fname);
+        return;
+    }
+
+    head = (const FS_CACHE_HEAD *) map;
+    if ((memcmp(head->magic, FS_CACHE_MAGIC, sizeof(FS_CACHE_MAGIC)) != 0)
+        || (head->byte_order != FS_CACHE_BYTE_ORDER)
+        || (head->version != FS_CACHE_VERSION)
+        || (memcmp(head->key, cache->key, sizeof(cache->key)) != 0)) {
+        if (tsk_verbose)
+            tsk_fprintf(stderr,
+                "tsk_fs_cache_open: Ignoring out of date cache file %"
+                PRIttocTSK "\n", cache->fname);
+        fs_cache_unmap(map, map_size, map_handle);
+        return;
+    }
+
+    // check that all of the sections are in the file before using any
+    off = sizeof(FS_CACHE_HEAD);
+    for (i = 0; i < head->sect_count; i++) {
+        const FS_CACHE_SECT *sect = (const FS_CACHE_SECT *) &map[off];
+        if ((map_size - off < sizeof(FS_CACHE_SECT))
+            || (sect->len % 8)
+            || (sect->len > map_size - off - sizeof(FS_CACHE_SECT)))
+            break;
+        off += sizeof(FS_CACHE_SECT) + sect->len;
+    }
+    if ((i != head->sect_count) || (off != map_size)) {
+        if (tsk_verbose)
+            tsk_fprintf(stderr,
+                "tsk_fs_cache_open: Ignoring truncated cache file %"
+                PRIttocTSK "\n", cache->fname);
+        fs_cache_unmap(map, map_size, map_handle);
+        return;
+    }
+
+    off = sizeof(FS_CACHE_HEAD);
+    for (i = 0; i < head->sect_count; i++) {
+        const FS_CACHE_SECT *sect = (const FS_CACHE_SECT *) &map[off];
+        const uint8_t *data = &map[off + sizeof(FS_CACHE_SECT)];
+        uint8_t retval = 1;
+
+        off += sizeof(FS_CACHE_SECT) + sect->len;
+        if ((sect->type >= 8 * sizeof(cache->loaded))
+            || (cache->loaded & (1 << sect->type)))
+            continue;
+
+        if (sect->type == FS_CACHE_SECT_NAMED)
+            retval = fs_cache_load_named(a_fs, data, sect->len);
+        else if (sect->type == FS_CACHE_SECT_ORPHANS)
+            retval = fs_cache_load_orphans(a_fs, data, sect->len);
+        else if (sect->type == FS_CACHE_SECT_NTFS_PARENTS)
+            retval = fs_cache_load_ntfs(a_fs, data, sect->len);
+
+        if (retval) {
+            tsk_error_reset();
+            continue;
+        }
+        cache->loaded |= (1 << sect->type);
+    }
+    fs_cache_unmap(map, map_size, map_handle);
+
+    if (tsk_verbose)
+        tsk_fprintf(stderr,
+            "tsk_fs_cache_open: Loaded cache file %" PRIttocTSK
+            " (sections: %x)\n", cache->fname, cache->loaded);
+}
+
+
+/** \internal
+ * Add a section to the cache file that is being made.
+ */
+static void
+fs_cache_add_sect(std::vector < uint8_t > &a_buf, uint32_t a_type,
+    const std::vector < uint8_t > &a_data)
+{
+    FS_CACHE_SECT sect;
+    memset(&sect, 0, sizeof(sect));
+    sect.type = a_type;
+    sect.len = a_data.size();
+    a_buf.insert(a_buf.end(), (const uint8_t *) &sect,
+        (const uint8_t *) &sect + sizeof(sect));
+    a_buf.insert(a_buf.end(), a_data.begin(), a_data.end());
+    ((FS_CACHE_HEAD *) &a_buf[0])->sect_count++;
+}
+
+/** \internal
+ * Append a structure to a section that is being made.
+ */
+static void
+fs_cache_append(std::vector < uint8_t > &a_data, const void *a_ptr,
+    size_t a_len)
+{
+    a_data.insert(a_data.end(), (const uint8_t *) a_ptr,
+        (const uint8_t *) a_ptr + a_len);
+}
+
+/** \internal
+ * Write the cache file.  It is written to a temp file first so that other
+ * processes never see a partial file.  The temp file has a unique name so
+ * that processes that save the same file system at the same time do not
+ * write to the same temp file.
+ * @returns 1 on error and 0 on success
+ */
+static uint8_t
+fs_cache_write(const TSK_TCHAR * a_fname, const std::vector < uint8_t > &a_buf)
+{
+    size_t flen = TSTRLEN(a_fname) + 32;
+    TSK_TCHAR *tmp_fname;
+    FILE *hFile;
+    uint8_t failed;
+
+    if ((tmp_fname =
+            (TSK_TCHAR *) tsk_malloc(flen * sizeof(TSK_TCHAR))) == NULL)
+        return 1;
+
+#ifdef TSK_WIN32
+    TSNPRINTF(tmp_fname, flen, _TSK_T("%s.%lu-%lu.tmp"), a_fname,
+        (unsigned long) GetCurrentProcessId(),
+        (unsigned long) GetCurrentThreadId());
+    hFile = _wfopen(tmp_fname, L"wb");
+#else
+    {
+        int fd;
+
+        TSNPRINTF(tmp_fname, flen, _TSK_T("%s.XXXXXX"), a_fname);
+        if ((fd = mkstemp(tmp_fname)) < 0) {
+            free(tmp_fname);
+            return 1;
+        }
+        if ((hFile = fdopen(fd, "wb")) == NULL) {
+            close(fd);
+            unlink(tmp_fname);
+        }
+    }
+#endif
+    if (hFile == NULL) {
+        free(tmp_fname);
+        return 1;
+    }
+
+    failed = (fwrite(&a_buf[0], a_buf.size(), 1, hFile) != 1);
+    if (fclose(hFile))
+        failed = 1;
+
+#ifdef TSK_WIN32
+    if ((failed == 0)
+        && (MoveFileEx(tmp_fname, a_fname, MOVEFILE_REPLACE_EXISTING) == 0))
+        failed = 1;
+    if (failed)
+        _wunlink(tmp_fname);
+#else
+    if ((failed == 0) && (rename(tmp_fname, a_fname) != 0))
+        failed = 1;
+    if (failed)
+        unlink(tmp_fname);
+#endif
+
+    free(tmp_fname);
+    return failed;
+}
+
+/** \internal
+ * Called when a file system is being closed.  Saves the orphan data that
+ * was found while it was open to the sidecar cache file, if there is any
+ * that is not already in the file.  Errors are not returned.  This must
+ * be called before the file system specific data is freed.
+ * @param a_fs File system that is being closed
+ */
+void
+tsk_fs_cache_save(TSK_FS_INFO * a_fs)
+{
+    TSK_FS_CACHE *cache = a_fs->cache;
+    std::vector < uint8_t > buf;
+    std::vector < uint8_t > data;
+    FS_CACHE_HEAD head;
+    int have = 0;
+
+    if (cache == NULL)
+        return;
+    a_fs->cache = NULL;
+
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, FS_CACHE_MAGIC, sizeof(FS_CACHE_MAGIC));
+    head.byte_order = FS_CACHE_BYTE_ORDER;
+    head.version = FS_CACHE_VERSION;
+    memcpy(head.key, cache->key, sizeof(head.key));
+    fs_cache_append(buf, &head, sizeof(head));
+
+    tsk_take_lock(&a_fs->list_inum_named_lock);
+    if (a_fs->list_inum_named) {
+        TSK_LIST *ent;
+        data.clear();
+        for (ent = a_fs->list_inum_named; ent != NULL; ent = ent->next) {
+            fs_cache_append(data, &ent->key, sizeof(uint64_t));
+            fs_cache_append(data, &ent->len, sizeof(uint64_t));
+        }
+        fs_cache_add_sect(buf, FS_CACHE_SECT_NAMED, data);
+        have |= (1 << FS_CACHE_SECT_NAMED);
+    }
+    tsk_release_lock(&a_fs->list_inum_named_lock);
+
+    tsk_take_lock(&a_fs->orphan_dir_lock);
+    if (a_fs->orphan_dir) {
+        TSK_FS_DIR *fs_dir = a_fs->orphan_dir;
+        FS_CACHE_DIR cdir;
+        size_t i;
+
+        data.clear();
+        memset(&cdir, 0, sizeof(cdir));
+        cdir.addr = fs_dir->addr;
+        cdir.seq = fs_dir->seq;
+        cdir.count = fs_dir->names_used;
+        fs_cache_append(data, &cdir, sizeof(cdir));
+        for (i = 0; i < fs_dir->names_used; i++) {
+            TSK_FS_NAME *fs_name = &fs_dir->names[i];
+            FS_CACHE_NAME cname;
+
+            memset(&cname, 0, sizeof(cname));
+            cname.meta_addr = fs_name->meta_addr;
+            cname.meta_seq = fs_name->meta_seq;
+            cname.par_addr = fs_name->par_addr;
+            cname.par_seq = fs_name->par_seq;
+            cname.type = fs_name->type;
+            cname.flags = fs_name->flags;
+            cname.name_len =
+                (uint32_t) (fs_name->name ? strlen(fs_name->name) : 0);
+            cname.shrt_name_len =
+                (uint32_t) (fs_name->shrt_name ? strlen(fs_name->shrt_name) : 0);
+            fs_cache_append(data, &cname, sizeof(cname));
+            fs_cache_append(data, fs_name->name, cname.name_len);
+            fs_cache_append(data, fs_name->shrt_name, cname.shrt_name_len);
+            data.resize((data.size() + 7) & ~((size_t) 7), 0);
+        }
+        fs_cache_add_sect(buf, FS_CACHE_SECT_ORPHANS, data);
+        have |= (1 << FS_CACHE_SECT_ORPHANS);
+    }
+    tsk_release_lock(&a_fs->orphan_dir_lock);
+
+    if (TSK_FS_TYPE_ISNTFS(a_fs->ftype)) {
+        NTFS_PAR_MAP_ENT *ents = NULL;
+        size_t count = 0;
+
+        if (ntfs_parent_map_export((NTFS_INFO *) a_fs, &ents, &count) == 0) {
+            if (ents) {
+                FS_CACHE_NTFS cntfs;
+
+                data.clear();
+                memset(&cntfs, 0, sizeof(cntfs));
+                cntfs.alloc_file_count = ((NTFS_INFO *) a_fs)->alloc_file_count;
+                cntfs.count = count;
+                fs_cache_append(data, &cntfs, sizeof(cntfs));
+                fs_cache_append(data, ents, count * sizeof(NTFS_PAR_MAP_ENT));
+                fs_cache_add_sect(buf, FS_CACHE_SECT_NTFS_PARENTS, data);
+                have |= (1 << FS_CACHE_SECT_NTFS_PARENTS);
+                free(ents);
+            }
+        }
+        else {
+            tsk_error_reset();
+        }
+    }
+
+    // only write the file if there is something new to save
+    if (have & ~cache->loaded) {
+        if (fs_cache_write(cache->fname, buf)) {
+            if (tsk_verbose)
+                tsk_fprintf(stderr,
+                    "tsk_fs_cache_save: Error writing cache file %"
+                    PRIttocTSK "\n", cache->fname);
+            tsk_error_reset();
+        }
+        else if (tsk_verbose) {
+            tsk_fprintf(stderr,
+                "tsk_fs_cache_save: Saved cache file %" PRIttocTSK
+                " (sections: %x)\n", cache->fname, have);
+        }
+    }
+
+    free(cache->fname);
+    free(cache);
+}
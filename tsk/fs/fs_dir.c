@@ -18,6 +18,130 @@
 #include "tsk_fatfs.h"
 
 
+/* Number of names a directory must have before tsk_fs_dir_add() and
+ * tsk_fs_dir_contains() use a hash index instead of a linear search. */
+#define TSK_FS_DIR_IDX_MIN  64
+
+/** \internal
+ * Open addressing hash table of the names in a TSK_FS_DIR, keyed by
+ * the metadata address and tsk_fs_dir_hash() of the name.  Entries with
+ * the same key are kept in the same probe sequence so that all of them
+ * can be found.
+ */
+struct TSK_FS_DIR_IDX {
+    size_t *slot_idx;           ///< Index into names + 1 (0 if slot is empty)
+    uint32_t *slot_hash;        ///< Hash of the name in each slot
+    size_t slot_cnt;            ///< Number of slots (power of 2)
+    size_t used;                ///< Number of slots in use
+};
+
+static size_t
+tsk_fs_dir_idx_slot(const TSK_FS_DIR_IDX * a_idx, TSK_INUM_T a_meta_addr,
+    uint32_t a_hash)
+{
+    uint64_t key = ((uint64_t) a_meta_addr * 0x9E3779B97F4A7C15ULL) ^ a_hash;
+    key ^= key >> 29;
+    return (size_t) (key & (a_idx->slot_cnt - 1));
+}
+
+static void
+tsk_fs_dir_idx_free(TSK_FS_DIR * a_fs_dir)
+{
+    if (a_fs_dir->name_idx == NULL)
+        return;
+    free(a_fs_dir->name_idx->slot_idx);
+    free(a_fs_dir->name_idx->slot_hash);
+    free(a_fs_dir->name_idx);
+    a_fs_dir->name_idx = NULL;
+}
+
+/* Add names[a_name_idx] to the table.  There must be a free slot. */
+static void
+tsk_fs_dir_idx_insert(TSK_FS_DIR * a_fs_dir, size_t a_name_idx,
+    uint32_t a_hash)
+{
+    TSK_FS_DIR_IDX *idx = a_fs_dir->name_idx;
+    size_t slot = tsk_fs_dir_idx_slot(idx,
+        a_fs_dir->names[a_name_idx].meta_addr, a_hash);
+
+    while (idx->slot_idx[slot])
+        slot = (slot + 1) & (idx->slot_cnt - 1);
+
+    idx->slot_idx[slot] = a_name_idx + 1;
+    idx->slot_hash[slot] = a_hash;
+    idx->used++;
+}
+
+/* (Re)build the table with room for at least a_cnt names.
+ * @returns 1 on error */
+static uint8_t
+tsk_fs_dir_idx_build(TSK_FS_DIR * a_fs_dir, size_t a_cnt)
+{
+    TSK_FS_DIR_IDX *idx;
+    size_t i;
+
+    tsk_fs_dir_idx_free(a_fs_dir);
+
+    if ((idx = (TSK_FS_DIR_IDX *) tsk_malloc(sizeof(TSK_FS_DIR_IDX))) ==
+        NULL)
+        return 1;
+
+    // keep the load factor under 1/2
+    idx->slot_cnt = 256;
+    while (idx->slot_cnt < 2 * a_cnt)
+        idx->slot_cnt <<= 1;
+
+    if (((idx->slot_idx =
+                (size_t *) tsk_malloc(idx->slot_cnt * sizeof(size_t))) ==
+            NULL)
+        || ((idx->slot_hash =
+                (uint32_t *) tsk_malloc(idx->slot_cnt *
+                    sizeof(uint32_t))) == NULL)) {
+        free(idx->slot_idx);
+        free(idx);
+        return 1;
+    }
+    a_fs_dir->name_idx = idx;
+
+    for (i = 0; i < a_fs_dir->names_used; i++) {
+        tsk_fs_dir_idx_insert(a_fs_dir, i,
+            tsk_fs_dir_hash(a_fs_dir->names[i].name));
+    }
+    return 0;
+}
+
+/* Build the index if the directory has become large enough to need one.
+ * The index is only a speed up, so errors are not returned. */
+static void
+tsk_fs_dir_idx_check(TSK_FS_DIR * a_fs_dir)
+{
+    if ((a_fs_dir->name_idx == NULL)
+        && (a_fs_dir->names_used >= TSK_FS_DIR_IDX_MIN)) {
+        if (tsk_fs_dir_idx_build(a_fs_dir, a_fs_dir->names_used))
+            tsk_error_reset();
+    }
+}
+
+/* Add the name that was just put at the end of names to the index
+ * (if there is one), growing it as needed. */
+static void
+tsk_fs_dir_idx_add_last(TSK_FS_DIR * a_fs_dir, uint32_t a_hash)
+{
+    TSK_FS_DIR_IDX *idx = a_fs_dir->name_idx;
+
+    if (idx == NULL)
+        return;
+
+    if (2 * (idx->used + 1) > idx->slot_cnt) {
+        // the new name is already in names, so the rebuild adds it
+        if (tsk_fs_dir_idx_build(a_fs_dir, 2 * a_fs_dir->names_used))
+            tsk_error_reset();
+        return;
+    }
+    tsk_fs_dir_idx_insert(a_fs_dir, a_fs_dir->names_used - 1, a_hash);
+}
+
+
 /** \internal
 * Allocate a FS_DIR structure to load names into.
 *
@@ -102,6 +226,7 @@ tsk_fs_dir_reset(TSK_FS_DIR * a_fs_dir)
         tsk_fs_file_close(a_fs_dir->fs_file);
         a_fs_dir->fs_file = NULL;
     }
+    tsk_fs_dir_idx_free(a_fs_dir);
     a_fs_dir->names_used = 0;
     a_fs_dir->addr = 0;
     a_fs_dir->seq = 0;
@@ -121,6 +246,7 @@ tsk_fs_dir_copy(const TSK_FS_DIR * a_src_dir, TSK_FS_DIR * a_dst_dir)
 {
     size_t i;
 
+    tsk_fs_dir_idx_free(a_dst_dir);
     a_dst_dir->names_used = 0;
 
     // make sure we got the room
@@ -155,6 +281,24 @@ tsk_fs_dir_contains(TSK_FS_DIR * a_fs_dir, TSK_INUM_T meta_addr, uint32_t hash)
     size_t i;
     uint8_t bestFound = 0;
 
+    tsk_fs_dir_idx_check(a_fs_dir);
+
+    if (a_fs_dir->name_idx) {
+        TSK_FS_DIR_IDX *idx = a_fs_dir->name_idx;
+        size_t slot = tsk_fs_dir_idx_slot(idx, meta_addr, hash);
+
+        for (; idx->slot_idx[slot]; slot = (slot + 1) & (idx->slot_cnt - 1)) {
+            TSK_FS_NAME *fs_name = &a_fs_dir->names[idx->slot_idx[slot] - 1];
+            if ((idx->slot_hash[slot] == hash)
+                && (fs_name->meta_addr == meta_addr)) {
+                bestFound = fs_name->flags;
+                if (bestFound == TSK_FS_NAME_FLAG_ALLOC)
+                    break;
+            }
+        }
+        return bestFound;
+    }
+
     for (i = 0; i < a_fs_dir->names_used; i++) {
         if (meta_addr == a_fs_dir->names[i].meta_addr) {
             if (hash == tsk_fs_dir_hash(a_fs_dir->names[i].name)) {
@@ -203,18 +347,42 @@ uint8_t
 tsk_fs_dir_add(TSK_FS_DIR * a_fs_dir, const TSK_FS_NAME * a_fs_name)
 {
     TSK_FS_NAME *fs_name_dest = NULL;
+    uint32_t hash = 0;
     size_t i;
 
     /* see if we already have it in the buffer / queue
      * We skip this check for FAT because it will always fail because two entries
-     * never have the same meta address. */
-    // @@@ We could do something more efficient here too with orphan files because we do not 
-    // need to check the contents of that directory either and this takes a lot of time on those
-    // large images.
+     * never have the same meta address.
+     * Large directories (and $OrphanFiles) use the hash index so that
+     * loading them is not quadratic. */
+    if (TSK_FS_TYPE_ISFAT(a_fs_dir->fs_info->ftype) == 0) {
+        tsk_fs_dir_idx_check(a_fs_dir);
+    }
+    if (a_fs_dir->name_idx) {
+        hash = tsk_fs_dir_hash(a_fs_name->name);
+    }
+
     if (TSK_FS_TYPE_ISFAT(a_fs_dir->fs_info->ftype) == 0) {
-        for (i = 0; i < a_fs_dir->names_used; i++) {
-            if ((a_fs_name->meta_addr == a_fs_dir->names[i].meta_addr) &&
-                (strcmp(a_fs_name->name, a_fs_dir->names[i].name) == 0)) {
+        TSK_FS_DIR_IDX *idx = a_fs_dir->name_idx;
+        size_t slot = 0;
+
+        if (idx)
+            slot = tsk_fs_dir_idx_slot(idx, a_fs_name->meta_addr, hash);
+
+        /* Without an index, look at every name.  With one, look at
+         * the names in the probe sequence until an empty slot. */
+        for (i = 0; idx ? (idx->slot_idx[slot] != 0) : (i < a_fs_dir->names_used);
+            i++, slot = idx ? ((slot + 1) & (idx->slot_cnt - 1)) : 0) {
+            size_t name_i = i;
+
+            if (idx) {
+                if (idx->slot_hash[slot] != hash)
+                    continue;
+                name_i = idx->slot_idx[slot] - 1;
+            }
+
+            if ((a_fs_name->meta_addr == a_fs_dir->names[name_i].meta_addr) &&
+                (strcmp(a_fs_name->name, a_fs_dir->names[name_i].name) == 0)) {
 
                 if (tsk_verbose)
                     tsk_fprintf(stderr,
@@ -224,12 +392,12 @@ tsk_fs_dir_add(TSK_FS_DIR * a_fs_dir, const TSK_FS_NAME * a_fs_name)
 
                 /* We do not check type because then we cannot detect NTFS orphan file
                  * duplicates that are added as "-/r" while a similar entry exists as "r/r"
-                 (a_fs_name->type == a_fs_dir->names[i].type)) { */
+                 (a_fs_name->type == a_fs_dir->names[name_i].type)) { */
 
                 // if the one in the list is unalloc and we have an alloc, replace it
-                if ((a_fs_dir->names[i].flags & TSK_FS_NAME_FLAG_UNALLOC)
+                if ((a_fs_dir->names[name_i].flags & TSK_FS_NAME_FLAG_UNALLOC)
                     && (a_fs_name->flags & TSK_FS_NAME_FLAG_ALLOC)) {
-                    fs_name_dest = &a_fs_dir->names[i];
+                    fs_name_dest = &a_fs_dir->names[name_i];
 
                     // free the memory - not the most efficient, but prevents
                     // duplicate code.
@@ -251,10 +419,15 @@ tsk_fs_dir_add(TSK_FS_DIR * a_fs_dir, const TSK_FS_NAME * a_fs_name)
         }
 
         fs_name_dest = &a_fs_dir->names[a_fs_dir->names_used++];
-    }
+        if (tsk_fs_name_copy(fs_name_dest, a_fs_name))
+            return 1;
 
-    if (tsk_fs_name_copy(fs_name_dest, a_fs_name))
+        // a replaced entry keeps its key, so only new entries are indexed
+        tsk_fs_dir_idx_add_last(a_fs_dir, hash);
+    }
+    else if (tsk_fs_name_copy(fs_name_dest, a_fs_name)) {
         return 1;
+    }
 
     // add the parent address
     if (a_fs_dir->addr) {
@@ -361,6 +534,7 @@ tsk_fs_dir_close(TSK_FS_DIR * a_fs_dir)
         tsk_fs_dir_free_name_internal(&a_fs_dir->names[i]);
     }
     free(a_fs_dir->names);
+    tsk_fs_dir_idx_free(a_fs_dir);
 
     if (a_fs_dir->fs_file) {
         tsk_fs_file_close(a_fs_dir->fs_file);
@@ -1229,6 +1403,8 @@ tsk_fs_dir_find_orphans(TSK_FS_INFO * a_fs, TSK_FS_DIR * a_fs_dir)
     for (i = 0; i < a_fs_dir->names_used; i++) {
         if (tsk_list_find(data.orphan_subdir_list,
                 a_fs_dir->names[i].meta_addr)) {
+            // names are moved and removed, so the name index is stale
+            tsk_fs_dir_idx_free(a_fs_dir);
             if (a_fs_dir->names_used > 1) {
                 tsk_fs_name_copy(&a_fs_dir->names[i],
                     &a_fs_dir->names[a_fs_dir->names_used - 1]);
@@ -0,0 +1,697 @@
+/*
+** The Sleuth Kit
+**
+** Brian Carrier [carrier <at> sleuthkit [dot] org]
+** Copyright (c) 2011-2013 Brian Carrier.  All Rights reserved
+**
+** This software is distributed under the Common Public License 1.0
+*/
+
+/**
+ * \file fs_dir_iter.cpp
+ * Contains the iterator that returns the files of a directory tree one at
+ * a time.  It returns the same files as tsk_fs_dir_walk(), but keeps its
+ * state in a heap stack instead of recursing, so there is no limit on the
+ * depth or path length and the caller does not need a callback.
+ */
+
+#include "tsk_fs_i.h"
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <unordered_set>
+
+#define TSK_FS_DIR_ITER_TAG 0x57531247
+
+/** \internal
+ * Identifies the format of a checkpoint from tsk_fs_dir_iter_checkpoint().
+ */
+static const char fs_dir_iter_magic[8] =
+    { 'T', 'S', 'K', 'D', 'I', 'T', 'R', '1' };
+
+/** \internal
+ * A directory that is open in the iterator.  In depth first order there
+ * is one for each directory between the starting directory and the
+ * current one.  In breadth first order there is at most one.
+ */
+typedef struct {
+    TSK_FS_DIR *fs_dir;
+    TSK_INUM_T addr;            ///< Address of the directory
+    size_t idx;                 ///< Index of the current name in fs_dir
+    size_t path_len;            ///< Length of the path of the names in fs_dir
+    uint8_t save_bak;           ///< save_inum_named value before entering the directory
+} FS_DIR_ITER_FRAME;
+
+/** \internal
+ * A directory that is waiting to be opened in breadth first order.
+ */
+typedef struct {
+    TSK_INUM_T addr;
+    std::string path;
+} FS_DIR_ITER_QUEUED;
+
+struct TSK_FS_DIR_ITER {
+    int tag;
+    TSK_FS_INFO *fs;
+    TSK_INUM_T addr;            ///< Address of the starting directory
+    TSK_FS_DIR_WALK_FLAG_ENUM flags;
+    TSK_FS_DIR_ITER_ORDER_ENUM order;
+
+    TSK_FS_FILE *fs_file;       ///< File that is returned (name points into the frame's directory)
+    std::string path;           ///< Path of the current directory (ends in '/' if not empty)
+    std::vector < FS_DIR_ITER_FRAME > frames;
+    std::deque < FS_DIR_ITER_QUEUED > queue;    ///< Directories left to open (breadth first only)
+
+    /* Directories that are being walked (depth first) or that have been
+     * queued (breadth first), to stop at loops */
+    std::unordered_set < TSK_INUM_T > seen;
+
+    bool pending;               ///< The current name was returned and has not been finished
+    bool skip;                  ///< Do not recurse into the current name
+
+    /* Collect the unallocated named files for the orphan search (see
+     * tsk_fs_dir_walk()) */
+    uint8_t save_inum_named;
+    TSK_LIST *list_inum_named;
+};
+
+/** \internal
+ * Give the list of named unallocated files to the file system if no
+ * other walk has already done so.
+ */
+static void
+fs_dir_iter_save_named(TSK_FS_DIR_ITER * a_iter)
+{
+    TSK_FS_INFO *fs = a_iter->fs;
+
+    tsk_take_lock(&fs->list_inum_named_lock);
+    if (fs->list_inum_named == NULL) {
+        fs->list_inum_named = a_iter->list_inum_named;
+    }
+    else {
+        tsk_list_free(a_iter->list_inum_named);
+    }
+    a_iter->list_inum_named = NULL;
+    tsk_release_lock(&fs->list_inum_named_lock);
+    a_iter->save_inum_named = 0;
+}
+
+/** \internal
+ * Open a directory and make it the current one.
+ * @returns 1 on error
+ */
+static uint8_t
+fs_dir_iter_push(TSK_FS_DIR_ITER * a_iter, TSK_INUM_T a_addr)
+{
+    FS_DIR_ITER_FRAME frame;
+
+    if ((frame.fs_dir = tsk_fs_dir_open_meta(a_iter->fs, a_addr)) == NULL)
+        return 1;
+    frame.addr = a_addr;
+    frame.idx = 0;
+    frame.path_len = a_iter->path.size();
+    frame.save_bak = a_iter->save_inum_named;
+    a_iter->frames.push_back(frame);
+    return 0;
+}
+
+/** \internal
+ * Close the current directory and go back to its parent (depth first).
+ */
+static void
+fs_dir_iter_pop(TSK_FS_DIR_ITER * a_iter)
+{
+    FS_DIR_ITER_FRAME & frame = a_iter->frames.back();
+
+    if ((a_iter->order == TSK_FS_DIR_ITER_ORDER_DEPTH)
+        && (a_iter->frames.size() > 1)) {
+        a_iter->seen.erase(frame.addr);
+        if (frame.addr == TSK_FS_ORPHANDIR_INUM(a_iter->fs))
+            a_iter->save_inum_named = frame.save_bak;
+    }
+    tsk_fs_dir_close(frame.fs_dir);
+    a_iter->frames.pop_back();
+
+    if (a_iter->frames.empty() == false) {
+        a_iter->path.resize(a_iter->frames.back().path_len);
+        a_iter->frames.back().idx++;
+    }
+}
+
+/** \internal
+ * Load the metadata of the current name.
+ */
+static void
+fs_dir_iter_load(TSK_FS_DIR_ITER * a_iter)
+{
+    FS_DIR_ITER_FRAME & frame = a_iter->frames.back();
+    TSK_FS_FILE *fs_file = a_iter->fs_file;
+    TSK_FS_INFO *fs = a_iter->fs;
+
+    fs_file->name = &frame.fs_dir->names[frame.idx];
+
+    /* load the fs_meta structure if possible.
+     * Must have non-zero inode addr or have allocated name (if inode is 0) */
+    if ((fs_file->name->meta_addr)
+        || (fs_file->name->flags & TSK_FS_NAME_FLAG_ALLOC)) {
+        if (fs->file_add_meta(fs, fs_file, fs_file->name->meta_addr)) {
+            if (tsk_verbose)
+                tsk_error_print(stderr);
+            tsk_error_reset();
+        }
+    }
+
+    // save the inode info for orphan finding - if requested
+    if ((a_iter->save_inum_named) && (fs_file->meta)
+        && (fs_file->meta->flags & TSK_FS_META_FLAG_UNALLOC)) {
+        if (tsk_list_add(&a_iter->list_inum_named, fs_file->meta->addr)) {
+            tsk_list_free(a_iter->list_inum_named);
+            a_iter->list_inum_named = NULL;
+            a_iter->save_inum_named = 0;
+        }
+    }
+
+    /* If the orphan directory is the last name, then all of the named
+     * files have been seen.  Save the list now so that the orphan search
+     * does not need to do its own inode walk. */
+    if ((fs_file->name->meta_addr == TSK_FS_ORPHANDIR_INUM(fs))
+        && (frame.idx == frame.fs_dir->names_used - 1)
+        && (a_iter->save_inum_named == 1)) {
+        fs_dir_iter_save_named(a_iter);
+    }
+}
+
+/** \internal
+ * Finish the current name: recurse into it if it is a directory (see
+ * tsk_fs_dir_walk() for the rules) and move to the next name.
+ */
+static void
+fs_dir_iter_finish(TSK_FS_DIR_ITER * a_iter)
+{
+    TSK_FS_FILE *fs_file = a_iter->fs_file;
+    TSK_FS_INFO *fs = a_iter->fs;
+    bool pushed = false;
+
+    if ((a_iter->skip == false)
+        && (TSK_FS_IS_DIR_NAME(fs_file->name->type)
+            || (fs_file->name->type == TSK_FS_NAME_TYPE_UNDEF))
+        && (fs_file->meta)
+        && (TSK_FS_IS_DIR_META(fs_file->meta->type))
+        && (a_iter->flags & TSK_FS_DIR_WALK_FLAG_RECURSE)
+        && ((fs_file->name->flags & TSK_FS_NAME_FLAG_ALLOC)
+            || ((fs_file->name->flags & TSK_FS_NAME_FLAG_UNALLOC)
+                && (fs_file->meta->flags & TSK_FS_META_FLAG_UNALLOC)))
+        && (!TSK_FS_ISDOT(fs_file->name->name))
+        && ((fs_file->name->meta_addr != TSK_FS_ORPHANDIR_INUM(fs))
+            || ((a_iter->flags & TSK_FS_DIR_WALK_FLAG_NOORPHAN) == 0))) {
+        TSK_INUM_T addr = fs_file->name->meta_addr;
+
+        /* Make sure we do not get into an infinite loop */
+        if (a_iter->seen.insert(addr).second == false) {
+            if (tsk_verbose)
+                tsk_fprintf(stderr,
+                    "fs_dir_iter_finish: Loop detected with address %"
+                    PRIuINUM "\n", addr);
+        }
+        else if (a_iter->order == TSK_FS_DIR_ITER_ORDER_BREADTH) {
+            FS_DIR_ITER_QUEUED queued;
+            queued.addr = addr;
+            queued.path = a_iter->path + fs_file->name->name + "/";
+            a_iter->queue.push_back(queued);
+        }
+        else {
+            size_t path_len = a_iter->path.size();
+            uint8_t save = a_iter->save_inum_named;
+
+            /* We do not want to save info about named unalloc files
+             * when we go into the Orphan directory (because then we have
+             * no orphans). */
+            a_iter->path += fs_file->name->name;
+            a_iter->path += '/';
+            if (addr == TSK_FS_ORPHANDIR_INUM(fs))
+                a_iter->save_inum_named = 0;
+
+            if (fs_dir_iter_push(a_iter, addr)) {
+                /* If the directory could not be loaded, then we
+                 * still continue */
+                if (tsk_verbose) {
+                    tsk_fprintf(stderr,
+                        "fs_dir_iter_finish: error reading directory: %"
+                        PRIuINUM "\n", addr);
+                    tsk_error_print(stderr);
+                }
+                tsk_error_reset();
+                a_iter->seen.erase(addr);
+                a_iter->path.resize(path_len);
+                a_iter->save_inum_named = save;
+            }
+            else {
+                a_iter->frames.back().save_bak = save;
+                pushed = true;
+            }
+        }
+    }
+
+    fs_file->name = NULL;
+    if (fs_file->meta) {
+        tsk_fs_meta_close(fs_file->meta);
+        fs_file->meta = NULL;
+    }
+
+    // the parent moves on once the sub-directory has been popped
+    if (pushed == false)
+        a_iter->frames.back().idx++;
+    a_iter->pending = false;
+    a_iter->skip = false;
+}
+
+/** \internal
+ * Allocate an iterator with no open directories.
+ */
+static TSK_FS_DIR_ITER *
+fs_dir_iter_alloc(TSK_FS_INFO * a_fs, TSK_INUM_T a_addr,
+    TSK_FS_DIR_WALK_FLAG_ENUM a_flags, TSK_FS_DIR_ITER_ORDER_ENUM a_order)
+{
+    TSK_FS_DIR_ITER *iter;
+
+    if ((a_order != TSK_FS_DIR_ITER_ORDER_DEPTH)
+        && (a_order != TSK_FS_DIR_ITER_ORDER_BREADTH)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr("tsk_fs_dir_iter_open: Invalid order: %d",
+            a_order);
+        return NULL;
+    }
+
+    iter = new TSK_FS_DIR_ITER;
+    iter->fs = a_fs;
+    iter->addr = a_addr;
+    iter->flags = a_flags;
+    iter->order = a_order;
+    iter->pending = false;
+    iter->skip = false;
+    iter->save_inum_named = 0;
+    iter->list_inum_named = NULL;
+    if ((iter->fs_file = tsk_fs_file_alloc(a_fs)) == NULL) {
+        delete iter;
+        return NULL;
+    }
+    iter->tag = TSK_FS_DIR_ITER_TAG;
+    return iter;
+}
+
+/** \ingroup fslib
+ * Open an iterator over the file names in a directory (and its
+ * sub-directories if TSK_FS_DIR_WALK_FLAG_RECURSE is given).  The
+ * iterator returns the same files as tsk_fs_dir_walk() but the caller
+ * pulls them with tsk_fs_dir_iter_next() instead of getting a callback.
+ *
+ * In breadth first order, the list of named unallocated files is not
+ * collected for the orphan search, so finding the orphan files may need
+ * an extra walk of the metadata.
+ *
+ * @param a_fs File system to analyze
+ * @param a_addr Metadata address of the directory to start at
+ * @param a_flags Flags that select the names to return and if sub-directories are walked
+ * @param a_order Order to return the files of sub-directories in
+ * @returns NULL on error
+ */
+TSK_FS_DIR_ITER *
+tsk_fs_dir_iter_open(TSK_FS_INFO * a_fs, TSK_INUM_T a_addr,
+    TSK_FS_DIR_WALK_FLAG_ENUM a_flags, TSK_FS_DIR_ITER_ORDER_ENUM a_order)
+{
+    TSK_FS_DIR_ITER *iter;
+
+    if ((a_fs == NULL) || (a_fs->tag != TSK_FS_INFO_TAG)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr
+            ("tsk_fs_dir_iter_open: called with NULL or unallocated structures");
+        return NULL;
+    }
+
+    /* Sanity check on flags -- make sure at least one ALLOC is set */
+    if (((a_flags & TSK_FS_DIR_WALK_FLAG_ALLOC) == 0) &&
+        ((a_flags & TSK_FS_DIR_WALK_FLAG_UNALLOC) == 0)) {
+        a_flags = (TSK_FS_DIR_WALK_FLAG_ENUM) (a_flags |
+            TSK_FS_DIR_WALK_FLAG_ALLOC | TSK_FS_DIR_WALK_FLAG_UNALLOC);
+    }
+
+    if ((iter = fs_dir_iter_alloc(a_fs, a_addr, a_flags, a_order)) == NULL)
+        return NULL;
+
+    if (fs_dir_iter_push(iter, a_addr)) {
+        tsk_fs_dir_iter_close(iter);
+        return NULL;
+    }
+
+    /* if the flags are right, we can collect info that may be needed
+     * for an orphan walk. */
+    if (a_order == TSK_FS_DIR_ITER_ORDER_DEPTH) {
+        tsk_take_lock(&a_fs->list_inum_named_lock);
+        if ((a_fs->list_inum_named == NULL) && (a_addr == a_fs->root_inum)
+            && (a_flags & TSK_FS_DIR_WALK_FLAG_RECURSE)) {
+            iter->save_inum_named = 1;
+        }
+        tsk_release_lock(&a_fs->list_inum_named_lock);
+    }
+    return iter;
+}
+
+/** \ingroup fslib
+ * Return the next file from a directory iterator.  The file and path
+ * are owned by the iterator and are valid until the next call to
+ * tsk_fs_dir_iter_next() or tsk_fs_dir_iter_close().  A directory is
+ * recursed into when the next file is asked for, so call
+ * tsk_fs_dir_iter_skip() before that to skip it.
+ *
+ * @param a_iter Iterator to use
+ * @param a_fs_file [out] Set to the next file or to NULL if there are no more files
+ * @param a_path [out] Set to the path of the directory that the file is in (can be NULL)
+ * @returns 1 on error and 0 on success
+ */
+uint8_t
+tsk_fs_dir_iter_next(TSK_FS_DIR_ITER * a_iter, TSK_FS_FILE ** a_fs_file,
+    const char **a_path)
+{
+    if (a_fs_file)
+        *a_fs_file = NULL;
+    if (a_path)
+        *a_path = NULL;
+    if ((a_iter == NULL) || (a_iter->tag != TSK_FS_DIR_ITER_TAG)
+        || (a_fs_file == NULL)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr
+            ("tsk_fs_dir_iter_next: called with NULL or unallocated structures");
+        return 1;
+    }
+
+    if (a_iter->pending)
+        fs_dir_iter_finish(a_iter);
+
+    while (true) {
+        if (a_iter->frames.empty()) {
+            if (a_iter->queue.empty()) {
+                // we finished the walk, so the list of named files is complete
+                if (a_iter->save_inum_named == 1)
+                    fs_dir_iter_save_named(a_iter);
+                return 0;
+            }
+
+            FS_DIR_ITER_QUEUED & queued = a_iter->queue.front();
+            a_iter->path = queued.path;
+            if (fs_dir_iter_push(a_iter, queued.addr)) {
+                if (tsk_verbose) {
+                    tsk_fprintf(stderr,
+                        "tsk_fs_dir_iter_next: error reading directory: %"
+                        PRIuINUM "\n", queued.addr);
+                    tsk_error_print(stderr);
+                }
+                tsk_error_reset();
+            }
+            a_iter->queue.pop_front();
+            continue;
+        }
+
+        FS_DIR_ITER_FRAME & frame = a_iter->frames.back();
+        if (frame.idx >= frame.fs_dir->names_used) {
+            fs_dir_iter_pop(a_iter);
+            continue;
+        }
+
+        fs_dir_iter_load(a_iter);
+
+        // return the name if we have the right flags
+        if ((a_iter->fs_file->name->flags & a_iter->flags) ==
+            a_iter->fs_file->name->flags) {
+            a_iter->pending = true;
+            *a_fs_file = a_iter->fs_file;
+            if (a_path)
+                *a_path = a_iter->path.c_str();
+            return 0;
+        }
+        fs_dir_iter_finish(a_iter);
+    }
+}
+
+/** \ingroup fslib
+ * Do not recurse into the directory that was last returned by
+ * tsk_fs_dir_iter_next().
+ *
+ * @param a_iter Iterator to use
+ */
+void
+tsk_fs_dir_iter_skip(TSK_FS_DIR_ITER * a_iter)
+{
+    if ((a_iter == NULL) || (a_iter->tag != TSK_FS_DIR_ITER_TAG))
+        return;
+    if (a_iter->pending)
+        a_iter->skip = true;
+}
+
+static void
+fs_dir_iter_put64(std::vector < uint8_t > &a_buf, uint64_t a_val)
+{
+    uint8_t tmp[8];
+    for (int i = 0; i < 8; i++)
+        tmp[i] = (uint8_t) (a_val >> (8 * i));
+    a_buf.insert(a_buf.end(), tmp, tmp + 8);
+}
+
+static void
+fs_dir_iter_put_str(std::vector < uint8_t > &a_buf,
+    const std::string & a_str)
+{
+    fs_dir_iter_put64(a_buf, a_str.size());
+    a_buf.insert(a_buf.end(), a_str.begin(), a_str.end());
+}
+
+/** \internal
+ * Reads the values of a checkpoint and keeps track of the offset.
+ */
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t off;
+    bool bad;                   ///< Set if a read went past the end
+} FS_DIR_ITER_READER;
+
+static uint64_t
+fs_dir_iter_get64(FS_DIR_ITER_READER * a_rd)
+{
+    uint64_t val = 0;
+
+    if ((a_rd->bad) || (a_rd->len - a_rd->off < 8)) {
+        a_rd->bad = true;
+        return 0;
+    }
+    for (int i = 0; i < 8; i++)
+        val |= (uint64_t) a_rd->buf[a_rd->off + i] << (8 * i);
+    a_rd->off += 8;
+    return val;
+}
+
+static std::string
+fs_dir_iter_get_str(FS_DIR_ITER_READER * a_rd)
+{
+    uint64_t len = fs_dir_iter_get64(a_rd);
+
+    if ((a_rd->bad) || (a_rd->len - a_rd->off < len)) {
+        a_rd->bad = true;
+        return std::string();
+    }
+    std::string str((const char *) &a_rd->buf[a_rd->off], (size_t) len);
+    a_rd->off += (size_t) len;
+    return str;
+}
+
+/** \ingroup fslib
+ * Save the position of an iterator so that the walk can be continued
+ * later (with the same image) by tsk_fs_dir_iter_resume().  The resumed
+ * iterator returns the files that this iterator has not yet returned.
+ * A resumed iterator does not collect the named files for the orphan
+ * search.
+ *
+ * @param a_iter Iterator to save
+ * @param a_buf [out] Set to a buffer with the checkpoint (must be freed with free())
+ * @param a_len [out] Set to the length of the checkpoint
+ * @returns 1 on error and 0 on success
+ */
+uint8_t
+tsk_fs_dir_iter_checkpoint(TSK_FS_DIR_ITER * a_iter, uint8_t ** a_buf,
+    size_t * a_len)
+{
+    std::vector < uint8_t > buf;
+
+    if ((a_iter == NULL) || (a_iter->tag != TSK_FS_DIR_ITER_TAG)
+        || (a_buf == NULL) || (a_len == NULL)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr
+            ("tsk_fs_dir_iter_checkpoint: called with NULL or unallocated structures");
+        return 1;
+    }
+
+    buf.insert(buf.end(), fs_dir_iter_magic, fs_dir_iter_magic + 8);
+    fs_dir_iter_put64(buf, a_iter->addr);
+    fs_dir_iter_put64(buf, a_iter->flags);
+    fs_dir_iter_put64(buf, a_iter->order);
+    fs_dir_iter_put64(buf, a_iter->pending);
+    fs_dir_iter_put64(buf, a_iter->skip);
+    fs_dir_iter_put_str(buf, a_iter->path);
+
+    fs_dir_iter_put64(buf, a_iter->frames.size());
+    for (size_t i = 0; i < a_iter->frames.size(); i++) {
+        fs_dir_iter_put64(buf, a_iter->frames[i].addr);
+        fs_dir_iter_put64(buf, a_iter->frames[i].idx);
+        fs_dir_iter_put64(buf, a_iter->frames[i].path_len);
+    }
+
+    fs_dir_iter_put64(buf, a_iter->queue.size());
+    for (size_t i = 0; i < a_iter->queue.size(); i++) {
+        fs_dir_iter_put64(buf, a_iter->queue[i].addr);
+        fs_dir_iter_put_str(buf, a_iter->queue[i].path);
+    }
+
+    fs_dir_iter_put64(buf, a_iter->seen.size());
+    for (std::unordered_set < TSK_INUM_T >::const_iterator it =
+        a_iter->seen.begin(); it != a_iter->seen.end(); ++it)
+        fs_dir_iter_put64(buf, *it);
+
+    if ((*a_buf = (uint8_t *) tsk_malloc(buf.size())) == NULL)
+        return 1;
+    memcpy(*a_buf, &buf[0], buf.size());
+    *a_len = buf.size();
+    return 0;
+}
+
+/** \ingroup fslib
+ * Open an iterator at a position that was saved by
+ * tsk_fs_dir_iter_checkpoint().  The file system must be opened from the
+ * same image as the one that the checkpoint was made with.
+ *
+ * @param a_fs File system to analyze
+ * @param a_buf Checkpoint
+ * @param a_len Length of the checkpoint
+ * @returns NULL on error
+ */
+TSK_FS_DIR_ITER *
+tsk_fs_dir_iter_resume(TSK_FS_INFO * a_fs, const uint8_t * a_buf,
+    size_t a_len)
+{
+    FS_DIR_ITER_READER rd;
+    TSK_FS_DIR_ITER *iter;
+    TSK_INUM_T addr;
+    TSK_FS_DIR_WALK_FLAG_ENUM flags;
+    TSK_FS_DIR_ITER_ORDER_ENUM order;
+    bool pending, skip;
+    uint64_t cnt;
+
+    if ((a_fs == NULL) || (a_fs->tag != TSK_FS_INFO_TAG)
+        || (a_buf == NULL)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr
+            ("tsk_fs_dir_iter_resume: called with NULL or unallocated structures");
+        return NULL;
+    }
+    if ((a_len < 8) || (memcmp(a_buf, fs_dir_iter_magic, 8) != 0)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr("tsk_fs_dir_iter_resume: Invalid checkpoint");
+        return NULL;
+    }
+
+    rd.buf = a_buf;
+    rd.len = a_len;
+    rd.off = 8;
+    rd.bad = false;
+    addr = fs_dir_iter_get64(&rd);
+    flags = (TSK_FS_DIR_WALK_FLAG_ENUM) fs_dir_iter_get64(&rd);
+    order = (TSK_FS_DIR_ITER_ORDER_ENUM) fs_dir_iter_get64(&rd);
+    pending = fs_dir_iter_get64(&rd) ? true : false;
+    skip = fs_dir_iter_get64(&rd) ? true : false;
+    if ((iter = fs_dir_iter_alloc(a_fs, addr, flags, order)) == NULL)
+        return NULL;
+    iter->path = fs_dir_iter_get_str(&rd);
+
+    // reopen the directories that were open
+    cnt = fs_dir_iter_get64(&rd);
+    for (uint64_t i = 0; (i < cnt) && (rd.bad == false); i++) {
+        TSK_INUM_T dir_addr = fs_dir_iter_get64(&rd);
+        uint64_t idx = fs_dir_iter_get64(&rd);
+        uint64_t path_len = fs_dir_iter_get64(&rd);
+
+        if ((rd.bad) || (path_len > iter->path.size())) {
+            rd.bad = true;
+            break;
+        }
+        if (fs_dir_iter_push(iter, dir_addr)) {
+            tsk_fs_dir_iter_close(iter);
+            return NULL;
+        }
+        iter->frames.back().path_len = (size_t) path_len;
+        iter->frames.back().idx = (size_t) idx;
+        if ((idx > iter->frames.back().fs_dir->names_used)
+            || ((i + 1 < cnt) && (idx >= iter->frames.back().fs_dir->names_used))) {
+            rd.bad = true;
+            break;
+        }
+    }
+
+    cnt = fs_dir_iter_get64(&rd);
+    for (uint64_t i = 0; (i < cnt) && (rd.bad == false); i++) {
+        FS_DIR_ITER_QUEUED queued;
+        queued.addr = fs_dir_iter_get64(&rd);
+        queued.path = fs_dir_iter_get_str(&rd);
+        iter->queue.push_back(queued);
+    }
+
+    cnt = fs_dir_iter_get64(&rd);
+    for (uint64_t i = 0; (i < cnt) && (rd.bad == false); i++)
+        iter->seen.insert(fs_dir_iter_get64(&rd));
+
+    if ((rd.bad) || (pending && ((iter->frames.empty())
+                || (iter->frames.back().idx >=
+                    iter->frames.back().fs_dir->names_used)))) {
+        tsk_fs_dir_iter_close(iter);
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_ARG);
+        tsk_error_set_errstr
+            ("tsk_fs_dir_iter_resume: Invalid checkpoint or it does not match the file system");
+        return NULL;
+    }
+
+    // reload the name that was returned last, so that it can be finished
+    if (pending) {
+        fs_dir_iter_load(iter);
+        iter->pending = true;
+        iter->skip = skip;
+    }
+    return iter;
+}
+
+/** \ingroup fslib
+ * Close a directory iterator.
+ *
+ * @param a_iter Iterator to close
+ */
+void
+tsk_fs_dir_iter_close(TSK_FS_DIR_ITER * a_iter)
+{
+    if ((a_iter == NULL) || (a_iter->tag != TSK_FS_DIR_ITER_TAG))
+        return;
+    a_iter->tag = 0;
+
+    for (size_t i = 0; i < a_iter->frames.size(); i++)
+        tsk_fs_dir_close(a_iter->frames[i].fs_dir);
+
+    a_iter->fs_file->name = NULL;
+    tsk_fs_file_close(a_iter->fs_file);
+
+    // the walk did not finish, so the list is not complete
+    tsk_list_free(a_iter->list_inum_named);
+    delete a_iter;
+}
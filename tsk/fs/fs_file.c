@@ -28,8 +28,11 @@ tsk_fs_file_alloc(TSK_FS_INFO * a_fs)
 {
     TSK_FS_FILE *fs_file;
 
-    fs_file = (TSK_FS_FILE *) tsk_malloc(sizeof(TSK_FS_FILE));
-    if (fs_file == NULL)
+    if ((fs_file =
+            (TSK_FS_FILE *) tsk_fs_pool_get(TSK_FS_POOL_FILE)) != NULL)
+        memset(fs_file, 0, sizeof(TSK_FS_FILE));
+    else if ((fs_file =
+            (TSK_FS_FILE *) tsk_malloc(sizeof(TSK_FS_FILE))) == NULL)
         return NULL;
     fs_file->fs_info = a_fs;
     fs_file->tag = TSK_FS_FILE_TAG;
@@ -73,7 +76,7 @@ tsk_fs_file_close(TSK_FS_FILE * a_fs_file)
         a_fs_file->name = NULL;
     }
 
-    free(a_fs_file);
+    tsk_fs_pool_put(TSK_FS_POOL_FILE, a_fs_file);
 }
 
 
@@ -37,18 +37,35 @@ TSK_FS_META *
 tsk_fs_meta_alloc(size_t a_buf_len)
 {
     TSK_FS_META *fs_meta;
+    void *content_ptr = NULL;
 
+    /* Reuse a freed structure if there is one.  Its content buffer
+     * is kept if it is the right size. */
     if ((fs_meta =
+            (TSK_FS_META *) tsk_fs_pool_get(TSK_FS_POOL_META)) != NULL) {
+        if (fs_meta->content_len == a_buf_len) {
+            content_ptr = fs_meta->content_ptr;
+            if (content_ptr)
+                memset(content_ptr, 0, a_buf_len);
+        }
+        else {
+            free(fs_meta->content_ptr);
+        }
+        memset(fs_meta, 0, sizeof(TSK_FS_META));
+    }
+    else if ((fs_meta =
             (TSK_FS_META *) tsk_malloc(sizeof(TSK_FS_META))) == NULL)
         return NULL;
 
     fs_meta->attr_state = TSK_FS_META_ATTR_EMPTY;
 
     if (a_buf_len > 0) {
-        if ((fs_meta->content_ptr = tsk_malloc(a_buf_len)) == NULL) {
+        if ((content_ptr == NULL)
+            && ((content_ptr = tsk_malloc(a_buf_len)) == NULL)) {
             free(fs_meta);
             return NULL;
         }
+        fs_meta->content_ptr = content_ptr;
         fs_meta->content_len = a_buf_len;
     }
 
@@ -100,10 +117,6 @@ tsk_fs_meta_close(TSK_FS_META * fs_meta)
     // clear the tag so we know the structure isn't alloc
     fs_meta->tag = 0;
 
-    free(fs_meta->content_ptr);
-    fs_meta->content_ptr = NULL;
-    fs_meta->content_len = 0;
-
     if (fs_meta->attr)
         tsk_fs_attrlist_free(fs_meta->attr);
     fs_meta->attr = NULL;
@@ -118,8 +131,10 @@ tsk_fs_meta_close(TSK_FS_META * fs_meta)
         free(fs_name);
         fs_name = fs_name2;
     }
+    fs_meta->name2 = NULL;
 
-    free(fs_meta);
+    // the content buffer stays with the structure in the pool
+    tsk_fs_pool_put(TSK_FS_POOL_META, fs_meta);
 }
 
 /** \internal
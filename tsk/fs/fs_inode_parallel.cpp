@@ -0,0 +1,349 @@
+/*
+** The Sleuth Kit
+**
+** Brian Carrier [carrier <at> sleuthkit [dot] org]
+** Copyright (c) 2011-2013 Brian Carrier.  All Rights reserved
+**
+** This software is distributed under the Common Public License 1.0
+*/
+
+/**
+ * \file fs_inode_parallel.cpp
+ * Contains the code to walk the metadata structures of a file system on
+ * several threads.
+ */
+
+#include "tsk_fs_i.h"
+#include "tsk_ext2fs.h"
+#include "tsk_ffs.h"
+
+#include <vector>
+
+#ifdef TSK_MULTITHREAD_LIB
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#endif
+
+/** \internal
+ * Minimum number of metadata addresses in a partition of the walk.  Small
+ * groups are combined until the partition is at least this big.
+ */
+#define TSK_FS_META_WALK_PARALLEL_MIN 16384
+
+/** \internal
+ * Number of metadata addresses in a partition of an NTFS walk.
+ */
+#define TSK_FS_META_WALK_PARALLEL_NTFS 16384
+
+#ifdef TSK_MULTITHREAD_LIB
+
+/** \internal
+ * A range of metadata addresses that is walked by one thread.
+ */
+typedef struct {
+    TSK_INUM_T start;
+    TSK_INUM_T end;
+    std::vector < TSK_FS_FILE * >files; ///< Files waiting for the ordered callback
+    bool done;
+} META_WALK_PART;
+
+/** \internal
+ * State that is shared by the threads of a parallel walk.
+ */
+typedef struct {
+    TSK_FS_INFO *fs;
+    TSK_FS_META_FLAG_ENUM flags;
+    TSK_FS_META_WALK_CB action;
+    void *ptr;
+    bool ordered;
+
+    std::vector < META_WALK_PART > parts;
+    size_t window;              ///< Max number of parts past next_deliver that can be walked
+
+    std::atomic < bool > stop;  ///< Set to stop all of the walks
+    std::atomic < size_t > fail_part;   ///< First part whose walk failed (parts.size() if none)
+
+    std::mutex lock;            ///< Protects the fields below
+    std::condition_variable cond;
+    size_t next_part;           ///< Next part to give to a thread
+    size_t next_deliver;        ///< Next part to pass to the ordered callback
+    TSK_ERROR_INFO error;       ///< Error from the walk of fail_part
+} META_WALK_PARALLEL;
+
+/** \internal
+ * Per thread data that is passed to the file system's inode walk.
+ */
+typedef struct {
+    META_WALK_PARALLEL *walk;
+    size_t idx;                 ///< Index of the part being walked
+} META_WALK_THREAD;
+
+/** \internal
+ * Callback for the inode walk of one part.  In ordered mode the metadata
+ * is moved to a new file that is kept until the callback can be called in
+ * order, and the walk gets a new metadata structure to fill in.
+ */
+static TSK_WALK_RET_ENUM
+meta_walk_parallel_cb(TSK_FS_FILE * a_fs_file, void *a_ptr)
+{
+    META_WALK_THREAD *thread = (META_WALK_THREAD *) a_ptr;
+    META_WALK_PARALLEL *walk = thread->walk;
+    TSK_FS_FILE *fs_file;
+    TSK_FS_META *fs_meta;
+
+    // the parts after a failed part are not needed
+    if ((walk->stop) || (thread->idx > walk->fail_part))
+        return TSK_WALK_STOP;
+
+    if (walk->ordered == false) {
+        TSK_WALK_RET_ENUM retval = walk->action(a_fs_file, walk->ptr);
+        if (retval != TSK_WALK_CONT)
+            walk->stop = true;
+        return retval;
+    }
+
+    if ((fs_file = tsk_fs_file_alloc(walk->fs)) == NULL)
+        return TSK_WALK_ERROR;
+    if ((fs_meta = tsk_fs_meta_alloc(a_fs_file->meta->content_len)) == NULL) {
+        tsk_fs_file_close(fs_file);
+        return TSK_WALK_ERROR;
+    }
+    fs_file->meta = a_fs_file->meta;
+    a_fs_file->meta = fs_meta;
+    walk->parts[thread->idx].files.push_back(fs_file);
+    return TSK_WALK_CONT;
+}
+
+/** \internal
+ * Main loop of the worker threads.  Takes the next part, walks it and
+ * marks it as done until all parts have been walked or the walk stops.
+ */
+static void
+meta_walk_parallel_worker(META_WALK_PARALLEL * a_walk)
+{
+    META_WALK_THREAD thread;
+    thread.walk = a_walk;
+
+    while (true) {
+        {
+            std::unique_lock < std::mutex > lock(a_walk->lock);
+            while ((a_walk->stop == false)
+                && (a_walk->next_part < a_walk->parts.size())
+                && (a_walk->ordered)
+                && (a_walk->next_part >=
+                    a_walk->next_deliver + a_walk->window))
+                a_walk->cond.wait(lock);
+
+            if ((a_walk->stop)
+                || (a_walk->next_part >= a_walk->parts.size())
+                || (a_walk->next_part > a_walk->fail_part))
+                return;
+            thread.idx = a_walk->next_part++;
+        }
+
+        META_WALK_PART & part = a_walk->parts[thread.idx];
+        uint8_t retval = a_walk->fs->inode_walk(a_walk->fs, part.start,
+            part.end, a_walk->flags, meta_walk_parallel_cb, &thread);
+
+        std::unique_lock < std::mutex > lock(a_walk->lock);
+        if ((retval) && (thread.idx < a_walk->fail_part)) {
+            // the error is stored per thread, so save it for the caller
+            a_walk->error = *tsk_error_get_info();
+            a_walk->fail_part = thread.idx;
+            if (a_walk->ordered == false)
+                a_walk->stop = true;
+        }
+        part.done = true;
+        a_walk->cond.notify_all();
+    }
+}
+
+/** \internal
+ * Split the walk range into parts that follow the groups of the file
+ * system.
+ * @returns Number of addresses in a part (0 if the file system does not
+ * support parallel walks)
+ */
+static TSK_INUM_T
+meta_walk_parallel_part_size(TSK_FS_INFO * a_fs, TSK_INUM_T * a_base)
+{
+    TSK_INUM_T group;
+
+    *a_base = 0;
+    if (TSK_FS_TYPE_ISEXT(a_fs->ftype)) {
+        EXT2FS_INFO *ext2fs = (EXT2FS_INFO *) a_fs;
+        group = tsk_getu32(a_fs->endian, ext2fs->fs->s_inodes_per_group);
+        *a_base = 1;
+    }
+    else if (TSK_FS_TYPE_ISFFS(a_fs->ftype)) {
+        FFS_INFO *ffs = (FFS_INFO *) a_fs;
+        group = tsk_gets32(a_fs->endian, ffs->fs.sb1->cg_inode_num);
+    }
+    else if (TSK_FS_TYPE_ISNTFS(a_fs->ftype)) {
+        return TSK_FS_META_WALK_PARALLEL_NTFS;
+    }
+    else {
+        return 0;
+    }
+
+    if (group == 0)
+        return 0;
+    if (group < TSK_FS_META_WALK_PARALLEL_MIN)
+        group *= (TSK_FS_META_WALK_PARALLEL_MIN + group - 1) / group;
+    return group;
+}
+
+#endif
+
+/**
+ * \ingroup fslib
+ * Walk a range of metadata structures on several threads and call a
+ * callback for each structure that matches the flags supplied.  The range
+ * is split at the block groups (ExtX), cylinder groups (UFS) or ranges of
+ * MFT entries (NTFS) and each part is walked with the file system's inode
+ * walk, so each thread has its own TSK_FS_FILE and buffers.  Other file
+ * systems, and builds without multithreading support, are walked with
+ * tsk_fs_meta_walk().
+ *
+ * With TSK_FS_META_WALK_PARALLEL_ORDERED, the callback is called on the
+ * calling thread in the same order as tsk_fs_meta_walk() would call it.
+ * Otherwise, it is called concurrently from the worker threads, in no
+ * particular order, and must be thread safe.  Threads that are already in
+ * the callback when another call returns TSK_WALK_STOP finish their call.
+ *
+ * @param a_fs File system to process
+ * @param a_start Metadata address to start walking from
+ * @param a_end Metadata address to walk to
+ * @param a_flags Flags that specify the desired metadata features
+ * @param a_threads Number of threads to use (0 for the number of CPUs)
+ * @param a_pflags Flags that specify how the callback is called
+ * @param a_cb Callback function to call
+ * @param a_ptr Pointer to pass to the callback
+ * @returns 1 on error and 0 on success
+ */
+uint8_t
+tsk_fs_meta_walk_parallel(TSK_FS_INFO * a_fs, TSK_INUM_T a_start,
+    TSK_INUM_T a_end, TSK_FS_META_FLAG_ENUM a_flags,
+    unsigned int a_threads, TSK_FS_META_WALK_PARALLEL_ENUM a_pflags,
+    TSK_FS_META_WALK_CB a_cb, void *a_ptr)
+{
+    if ((a_fs == NULL) || (a_fs->tag != TSK_FS_INFO_TAG))
+        return 1;
+
+#ifdef TSK_MULTITHREAD_LIB
+    TSK_INUM_T base;
+    TSK_INUM_T part_size;
+
+    if (a_threads == 0)
+        a_threads = std::thread::hardware_concurrency();
+
+    part_size = meta_walk_parallel_part_size(a_fs, &base);
+    if ((a_threads <= 1) || (part_size == 0) || (a_start < base)
+        || (a_end < a_start) || (a_end > a_fs->last_inum)
+        || (a_end - a_start < part_size))
+        return tsk_fs_meta_walk(a_fs, a_start, a_end, a_flags, a_cb,
+            a_ptr);
+
+    /* Load the list of named inodes before the threads start so that
+     * the walks do not all try to load it. */
+    if (a_flags & TSK_FS_META_FLAG_ORPHAN) {
+        if (tsk_fs_dir_load_inum_named(a_fs) != TSK_OK) {
+            tsk_error_errstr2_concat
+                ("- tsk_fs_meta_walk_parallel: identifying inodes allocated by file names");
+            return 1;
+        }
+    }
+
+    META_WALK_PARALLEL walk;
+    walk.fs = a_fs;
+    walk.flags = a_flags;
+    walk.action = a_cb;
+    walk.ptr = a_ptr;
+    walk.ordered = (a_pflags & TSK_FS_META_WALK_PARALLEL_ORDERED) ? true : false;
+    walk.window = 2 * a_threads;
+    walk.next_part = 0;
+    walk.next_deliver = 0;
+    walk.stop = false;
+
+    for (TSK_INUM_T start = a_start; start <= a_end;) {
+        META_WALK_PART part;
+        TSK_INUM_T end =
+            base + ((start - base) / part_size + 1) * part_size - 1;
+        if (end > a_end)
+            end = a_end;
+        part.start = start;
+        part.end = end;
+        part.done = false;
+        walk.parts.push_back(part);
+        start = end + 1;
+    }
+    walk.fail_part = walk.parts.size();
+    if (a_threads > walk.parts.size())
+        a_threads = (unsigned int) walk.parts.size();
+
+    std::vector < std::thread > threads;
+    for (unsigned int i = 0; i < a_threads; i++)
+        threads.push_back(std::thread(meta_walk_parallel_worker, &walk));
+
+    uint8_t retval = 0;
+    if (walk.ordered) {
+        for (size_t i = 0; i < walk.parts.size(); i++) {
+            META_WALK_PART & part = walk.parts[i];
+            {
+                std::unique_lock < std::mutex > lock(walk.lock);
+                while (part.done == false)
+                    walk.cond.wait(lock);
+            }
+
+            // the files before an error are passed on, like tsk_fs_meta_walk
+            for (size_t j = 0; j < part.files.size(); j++) {
+                TSK_WALK_RET_ENUM cb_ret = a_cb(part.files[j], a_ptr);
+                if (cb_ret != TSK_WALK_CONT) {
+                    if (cb_ret == TSK_WALK_ERROR)
+                        retval = 1;
+                    walk.stop = true;
+                    break;
+                }
+            }
+            if (walk.stop)
+                break;
+            if (i == walk.fail_part) {
+                *tsk_error_get_info() = walk.error;
+                retval = 1;
+                break;
+            }
+
+            for (size_t j = 0; j < part.files.size(); j++)
+                tsk_fs_file_close(part.files[j]);
+            part.files.clear();
+
+            std::unique_lock < std::mutex > lock(walk.lock);
+            walk.next_deliver++;
+            walk.cond.notify_all();
+        }
+
+        std::unique_lock < std::mutex > lock(walk.lock);
+        walk.stop = true;
+        walk.cond.notify_all();
+    }
+
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    // free the files of the parts that were not passed to the callback
+    for (size_t i = 0; i < walk.parts.size(); i++) {
+        for (size_t j = 0; j < walk.parts[i].files.size(); j++)
+            tsk_fs_file_close(walk.parts[i].files[j]);
+    }
+
+    if ((walk.ordered == false) && (walk.fail_part < walk.parts.size())) {
+        *tsk_error_get_info() = walk.error;
+        retval = 1;
+    }
+    return retval;
+#else
+    return tsk_fs_meta_walk(a_fs, a_start, a_end, a_flags, a_cb, a_ptr);
+#endif
+}
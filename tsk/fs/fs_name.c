@@ -43,15 +43,43 @@ TSK_FS_NAME *
 tsk_fs_name_alloc(size_t norm_namelen, size_t shrt_namelen)
 {
     TSK_FS_NAME *fs_name;
-    fs_name = (TSK_FS_NAME *) tsk_malloc(sizeof(*fs_name));
-    if (fs_name == NULL)
+    char *name = NULL;
+    char *shrt_name = NULL;
+
+    /* Reuse a freed structure if there is one.  Its name buffers
+     * are kept if they are big enough.  Like the buffers that are made
+     * here, they have *_size bytes plus one for the NULL. */
+    if ((fs_name =
+            (TSK_FS_NAME *) tsk_fs_pool_get(TSK_FS_POOL_NAME)) != NULL) {
+        if ((fs_name->name) && (fs_name->name_size >= norm_namelen)) {
+            name = fs_name->name;
+            norm_namelen = fs_name->name_size;
+            name[0] = '\0';
+        }
+        else {
+            free(fs_name->name);
+        }
+        if ((shrt_namelen) && (fs_name->shrt_name)
+            && (fs_name->shrt_name_size >= shrt_namelen)) {
+            shrt_name = fs_name->shrt_name;
+            shrt_namelen = fs_name->shrt_name_size;
+            shrt_name[0] = '\0';
+        }
+        else {
+            free(fs_name->shrt_name);
+        }
+        memset(fs_name, 0, sizeof(TSK_FS_NAME));
+    }
+    else if ((fs_name =
+            (TSK_FS_NAME *) tsk_malloc(sizeof(*fs_name))) == NULL)
         return NULL;
 
-    fs_name->name = (char *) tsk_malloc(norm_namelen + 1);
-    if (fs_name->name == NULL) {
+    if ((name == NULL)
+        && ((name = (char *) tsk_malloc(norm_namelen + 1)) == NULL)) {
         free(fs_name);
         return NULL;
     }
+    fs_name->name = name;
     fs_name->name_size = norm_namelen;
 
     fs_name->flags = 0;
@@ -61,12 +89,14 @@ tsk_fs_name_alloc(size_t norm_namelen, size_t shrt_namelen)
         fs_name->shrt_name = NULL;
     }
     else {
-        fs_name->shrt_name = (char *) tsk_malloc(shrt_namelen + 1);
-        if (fs_name->shrt_name == NULL) {
+        if ((shrt_name == NULL)
+            && ((shrt_name =
+                    (char *) tsk_malloc(shrt_namelen + 1)) == NULL)) {
             free(fs_name->name);
             free(fs_name);
             return NULL;
         }
+        fs_name->shrt_name = shrt_name;
     }
 
     fs_name->type = TSK_FS_NAME_TYPE_UNDEF;
@@ -131,13 +161,11 @@ tsk_fs_name_free(TSK_FS_NAME * fs_name)
     if ((!fs_name) || (fs_name->tag != TSK_FS_NAME_TAG))
         return;
 
-    free(fs_name->name);
-    fs_name->name = NULL;
-
-    free(fs_name->shrt_name);
-    fs_name->shrt_name = NULL;
+    // clear the tag so we know the structure isn't alloc
+    fs_name->tag = 0;
 
-    free(fs_name);
+    // the name buffers stay with the structure in the pool
+    tsk_fs_pool_put(TSK_FS_POOL_NAME, fs_name);
 }
 
 /** \internal
@@ -161,7 +189,7 @@ tsk_fs_name_copy(TSK_FS_NAME * a_fs_name_to,
             a_fs_name_to->name_size = strlen(a_fs_name_from->name) + 16;
             a_fs_name_to->name =
                 (char *) tsk_realloc(a_fs_name_to->name,
-                a_fs_name_to->name_size);
+                a_fs_name_to->name_size + 1);
             if (a_fs_name_to->name == NULL)
                 return 1;
         }
@@ -183,7 +211,7 @@ tsk_fs_name_copy(TSK_FS_NAME * a_fs_name_to,
                 strlen(a_fs_name_from->shrt_name) + 16;
             a_fs_name_to->shrt_name =
                 (char *) tsk_realloc(a_fs_name_to->shrt_name,
-                a_fs_name_to->shrt_name_size);
+                a_fs_name_to->shrt_name_size + 1);
             if (a_fs_name_to->shrt_name == NULL)
                 return 1;
         }
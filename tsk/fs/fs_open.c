@@ -68,19 +68,10 @@ tsk_fs_open_vol(const TSK_VS_PART_INFO * a_part_info,
     return tsk_fs_open_img(a_part_info->vs->img_info, offset, a_ftype);
 }
 
-/**
- * \ingroup fslib
- * Tries to process data in a disk image at a given offset as a file system.
- * Returns a structure that can be used for analysis and reporting.
- *
- * @param a_img_info Disk image to analyze
- * @param a_offset Byte offset to start analyzing from
- * @param a_ftype Type of file system (or autodetect)
- *
- * @return NULL on error
- */
-TSK_FS_INFO *
-tsk_fs_open_img(TSK_IMG_INFO * a_img_info, TSK_OFF_T a_offset,
+/* fs_open_img_type - call the open routine of the file system type (or
+ * of each type when autodetecting) */
+static TSK_FS_INFO *
+fs_open_img_type(TSK_IMG_INFO * a_img_info, TSK_OFF_T a_offset,
     TSK_FS_TYPE_ENUM a_ftype)
 {
     TSK_FS_INFO *fs_info;
@@ -189,6 +180,32 @@ tsk_fs_open_img(TSK_IMG_INFO * a_img_info, TSK_OFF_T a_offset,
     return NULL;
 }
 
+/**
+ * \ingroup fslib
+ * Tries to process data in a disk image at a given offset as a file system.
+ * Returns a structure that can be used for analysis and reporting.
+ * The sidecar cache is loaded if one was set with tsk_fs_cache_set_dir().
+ *
+ * @param a_img_info Disk image to analyze
+ * @param a_offset Byte offset to start analyzing from
+ * @param a_ftype Type of file system (or autodetect)
+ *
+ * @return NULL on error
+ */
+TSK_FS_INFO *
+tsk_fs_open_img(TSK_IMG_INFO * a_img_info, TSK_OFF_T a_offset,
+    TSK_FS_TYPE_ENUM a_ftype)
+{
+    TSK_FS_INFO *fs_info;
+
+    if ((fs_info =
+            fs_open_img_type(a_img_info, a_offset, a_ftype)) == NULL)
+        return NULL;
+
+    tsk_fs_cache_open(fs_info);
+    return fs_info;
+}
+
 /**
  * \ingroup fslib
  * Close an open file system.
@@ -200,6 +217,10 @@ tsk_fs_close(TSK_FS_INFO * a_fs)
     if ((a_fs == NULL) || (a_fs->tag != TSK_FS_INFO_TAG))
         return;
 
+    // save the orphan data if it is new, while the file system specific
+    // data (such as the NTFS orphan map) is still there
+    tsk_fs_cache_save(a_fs);
+
     // each file system is supposed to call tsk_fs_free() 
 
     a_fs->close(a_fs);
@@ -216,6 +237,7 @@ tsk_fs_malloc(size_t a_len)
         return NULL;
     tsk_init_lock(&fs_info->list_inum_named_lock);
     tsk_init_lock(&fs_info->orphan_dir_lock);
+    tsk_init_lock(&fs_info->attr_run_idx_lock);
 
     fs_info->list_inum_named = NULL;
 
@@ -245,6 +267,7 @@ tsk_fs_free(TSK_FS_INFO * a_fs_info)
 
     tsk_deinit_lock(&a_fs_info->list_inum_named_lock);
     tsk_deinit_lock(&a_fs_info->orphan_dir_lock);
+    tsk_deinit_lock(&a_fs_info->attr_run_idx_lock);
 
     free(a_fs_info);
 }
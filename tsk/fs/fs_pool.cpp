@@ -0,0 +1,200 @@
+/*
+** The Sleuth Kit
+**
+** Brian Carrier [carrier <at> sleuthkit [dot] org]
+** Copyright (c) 2011-2013 Brian Carrier.  All Rights reserved
+**
+** This software is distributed under the Common Public License 1.0
+*/
+
+/**
+ * \file fs_pool.cpp
+ * Contains the per-thread pools that keep freed TSK_FS_FILE, TSK_FS_META,
+ * TSK_FS_NAME and attribute structures so that they can be reused by the
+ * next allocation instead of going back to malloc.  A directory walk
+ * allocates and frees several of these for every entry.
+ */
+
+#include "tsk_fs_i.h"
+
+#include <stddef.h>
+
+/** \internal
+ * Maximum number of structures that are kept in each pool (per thread).
+ * Anything freed once a pool is full goes back to the heap.
+ */
+static const size_t fs_pool_max[TSK_FS_POOL_MAX] = {
+    64,                         // TSK_FS_POOL_FILE
+    64,                         // TSK_FS_POOL_META
+    64,                         // TSK_FS_POOL_NAME
+    64,                         // TSK_FS_POOL_ATTRLIST
+    256,                        // TSK_FS_POOL_ATTR
+    4096                        // TSK_FS_POOL_RUN
+};
+
+/** \internal
+ * Buffers larger than this are freed instead of being kept with a pooled
+ * structure, so that one large name or attribute does not stay around.
+ */
+#define FS_POOL_BUF_MAX 4096
+
+/* The free lists are linked through the first pointer-sized bytes of each
+ * structure.  Make sure that none of the buffers that are kept with a
+ * pooled structure live there. */
+static_assert(offsetof(TSK_FS_META, content_ptr) >= sizeof(void *),
+    "TSK_FS_META link overlaps content_ptr");
+static_assert(offsetof(TSK_FS_NAME, name) >= sizeof(void *),
+    "TSK_FS_NAME link overlaps name");
+static_assert(offsetof(TSK_FS_ATTR, name) >= sizeof(void *),
+    "TSK_FS_ATTR link overlaps name");
+
+typedef struct {
+    void *head;                 ///< First free structure (or NULL)
+    size_t count;               ///< Number of structures in the list
+} FS_POOL_LIST;
+
+typedef struct {
+    FS_POOL_LIST lists[TSK_FS_POOL_MAX];
+    uint8_t closed;             ///< Set once the thread's pools have been freed
+} FS_POOL;
+
+#ifdef TSK_MULTITHREAD_LIB
+#define FS_POOL_LOCAL thread_local
+#else
+#define FS_POOL_LOCAL
+#endif
+
+/* Kept as plain data so that it stays valid until the thread (or process)
+ * is gone, even after the cleanup object below has run. */
+static FS_POOL_LOCAL FS_POOL fs_pool;
+
+static void *
+fs_pool_next(void *a_ptr)
+{
+    void *next;
+    memcpy(&next, a_ptr, sizeof(next));
+    return next;
+}
+
+/** \internal
+ * Free a structure and the buffers that were kept with it.
+ */
+static void
+fs_pool_destroy(TSK_FS_POOL_ENUM a_type, void *a_ptr)
+{
+    if (a_type == TSK_FS_POOL_META) {
+        free(((TSK_FS_META *) a_ptr)->content_ptr);
+    }
+    else if (a_type == TSK_FS_POOL_NAME) {
+        free(((TSK_FS_NAME *) a_ptr)->name);
+        free(((TSK_FS_NAME *) a_ptr)->shrt_name);
+    }
+    else if (a_type == TSK_FS_POOL_ATTR) {
+        free(((TSK_FS_ATTR *) a_ptr)->name);
+        free(((TSK_FS_ATTR *) a_ptr)->rd.buf);
+    }
+    free(a_ptr);
+}
+
+/** \internal
+ * Frees the pools of a thread when it exits.
+ */
+class FsPoolCleanup {
+  public:
+    ~FsPoolCleanup() {
+        for (int i = 0; i < TSK_FS_POOL_MAX; i++) {
+            FS_POOL_LIST *list = &fs_pool.lists[i];
+            while (list->head) {
+                void *ptr = list->head;
+                list->head = fs_pool_next(ptr);
+                fs_pool_destroy((TSK_FS_POOL_ENUM) i, ptr);
+            }
+            list->count = 0;
+        }
+        fs_pool.closed = 1;
+    }
+};
+
+/**
+ * \internal
+ * Take a structure from the pool of the calling thread.  The structure
+ * still has the values it had when it was freed (other than its first
+ * pointer-sized bytes) and must be initialized by the caller.
+ *
+ * @param a_type Type of structure to get
+ * @returns NULL if the pool is empty
+ */
+void *
+tsk_fs_pool_get(TSK_FS_POOL_ENUM a_type)
+{
+    FS_POOL_LIST *list = &fs_pool.lists[a_type];
+    void *ptr = list->head;
+
+    if (ptr == NULL)
+        return NULL;
+    list->head = fs_pool_next(ptr);
+    list->count--;
+    return ptr;
+}
+
+/**
+ * \internal
+ * Give a structure that is no longer used to the pool of the calling
+ * thread.  The structure is freed if the pool is full.  Buffers that
+ * the type keeps (see TSK_FS_POOL_ENUM) must be valid or NULL.
+ *
+ * @param a_type Type of structure
+ * @param a_ptr Structure to recycle
+ */
+void
+tsk_fs_pool_put(TSK_FS_POOL_ENUM a_type, void *a_ptr)
+{
+    static FS_POOL_LOCAL FsPoolCleanup cleanup;
+    FS_POOL_LIST *list = &fs_pool.lists[a_type];
+
+    (void) cleanup;
+    if ((fs_pool.closed) || (list->count >= fs_pool_max[a_type])) {
+        fs_pool_destroy(a_type, a_ptr);
+        return;
+    }
+
+    // do not hold on to large buffers
+    if (a_type == TSK_FS_POOL_META) {
+        TSK_FS_META *fs_meta = (TSK_FS_META *) a_ptr;
+        if (fs_meta->content_len > FS_POOL_BUF_MAX) {
+            free(fs_meta->content_ptr);
+            fs_meta->content_ptr = NULL;
+            fs_meta->content_len = 0;
+        }
+    }
+    else if (a_type == TSK_FS_POOL_NAME) {
+        TSK_FS_NAME *fs_name = (TSK_FS_NAME *) a_ptr;
+        if (fs_name->name_size > FS_POOL_BUF_MAX) {
+            free(fs_name->name);
+            fs_name->name = NULL;
+            fs_name->name_size = 0;
+        }
+        if (fs_name->shrt_name_size > FS_POOL_BUF_MAX) {
+            free(fs_name->shrt_name);
+            fs_name->shrt_name = NULL;
+            fs_name->shrt_name_size = 0;
+        }
+    }
+    else if (a_type == TSK_FS_POOL_ATTR) {
+        TSK_FS_ATTR *fs_attr = (TSK_FS_ATTR *) a_ptr;
+        if (fs_attr->name_size > FS_POOL_BUF_MAX) {
+            free(fs_attr->name);
+            fs_attr->name = NULL;
+            fs_attr->name_size = 0;
+        }
+        if (fs_attr->rd.buf_size > FS_POOL_BUF_MAX) {
+            free(fs_attr->rd.buf);
+            fs_attr->rd.buf = NULL;
+            fs_attr->rd.buf_size = 0;
+        }
+    }
+
+    memcpy(a_ptr, &list->head, sizeof(list->head));
+    list->head = a_ptr;
+    list->count++;
+}
@@ -422,6 +422,84 @@ hfs_extents_to_attr(TSK_FS_INFO * a_fs, const hfs_ext_desc * a_extents,
 }
 
 
+/** \internal
+ * Read a node of the catalog or extents B-tree.  Recently read nodes are
+ * kept in a small LRU cache in HFS_INFO so that repeated descents from the
+ * root of the tree do not go back to the image for the upper levels.
+ *
+ * @param hfs File system being analyzed
+ * @param a_tree Tree that the node is in (HFS_BT_CACHE_CATALOG or HFS_BT_CACHE_EXTENTS)
+ * @param a_attr Attribute of the tree's file
+ * @param a_node Node number to read
+ * @param a_buf [out] Buffer to store the node in
+ * @param a_nodesize Size of a node (and of a_buf)
+ * @returns number of bytes read or -1 on error (same as tsk_fs_attr_read)
+ */
+static ssize_t
+hfs_bt_read_node(HFS_INFO * hfs, uint8_t a_tree, const TSK_FS_ATTR * a_attr,
+    uint32_t a_node, char *a_buf, uint16_t a_nodesize)
+{
+    HFS_BT_NODE_CACHE_ENT *victim = NULL;
+    ssize_t cnt;
+    int i;
+
+    tsk_take_lock(&(hfs->btree_cache_lock));
+    for (i = 0; i < HFS_BT_NODE_CACHE_NUM; i++) {
+        HFS_BT_NODE_CACHE_ENT *ent = &hfs->node_cache[i];
+        if ((ent->tree == a_tree) && (ent->node == a_node)
+            && (ent->len == a_nodesize)) {
+            memcpy(a_buf, ent->data, a_nodesize);
+            ent->stamp = ++hfs->node_cache_stamp;
+            tsk_release_lock(&(hfs->btree_cache_lock));
+            return a_nodesize;
+        }
+    }
+    tsk_release_lock(&(hfs->btree_cache_lock));
+
+    cnt = tsk_fs_attr_read(a_attr, (TSK_OFF_T) a_node * a_nodesize,
+        a_buf, a_nodesize, 0);
+    if (cnt != a_nodesize)
+        return cnt;
+
+    /* Save it in the least recently used slot.  Another thread may have
+     * added the same node while we were reading it, so check again. */
+    tsk_take_lock(&(hfs->btree_cache_lock));
+    for (i = 0; i < HFS_BT_NODE_CACHE_NUM; i++) {
+        HFS_BT_NODE_CACHE_ENT *ent = &hfs->node_cache[i];
+        if ((ent->tree == a_tree) && (ent->node == a_node)
+            && (ent->len == a_nodesize)) {
+            victim = NULL;
+            break;
+        }
+        if ((victim == NULL) || (ent->tree == HFS_BT_CACHE_UNUSED)
+            || ((victim->tree != HFS_BT_CACHE_UNUSED)
+                && (ent->stamp < victim->stamp)))
+            victim = ent;
+    }
+    if (victim) {
+        if (victim->len != a_nodesize) {
+            free(victim->data);
+            victim->len = 0;
+            victim->tree = HFS_BT_CACHE_UNUSED;
+            victim->data = (char *) tsk_malloc(a_nodesize);
+        }
+        // the cache is only an optimization, so ignore allocation errors
+        if (victim->data) {
+            memcpy(victim->data, a_buf, a_nodesize);
+            victim->len = a_nodesize;
+            victim->tree = a_tree;
+            victim->node = a_node;
+            victim->stamp = ++hfs->node_cache_stamp;
+        }
+        else {
+            tsk_error_reset();
+        }
+    }
+    tsk_release_lock(&(hfs->btree_cache_lock));
+    return cnt;
+}
+
+
 /**
  * Look in the extents catalog for entries for a given file. Add the runs
  * to the passed attribute structure.
@@ -547,8 +625,8 @@ hfs_ext_find_extent_record_attr(HFS_INFO * hfs, uint32_t cnid,
                 "hfs_ext_find_extent_record: reading node %" PRIu32
                 " at offset %" PRIuOFF "\n", cur_node, cur_off);
 
-        cnt = tsk_fs_attr_read(hfs->extents_attr, cur_off,
-            node, nodesize, 0);
+        cnt = hfs_bt_read_node(hfs, HFS_BT_CACHE_EXTENTS,
+            hfs->extents_attr, cur_node, node, nodesize);
         if (cnt != nodesize) {
             if (cnt >= 0) {
                 tsk_error_reset();
@@ -888,9 +966,9 @@ hfs_cat_traverse(HFS_INFO * hfs,
         }
 
         // read the current node
-        cur_off = cur_node * nodesize;
-        cnt = tsk_fs_attr_read(hfs->catalog_attr, cur_off,
-            node, nodesize, 0);
+        cur_off = (TSK_OFF_T) cur_node * nodesize;
+        cnt = hfs_bt_read_node(hfs, HFS_BT_CACHE_CATALOG,
+            hfs->catalog_attr, cur_node, node, nodesize);
         if (cnt != nodesize) {
             if (cnt >= 0) {
                 tsk_error_reset();
@@ -1187,6 +1265,161 @@ hfs_cat_get_record_offset(HFS_INFO * hfs, const hfs_btree_key_cat * needle)
 
 
 
+typedef struct {
+    HFS_CAT_IDX_ENT *idx;
+    uint32_t cnt;
+    uint16_t nodesize;
+} HFS_CAT_IDX_BUILD_DATA;
+
+static uint8_t
+hfs_cat_idx_build_cb(HFS_INFO * hfs, int8_t level_type,
+    const hfs_btree_key_cat * cur_key,
+    TSK_OFF_T key_off, void *ptr)
+{
+    HFS_CAT_IDX_BUILD_DATA *data = (HFS_CAT_IDX_BUILD_DATA *) ptr;
+    TSK_ENDIAN_ENUM endian = hfs->fs_info.endian;
+    uint32_t node;
+    size_t rec_off;
+    size_t keylen;
+    const uint8_t *rec;
+    uint16_t rec_type;
+    uint32_t cnid;
+
+    // go to the left-most leaf and walk all of them from there
+    if (level_type == HFS_BT_NODE_TYPE_IDX)
+        return HFS_BTREE_CB_IDX_EQGT;
+
+    node = (uint32_t) (key_off / data->nodesize);
+    rec_off = (size_t) (key_off % data->nodesize);
+    keylen = 2 + tsk_getu16(endian, cur_key->key_len);
+    if ((keylen < 8) || (rec_off + keylen + 12 > data->nodesize))
+        return HFS_BTREE_CB_LEAF_GO;
+
+    // the key points into the node buffer, so the record follows it
+    rec = (const uint8_t *) cur_key + keylen;
+    rec_type = tsk_getu16(endian, rec);
+    if ((rec_type == HFS_FOLDER_THREAD) || (rec_type == HFS_FILE_THREAD)) {
+        if (tsk_getu16(endian, cur_key->name.length) != 0)
+            return HFS_BTREE_CB_LEAF_GO;
+        cnid = tsk_getu32(endian, cur_key->parent_cnid);
+        if ((cnid < data->cnt) && (data->idx[cnid].thread_node == 0)) {
+            data->idx[cnid].thread_node = node;
+            data->idx[cnid].thread_off = (uint16_t) (rec_off + keylen);
+        }
+    }
+    else if ((rec_type == HFS_FOLDER_RECORD)
+        || (rec_type == HFS_FILE_RECORD)) {
+        cnid = tsk_getu32(endian, &rec[8]);
+        if ((cnid < data->cnt) && (data->idx[cnid].rec_node == 0)) {
+            data->idx[cnid].rec_node = node;
+            data->idx[cnid].rec_off = (uint16_t) (rec_off + keylen);
+        }
+    }
+    return HFS_BTREE_CB_LEAF_GO;
+}
+
+/** \internal
+ * Walk all of the catalog leaf nodes once and record where the thread and
+ * file/folder records for each CNID are, so that later lookups do not need
+ * to descend the tree.  Only one thread builds the index.  Errors are
+ * ignored because lookups fall back to searching the tree.
+ * @param hfs File system being analyzed
+ */
+static void
+hfs_cat_idx_build(HFS_INFO * hfs)
+{
+    TSK_FS_INFO *fs = (TSK_FS_INFO *) & (hfs->fs_info);
+    HFS_CAT_IDX_BUILD_DATA data;
+
+    tsk_take_lock(&(hfs->btree_cache_lock));
+    if (hfs->cat_idx_state != 0) {
+        tsk_release_lock(&(hfs->btree_cache_lock));
+        return;
+    }
+    hfs->cat_idx_state = 1;
+    tsk_release_lock(&(hfs->btree_cache_lock));
+
+    if (fs->last_inum + 1 > HFS_CAT_IDX_MAX)
+        data.cnt = HFS_CAT_IDX_MAX;
+    else
+        data.cnt = (uint32_t) (fs->last_inum + 1);
+    data.nodesize = tsk_getu16(fs->endian, hfs->catalog_header.nodesize);
+    data.idx = NULL;
+
+    if (data.nodesize != 0) {
+        data.idx =
+            (HFS_CAT_IDX_ENT *) tsk_malloc(data.cnt *
+            sizeof(HFS_CAT_IDX_ENT));
+        if ((data.idx)
+            && (hfs_cat_traverse(hfs, hfs_cat_idx_build_cb, &data))) {
+            if (tsk_verbose)
+                tsk_fprintf(stderr,
+                    "hfs_cat_idx_build: error walking catalog, not using index\n");
+            free(data.idx);
+            data.idx = NULL;
+        }
+    }
+    tsk_error_reset();
+
+    tsk_take_lock(&(hfs->btree_cache_lock));
+    hfs->cat_idx = data.idx;
+    hfs->cat_idx_cnt = data.idx ? data.cnt : 0;
+    hfs->cat_idx_state = 2;
+    tsk_release_lock(&(hfs->btree_cache_lock));
+}
+
+/** \internal
+ * Get the location of the thread and file/folder records for a CNID from
+ * the catalog index.  The index is built once enough lookups have been done.
+ * @param hfs File system being analyzed
+ * @param inum CNID to look up
+ * @param thread_off [out] Byte offset of thread record data in catalog file or 0 if unknown
+ * @param rec_off [out] Byte offset of file/folder record data in catalog file or 0 if unknown
+ * @returns 1 if the index covers inum (and a missing thread record means
+ * that the CNID is not in the catalog) and 0 if not.
+ */
+static uint8_t
+hfs_cat_idx_get(HFS_INFO * hfs, TSK_INUM_T inum, TSK_OFF_T * thread_off,
+    TSK_OFF_T * rec_off)
+{
+    TSK_FS_INFO *fs = (TSK_FS_INFO *) & (hfs->fs_info);
+    HFS_CAT_IDX_ENT *idx;
+    uint32_t idx_cnt;
+    uint8_t do_build = 0;
+    TSK_OFF_T nodesize;
+
+    *thread_off = 0;
+    *rec_off = 0;
+
+    tsk_take_lock(&(hfs->btree_cache_lock));
+    if ((hfs->cat_idx_state == 0)
+        && (++hfs->cat_lookup_cnt >= HFS_CAT_IDX_LOOKUPS))
+        do_build = 1;
+    tsk_release_lock(&(hfs->btree_cache_lock));
+
+    if (do_build)
+        hfs_cat_idx_build(hfs);
+
+    tsk_take_lock(&(hfs->btree_cache_lock));
+    idx = hfs->cat_idx;
+    idx_cnt = hfs->cat_idx_cnt;
+    tsk_release_lock(&(hfs->btree_cache_lock));
+
+    if ((idx == NULL) || (inum >= idx_cnt))
+        return 0;
+
+    nodesize = tsk_getu16(fs->endian, hfs->catalog_header.nodesize);
+    if (idx[inum].thread_node)
+        *thread_off =
+            (TSK_OFF_T) idx[inum].thread_node * nodesize +
+            idx[inum].thread_off;
+    if (idx[inum].rec_node)
+        *rec_off =
+            (TSK_OFF_T) idx[inum].rec_node * nodesize + idx[inum].rec_off;
+    return 1;
+}
+
+
 /** \internal
  * Given a byte offset to a leaf record in teh catalog file, read the data as
  * a thread record. This will zero the buffer and read in the size of the thread
@@ -1568,6 +1801,8 @@ hfs_cat_file_lookup(HFS_INFO * hfs, TSK_INUM_T inum, HFS_ENTRY * entry,
     hfs_thread thread;          /* thread record */
     hfs_file_folder record;     /* file/folder record */
     TSK_OFF_T off;
+    TSK_OFF_T idx_thread_off;     /* locations from the catalog index */
+    TSK_OFF_T idx_rec_off;
 
     tsk_error_reset();
 
@@ -1589,78 +1824,97 @@ hfs_cat_file_lookup(HFS_INFO * hfs, TSK_INUM_T inum, HFS_ENTRY * entry,
     }
 
 
+    /* use the catalog index if we have one, else search the tree */
+    if (hfs_cat_idx_get(hfs, inum, &idx_thread_off, &idx_rec_off)
+        && (idx_thread_off == 0)) {
+        tsk_error_set_errno(TSK_ERR_FS_INODE_NUM);
+        tsk_error_set_errstr
+            ("hfs_cat_file_lookup: Error finding thread node for file (%"
+            PRIuINUM ")", inum);
+        return 1;
+    }
+
     /* first look up the thread record for the item we're searching for */
+    if ((idx_thread_off == 0)
+        || (hfs_cat_read_thread_record(hfs, idx_thread_off, &thread))) {
+        tsk_error_reset();
 
-    /* set up the thread record key */
-    memset((char *) &key, 0, sizeof(hfs_btree_key_cat));
-    cnid_to_array((uint32_t) inum, key.parent_cnid);
+        /* set up the thread record key */
+        memset((char *) &key, 0, sizeof(hfs_btree_key_cat));
+        cnid_to_array((uint32_t) inum, key.parent_cnid);
 
-    if (tsk_verbose)
-        tsk_fprintf(stderr,
-            "hfs_cat_file_lookup: Looking up thread record (%" PRIuINUM
-            ")\n", inum);
-
-    /* look up the thread record */
-    off = hfs_cat_get_record_offset(hfs, &key);
-    if (off == 0) {
-        // no parsing error, just not found
-        if (tsk_error_get_errno() == 0) {
-            tsk_error_set_errno(TSK_ERR_FS_INODE_NUM);
-            tsk_error_set_errstr
-                ("hfs_cat_file_lookup: Error finding thread node for file (%"
-                PRIuINUM ")", inum);
+        if (tsk_verbose)
+            tsk_fprintf(stderr,
+                "hfs_cat_file_lookup: Looking up thread record (%" PRIuINUM
+                ")\n", inum);
+
+        /* look up the thread record */
+        off = hfs_cat_get_record_offset(hfs, &key);
+        if (off == 0) {
+            // no parsing error, just not found
+            if (tsk_error_get_errno() == 0) {
+                tsk_error_set_errno(TSK_ERR_FS_INODE_NUM);
+                tsk_error_set_errstr
+                    ("hfs_cat_file_lookup: Error finding thread node for file (%"
+                    PRIuINUM ")", inum);
+            }
+            else {
+                tsk_error_set_errstr2
+                    (" hfs_cat_file_lookup: thread for file (%" PRIuINUM ")",
+                    inum);
+            }
+            return 1;
         }
-        else {
-            tsk_error_set_errstr2
-                (" hfs_cat_file_lookup: thread for file (%" PRIuINUM ")",
+
+        /* read the thread record */
+        if (hfs_cat_read_thread_record(hfs, off, &thread)) {
+            tsk_error_set_errstr2(" hfs_cat_file_lookup: file (%" PRIuINUM ")",
                 inum);
+            return 1;
         }
-        return 1;
-    }
-
-    /* read the thread record */
-    if (hfs_cat_read_thread_record(hfs, off, &thread)) {
-        tsk_error_set_errstr2(" hfs_cat_file_lookup: file (%" PRIuINUM ")",
-            inum);
-        return 1;
     }
 
     /* now look up the actual file/folder record */
+    if ((idx_rec_off == 0)
+        || (hfs_cat_read_file_folder_record(hfs, idx_rec_off, &record))
+        || (tsk_getu32(fs->endian, record.file.std.cnid) != inum)) {
+        tsk_error_reset();
 
-    /* build key */
-    memset((char *) &key, 0, sizeof(hfs_btree_key_cat));
-    memcpy((char *) key.parent_cnid, (char *) thread.parent_cnid,
-        sizeof(key.parent_cnid));
-    memcpy((char *) &key.name, (char *) &thread.name, sizeof(key.name));
+        /* build key */
+        memset((char *) &key, 0, sizeof(hfs_btree_key_cat));
+        memcpy((char *) key.parent_cnid, (char *) thread.parent_cnid,
+            sizeof(key.parent_cnid));
+        memcpy((char *) &key.name, (char *) &thread.name, sizeof(key.name));
 
-    if (tsk_verbose)
-        tsk_fprintf(stderr,
-            "hfs_cat_file_lookup: Looking up file record (parent: %"
-            PRIuINUM ")\n", (uint64_t) tsk_getu32(fs->endian,
-                key.parent_cnid));
-
-    /* look up the record */
-    off = hfs_cat_get_record_offset(hfs, &key);
-    if (off == 0) {
-        // no parsing error, just not found
-        if (tsk_error_get_errno() == 0) {
-            tsk_error_set_errno(TSK_ERR_FS_INODE_NUM);
-            tsk_error_set_errstr
-                ("hfs_cat_file_lookup: Error finding record node %"
-                PRIuINUM, inum);
-        }
-        else {
-            tsk_error_set_errstr2(" hfs_cat_file_lookup: file (%" PRIuINUM
-                ")", inum);
+        if (tsk_verbose)
+            tsk_fprintf(stderr,
+                "hfs_cat_file_lookup: Looking up file record (parent: %"
+                PRIuINUM ")\n", (uint64_t) tsk_getu32(fs->endian,
+                    key.parent_cnid));
+
+        /* look up the record */
+        off = hfs_cat_get_record_offset(hfs, &key);
+        if (off == 0) {
+            // no parsing error, just not found
+            if (tsk_error_get_errno() == 0) {
+                tsk_error_set_errno(TSK_ERR_FS_INODE_NUM);
+                tsk_error_set_errstr
+                    ("hfs_cat_file_lookup: Error finding record node %"
+                    PRIuINUM, inum);
+            }
+            else {
+                tsk_error_set_errstr2(" hfs_cat_file_lookup: file (%" PRIuINUM
+                    ")", inum);
+            }
+            return 1;
         }
-        return 1;
-    }
 
-    /* read the record */
-    if (hfs_cat_read_file_folder_record(hfs, off, &record)) {
-        tsk_error_set_errstr2(" hfs_cat_file_lookup: file (%" PRIuINUM ")",
-            inum);
-        return 1;
+        /* read the record */
+        if (hfs_cat_read_file_folder_record(hfs, off, &record)) {
+            tsk_error_set_errstr2(" hfs_cat_file_lookup: file (%" PRIuINUM ")",
+                inum);
+            return 1;
+        }
     }
 
     /* these memcpy can be gotten rid of, really */
@@ -3226,6 +3480,132 @@ hfs_attr_walk_lzvn_rsrc(const TSK_FS_ATTR * fs_attr,
 }
 
 
+/* Number of decompressed compression units that are kept for each
+ * compressed data fork that is read with hfs_file_read_compressed_rsrc(). */
+#define HFS_COMP_CACHE_UNITS 4
+
+/**
+ * \internal
+ * A decompressed compression unit in a HFS_COMP_CACHE.
+ */
+typedef struct {
+    TSK_OFF_T unit;             // index of the unit in the block table
+    char *buf;                  // decompressed data (NULL if entry is not used)
+    uint64_t len;               // number of bytes in buf
+    uint32_t used;              // value of HFS_COMP_CACHE::clock when last used
+} HFS_COMP_CACHE_ENT;
+
+/**
+ * \internal
+ * State that hfs_file_read_compressed_rsrc() keeps with a compressed data
+ * fork (in TSK_FS_ATTR::r_cache) so that the block table is read once
+ * and small reads do not decompress the same units over and over.
+ */
+typedef struct {
+    tsk_lock_t lock;            // protects everything below
+    uint8_t tableLoaded;        // set once the block table has been read
+    CMP_OFFSET_ENTRY *offsetTable;
+    uint32_t offsetTableSize;
+    uint32_t offsetTableOffset;
+    char *rawBuf;               // compressed data of the unit being read
+    char *uncBuf;               // buffer to decompress the next unit into
+    HFS_COMP_CACHE_ENT ents[HFS_COMP_CACHE_UNITS];
+    uint32_t clock;             // incremented each time an entry is used
+} HFS_COMP_CACHE;
+
+/**
+ * \internal
+ * Free a HFS_COMP_CACHE (used as TSK_FS_ATTR::r_cache_free).
+ */
+static void
+hfs_comp_cache_free(void *a_ptr)
+{
+    HFS_COMP_CACHE *cache = (HFS_COMP_CACHE *) a_ptr;
+    int i;
+
+    for (i = 0; i < HFS_COMP_CACHE_UNITS; i++)
+        free(cache->ents[i].buf);
+    free(cache->offsetTable);
+    free(cache->rawBuf);
+    free(cache->uncBuf);
+    tsk_deinit_lock(&cache->lock);
+    free(cache);
+}
+
+/**
+ * \internal
+ * Get a decompressed compression unit from the cache of a data fork,
+ * decompressing it (and replacing the least recently used unit) if it
+ * is not there.  Must be called while holding the cache lock.
+ *
+ * @param cache the cache of the data fork
+ * @param rAttr the resource fork
+ * @param indx index of block to get
+ * @param decompress_block pointer to decompression function
+ * @return entry with the decompressed data or NULL on error
+ */
+static HFS_COMP_CACHE_ENT *
+hfs_comp_cache_get(HFS_COMP_CACHE * cache, const TSK_FS_ATTR * rAttr,
+    TSK_OFF_T indx,
+    int (*decompress_block)(char* rawBuf,
+                            uint32_t len,
+                            char* uncBuf,
+                            uint64_t* uncLen))
+{
+    HFS_COMP_CACHE_ENT *ent = NULL;
+    ssize_t uncLen;
+    char *tmp;
+    int i;
+
+    cache->clock++;
+    for (i = 0; i < HFS_COMP_CACHE_UNITS; i++) {
+        if ((cache->ents[i].buf) && (cache->ents[i].unit == indx)) {
+            cache->ents[i].used = cache->clock;
+            return &cache->ents[i];
+        }
+        if ((ent == NULL) || (cache->ents[i].buf == NULL)
+            || ((ent->buf) && (cache->ents[i].used < ent->used)))
+            ent = &cache->ents[i];
+    }
+
+    // Allocate buffers for the raw and uncompressed data
+    /* Raw data can be COMPRESSION_UNIT_SIZE+1 if the zlib data is not
+     * compressed and there is a 1-byte flag that indicates that
+     * the data is not compressed. */
+    if ((cache->rawBuf == NULL) && ((cache->rawBuf =
+                (char *) tsk_malloc(COMPRESSION_UNIT_SIZE + 1)) == NULL)) {
+        error_returned
+            (" %s: buffers for reading and uncompressing", __func__);
+        return NULL;
+    }
+    if ((cache->uncBuf == NULL) && ((cache->uncBuf =
+                (char *) tsk_malloc(COMPRESSION_UNIT_SIZE)) == NULL)) {
+        error_returned
+            (" %s: buffers for reading and uncompressing", __func__);
+        return NULL;
+    }
+
+    uncLen = read_and_decompress_block(rAttr, cache->rawBuf, cache->uncBuf,
+        cache->offsetTable, cache->offsetTableSize, cache->offsetTableOffset,
+        (size_t) indx, decompress_block);
+    if (uncLen == -1)
+        return NULL;
+
+    /* The caller pads reads past the end of the last unit with the rest of
+     * the buffer, which must not have data from a previous unit in it. */
+    memset(cache->uncBuf + uncLen, 0, COMPRESSION_UNIT_SIZE - uncLen);
+
+    // keep the uncompressed data and decompress the next unit into the
+    // old buffer of the entry
+    tmp = ent->buf;
+    ent->buf = cache->uncBuf;
+    cache->uncBuf = tmp;
+    ent->len = (uint64_t) uncLen;
+    ent->unit = indx;
+    ent->used = cache->clock;
+    return ent;
+}
+
 /**
  * \internal
  * Read a compressed resource
@@ -3252,11 +3632,9 @@ hfs_file_read_compressed_rsrc(const TSK_FS_ATTR * a_fs_attr,
 {
     TSK_FS_FILE *fs_file;
     const TSK_FS_ATTR *rAttr;
-    char *rawBuf = NULL;
-    char *uncBuf = NULL;
-    uint32_t offsetTableOffset;
+    HFS_COMP_CACHE *cache;
     uint32_t offsetTableSize;         // Size of the offset table
-    CMP_OFFSET_ENTRY *offsetTable = NULL;
+    const CMP_OFFSET_ENTRY *offsetTable;
     TSK_OFF_T indx;                // index for looping over the offset table
     TSK_OFF_T startUnit = 0;
     uint32_t startUnitOffset = 0;
@@ -3326,10 +3704,42 @@ hfs_file_read_compressed_rsrc(const TSK_FS_ATTR * a_fs_attr,
         return -1;
     }
 
+    /* Get the cache of the block table and decompressed units for this
+     * attribute (it is freed with the attribute).  It is created once,
+     * under the lock, and is then found without it. */
+    cache = (HFS_COMP_CACHE *) tsk_atomic_load_ptr(&a_fs_attr->r_cache);
+    if (cache == NULL) {
+        tsk_take_lock(&fs_file->fs_info->attr_run_idx_lock);
+        if (a_fs_attr->r_cache == NULL) {
+            if ((cache =
+                    (HFS_COMP_CACHE *) tsk_malloc(sizeof(HFS_COMP_CACHE)))
+                == NULL) {
+                tsk_release_lock(&fs_file->fs_info->attr_run_idx_lock);
+                return -1;
+            }
+            tsk_init_lock(&cache->lock);
+            ((TSK_FS_ATTR *) a_fs_attr)->r_cache_free = hfs_comp_cache_free;
+            tsk_atomic_store_ptr(&((TSK_FS_ATTR *) a_fs_attr)->r_cache,
+                cache);
+        }
+        cache = (HFS_COMP_CACHE *) a_fs_attr->r_cache;
+        tsk_release_lock(&fs_file->fs_info->attr_run_idx_lock);
+    }
+
+    /* Reading the resource fork can take attr_run_idx_lock, so the block
+     * table is read (once) while holding only the cache lock. */
+    tsk_take_lock(&cache->lock);
+
     // read the offset table from the fork header
-    if (!read_block_table(rAttr, &offsetTable, &offsetTableSize, &offsetTableOffset)) {
-      return -1;
+    if (!cache->tableLoaded) {
+        if (!read_block_table(rAttr, &cache->offsetTable,
+                &cache->offsetTableSize, &cache->offsetTableOffset)) {
+            goto on_error;
+        }
+        cache->tableLoaded = 1;
     }
+    offsetTable = cache->offsetTable;
+    offsetTableSize = cache->offsetTableSize;
 
     // Compute the range of compression units needed for the request
     startUnit = a_offset / COMPRESSION_UNIT_SIZE;
@@ -3352,42 +3762,22 @@ hfs_file_read_compressed_rsrc(const TSK_FS_ATTR * a_fs_attr,
             " to %" PRIuOFF "\n", __func__, startUnit, endUnit);
     bytesCopied = 0;
 
-    // Allocate buffers for the raw and uncompressed data
-    /* Raw data can be COMPRESSION_UNIT_SIZE+1 if the zlib data is not
-     * compressed and there is a 1-byte flag that indicates that
-     * the data is not compressed. */
-    rawBuf = (char *) tsk_malloc(COMPRESSION_UNIT_SIZE + 1);
-    if (rawBuf == NULL) {
-        error_returned
-            (" %s: buffers for reading and uncompressing", __func__);
-        goto on_error;
-    }
-
-    uncBuf = (char *) tsk_malloc(COMPRESSION_UNIT_SIZE);
-    if (uncBuf == NULL) {
-        error_returned
-            (" %s: buffers for reading and uncompressing", __func__);
-        goto on_error;
-    }
-
     // Read from the indicated comp units
     for (indx = startUnit; indx <= endUnit; ++indx) {
+        HFS_COMP_CACHE_ENT *ent;
         uint64_t uncLen;
-        char *uncBufPtr = uncBuf;
+        char *uncBufPtr;
         size_t bytesToCopy;
 
-        switch ((uncLen = read_and_decompress_block(
-                    rAttr, rawBuf, uncBuf,
-                    offsetTable, offsetTableSize, offsetTableOffset, (size_t)indx,
-                    decompress_block)))
-        {
-        case -1:
+        if ((ent = hfs_comp_cache_get(cache, rAttr, indx,
+                    decompress_block)) == NULL)
             goto on_error;
-        case  0:
+
+        // units without data are skipped
+        if (ent->len == 0)
             continue;
-        default:
-            break;
-        }
+        uncLen = ent->len;
+        uncBufPtr = ent->buf;
 
         // If this is the first comp unit, then we must skip over the
         // startUnitOffset bytes.
@@ -3407,6 +3797,7 @@ hfs_file_read_compressed_rsrc(const TSK_FS_ATTR * a_fs_attr,
         memcpy(a_buf + bytesCopied, uncBufPtr, bytesToCopy);
         bytesCopied += bytesToCopy;
     }
+    tsk_release_lock(&cache->lock);
 
     // Well, we don't know (without a lot of work) what the
     // true uncompressed size of the stream is.  All we know is the "upper bound" which
@@ -3421,16 +3812,10 @@ hfs_file_read_compressed_rsrc(const TSK_FS_ATTR * a_fs_attr,
         memset(a_buf + bytesCopied, 0, a_len - (size_t) bytesCopied);   // cast OK because diff must be < compression unit size
     }
 
-    free(offsetTable);
-    free(rawBuf);
-    free(uncBuf);
-
     return (ssize_t) bytesCopied;       // cast OK, cannot be greater than a_len which cannot be greater than SIZE_MAX/2 (rounded down).
 
 on_error:
-    free(offsetTable);
-    free(rawBuf);
-    free(uncBuf);
+    tsk_release_lock(&cache->lock);
     return -1;
 }
 
@@ -5360,6 +5745,11 @@ hfs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
     if (start_inum > end_inum)
         XSWAP(start_inum, end_inum);
 
+    /* Looking up a range of CNIDs one by one would otherwise descend the
+     * catalog tree for each of them */
+    if (end_inum - start_inum > 1)
+        hfs_cat_idx_build((HFS_INFO *) fs);
+
     for (inum = start_inum; inum <= end_inum; ++inum) {
         int retval;
 
@@ -6415,6 +6805,7 @@ static void
 hfs_close(TSK_FS_INFO * fs)
 {
     HFS_INFO *hfs = (HFS_INFO *) fs;
+    int i;
     // We'll grab this lock a bit early.
     tsk_take_lock(&(hfs->metadata_dir_cache_lock));
     fs->tag = 0;
@@ -6449,6 +6840,16 @@ hfs_close(TSK_FS_INFO * fs)
     tsk_release_lock(&(hfs->metadata_dir_cache_lock));
     tsk_deinit_lock(&(hfs->metadata_dir_cache_lock));
 
+    tsk_take_lock(&(hfs->btree_cache_lock));
+    for (i = 0; i < HFS_BT_NODE_CACHE_NUM; i++) {
+        free(hfs->node_cache[i].data);
+        hfs->node_cache[i].data = NULL;
+    }
+    free(hfs->cat_idx);
+    hfs->cat_idx = NULL;
+    tsk_release_lock(&(hfs->btree_cache_lock));
+    tsk_deinit_lock(&(hfs->btree_cache_lock));
+
     tsk_fs_free((TSK_FS_INFO *)hfs);
 }
 
@@ -6622,6 +7023,7 @@ hfs_open(TSK_IMG_INFO * img_info, TSK_OFF_T offset,
 
     // Initialize the lock
     tsk_init_lock(&(hfs->metadata_dir_cache_lock));
+    tsk_init_lock(&(hfs->btree_cache_lock));
 
     /*
      * Set function pointers
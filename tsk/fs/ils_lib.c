@@ -274,12 +274,16 @@ tsk_fs_ils(TSK_FS_INFO * fs, TSK_FS_ILS_FLAG_ENUM lclflags,
 
         print_header_mac();
 
-        if (fs->inode_walk(fs, istart, ilast, flags, ils_mac_act, &data))
+        /* The structures are read on all CPUs, but the callback is still
+         * called in address order so that the output does not change. */
+        if (tsk_fs_meta_walk_parallel(fs, istart, ilast, flags, 0,
+                TSK_FS_META_WALK_PARALLEL_ORDERED, ils_mac_act, &data))
             return 1;
     }
     else {
         print_header(fs);
-        if (fs->inode_walk(fs, istart, ilast, flags, ils_act, &data))
+        if (tsk_fs_meta_walk_parallel(fs, istart, ilast, flags, 0,
+                TSK_FS_META_WALK_PARALLEL_ORDERED, ils_act, &data))
             return 1;
     }
 
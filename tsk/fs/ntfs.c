@@ -36,6 +36,11 @@
  */
 
 
+/** \internal
+ * Maximum number of bytes of $MFT that ntfs_inode_walk() reads at a time.
+ */
+#define NTFS_MFT_READ_SIZE (4 * 1024 * 1024)
+
 /* Macro to pass in both the epoch time value and the nano time value */
 #define WITHNANO(x) x, (unsigned int)x##_nano
 
@@ -117,6 +122,109 @@ nt2nano(uint64_t ntdate)
 
 
 
+/**
+ * Check and remove the update sequence values (fixups) of an MFT entry
+ * that has been read into a buffer.
+ *
+ * @param a_ntfs File system that the entry is from
+ * @param a_buf Buffer with the raw entry.  Must be of size NTFS_INFO.mft_rsize_b
+ *
+ * @returns TSK_COR if the update sequence is corrupt and TSK_OK otherwise
+ */
+static TSK_RETVAL_ENUM
+ntfs_mft_fixup(NTFS_INFO * a_ntfs, char *a_buf)
+{
+    int i;
+    TSK_FS_INFO *fs = (TSK_FS_INFO *) & a_ntfs->fs_info;
+    ntfs_upd *upd;
+    uint16_t sig_seq;
+    ntfs_mft *mft;
+
+    /* The MFT entries have error and integrity checks in them
+     * called update sequences.  They must be checked and removed
+     * so that later functions can process the data as normal.
+     * They are located in the last 2 bytes of each 512-bytes of data.
+     *
+     * We first verify that the the 2-byte value is a give value and
+     * then replace it with what should be there
+     */
+    /* sanity check so we don't run over in the next loop */
+    mft = (ntfs_mft *) a_buf;
+    if ((tsk_getu16(fs->endian, mft->upd_cnt) > 0) &&
+        (((uint32_t) (tsk_getu16(fs->endian,
+                        mft->upd_cnt) - 1) * NTFS_UPDATE_SEQ_STRIDE) >
+            a_ntfs->mft_rsize_b)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_INODE_COR);
+        tsk_error_set_errstr
+            ("dinode_lookup: More Update Sequence Entries than MFT size");
+        return TSK_COR;
+    }
+    if (tsk_getu16(fs->endian, mft->upd_off) + sizeof(ntfs_upd) > a_ntfs->mft_rsize_b) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_INODE_COR);
+        tsk_error_set_errstr
+            ("dinode_lookup: Update sequence would read past MFT size");
+        return TSK_COR;
+    }
+
+    /* Apply the update sequence structure template */
+    upd =
+        (ntfs_upd *) ((uintptr_t) a_buf + tsk_getu16(fs->endian,
+            mft->upd_off));
+    /* Get the sequence value that each 16-bit value should be */
+    sig_seq = tsk_getu16(fs->endian, upd->upd_val);
+    /* cycle through each sector */
+    for (i = 1; i < tsk_getu16(fs->endian, mft->upd_cnt); i++) {
+        uint8_t *new_val, *old_val;
+        /* The offset into the buffer of the value to analyze */
+        size_t offset = i * NTFS_UPDATE_SEQ_STRIDE - 2;
+
+        /* Check that there is room in the buffer to read the current sequence value */
+        if (offset + 2 > a_ntfs->mft_rsize_b) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_FS_INODE_COR);
+            tsk_error_set_errstr
+            ("dinode_lookup: Ran out of data while parsing update sequence values");
+            return TSK_COR;
+        }
+
+        /* get the current sequence value */
+        uint16_t cur_seq =
+            tsk_getu16(fs->endian, (uintptr_t) a_buf + offset);
+        if (cur_seq != sig_seq) {
+            /* get the replacement value */
+            uint16_t cur_repl =
+                tsk_getu16(fs->endian, &upd->upd_seq + (i - 1) * 2);
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_FS_GENFS);
+
+            tsk_error_set_errstr
+                ("Incorrect update sequence value in MFT entry\nSignature Value: 0x%"
+                PRIx16 " Actual Value: 0x%" PRIx16
+                " Replacement Value: 0x%" PRIx16
+                "\nThis is typically because of a corrupted entry",
+                sig_seq, cur_seq, cur_repl);
+            return TSK_COR;
+        }
+
+        new_val = &upd->upd_seq + (i - 1) * 2;
+        old_val = (uint8_t *) ((uintptr_t) a_buf + offset);
+        /*
+           if (tsk_verbose)
+           tsk_fprintf(stderr,
+           "ntfs_dinode_lookup: upd_seq %i   Replacing: %.4"
+           PRIx16 "   With: %.4" PRIx16 "\n", i,
+           tsk_getu16(fs->endian, old_val), tsk_getu16(fs->endian,
+           new_val));
+         */
+        *old_val++ = *new_val++;
+        *old_val = *new_val;
+    }
+
+    return TSK_OK;
+}
+
 /**
  * Read an MFT entry and save it in raw form in the given buffer.
  * NOTE: This will remove the update sequence integrity checks in the
@@ -133,12 +241,8 @@ ntfs_dinode_lookup(NTFS_INFO * a_ntfs, char *a_buf, TSK_INUM_T a_mftnum)
 {
     TSK_OFF_T mftaddr_b, mftaddr2_b, offset;
     size_t mftaddr_len = 0;
-    int i;
     TSK_FS_INFO *fs = (TSK_FS_INFO *) & a_ntfs->fs_info;
     TSK_FS_ATTR_RUN *data_run;
-    ntfs_upd *upd;
-    uint16_t sig_seq;
-    ntfs_mft *mft;
 
 
     /* sanity checks */
@@ -355,105 +459,167 @@ ntfs_dinode_lookup(NTFS_INFO * a_ntfs, char *a_buf, TSK_INUM_T a_mftnum)
         return 1;
     }
 #endif
-    /* The MFT entries have error and integrity checks in them
-     * called update sequences.  They must be checked and removed
-     * so that later functions can process the data as normal.
-     * They are located in the last 2 bytes of each 512-bytes of data.
-     *
-     * We first verify that the the 2-byte value is a give value and
-     * then replace it with what should be there
-     */
-    /* sanity check so we don't run over in the next loop */
-    mft = (ntfs_mft *) a_buf;
-    if ((tsk_getu16(fs->endian, mft->upd_cnt) > 0) &&
-        (((uint32_t) (tsk_getu16(fs->endian,
-                        mft->upd_cnt) - 1) * NTFS_UPDATE_SEQ_STRIDE) >
-            a_ntfs->mft_rsize_b)) {
-        tsk_error_reset();
-        tsk_error_set_errno(TSK_ERR_FS_INODE_COR);
-        tsk_error_set_errstr
-            ("dinode_lookup: More Update Sequence Entries than MFT size");
-        return TSK_COR;
-    }
-    if (tsk_getu16(fs->endian, mft->upd_off) + sizeof(ntfs_upd) > a_ntfs->mft_rsize_b) {
-        tsk_error_reset();
-        tsk_error_set_errno(TSK_ERR_FS_INODE_COR);
-        tsk_error_set_errstr
-            ("dinode_lookup: Update sequence would read past MFT size");
-        return TSK_COR;
-    }
+    return ntfs_mft_fixup(a_ntfs, a_buf);
+}
 
-    /* Apply the update sequence structure template */
-    upd =
-        (ntfs_upd *) ((uintptr_t) a_buf + tsk_getu16(fs->endian,
-            mft->upd_off));
-    /* Get the sequence value that each 16-bit value should be */
-    sig_seq = tsk_getu16(fs->endian, upd->upd_val);
-    /* cycle through each sector */
-    for (i = 1; i < tsk_getu16(fs->endian, mft->upd_cnt); i++) {
-        uint8_t *new_val, *old_val;
-        /* The offset into the buffer of the value to analyze */
-        size_t offset = i * NTFS_UPDATE_SEQ_STRIDE - 2;
 
-        /* Check that there is room in the buffer to read the current sequence value */
-        if (offset + 2 > a_ntfs->mft_rsize_b) {
-            tsk_error_reset();
-            tsk_error_set_errno(TSK_ERR_FS_INODE_COR);
-            tsk_error_set_errstr
-            ("dinode_lookup: Ran out of data while parsing update sequence values");
-            return TSK_COR;
-        }
 
-        /* get the current sequence value */
-        uint16_t cur_seq =
-            tsk_getu16(fs->endian, (uintptr_t) a_buf + offset);
-        if (cur_seq != sig_seq) {
-            /* get the replacement value */
-            uint16_t cur_repl =
-                tsk_getu16(fs->endian, &upd->upd_seq + (i - 1) * 2);
-            tsk_error_reset();
-            tsk_error_set_errno(TSK_ERR_FS_GENFS);
+/**
+ * Read consecutive MFT entries that are in the same run of $MFT with a
+ * single read.  The update sequences are not removed; call
+ * ntfs_mft_fixup() on each entry before it is used.
+ *
+ * @param a_ntfs File system to read from
+ * @param a_buf Buffer to save the raw entries to
+ * @param a_buf_len Size of a_buf in bytes
+ * @param a_mftnum Address of the first MFT entry to read
+ * @param a_last Address of the last MFT entry that is needed
+ *
+ * @returns Number of entries that were read.  0 if the entries could not
+ * be read as a run, in which case ntfs_dinode_lookup() should be used.
+ */
+static size_t
+ntfs_dinode_lookup_run(NTFS_INFO * a_ntfs, char *a_buf, size_t a_buf_len,
+    TSK_INUM_T a_mftnum, TSK_INUM_T a_last)
+{
+    TSK_FS_INFO *fs = (TSK_FS_INFO *) & a_ntfs->fs_info;
+    TSK_FS_ATTR_RUN *data_run;
+    TSK_OFF_T offset;
+    TSK_OFF_T mftaddr_b = 0;
+    size_t count;
+    ssize_t cnt;
 
-            tsk_error_set_errstr
-                ("Incorrect update sequence value in MFT entry\nSignature Value: 0x%"
-                PRIx16 " Actual Value: 0x%" PRIx16
-                " Replacement Value: 0x%" PRIx16
-                "\nThis is typically because of a corrupted entry",
-                sig_seq, cur_seq, cur_repl);
-            return TSK_COR;
+    if ((a_ntfs->mft_data == NULL) || (a_mftnum < fs->first_inum)
+        || (a_last > fs->last_inum - 1) || (a_last < a_mftnum))
+        return 0;
+
+    count = a_buf_len / a_ntfs->mft_rsize_b;
+    if (count > a_last - a_mftnum + 1)
+        count = (size_t) (a_last - a_mftnum + 1);
+
+    /* Find the run with the first entry.  Only the entries that are
+     * completely in that run are read. */
+    offset = a_mftnum * a_ntfs->mft_rsize_b;
+    for (data_run = a_ntfs->mft_data->nrd.run;
+        data_run != NULL; data_run = data_run->next) {
+        TSK_OFF_T run_len;
+
+        if ((offset < 0)
+            || (data_run->len >=
+                (TSK_DADDR_T) (LLONG_MAX / a_ntfs->csize_b)))
+            return 0;
+
+        run_len = data_run->len * a_ntfs->csize_b;
+        if (offset < run_len) {
+            if ((TSK_OFF_T) count > (run_len - offset) / a_ntfs->mft_rsize_b)
+                count = (size_t) ((run_len - offset) / a_ntfs->mft_rsize_b);
+            mftaddr_b = data_run->addr * a_ntfs->csize_b + offset;
+            break;
         }
+        offset -= run_len;
+    }
+    if (mftaddr_b == 0)
+        return 0;
 
-        new_val = &upd->upd_seq + (i - 1) * 2;
-        old_val = (uint8_t *) ((uintptr_t) a_buf + offset);
-        /*
-           if (tsk_verbose)
-           tsk_fprintf(stderr,
-           "ntfs_dinode_lookup: upd_seq %i   Replacing: %.4"
-           PRIx16 "   With: %.4" PRIx16 "\n", i,
-           tsk_getu16(fs->endian, old_val), tsk_getu16(fs->endian,
-           new_val));
-         */
-        *old_val++ = *new_val++;
-        *old_val = *new_val;
+    // do not read past the blocks that are in a partial image
+    if ((fs->last_block_act > 0) && (fs->last_block_act < fs->last_block)) {
+        TSK_OFF_T img_end =
+            (TSK_OFF_T) (fs->last_block_act + 1) * fs->block_size;
+        if (mftaddr_b + (TSK_OFF_T) (count * a_ntfs->mft_rsize_b) > img_end)
+            count = (mftaddr_b < img_end) ?
+                (size_t) ((img_end - mftaddr_b) / a_ntfs->mft_rsize_b) : 0;
     }
+    if (count < 2)
+        return 0;
 
-    return TSK_OK;
+    cnt = tsk_fs_read(fs, mftaddr_b, a_buf, count * a_ntfs->mft_rsize_b);
+    if (cnt < (ssize_t) a_ntfs->mft_rsize_b) {
+        tsk_error_reset();
+        return 0;
+    }
+
+    if (tsk_verbose)
+        tsk_fprintf(stderr,
+            "ntfs_dinode_lookup_run: Read MFT entries %" PRIuINUM
+            " to %" PRIuINUM " at %" PRIuOFF "\n", a_mftnum,
+            a_mftnum + cnt / a_ntfs->mft_rsize_b - 1, mftaddr_b);
+
+    return (size_t) cnt / a_ntfs->mft_rsize_b;
 }
 
+/*
+ * Load the cluster of the $Bitmap file with the allocation bits of the
+ * clusters starting at base * bits per cluster into ntfs->bmap_buf.
+ *
+ * Note: This routine assumes &ntfs->lock is locked by the caller.
+ *
+ * return 1 on error and 0 on success
+ */
+static uint8_t
+ntfs_bmap_load(NTFS_INFO * ntfs, TSK_DADDR_T base)
+{
+    TSK_DADDR_T c = base;
+    TSK_FS_ATTR_RUN *run;
+    TSK_DADDR_T fsaddr = 0;
+    ssize_t cnt;
 
+    /* is this the same as in the cached buffer? */
+    if (base == ntfs->bmap_buf_off)
+        return 0;
+
+    /* get the file system address of the bitmap cluster */
+    for (run = ntfs->bmap; run; run = run->next) {
+        if (run->len <= c) {
+            c -= run->len;
+        }
+        else {
+            fsaddr = run->addr + c;
+            break;
+        }
+    }
+
+    if (fsaddr == 0) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_BLK_NUM);
+        tsk_error_set_errstr
+            ("is_clustalloc: cluster not found in bitmap: %" PRIuDADDR
+            "", c);
+        return 1;
+    }
+    if (fsaddr > ntfs->fs_info.last_block) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_FS_BLK_NUM);
+        tsk_error_set_errstr
+            ("is_clustalloc: Cluster in bitmap too large for image: %"
+            PRIuDADDR, fsaddr);
+        return 1;
+    }
+    ntfs->bmap_buf_off = base;
+    cnt = tsk_fs_read_block
+        (&ntfs->fs_info, fsaddr, ntfs->bmap_buf,
+        ntfs->fs_info.block_size);
+    if (cnt != ntfs->fs_info.block_size) {
+        if (cnt >= 0) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_FS_READ);
+        }
+        tsk_error_set_errstr2
+            ("is_clustalloc: Error reading bitmap at %" PRIuDADDR,
+            fsaddr);
+        return 1;
+    }
+    return 0;
+}
 
 /*
- * given a cluster, return the allocation status or
- * -1 if an error occurs
+ * Check that the allocation status of a cluster can be looked up.
+ *
+ * return -1 on error, 1 if everything is allocated because the MFT
+ * is being loaded, and 0 otherwise
  */
 static int
-is_clustalloc(NTFS_INFO * ntfs, TSK_DADDR_T addr)
+is_clustalloc_check(NTFS_INFO * ntfs, TSK_DADDR_T addr)
 {
-    int bits_p_clust, b;
-    TSK_DADDR_T base;
-    int8_t ret;
-    bits_p_clust = 8 * ntfs->fs_info.block_size;
-
     /* While we are loading the MFT, assume that everything
      * is allocated.  This should only be needed when we are
      * dealing with an attribute list ...
@@ -477,6 +643,24 @@ is_clustalloc(NTFS_INFO * ntfs, TSK_DADDR_T addr)
         tsk_error_set_errstr("is_clustalloc: cluster too large");
         return -1;
     }
+    return 0;
+}
+
+/*
+ * given a cluster, return the allocation status or
+ * -1 if an error occurs
+ */
+static int
+is_clustalloc(NTFS_INFO * ntfs, TSK_DADDR_T addr)
+{
+    int bits_p_clust, b;
+    TSK_DADDR_T base;
+    int8_t ret;
+    bits_p_clust = 8 * ntfs->fs_info.block_size;
+
+    ret = is_clustalloc_check(ntfs, addr);
+    if (ret != 0)
+        return ret;
 
     /* identify the base cluster in the bitmap file */
     base = addr / bits_p_clust;
@@ -484,57 +668,9 @@ is_clustalloc(NTFS_INFO * ntfs, TSK_DADDR_T addr)
 
     tsk_take_lock(&ntfs->lock);
 
-    /* is this the same as in the cached buffer? */
-    if (base != ntfs->bmap_buf_off) {
-        TSK_DADDR_T c = base;
-        TSK_FS_ATTR_RUN *run;
-        TSK_DADDR_T fsaddr = 0;
-        ssize_t cnt;
-
-        /* get the file system address of the bitmap cluster */
-        for (run = ntfs->bmap; run; run = run->next) {
-            if (run->len <= c) {
-                c -= run->len;
-            }
-            else {
-                fsaddr = run->addr + c;
-                break;
-            }
-        }
-
-        if (fsaddr == 0) {
-            tsk_release_lock(&ntfs->lock);
-            tsk_error_reset();
-            tsk_error_set_errno(TSK_ERR_FS_BLK_NUM);
-            tsk_error_set_errstr
-                ("is_clustalloc: cluster not found in bitmap: %" PRIuDADDR
-                "", c);
-            return -1;
-        }
-        if (fsaddr > ntfs->fs_info.last_block) {
-            tsk_release_lock(&ntfs->lock);
-            tsk_error_reset();
-            tsk_error_set_errno(TSK_ERR_FS_BLK_NUM);
-            tsk_error_set_errstr
-                ("is_clustalloc: Cluster in bitmap too large for image: %"
-                PRIuDADDR, fsaddr);
-            return -1;
-        }
-        ntfs->bmap_buf_off = base;
-        cnt = tsk_fs_read_block
-            (&ntfs->fs_info, fsaddr, ntfs->bmap_buf,
-            ntfs->fs_info.block_size);
-        if (cnt != ntfs->fs_info.block_size) {
-            tsk_release_lock(&ntfs->lock);
-            if (cnt >= 0) {
-                tsk_error_reset();
-                tsk_error_set_errno(TSK_ERR_FS_READ);
-            }
-            tsk_error_set_errstr2
-                ("is_clustalloc: Error reading bitmap at %" PRIuDADDR,
-                fsaddr);
-            return -1;
-        }
+    if (ntfs_bmap_load(ntfs, base)) {
+        tsk_release_lock(&ntfs->lock);
+        return -1;
     }
 
     /* identify if the cluster is allocated or not */
@@ -544,6 +680,51 @@ is_clustalloc(NTFS_INFO * ntfs, TSK_DADDR_T addr)
     return ret;
 }
 
+/*
+ * given a cluster, return the allocation status and the number of 
+ * clusters up to a_last that have the same status (or 0 if an error
+ * occurs).  The run ends at the end of the bitmap cluster.
+ */
+static TSK_DADDR_T
+is_clustalloc_run(NTFS_INFO * ntfs, TSK_DADDR_T addr, TSK_DADDR_T a_last,
+    int *a_alloc)
+{
+    TSK_DADDR_T bits_p_clust, base, b, end;
+    TSK_DADDR_T len;
+    int ret;
+
+    ret = is_clustalloc_check(ntfs, addr);
+    if (ret == -1) {
+        return 0;
+    }
+    else if (ret == 1) {
+        *a_alloc = 1;
+        return a_last - addr + 1;
+    }
+
+    /* identify the base cluster in the bitmap file */
+    bits_p_clust = 8 * (TSK_DADDR_T) ntfs->fs_info.block_size;
+    base = addr / bits_p_clust;
+    b = addr % bits_p_clust;
+    end = bits_p_clust;
+    if (a_last - addr < end - b)
+        end = b + (a_last - addr) + 1;
+
+    tsk_take_lock(&ntfs->lock);
+
+    if (ntfs_bmap_load(ntfs, base)) {
+        tsk_release_lock(&ntfs->lock);
+        return 0;
+    }
+
+    *a_alloc = (isset(ntfs->bmap_buf, b)) ? 1 : 0;
+    len = tsk_fs_bitmap_run((uint8_t *) ntfs->bmap_buf, (size_t) b,
+        (size_t) end);
+
+    tsk_release_lock(&ntfs->lock);
+    return len;
+}
+
 
 
 /**********************************************************************
@@ -806,9 +987,8 @@ typedef struct {
 static void
 ntfs_uncompress_reset(NTFS_COMP_INFO * comp)
 {
-    memset(comp->uncomp_buf, 0, comp->buf_size_b);
+    // only the first uncomp_idx and comp_len bytes of the buffers are used
     comp->uncomp_idx = 0;
-    memset(comp->comp_buf, 0, comp->buf_size_b);
     comp->comp_len = 0;
 }
 
@@ -857,7 +1037,8 @@ ntfs_uncompress_done(NTFS_COMP_INFO * comp)
  /**
   * Uncompress the block of data in comp->comp_buf,
   * which has a size of comp->comp_len.
-  * Store the result in the comp->uncomp_buf.
+  * Store the result in the comp->uncomp_buf.  comp->uncomp_idx is
+  * only set on success.
   *
   * @param comp Compression unit structure
   *
@@ -868,6 +1049,14 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
 {
     size_t cl_index;
 
+    /* Work on local copies of the buffer state so that it does not
+     * need to be reloaded after each byte that is written */
+    char *uncomp_buf = comp->uncomp_buf;
+    const char *comp_buf = comp->comp_buf;
+    const size_t comp_len = comp->comp_len;
+    const size_t buf_size_b = comp->buf_size_b;
+    size_t uncomp_idx = 0;
+
     tsk_error_reset();
 
     comp->uncomp_idx = 0;
@@ -876,23 +1065,24 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
      * We maintain state using different levels of loops.
      * We use +1 here because the size value at start of block is 2 bytes.
      */
-    for (cl_index = 0; cl_index + 1 < comp->comp_len;) {
+    for (cl_index = 0; cl_index + 1 < comp_len;) {
         size_t blk_end;         // index into the buffer to where block ends
         size_t blk_size;        // size of the current block
         uint8_t iscomp;         // set to 1 if block is compressed
         size_t blk_st_uncomp;   // index into uncompressed buffer where block started
+        int blk_shift = 0;      // shift of the last phrase token in the block
 
         /* The first two bytes of each block contain the size
          * information.*/
-        blk_size = ((((unsigned char) comp->comp_buf[cl_index + 1] << 8) |
-                ((unsigned char) comp->comp_buf[cl_index])) & 0x0FFF) + 3;
+        blk_size = ((((unsigned char) comp_buf[cl_index + 1] << 8) |
+                ((unsigned char) comp_buf[cl_index])) & 0x0FFF) + 3;
 
         // this seems to indicate end of block
         if (blk_size == 3)
             break;
 
         blk_end = cl_index + blk_size;
-        if (blk_end > comp->comp_len) {
+        if (blk_end > comp_len) {
             tsk_error_set_errno(TSK_ERR_FS_FWALK);
             tsk_error_set_errstr
                 ("ntfs_uncompress_compunit: Block length longer than buffer length: %"
@@ -906,13 +1096,13 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
                 blk_size);
 
         /* The MSB identifies if the block is compressed */
-        if ((comp->comp_buf[cl_index + 1] & 0x8000) == 0)
+        if ((comp_buf[cl_index + 1] & 0x8000) == 0)
             iscomp = 0;
         else
             iscomp = 1;
 
         // keep track of where this block started in the buffer
-        blk_st_uncomp = comp->uncomp_idx;
+        blk_st_uncomp = uncomp_idx;
         cl_index += 2;
 
         // the 4096 size seems to occur at the same times as no compression
@@ -923,13 +1113,23 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
                 int a;
 
                 // get the header header
-                unsigned char header = comp->comp_buf[cl_index];
+                unsigned char header = comp_buf[cl_index];
                 cl_index++;
 
                 if (tsk_verbose)
                     tsk_fprintf(stderr,
                         "ntfs_uncompress_compunit: New Tag: %x\n", header);
 
+                /* A group of 8 symbol tokens is copied as is */
+                if ((header == 0) && (tsk_verbose == 0)
+                    && (cl_index + 8 <= blk_end)
+                    && (uncomp_idx + 8 <= buf_size_b)) {
+                    memcpy(&uncomp_buf[uncomp_idx], &comp_buf[cl_index], 8);
+                    uncomp_idx += 8;
+                    cl_index += 8;
+                    continue;
+                }
+
                 for (a = 0; a < 8 && cl_index < blk_end; a++) {
 
                     /* Determine token type and parse appropriately. *
@@ -942,15 +1142,14 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
                                 "ntfs_uncompress_compunit: Symbol Token: %"
                                 PRIuSIZE "\n", cl_index);
 
-                        if (comp->uncomp_idx >= comp->buf_size_b) {
+                        if (uncomp_idx >= buf_size_b) {
                             tsk_error_set_errno(TSK_ERR_FS_FWALK);
                             tsk_error_set_errstr
                                 ("ntfs_uncompress_compunit: Trying to write past end of uncompression buffer: %"
-                                PRIuSIZE "", comp->uncomp_idx);
+                                PRIuSIZE "", uncomp_idx);
                             return 1;
                         }
-                        comp->uncomp_buf[comp->uncomp_idx++] =
-                            comp->comp_buf[cl_index];
+                        uncomp_buf[uncomp_idx++] = comp_buf[cl_index];
 
                         cl_index++;
                     }
@@ -976,22 +1175,24 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
                         }
 
                         pheader =
-                            ((((comp->comp_buf[cl_index +
+                            ((((comp_buf[cl_index +
                                             1]) << 8) & 0xFF00) |
-                            (comp->comp_buf[cl_index] & 0xFF));
+                            (comp_buf[cl_index] & 0xFF));
                         cl_index += 2;
 
 
                         /* The number of bits for the start and length
                          * in the 2-byte header change depending on the
                          * location in the compression unit.  This identifies
-                         * how many bits each has */
-                        shift = 0;
-                        for (i =
-                            comp->uncomp_idx -
-                            blk_st_uncomp - 1; i >= 0x10; i >>= 1) {
-                            shift++;
+                         * how many bits each has.  The position only grows
+                         * within a block, so we continue from the last
+                         * shift instead of starting again at 0. */
+                        i = uncomp_idx - blk_st_uncomp - 1;
+                        while ((blk_shift < 13)
+                            && (i >= ((size_t) 0x10 << blk_shift))) {
+                            blk_shift++;
                         }
+                        shift = blk_shift;
                         if (shift > 12) {
                             tsk_error_reset();
                             tsk_error_set_errno(TSK_ERR_FS_FWALK);
@@ -1005,7 +1206,7 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
                         offset = (pheader >> (12 - shift)) + 1;
                         length = (pheader & (0xFFF >> shift)) + 2;
 
-                        start_position_index = comp->uncomp_idx - offset;
+                        start_position_index = uncomp_idx - offset;
                         end_position_index = start_position_index + length;
 
                         if (tsk_verbose)
@@ -1015,45 +1216,59 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
                                 length, offset, pheader);
 
                         /* Sanity checks on values */
-                        if (offset > comp->uncomp_idx) {
+                        if (offset > uncomp_idx) {
                             tsk_error_reset();
                             tsk_error_set_errno(TSK_ERR_FS_FWALK);
                             tsk_error_set_errstr
                                 ("ntfs_uncompress_compunit: Phrase token offset is too large:  %d (max: %"
-                                PRIuSIZE ")", offset, comp->uncomp_idx);
+                                PRIuSIZE ")", offset, uncomp_idx);
                             return 1;
                         }
                         else if (length + start_position_index >
-                            comp->buf_size_b) {
+                            buf_size_b) {
                             tsk_error_reset();
                             tsk_error_set_errno(TSK_ERR_FS_FWALK);
                             tsk_error_set_errstr
                                 ("ntfs_uncompress_compunit: Phrase token length is too large:  %d (max: %" PRIuSIZE")",
                                 length,
-                                comp->buf_size_b - start_position_index);
+                                buf_size_b - start_position_index);
                             return 1;
                         }
                         else if (end_position_index -
                             start_position_index + 1 >
-                            comp->buf_size_b - comp->uncomp_idx) {
+                            buf_size_b - uncomp_idx) {
                             tsk_error_reset();
                             tsk_error_set_errno(TSK_ERR_FS_FWALK);
                             tsk_error_set_errstr
                                 ("ntfs_uncompress_compunit: Phrase token length is too large for rest of uncomp buf:  %" PRIuSIZE" (max: %"
                                 PRIuSIZE ")",
                                 end_position_index - start_position_index +
-                                1, comp->buf_size_b - comp->uncomp_idx);
+                                1, buf_size_b - uncomp_idx);
                             return 1;
                         }
 
-                        for (;
-                            start_position_index <= end_position_index
-                            && comp->uncomp_idx < comp->buf_size_b;
-                            start_position_index++) {
-
-                            // Copy the previous data to the current position
-                            comp->uncomp_buf[comp->uncomp_idx++]
-                                = comp->uncomp_buf[start_position_index];
+                        // Copy the previous data to the current position.
+                        // The checks above make sure that it all fits.
+                        // Short phrases are faster to copy a byte at a time.
+                        if ((offset > length) && (length >= 16)) {
+                            memcpy(&uncomp_buf[uncomp_idx],
+                                &uncomp_buf[start_position_index],
+                                length + 1);
+                            uncomp_idx += length + 1;
+                        }
+                        else if ((offset == 1) && (length >= 16)) {
+                            // a run of the previous byte
+                            memset(&uncomp_buf[uncomp_idx],
+                                uncomp_buf[uncomp_idx - 1], length + 1);
+                            uncomp_idx += length + 1;
+                        }
+                        else {
+                            for (;
+                                start_position_index <= end_position_index;
+                                start_position_index++) {
+                                uncomp_buf[uncomp_idx++]
+                                    = uncomp_buf[start_position_index];
+                            }
                         }
                     }
                     header >>= 1;
@@ -1064,10 +1279,10 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
 
         // this block contains uncompressed data
         else {
-            while (cl_index < blk_end && cl_index < comp->comp_len) {
+            while (cl_index < blk_end && cl_index < comp_len) {
                 /* This seems to happen only with corrupt data -- such as
                  * when an unallocated file is being processed... */
-                if (comp->uncomp_idx >= comp->buf_size_b) {
+                if (uncomp_idx >= buf_size_b) {
                     tsk_error_reset();
                     tsk_error_set_errno(TSK_ERR_FS_FWALK);
                     tsk_error_set_errstr
@@ -1076,12 +1291,12 @@ ntfs_uncompress_compunit(NTFS_COMP_INFO * comp)
                 }
 
                 // Place data in uncompression_buffer
-                comp->uncomp_buf[comp->uncomp_idx++] =
-                    comp->comp_buf[cl_index++];
+                uncomp_buf[uncomp_idx++] = comp_buf[cl_index++];
             }
         }
     }                           // end of loop inside of compression unit
 
+    comp->uncomp_idx = uncomp_idx;
     return 0;
 }
 
@@ -1473,6 +1688,212 @@ ntfs_attr_walk_special(const TSK_FS_ATTR * fs_attr,
 }
 
 
+/* Number of decompressed compression units that are kept for each
+ * compressed attribute that is read with ntfs_file_read_special(). */
+#define NTFS_COMP_CACHE_UNITS 4
+
+/** \internal
+ * A decompressed compression unit in a NTFS_COMP_CACHE.
+ */
+typedef struct {
+    TSK_DADDR_T unit;           // index of the compression unit in the attribute
+    char *buf;                  // decompressed data (NULL if entry is not used)
+    size_t len;                 // number of bytes in buf
+    uint32_t used;              // value of NTFS_COMP_CACHE::clock when last used
+} NTFS_COMP_CACHE_ENT;
+
+/** \internal
+ * State that ntfs_file_read_special() keeps with a compressed attribute
+ * (in TSK_FS_ATTR::r_cache) so that small reads do not decompress the
+ * same compression units over and over.  run_vcn is the cluster offset
+ * of each run (in the order of the run list), which lets us find the
+ * clusters of a compression unit without walking the list from the start.
+ */
+typedef struct {
+    tsk_lock_t lock;            // protects everything below
+    size_t run_count;           // number of runs in the attribute
+    TSK_FS_ATTR_RUN **run;      // pointer to each run
+    TSK_DADDR_T *run_vcn;       // cluster offset of the start of each run
+    TSK_DADDR_T *comp_unit;     // addresses of the unit being decompressed
+    NTFS_COMP_INFO comp;        // buffers to decompress units with
+    NTFS_COMP_CACHE_ENT ents[NTFS_COMP_CACHE_UNITS];
+    uint32_t clock;             // incremented each time an entry is used
+} NTFS_COMP_CACHE;
+
+/** \internal
+ * Free a NTFS_COMP_CACHE (used as TSK_FS_ATTR::r_cache_free).
+ */
+static void
+ntfs_comp_cache_free(void *a_ptr)
+{
+    NTFS_COMP_CACHE *cache = (NTFS_COMP_CACHE *) a_ptr;
+    int i;
+
+    for (i = 0; i < NTFS_COMP_CACHE_UNITS; i++)
+        free(cache->ents[i].buf);
+    ntfs_uncompress_done(&cache->comp);
+    free(cache->comp_unit);
+    free(cache->run_vcn);
+    free(cache->run);
+    tsk_deinit_lock(&cache->lock);
+    free(cache);
+}
+
+/** \internal
+ * Create the decompression cache for a compressed attribute.
+ *
+ * @param a_fs_attr Attribute to create cache for
+ * @returns NULL on error
+ */
+static NTFS_COMP_CACHE *
+ntfs_comp_cache_alloc(const TSK_FS_ATTR * a_fs_attr)
+{
+    TSK_FS_INFO *fs = a_fs_attr->fs_file->fs_info;
+    NTFS_COMP_CACHE *cache;
+    TSK_FS_ATTR_RUN *fs_attr_run;
+    TSK_DADDR_T vcn = 0;
+    size_t i;
+
+    if ((cache =
+            (NTFS_COMP_CACHE *) tsk_malloc(sizeof(NTFS_COMP_CACHE))) ==
+        NULL)
+        return NULL;
+    tsk_init_lock(&cache->lock);
+
+    for (fs_attr_run = a_fs_attr->nrd.run; fs_attr_run;
+        fs_attr_run = fs_attr_run->next)
+        cache->run_count++;
+
+    if (ntfs_uncompress_setup(fs, &cache->comp, a_fs_attr->nrd.compsize)) {
+        ntfs_comp_cache_free(cache);
+        return NULL;
+    }
+    if (((cache->comp_unit =
+                (TSK_DADDR_T *) tsk_malloc(a_fs_attr->nrd.compsize *
+                    sizeof(TSK_DADDR_T))) == NULL)
+        || ((cache->run =
+                (TSK_FS_ATTR_RUN **) tsk_malloc((cache->run_count +
+                        1) * sizeof(TSK_FS_ATTR_RUN *))) == NULL)
+        || ((cache->run_vcn =
+                (TSK_DADDR_T *) tsk_malloc((cache->run_count +
+                        1) * sizeof(TSK_DADDR_T))) == NULL)) {
+        ntfs_comp_cache_free(cache);
+        return NULL;
+    }
+
+    for (i = 0, fs_attr_run = a_fs_attr->nrd.run; fs_attr_run;
+        i++, fs_attr_run = fs_attr_run->next) {
+        cache->run[i] = fs_attr_run;
+        cache->run_vcn[i] = vcn;
+        vcn += fs_attr_run->len;
+    }
+    // an extra entry with the end of the last run makes the search simpler
+    cache->run[i] = NULL;
+    cache->run_vcn[i] = vcn;
+
+    return cache;
+}
+
+/** \internal
+ * Get a decompressed compression unit of an attribute from its cache,
+ * decompressing it (and replacing the least recently used unit) if it
+ * is not there.  Must be called while holding the cache lock.
+ *
+ * @param a_fs_attr Compressed attribute
+ * @param a_cache Cache of the attribute
+ * @param a_unit Index of the compression unit in the attribute
+ * @param a_ent [out] Entry with the decompressed data.  Set to NULL if
+ * the unit is past the end of the runs.
+ * @returns 1 on error and 0 on success
+ */
+static uint8_t
+ntfs_comp_cache_get(const TSK_FS_ATTR * a_fs_attr,
+    NTFS_COMP_CACHE * a_cache, TSK_DADDR_T a_unit,
+    NTFS_COMP_CACHE_ENT ** a_ent)
+{
+    TSK_FS_INFO *fs = a_fs_attr->fs_file->fs_info;
+    uint32_t compsize = a_fs_attr->nrd.compsize;
+    NTFS_COMP_CACHE_ENT *ent = NULL;
+    TSK_DADDR_T vcn = a_unit * compsize;
+    uint32_t comp_unit_idx = 0;
+    size_t lo, hi;
+    char *tmp;
+    int i;
+
+    *a_ent = NULL;
+    a_cache->clock++;
+
+    for (i = 0; i < NTFS_COMP_CACHE_UNITS; i++) {
+        if ((a_cache->ents[i].buf) && (a_cache->ents[i].unit == a_unit)) {
+            a_cache->ents[i].used = a_cache->clock;
+            *a_ent = &a_cache->ents[i];
+            return 0;
+        }
+        if ((ent == NULL) || (a_cache->ents[i].buf == NULL)
+            || ((ent->buf) && (a_cache->ents[i].used < ent->used)))
+            ent = &a_cache->ents[i];
+    }
+
+    if (vcn >= a_cache->run_vcn[a_cache->run_count])
+        return 0;
+
+    // find the run that the unit starts in
+    lo = 0;
+    hi = a_cache->run_count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a_cache->run_vcn[mid] <= vcn)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    // queue up the addresses of the unit
+    for (; (lo < a_cache->run_count) && (comp_unit_idx < compsize); lo++) {
+        TSK_FS_ATTR_RUN *fs_attr_run = a_cache->run[lo];
+        TSK_DADDR_T a = 0;
+        TSK_DADDR_T addr;
+
+        if (vcn > a_cache->run_vcn[lo])
+            a = vcn - a_cache->run_vcn[lo];
+
+        addr = fs_attr_run->addr;
+        // don't increment addr if it is 0 -- sparse
+        if (addr)
+            addr += a;
+
+        for (; (a < fs_attr_run->len) && (comp_unit_idx < compsize); a++) {
+            a_cache->comp_unit[comp_unit_idx++] = addr;
+
+            /* If it is a sparse run, don't increment the addr so that
+             * it remains 0 */
+            if (((fs_attr_run->flags & TSK_FS_ATTR_RUN_FLAG_SPARSE) == 0)
+                && ((fs_attr_run->flags & TSK_FS_ATTR_RUN_FLAG_FILLER) ==
+                    0))
+                addr++;
+        }
+    }
+
+    // decompress the unit
+    if (ntfs_proc_compunit((NTFS_INFO *) fs, &a_cache->comp,
+            a_cache->comp_unit, comp_unit_idx)) {
+        return 1;
+    }
+
+    // keep the uncompressed buffer and give comp the old one of the entry
+    if (((tmp = ent->buf) == NULL)
+        && ((tmp = (char *) tsk_malloc(a_cache->comp.buf_size_b)) == NULL))
+        return 1;
+    ent->buf = a_cache->comp.uncomp_buf;
+    a_cache->comp.uncomp_buf = tmp;
+    ent->len = a_cache->comp.uncomp_idx;
+    ent->unit = a_unit;
+    ent->used = a_cache->clock;
+    *a_ent = ent;
+    return 0;
+}
+
+
 /** \internal
  *
  * @returns number of bytes read or -1 on error (incl if offset is past EOF)
@@ -1482,7 +1903,6 @@ ntfs_file_read_special(const TSK_FS_ATTR * a_fs_attr,
     TSK_OFF_T a_offset, char *a_buf, size_t a_len)
 {
     TSK_FS_INFO *fs = NULL;
-    NTFS_INFO *ntfs = NULL;
 
     if ((a_fs_attr == NULL) || (a_fs_attr->fs_file == NULL)
         || (a_fs_attr->fs_file->meta == NULL)
@@ -1494,15 +1914,11 @@ ntfs_file_read_special(const TSK_FS_ATTR * a_fs_attr,
     }
 
     fs = a_fs_attr->fs_file->fs_info;
-    ntfs = (NTFS_INFO *) fs;
 
     if (a_fs_attr->flags & TSK_FS_ATTR_COMP) {
-        TSK_FS_ATTR_RUN *data_run_cur;
-        TSK_OFF_T cu_blkoffset; // block offset of starting compression unit to start reading from
+        NTFS_COMP_CACHE *cache;
+        TSK_DADDR_T unit;       // compression unit to start reading from
         size_t byteoffset;      // byte offset in compression unit of where we want to start reading from
-        TSK_DADDR_T *comp_unit;
-        uint32_t comp_unit_idx = 0;
-        NTFS_COMP_INFO comp;
         size_t buf_idx = 0;
 
         if (a_fs_attr->nrd.compsize <= 0) {
@@ -1538,121 +1954,77 @@ ntfs_file_read_special(const TSK_FS_ATTR * a_fs_attr,
             return len;
         }
 
-        /* Allocate the buffers and state structure */
-        if (ntfs_uncompress_setup(fs, &comp, a_fs_attr->nrd.compsize)) {
-            return -1;
-        }
-
-        comp_unit =
-            (TSK_DADDR_T *) tsk_malloc(a_fs_attr->nrd.compsize *
-            sizeof(TSK_DADDR_T));
-        if (comp_unit == NULL) {
-            ntfs_uncompress_done(&comp);
-            return -1;
+        /* Get the cache of decompressed units for this attribute (it
+         * is freed with the attribute).  It is created once, under the
+         * lock, and is then found without it. */
+        cache = (NTFS_COMP_CACHE *) tsk_atomic_load_ptr(&a_fs_attr->r_cache);
+        if (cache == NULL) {
+            tsk_take_lock(&fs->attr_run_idx_lock);
+            if (a_fs_attr->r_cache == NULL) {
+                if ((cache = ntfs_comp_cache_alloc(a_fs_attr)) == NULL) {
+                    tsk_release_lock(&fs->attr_run_idx_lock);
+                    return -1;
+                }
+                ((TSK_FS_ATTR *) a_fs_attr)->r_cache_free =
+                    ntfs_comp_cache_free;
+                tsk_atomic_store_ptr(&((TSK_FS_ATTR *) a_fs_attr)->r_cache,
+                    cache);
+            }
+            cache = (NTFS_COMP_CACHE *) a_fs_attr->r_cache;
+            tsk_release_lock(&fs->attr_run_idx_lock);
         }
 
         // figure out the needed offsets
-        cu_blkoffset = a_offset / fs->block_size;
-        if (cu_blkoffset) {
-            cu_blkoffset /= a_fs_attr->nrd.compsize;
-            cu_blkoffset *= a_fs_attr->nrd.compsize;
-        }
-
-        byteoffset = (size_t) (a_offset - cu_blkoffset * fs->block_size);
-
-        // cycle through the run until we find where we can start to process the clusters
-        for (data_run_cur = a_fs_attr->nrd.run;
-            (data_run_cur) && (buf_idx < a_len);
-            data_run_cur = data_run_cur->next) {
-
-            TSK_DADDR_T addr;
-            size_t a;
-
-            // See if this run contains the starting offset they requested
-            if (data_run_cur->offset + data_run_cur->len <
-                (TSK_DADDR_T) cu_blkoffset)
-                continue;
-
-
-            // seek to the start of where we want to read (we may need to read several runs)
-            if (data_run_cur->offset > (TSK_DADDR_T) cu_blkoffset)
-                a = 0;
-            else
-                a = (size_t) (cu_blkoffset - data_run_cur->offset);
-
-            addr = data_run_cur->addr;
-            // don't increment addr if it is 0 -- sparse
-            if (addr)
-                addr += a;
-
-            /* cycle through the relevant in the run */
-            for (; a < data_run_cur->len && buf_idx < a_len; a++) {
-
-                // queue up the addresses until we get a full unit
-                comp_unit[comp_unit_idx++] = addr;
+        unit = a_offset / fs->block_size / a_fs_attr->nrd.compsize;
+        byteoffset = (size_t) (a_offset -
+            unit * a_fs_attr->nrd.compsize * fs->block_size);
+
+        tsk_take_lock(&cache->lock);
+        for (; buf_idx < a_len; unit++) {
+            NTFS_COMP_CACHE_ENT *ent;
+            size_t cpylen;
+
+            if (ntfs_comp_cache_get(a_fs_attr, cache, unit, &ent)) {
+                tsk_release_lock(&cache->lock);
+                tsk_error_set_errstr2("%" PRIuINUM " - type: %"
+                    PRIu32 "  id: %d  Status: %s",
+                    a_fs_attr->fs_file->meta->addr,
+                    a_fs_attr->type, a_fs_attr->id,
+                    (a_fs_attr->fs_file->meta->
+                        flags & TSK_FS_META_FLAG_ALLOC) ?
+                    "Allocated" : "Deleted");
+                return -1;
+            }
+            // past the end of the runs
+            if (ent == NULL)
+                break;
 
-                // time to decompress (if queue is full or this is the last block)
-                if ((comp_unit_idx == a_fs_attr->nrd.compsize)
-                    || ((a == data_run_cur->len - 1)
-                        && (data_run_cur->next == NULL))) {
-                    size_t cpylen;
+            // copy uncompressed data to the output buffer
+            if (ent->len < byteoffset) {
 
-                    // decompress the unit
-                    if (ntfs_proc_compunit(ntfs, &comp, comp_unit,
-                            comp_unit_idx)) {
-                        tsk_error_set_errstr2("%" PRIuINUM " - type: %"
-                            PRIu32 "  id: %d  Status: %s",
-                            a_fs_attr->fs_file->meta->addr,
-                            a_fs_attr->type, a_fs_attr->id,
-                            (a_fs_attr->fs_file->meta->
-                                flags & TSK_FS_META_FLAG_ALLOC) ?
-                            "Allocated" : "Deleted");
-                        free(comp_unit);
-                        ntfs_uncompress_done(&comp);
-                        return -1;
-                    }
+                // @@ ERROR
+                tsk_release_lock(&cache->lock);
+                return -1;
+            }
+            else if (ent->len - byteoffset < a_len - buf_idx) {
+                cpylen = ent->len - byteoffset;
+            }
+            else {
+                cpylen = a_len - buf_idx;
+            }
+            // Make sure not to return more bytes than are in the file
+            if (cpylen > (a_fs_attr->size - (a_offset + buf_idx)))
+                cpylen =
+                    (size_t) (a_fs_attr->size - (a_offset + buf_idx));
 
-                    // copy uncompressed data to the output buffer
-                    if (comp.uncomp_idx < byteoffset) {
+            memcpy(&a_buf[buf_idx], &ent->buf[byteoffset], cpylen);
 
-                        // @@ ERROR
-                        free(comp_unit);
-                        ntfs_uncompress_done(&comp);
-                        return -1;
-                    }
-                    else if (comp.uncomp_idx - byteoffset <
-                        a_len - buf_idx) {
-                        cpylen = comp.uncomp_idx - byteoffset;
-                    }
-                    else {
-                        cpylen = a_len - buf_idx;
-                    }
-                    // Make sure not to return more bytes than are in the file
-                    if (cpylen > (a_fs_attr->size - (a_offset + buf_idx)))
-                        cpylen =
-                            (size_t) (a_fs_attr->size - (a_offset +
-                                buf_idx));
-
-                    memcpy(&a_buf[buf_idx], &comp.uncomp_buf[byteoffset],
-                        cpylen);
-
-                    // reset this in case we need to also read from the next run
-                    byteoffset = 0;
-                    buf_idx += cpylen;
-                    comp_unit_idx = 0;
-                }
-                /* If it is a sparse run, don't increment the addr so that
-                 * it remains 0 */
-                if (((data_run_cur->flags & TSK_FS_ATTR_RUN_FLAG_SPARSE) ==
-                        0)
-                    && ((data_run_cur->flags & TSK_FS_ATTR_RUN_FLAG_FILLER)
-                        == 0))
-                    addr++;
-            }
+            // reset this in case we need to also read from the next unit
+            byteoffset = 0;
+            buf_idx += cpylen;
         }
+        tsk_release_lock(&cache->lock);
 
-        free(comp_unit);
-        ntfs_uncompress_done(&comp);
         return (ssize_t) buf_idx;
     }
     else {
@@ -3770,6 +4142,22 @@ ntfs_block_getflags(TSK_FS_INFO * a_fs, TSK_DADDR_T a_addr)
 
 
 
+static TSK_DADDR_T
+ntfs_block_getflags_run(TSK_FS_INFO * a_fs, TSK_DADDR_T a_addr,
+    TSK_DADDR_T a_last, TSK_FS_BLOCK_FLAG_ENUM * a_flags)
+{
+    NTFS_INFO *ntfs = (NTFS_INFO *) a_fs;
+    TSK_DADDR_T len;
+    int alloc = 0;
+
+    /* identify if the clusters are allocated or not */
+    len = is_clustalloc_run(ntfs, a_addr, a_last, &alloc);
+    *a_flags = alloc ? TSK_FS_BLOCK_FLAG_ALLOC : TSK_FS_BLOCK_FLAG_UNALLOC;
+    return len;
+}
+
+
+
 /*
  * flags: TSK_FS_BLOCK_FLAG_ALLOC and FS_FLAG_UNALLOC
  *
@@ -3902,6 +4290,11 @@ ntfs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
     TSK_FS_FILE *fs_file;
     TSK_INUM_T end_inum_tmp;
     ntfs_mft *mft;
+    char *mft_buf;              /* buffer for entries that are read one at a time */
+    char *rbuf;                 /* entries that were read as a run */
+    size_t rbuf_len;
+    size_t rbuf_cnt = 0;        /* number of entries in rbuf */
+    TSK_INUM_T rbuf_inum = 0;   /* first entry in rbuf */
     /*
      * Sanity checks.
      */
@@ -3984,7 +4377,7 @@ ntfs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         return 1;
     }
 
-    if ((mft = (ntfs_mft *) tsk_malloc(ntfs->mft_rsize_b)) == NULL) {
+    if ((mft_buf = (char *) tsk_malloc(ntfs->mft_rsize_b)) == NULL) {
         tsk_fs_file_close(fs_file);
         return 1;
     }
@@ -3995,15 +4388,41 @@ ntfs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
     else
         end_inum_tmp = end_inum;
 
+    /* $MFT is read in large runs instead of an entry at a time.  The
+     * entries are processed in place in the buffer. */
+    rbuf_len = NTFS_MFT_READ_SIZE - NTFS_MFT_READ_SIZE % ntfs->mft_rsize_b;
+    if (end_inum_tmp < start_inum)
+        rbuf_len = ntfs->mft_rsize_b;
+    else if ((end_inum_tmp - start_inum + 1) < rbuf_len / ntfs->mft_rsize_b)
+        rbuf_len = (size_t) (end_inum_tmp - start_inum + 1) *
+            ntfs->mft_rsize_b;
+    if ((rbuf = (char *) tsk_malloc(rbuf_len)) == NULL) {
+        tsk_fs_file_close(fs_file);
+        free(mft_buf);
+        return 1;
+    }
+
 
     for (mftnum = start_inum; mftnum <= end_inum_tmp; mftnum++) {
         int retval;
         TSK_RETVAL_ENUM retval2;
 
         /* read MFT entry in to NTFS_INFO */
-        if ((retval2 =
-                ntfs_dinode_lookup(ntfs, (char *) mft,
-                    mftnum)) != TSK_OK) {
+        if ((mftnum < rbuf_inum) || (mftnum >= rbuf_inum + rbuf_cnt)) {
+            rbuf_cnt = ntfs_dinode_lookup_run(ntfs, rbuf, rbuf_len,
+                mftnum, end_inum_tmp);
+            rbuf_inum = mftnum;
+        }
+        if (rbuf_cnt > 0) {
+            mft = (ntfs_mft *) & rbuf[(size_t) (mftnum - rbuf_inum) *
+                ntfs->mft_rsize_b];
+            retval2 = ntfs_mft_fixup(ntfs, (char *) mft);
+        }
+        else {
+            mft = (ntfs_mft *) mft_buf;
+            retval2 = ntfs_dinode_lookup(ntfs, (char *) mft, mftnum);
+        }
+        if (retval2 != TSK_OK) {
             // if the entry is corrupt, then skip to the next one
             if (retval2 == TSK_COR) {
                 if (tsk_verbose)
@@ -4012,7 +4431,8 @@ ntfs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
                 continue;
             }
             tsk_fs_file_close(fs_file);
-            free(mft);
+            free(mft_buf);
+            free(rbuf);
             return 1;
         }
 
@@ -4052,7 +4472,8 @@ ntfs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
                 continue;
             }
             tsk_fs_file_close(fs_file);
-            free(mft);
+            free(mft_buf);
+            free(rbuf);
             return 1;
         }
 
@@ -4066,12 +4487,14 @@ ntfs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
         retval = a_action(fs_file, ptr);
         if (retval == TSK_WALK_STOP) {
             tsk_fs_file_close(fs_file);
-            free(mft);
+            free(mft_buf);
+            free(rbuf);
             return 0;
         }
         else if (retval == TSK_WALK_ERROR) {
             tsk_fs_file_close(fs_file);
-            free(mft);
+            free(mft_buf);
+            free(rbuf);
             return 1;
         }
     }
@@ -4084,25 +4507,29 @@ ntfs_inode_walk(TSK_FS_INFO * fs, TSK_INUM_T start_inum,
 
         if (tsk_fs_dir_make_orphan_dir_meta(fs, fs_file->meta)) {
             tsk_fs_file_close(fs_file);
-            free(mft);
+            free(mft_buf);
+            free(rbuf);
             return 1;
         }
         /* call action */
         retval = a_action(fs_file, ptr);
         if (retval == TSK_WALK_STOP) {
             tsk_fs_file_close(fs_file);
-            free(mft);
+            free(mft_buf);
+            free(rbuf);
             return 0;
         }
         else if (retval == TSK_WALK_ERROR) {
             tsk_fs_file_close(fs_file);
-            free(mft);
+            free(mft_buf);
+            free(rbuf);
             return 1;
         }
     }
 
     tsk_fs_file_close(fs_file);
-    free(mft);
+    free(mft_buf);
+    free(rbuf);
     return 0;
 }
 
@@ -5112,6 +5539,7 @@ ntfs_open(TSK_IMG_INFO * img_info, TSK_OFF_T offset,
     fs->inode_walk = ntfs_inode_walk;
     fs->block_walk = ntfs_block_walk;
     fs->block_getflags = ntfs_block_getflags;
+    fs->block_getflags_run = ntfs_block_getflags_run;
 
     fs->get_default_attr_type = ntfs_get_default_attr_type;
     fs->load_attrs = ntfs_load_attrs;
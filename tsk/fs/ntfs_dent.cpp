@@ -101,6 +101,14 @@ class NTFS_PAR_MAP  {
         std::vector <NTFS_META_ADDR> &get (uint32_t seq) {
             return seq2addrs[seq];
         }
+
+        /**
+         * Get the children for this folder at all sequences.
+         * @returns map of sequence to list of INUMS for children.
+         */
+        const std::map <uint32_t, std::vector <NTFS_META_ADDR> > &getAll () {
+            return seq2addrs;
+        }
  };
 
 
@@ -204,7 +212,106 @@ ntfs_orphan_map_free(NTFS_INFO * a_ntfs)
 
     delete tmpParentMap;
     a_ntfs->orphan_map = NULL;
+    a_ntfs->orphan_map_done = 0;
+    tsk_release_lock(&a_ntfs->orphan_map_lock);
+}
+
+
+/** \internal
+ * Copy the parent to child pairs of the map into an array so that they
+ * can be saved in the sidecar cache.
+ *
+ * @param a_ntfs File system to get the map of
+ * @param a_ents [out] Array of pairs (must be freed by caller).  NULL if
+ * the map has not been fully loaded.
+ * @param a_count [out] Number of pairs in a_ents
+ * @returns 1 on error and 0 on success
+ */
+uint8_t
+ntfs_parent_map_export(NTFS_INFO * a_ntfs, NTFS_PAR_MAP_ENT ** a_ents,
+    size_t * a_count)
+{
+    *a_ents = NULL;
+    *a_count = 0;
+
+    tsk_take_lock(&a_ntfs->orphan_map_lock);
+    if ((a_ntfs->orphan_map == NULL) || (a_ntfs->orphan_map_done == 0)) {
+        tsk_release_lock(&a_ntfs->orphan_map_lock);
+        return 0;
+    }
+
+    std::map<TSK_INUM_T, NTFS_PAR_MAP> *tmpParentMap = getParentMap(a_ntfs);
+    std::map<TSK_INUM_T, NTFS_PAR_MAP>::iterator parIt;
+    size_t count = 0;
+    for (parIt = tmpParentMap->begin(); parIt != tmpParentMap->end(); ++parIt) {
+        const std::map <uint32_t, std::vector <NTFS_META_ADDR> > &seq2addrs = parIt->second.getAll();
+        std::map <uint32_t, std::vector <NTFS_META_ADDR> >::const_iterator seqIt;
+        for (seqIt = seq2addrs.begin(); seqIt != seq2addrs.end(); ++seqIt)
+            count += seqIt->second.size();
+    }
+
+    // allocate at least one entry so that an empty map is not NULL
+    NTFS_PAR_MAP_ENT *ents = (NTFS_PAR_MAP_ENT *) tsk_malloc((count + 1) * sizeof(NTFS_PAR_MAP_ENT));
+    if (ents == NULL) {
+        tsk_release_lock(&a_ntfs->orphan_map_lock);
+        return 1;
+    }
+
+    size_t i = 0;
+    for (parIt = tmpParentMap->begin(); parIt != tmpParentMap->end(); ++parIt) {
+        const std::map <uint32_t, std::vector <NTFS_META_ADDR> > &seq2addrs = parIt->second.getAll();
+        std::map <uint32_t, std::vector <NTFS_META_ADDR> >::const_iterator seqIt;
+        for (seqIt = seq2addrs.begin(); seqIt != seq2addrs.end(); ++seqIt) {
+            for (size_t a = 0; a < seqIt->second.size(); a++) {
+                NTFS_META_ADDR addr = seqIt->second[a];
+                ents[i].par_addr = parIt->first;
+                ents[i].par_seq = seqIt->first;
+                ents[i].addr = addr.getAddr();
+                ents[i].seq = addr.getSeq();
+                ents[i].hash = addr.getHash();
+                i++;
+            }
+        }
+    }
+    tsk_release_lock(&a_ntfs->orphan_map_lock);
+
+    *a_ents = ents;
+    *a_count = count;
+    return 0;
+}
+
+
+/** \internal
+ * Load the map from pairs that were saved in the sidecar cache instead
+ * of walking the MFT.  Nothing is done if the map was already loaded.
+ *
+ * @param a_ntfs File system to load the map of
+ * @param a_ents Pairs from ntfs_parent_map_export()
+ * @param a_count Number of pairs in a_ents
+ * @param a_alloc_file_count Number of allocated files that was found when
+ * the map was made
+ * @returns 1 on error and 0 on success
+ */
+uint8_t
+ntfs_parent_map_import(NTFS_INFO * a_ntfs, const NTFS_PAR_MAP_ENT * a_ents,
+    size_t a_count, int a_alloc_file_count)
+{
+    tsk_take_lock(&a_ntfs->orphan_map_lock);
+    if (a_ntfs->orphan_map != NULL) {
+        tsk_release_lock(&a_ntfs->orphan_map_lock);
+        return 0;
+    }
+
+    std::map<TSK_INUM_T, NTFS_PAR_MAP> *tmpParentMap = getParentMap(a_ntfs);
+    for (size_t i = 0; i < a_count; i++) {
+        NTFS_PAR_MAP &tmpParMap = (*tmpParentMap)[a_ents[i].par_addr];
+        tmpParMap.add(a_ents[i].par_seq, a_ents[i].addr, a_ents[i].seq,
+            a_ents[i].hash);
+    }
+    a_ntfs->alloc_file_count = a_alloc_file_count;
+    a_ntfs->orphan_map_done = 1;
     tsk_release_lock(&a_ntfs->orphan_map_lock);
+    return 0;
 }
 
 
@@ -1234,6 +1341,7 @@ ntfs_dir_open_meta(TSK_FS_INFO * a_fs, TSK_FS_DIR ** a_fs_dir,
             tsk_release_lock(&ntfs->orphan_map_lock);
             return TSK_ERR;
         }
+        ntfs->orphan_map_done = 1;
     }
 
     
@@ -49,6 +49,7 @@ extern "C" {
 
     typedef struct TSK_FS_INFO TSK_FS_INFO;
     typedef struct TSK_FS_FILE TSK_FS_FILE;
+    typedef struct TSK_FS_CACHE TSK_FS_CACHE;
 
 
 
@@ -117,6 +118,28 @@ extern "C" {
     typedef TSK_WALK_RET_ENUM(*TSK_FS_BLOCK_WALK_CB) (const TSK_FS_BLOCK *
         a_block, void *a_ptr);
 
+    /**
+    * Consecutive file system blocks that have the same flags.  Used by 
+    * tsk_fs_block_extent_walk().
+    */
+    typedef struct {
+        TSK_FS_INFO *fs_info;   ///< Pointer to file system that the blocks are from
+        TSK_DADDR_T addr;       ///< Address of first block
+        TSK_DADDR_T len;        ///< Number of blocks
+        TSK_FS_BLOCK_FLAG_ENUM flags;   ///< Flags of the blocks (alloc or unalloc etc.)
+        char *buf;              ///< Buffer with the content of the blocks (len * TSK_FS_INFO::block_size bytes) or NULL if the walk has the AONLY flag
+    } TSK_FS_BLOCK_EXTENT;
+
+    /**
+    * Function definition used for callback to tsk_fs_block_extent_walk().
+    *
+    * @param a_extent Pointer to extent structure that holds block addresses, content and flags
+    * @param a_ptr Pointer that was supplied by the caller who called tsk_fs_block_extent_walk
+    * @returns Value to identify if walk should continue, stop, or stop because of error
+    */
+    typedef TSK_WALK_RET_ENUM(*TSK_FS_BLOCK_EXTENT_WALK_CB) (const
+        TSK_FS_BLOCK_EXTENT * a_extent, void *a_ptr);
+
 
     // external block-level functions
     extern void tsk_fs_block_free(TSK_FS_BLOCK * a_fs_block);
@@ -129,6 +152,10 @@ extern "C" {
         TSK_DADDR_T a_start_blk, TSK_DADDR_T a_end_blk,
         TSK_FS_BLOCK_WALK_FLAG_ENUM a_flags, TSK_FS_BLOCK_WALK_CB a_action,
         void *a_ptr);
+    extern uint8_t tsk_fs_block_extent_walk(TSK_FS_INFO * a_fs,
+        TSK_DADDR_T a_start_blk, TSK_DADDR_T a_end_blk,
+        TSK_FS_BLOCK_WALK_FLAG_ENUM a_flags,
+        TSK_FS_BLOCK_EXTENT_WALK_CB a_action, void *a_ptr);
 
     //@}
 
@@ -251,6 +278,7 @@ extern "C" {
 #define TSK_FS_ATTR_ID_DEFAULT  0       ///< Default Data ID used if file system does not assign one.
 
     typedef struct TSK_FS_ATTR TSK_FS_ATTR;
+    typedef struct TSK_FS_ATTR_RUN_IDX TSK_FS_ATTR_RUN_IDX;
     /**
     * Holds information about the location of file content (or a file attribute). For most file systems, a file
     * has only a single attribute that stores the file content.
@@ -309,6 +337,9 @@ extern "C" {
             TSK_OFF_T a_offset, char *a_buf, size_t a_len);
          uint8_t(*w) (const TSK_FS_ATTR * fs_attr,
             int flags, TSK_FS_FILE_WALK_CB, void *);
+        void *r_cache;          ///< \internal State that the special read function keeps between calls, such as decompressed data (NULL if none) (r/w shared - created under attr_run_idx_lock, read without it)
+        void (*r_cache_free) (void *);  ///< \internal Function that frees r_cache
+        TSK_FS_ATTR_RUN_IDX *run_idx;   ///< \internal Sorted index of the runs in nrd that tsk_fs_attr_read() builds for long run lists (NULL if not built) (r/w shared - built under attr_run_idx_lock, read without it)
     };
 
 
@@ -533,6 +564,22 @@ extern "C" {
         TSK_INUM_T a_end, TSK_FS_META_FLAG_ENUM a_flags,
         TSK_FS_META_WALK_CB a_cb, void *a_ptr);
 
+    /**
+    * Flags that are used to specify how tsk_fs_meta_walk_parallel() calls
+    * the callback.
+    */
+    enum TSK_FS_META_WALK_PARALLEL_ENUM {
+        TSK_FS_META_WALK_PARALLEL_DEFAULT = 0x00,       ///< Call the callback concurrently from the worker threads
+        TSK_FS_META_WALK_PARALLEL_ORDERED = 0x01,       ///< Call the callback from the calling thread in metadata address order
+    };
+    typedef enum TSK_FS_META_WALK_PARALLEL_ENUM TSK_FS_META_WALK_PARALLEL_ENUM;
+
+    extern uint8_t tsk_fs_meta_walk_parallel(TSK_FS_INFO * a_fs,
+        TSK_INUM_T a_start, TSK_INUM_T a_end,
+        TSK_FS_META_FLAG_ENUM a_flags, unsigned int a_threads,
+        TSK_FS_META_WALK_PARALLEL_ENUM a_pflags, TSK_FS_META_WALK_CB a_cb,
+        void *a_ptr);
+
     extern uint8_t tsk_fs_meta_make_ls(const TSK_FS_META * a_fs_meta,
         char *a_buf, size_t a_len);
 
@@ -618,6 +665,7 @@ extern "C" {
 
 
 #define TSK_FS_DIR_TAG  0x57531246
+    typedef struct TSK_FS_DIR_IDX TSK_FS_DIR_IDX;
     /**
     * A handle to a directory so that its files can be individually accessed.
     */
@@ -634,6 +682,8 @@ extern "C" {
         uint32_t seq;           ///< Metadata address sequence (NTFS Only)
 
         TSK_FS_INFO *fs_info;   ///< Pointer to file system the directory is located in
+
+        TSK_FS_DIR_IDX *name_idx;       ///< \internal Hash index of names by (meta_addr, name) used to find duplicates (NULL for small directories)
     } TSK_FS_DIR;
 
     /**
@@ -661,6 +711,28 @@ extern "C" {
     extern const TSK_FS_NAME *tsk_fs_dir_get_name(const TSK_FS_DIR * a_fs_dir, size_t a_idx);
     extern void tsk_fs_dir_close(TSK_FS_DIR *);
 
+    /**
+    * Order that tsk_fs_dir_iter_next() returns the files of sub-directories in.
+    */
+    typedef enum {
+        TSK_FS_DIR_ITER_ORDER_DEPTH = 0x00,     ///< Depth first (same order as tsk_fs_dir_walk())
+        TSK_FS_DIR_ITER_ORDER_BREADTH = 0x01,   ///< Breadth first (all files in a directory before the files of its sub-directories)
+    } TSK_FS_DIR_ITER_ORDER_ENUM;
+
+    typedef struct TSK_FS_DIR_ITER TSK_FS_DIR_ITER;
+
+    extern TSK_FS_DIR_ITER *tsk_fs_dir_iter_open(TSK_FS_INFO * a_fs,
+        TSK_INUM_T a_addr, TSK_FS_DIR_WALK_FLAG_ENUM a_flags,
+        TSK_FS_DIR_ITER_ORDER_ENUM a_order);
+    extern uint8_t tsk_fs_dir_iter_next(TSK_FS_DIR_ITER * a_iter,
+        TSK_FS_FILE ** a_fs_file, const char **a_path);
+    extern void tsk_fs_dir_iter_skip(TSK_FS_DIR_ITER * a_iter);
+    extern uint8_t tsk_fs_dir_iter_checkpoint(TSK_FS_DIR_ITER * a_iter,
+        uint8_t ** a_buf, size_t * a_len);
+    extern TSK_FS_DIR_ITER *tsk_fs_dir_iter_resume(TSK_FS_INFO * a_fs,
+        const uint8_t * a_buf, size_t a_len);
+    extern void tsk_fs_dir_iter_close(TSK_FS_DIR_ITER * a_iter);
+
     extern int8_t tsk_fs_path2inum(TSK_FS_INFO * a_fs, const char *a_path,
         TSK_INUM_T * a_result, TSK_FS_NAME * a_fs_name);
 
@@ -989,6 +1061,13 @@ extern "C" {
         void (*close) (TSK_FS_INFO * fs);       ///< FS-specific function: Call tsk_fs_close() instead.
 
          uint8_t(*fread_owner_sid) (TSK_FS_FILE *, char **);    // FS-specific function. Call tsk_fs_file_get_owner_sid() instead.
+
+         TSK_DADDR_T(*block_getflags_run) (TSK_FS_INFO * a_fs, TSK_DADDR_T a_addr, TSK_DADDR_T a_last, TSK_FS_BLOCK_FLAG_ENUM * a_flags);    ///< \internal Optional: Get the flags of a_addr and the number of blocks from a_addr to a_last that have them (0 on error).  Only set if block_walk uses the same flags. 
+
+        TSK_FS_CACHE *cache;    ///< \internal State of the sidecar cache file (NULL if it is not being used)
+
+        /* attr_run_idx_lock serializes the creation of TSK_FS_ATTR::run_idx and TSK_FS_ATTR::r_cache for the attributes of files in this fs.  Both are published with tsk_atomic_store_ptr() and are read without the lock. */
+        tsk_lock_t attr_run_idx_lock;   // taken only when building a run index or read cache
     };
 
 
@@ -998,6 +1077,7 @@ extern "C" {
     extern TSK_FS_INFO *tsk_fs_open_vol(const TSK_VS_PART_INFO *,
         TSK_FS_TYPE_ENUM);
     extern void tsk_fs_close(TSK_FS_INFO *);
+    extern uint8_t tsk_fs_cache_set_dir(const TSK_TCHAR * a_dir);
 
     extern TSK_FS_TYPE_ENUM tsk_fs_type_toid_utf8(const char *);
     extern TSK_FS_TYPE_ENUM tsk_fs_type_toid(const TSK_TCHAR *);
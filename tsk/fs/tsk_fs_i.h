@@ -84,6 +84,8 @@ extern "C" {
     extern TSK_FS_BLOCK *tsk_fs_block_alloc(TSK_FS_INFO * fs);
     extern int tsk_fs_block_set(TSK_FS_INFO * fs, TSK_FS_BLOCK * fs_block,
         TSK_DADDR_T a_addr, TSK_FS_BLOCK_FLAG_ENUM a_flags, char *a_buf);
+    extern size_t tsk_fs_bitmap_run(const uint8_t * a_map, size_t a_start,
+        size_t a_end);
 
     /* FS_DATA */
     extern TSK_FS_ATTR *tsk_fs_attr_alloc(TSK_FS_ATTR_FLAG_ENUM);
@@ -154,6 +156,23 @@ extern "C" {
     extern TSK_RETVAL_ENUM tsk_fs_dir_find_orphans(TSK_FS_INFO * a_fs,
         TSK_FS_DIR * a_fs_dir);
 
+    /* Sidecar cache of the orphan data */
+    extern void tsk_fs_cache_open(TSK_FS_INFO * a_fs);
+    extern void tsk_fs_cache_save(TSK_FS_INFO * a_fs);
+
+    /* Per-thread pools of freed structures */
+    typedef enum {
+        TSK_FS_POOL_FILE = 0,   ///< TSK_FS_FILE
+        TSK_FS_POOL_META,       ///< TSK_FS_META (keeps content_ptr)
+        TSK_FS_POOL_NAME,       ///< TSK_FS_NAME (keeps name and shrt_name)
+        TSK_FS_POOL_ATTRLIST,   ///< TSK_FS_ATTRLIST
+        TSK_FS_POOL_ATTR,       ///< TSK_FS_ATTR (keeps name and rd.buf)
+        TSK_FS_POOL_RUN,        ///< TSK_FS_ATTR_RUN
+        TSK_FS_POOL_MAX
+    } TSK_FS_POOL_ENUM;
+    extern void *tsk_fs_pool_get(TSK_FS_POOL_ENUM a_type);
+    extern void tsk_fs_pool_put(TSK_FS_POOL_ENUM a_type, void *a_ptr);
+
     /* FS_DENT */
     extern TSK_FS_NAME *tsk_fs_name_alloc(size_t, size_t);
     extern uint8_t tsk_fs_name_realloc(TSK_FS_NAME *, size_t);
@@ -637,6 +637,39 @@ typedef union {
     hfs_file file;
 } hfs_file_folder;
 
+/* Number of catalog and extents B-tree nodes kept in the node cache */
+#define HFS_BT_NODE_CACHE_NUM   64
+
+/* Values for HFS_BT_NODE_CACHE_ENT.tree */
+#define HFS_BT_CACHE_UNUSED     0
+#define HFS_BT_CACHE_CATALOG    1
+#define HFS_BT_CACHE_EXTENTS    2
+
+/* Cached copy of a B-tree node */
+typedef struct {
+    uint8_t tree;               ///< Tree the node came from (HFS_BT_CACHE_*)
+    uint32_t node;              ///< Node number in the tree
+    uint32_t stamp;             ///< Last use, for LRU replacement
+    uint16_t len;               ///< Size of the data buffer
+    char *data;                 ///< Node contents
+} HFS_BT_NODE_CACHE_ENT;
+
+/* Location of the thread and file/folder records for a CNID, in the form of
+ * a catalog node and the byte offset of the record data in that node.
+ * A node of 0 (the header node) means that the record was not seen. */
+typedef struct {
+    uint32_t thread_node;
+    uint32_t rec_node;
+    uint16_t thread_off;
+    uint16_t rec_off;
+} HFS_CAT_IDX_ENT;
+
+/* Largest number of CNIDs that the catalog index will cover */
+#define HFS_CAT_IDX_MAX         (1 << 22)
+
+/* Number of catalog lookups after which the catalog index is built */
+#define HFS_CAT_IDX_LOOKUPS     1024
+
 typedef struct {
     TSK_FS_INFO fs_info;        /* SUPER CLASS */
 
@@ -682,6 +715,15 @@ typedef struct {
     // and will also use this to protect the rest of the HFS_INFO struct.
     tsk_lock_t metadata_dir_cache_lock;
 
+    /* btree_cache_lock protects node_cache, node_cache_stamp, cat_idx, cat_idx_cnt, cat_idx_state and cat_lookup_cnt */
+    tsk_lock_t btree_cache_lock;
+    HFS_BT_NODE_CACHE_ENT node_cache[HFS_BT_NODE_CACHE_NUM];    ///< Recently read catalog and extents nodes
+    uint32_t node_cache_stamp;  ///< Counter used to age node_cache entries
+    HFS_CAT_IDX_ENT *cat_idx;   ///< CNID to catalog record index (NULL until built; read-only once set)
+    uint32_t cat_idx_cnt;       ///< Number of entries in cat_idx
+    uint8_t cat_idx_state;      ///< 0 = not built, 1 = being built, 2 = built or failed
+    uint32_t cat_lookup_cnt;    ///< Number of catalog lookups done without the index
+
     // These special files are optional.
     unsigned char has_extents_file;     // and also the Bad Blocks file
     unsigned char has_startup_file;
@@ -727,6 +727,7 @@ extern "C" {
         /* orphan_map_lock protects orphan_map */
         tsk_lock_t orphan_map_lock;
         void *orphan_map;       // map that lists par directory to its orphans. (r/w shared - lock)
+        uint8_t orphan_map_done;        // set once orphan_map has all of the MFT entries (r/w shared - lock)
 
 #if TSK_USE_SID
         /* sid_lock protects sii_data, sds_data */
@@ -754,6 +755,25 @@ extern "C" {
 
     extern void ntfs_orphan_map_free(NTFS_INFO * a_ntfs);
 
+    /** \internal
+     * One parent and child pair of the orphan map, in the form that it is
+     * saved to the sidecar cache.
+     */
+    typedef struct {
+        uint64_t par_addr;      // Address of the parent directory
+        uint64_t addr;          // Address of the child
+        uint32_t par_seq;       // Sequence of the parent that the child was in
+        uint32_t seq;           // Sequence of the child
+        uint32_t hash;          // Hash of the child name (tsk_fs_dir_hash())
+        uint32_t pad;
+    } NTFS_PAR_MAP_ENT;
+
+    extern uint8_t ntfs_parent_map_export(NTFS_INFO * a_ntfs,
+        NTFS_PAR_MAP_ENT ** a_ents, size_t * a_count);
+    extern uint8_t ntfs_parent_map_import(NTFS_INFO * a_ntfs,
+        const NTFS_PAR_MAP_ENT * a_ents, size_t a_count,
+        int a_alloc_file_count);
+
     extern int ntfs_name_cmp(TSK_FS_INFO *, const char *, const char *);
 
     extern uint8_t ntfs_find_file(TSK_FS_INFO * fs, TSK_INUM_T inode_toid,
@@ -11,6 +11,9 @@
 #include "tsk_hashdb_i.h"
 #include "tsk_hash_info.h"
 
+#include <algorithm>
+#include <vector>
+
 /**
 * \file binsrch_index.cpp
 * Functions common to all text hash databases (i.e. NSRL, HashKeeper, EnCase, etc.).
@@ -29,6 +32,36 @@ static const uint64_t IDX_IDX_ENTRY_NOT_SET = 0xFFFFFFFFFFFFFFFFUL;
 static const uint64_t IDX_IDX_ENTRY_NOT_SET = 0xFFFFFFFFFFFFFFFFULL;
 #endif
 
+// A binary copy of the sorted index is also created next to the text index
+// (the .bidx file). It is memory mapped when the index is opened, so that 
+// lookups are done without seeking and parsing lines in the text index.
+// Layout: BIDX_HEAD, then BIDX_PREFIX_COUNT + 1 entry numbers that map the
+// first two bytes of a hash to its set of entries, then the sorted entries.
+// Each entry is the binary hash followed by its offset in the database. 
+// Values are in the byte order of the system that made the file; the
+// file is ignored if the order does not match, and it is made again if it
+// is out of date with the text index.
+static const char BIDX_MAGIC[8] = { 'T', 'S', 'K', 'B', 'I', 'D', 'X', '2' };
+static const uint32_t BIDX_BYTE_ORDER = 0x01020304;
+static const size_t BIDX_PREFIX_COUNT = 65536;
+
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;        // BIDX_BYTE_ORDER
+    uint32_t hash_bytes;        // Size of the binary hashes
+    uint64_t count;             // Number of entries
+    uint64_t idx_size;          // Size of the text index that this was made from
+    int64_t idx_mtime;          // Modification time of the text index
+    uint8_t idx_sig[16];        // MD5 of the start and end of the text index (see hdb_binsrch_idx_sig())
+} BIDX_HEAD;
+
+// Number of bytes at the start and at the end of the text index that go
+// into BIDX_HEAD.idx_sig
+static const size_t BIDX_SIG_LEN = 4096;
+
+static const size_t BIDX_TABLE_OFF = sizeof(BIDX_HEAD);
+static const size_t BIDX_ENTRIES_OFF = sizeof(BIDX_HEAD) + (BIDX_PREFIX_COUNT + 1) * sizeof(uint64_t);
+
 
 /**
  * Called by the various text-based databases to setup the TSK_HDB_BINSRCH_INFO struct.
@@ -57,6 +90,7 @@ TSK_HDB_BINSRCH_INFO *hdb_binsrch_open(FILE *hDb, const TSK_TCHAR *db_path)
     hdb_binsrch_info->base.lookup_str = hdb_binsrch_lookup_str;
     hdb_binsrch_info->base.lookup_raw = hdb_binsrch_lookup_bin;
     hdb_binsrch_info->base.lookup_verbose_str = hdb_binsrch_lookup_verbose_str;
+    hdb_binsrch_info->base.lookup_batch = hdb_binsrch_lookup_batch;
     hdb_binsrch_info->base.accepts_updates = hdb_binsrch_accepts_updates;
     hdb_binsrch_info->base.close_db = hdb_binsrch_close;
 
@@ -105,6 +139,13 @@ static uint8_t
         return 1;
     }
 
+    /* Make the name for the binary index file */
+    hdb_binsrch_info->bidx_fname =
+        (TSK_TCHAR *) tsk_malloc(flen * sizeof(TSK_TCHAR));
+    if (hdb_binsrch_info->bidx_fname == NULL) {
+        return 1;
+    }
+
     /* Set hash type specific information */
     switch (htype) {
     case TSK_HDB_HTYPE_MD5_ID:
@@ -116,6 +157,9 @@ static uint8_t
         TSNPRINTF(hdb_binsrch_info->idx_idx_fname, flen,
             _TSK_T("%s-%") PRIcTSK _TSK_T(".idx2"),
             hdb_binsrch_info->base.db_fname, TSK_HDB_HTYPE_MD5_STR);
+        TSNPRINTF(hdb_binsrch_info->bidx_fname, flen,
+            _TSK_T("%s-%") PRIcTSK _TSK_T(".bidx"),
+            hdb_binsrch_info->base.db_fname, TSK_HDB_HTYPE_MD5_STR);
         return 0;
     case TSK_HDB_HTYPE_SHA1_ID:
         hdb_binsrch_info->hash_type = htype;
@@ -126,6 +170,9 @@ static uint8_t
         TSNPRINTF(hdb_binsrch_info->idx_idx_fname, flen,
             _TSK_T("%s-%") PRIcTSK _TSK_T(".idx2"),
             hdb_binsrch_info->base.db_fname, TSK_HDB_HTYPE_SHA1_STR);
+        TSNPRINTF(hdb_binsrch_info->bidx_fname, flen,
+            _TSK_T("%s-%") PRIcTSK _TSK_T(".bidx"),
+            hdb_binsrch_info->base.db_fname, TSK_HDB_HTYPE_SHA1_STR);
         return 0;
 
         // listed to prevent compiler warnings
@@ -282,6 +329,236 @@ static uint8_t
     return 0;
 }
 
+/** \internal
+* Unmap the binary index, if it is mapped.
+*/
+static void
+    hdb_binsrch_unmap_bin_idx(TSK_HDB_BINSRCH_INFO *hdb_binsrch_info)
+{
+    if (hdb_binsrch_info->bidx_map == NULL) {
+        return;
+    }
+#ifdef TSK_WIN32
+    UnmapViewOfFile(hdb_binsrch_info->bidx_map);
+    CloseHandle((HANDLE) hdb_binsrch_info->bidx_map_handle);
+    hdb_binsrch_info->bidx_map_handle = NULL;
+#else
+    munmap(hdb_binsrch_info->bidx_map, hdb_binsrch_info->bidx_map_size);
+#endif
+    hdb_binsrch_info->bidx_map = NULL;
+    hdb_binsrch_info->bidx_map_size = 0;
+}
+
+/** \internal
+* Get the values that the binary index uses to tell if it was made from the
+* open text index: its modification time and an MD5 of its first and last
+* BIDX_SIG_LEN bytes.  A text index that is made again with the same 
+* number of lines has different values.
+*
+* @param hdb_binsrch_info Hash database with the text index open
+* @param a_mtime [out] Modification time of the text index
+* @param a_sig [out] MD5 of the start and end of the text index
+* @return 1 on error and 0 on success
+*/
+static uint8_t
+    hdb_binsrch_idx_sig(TSK_HDB_BINSRCH_INFO *hdb_binsrch_info, int64_t *a_mtime,
+    uint8_t a_sig[16])
+{
+    struct STAT_STR sb;
+    if (TSTAT(hdb_binsrch_info->idx_fname, &sb) < 0) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_HDB_MISSING);
+        tsk_error_set_errstr("hdb_binsrch_idx_sig: Error finding index file: %" PRIttocTSK,
+            hdb_binsrch_info->idx_fname);
+        return 1;
+    }
+    *a_mtime = (int64_t) sb.st_mtime;
+
+    TSK_OFF_T offs[2];
+    offs[0] = 0;
+    offs[1] = (hdb_binsrch_info->idx_size > (TSK_OFF_T) BIDX_SIG_LEN) ?
+        hdb_binsrch_info->idx_size - BIDX_SIG_LEN : 0;
+
+    char buf[BIDX_SIG_LEN];
+    TSK_MD5_CTX md5;
+    TSK_MD5_Init(&md5);
+    for (int i = 0; i < 2; i++) {
+        size_t len = BIDX_SIG_LEN;
+        if (hdb_binsrch_info->idx_size - offs[i] < (TSK_OFF_T) len) {
+            len = (size_t) (hdb_binsrch_info->idx_size - offs[i]);
+        }
+        if ((0 != fseeko(hdb_binsrch_info->hIdx, offs[i], SEEK_SET))
+            || (len != fread(buf, 1, len, hdb_binsrch_info->hIdx))) {
+                tsk_error_reset();
+                tsk_error_set_errno(TSK_ERR_HDB_READIDX);
+                tsk_error_set_errstr("hdb_binsrch_idx_sig: Error reading index file: %" PRIttocTSK,
+                    hdb_binsrch_info->idx_fname);
+                return 1;
+        }
+        TSK_MD5_Update(&md5, (unsigned char *) buf, (unsigned int) len);
+    }
+    TSK_MD5_Final(a_sig, &md5);
+    return 0;
+}
+
+static uint8_t
+    hdb_binsrch_make_bin_idx(TSK_HDB_BINSRCH_INFO *hdb_binsrch_info);
+
+/** \internal
+* Memory map the binary index, if there is one that matches the open text
+* index.  A missing binary index is not an error; lookups will use the text
+* index.  An out of date one is made again, if that is allowed.
+*
+* @param hdb_binsrch_info Hash database with the text index open
+* @param a_rebuild 1 to make the binary index again if it is out of date
+* @return 1 on error and 0 on success
+*/
+static uint8_t
+    hdb_binsrch_map_bin_idx(TSK_HDB_BINSRCH_INFO *hdb_binsrch_info, uint8_t a_rebuild)
+{
+    const char *func_name = "hdb_binsrch_map_bin_idx";
+    uint8_t *map = NULL;
+    uint64_t map_size = 0;
+
+    if ((hdb_binsrch_info->bidx_map != NULL) || (hdb_binsrch_info->bidx_fname == NULL)) {
+        return 0;
+    }
+
+#ifdef TSK_WIN32
+    {
+        HANDLE hWin;
+        HANDLE hMap;
+        DWORD szLow, szHi;
+
+        if (-1 == GetFileAttributes(hdb_binsrch_info->bidx_fname)) {
+            // The file does not exist. Not a problem.
+            return 0;
+        }
+
+        if ((hWin = CreateFile(hdb_binsrch_info->bidx_fname, GENERIC_READ,
+            FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0)) == INVALID_HANDLE_VALUE) {
+                tsk_error_reset();
+                tsk_error_set_errno(TSK_ERR_HDB_OPEN);
+                tsk_error_set_errstr(
+                    "%s: error opening binary index: %" PRIttocTSK" - %d",
+                    func_name, hdb_binsrch_info->bidx_fname, (int)GetLastError());
+                return 1;
+        }
+
+        szLow = GetFileSize(hWin, &szHi);
+        map_size = szLow | ((uint64_t) szHi << 32);
+        if ((szLow == 0xffffffff) || (map_size < BIDX_ENTRIES_OFF)) {
+            CloseHandle(hWin);
+            return 0;
+        }
+
+        hMap = CreateFileMapping(hWin, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(hWin);
+        if (hMap == NULL) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_HDB_OPEN);
+            tsk_error_set_errstr(
+                "%s: error mapping binary index: %" PRIttocTSK" - %d",
+                func_name, hdb_binsrch_info->bidx_fname, (int)GetLastError());
+            return 1;
+        }
+
+        if ((map = (uint8_t *) MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0)) == NULL) {
+            CloseHandle(hMap);
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_HDB_OPEN);
+            tsk_error_set_errstr(
+                "%s: error mapping view of binary index: %" PRIttocTSK" - %d",
+                func_name, hdb_binsrch_info->bidx_fname, (int)GetLastError());
+            return 1;
+        }
+        hdb_binsrch_info->bidx_map_handle = hMap;
+    }
+#else
+    {
+        struct stat sb;
+        int fd;
+
+        if (stat(hdb_binsrch_info->bidx_fname, &sb) < 0) {
+            // The file does not exist. Not a problem.
+            return 0;
+        }
+        map_size = sb.st_size;
+        if ((map_size < BIDX_ENTRIES_OFF) || (map_size != (size_t) map_size)) {
+            return 0;
+        }
+
+        if ((fd = open(hdb_binsrch_info->bidx_fname, O_RDONLY)) < 0) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_HDB_OPEN);
+            tsk_error_set_errstr(
+                "%s: error opening binary index: %s",
+                func_name, hdb_binsrch_info->bidx_fname);
+            return 1;
+        }
+
+        map = (uint8_t *) mmap(NULL, (size_t) map_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_HDB_OPEN);
+            tsk_error_set_errstr(
+                "%s: error mapping binary index: %s",
+                func_name, hdb_binsrch_info->bidx_fname);
+            return 1;
+        }
+#ifdef MADV_RANDOM
+        madvise(map, (size_t) map_size, MADV_RANDOM);
+#endif
+    }
+#endif
+
+    hdb_binsrch_info->bidx_map = map;
+    hdb_binsrch_info->bidx_map_size = (size_t) map_size;
+
+    // Only use it if it was made from the current text index
+    const BIDX_HEAD *head = (const BIDX_HEAD *) map;
+    size_t ent_len = hdb_binsrch_info->hash_len / 2 + sizeof(uint64_t);
+    uint64_t count = 0;
+    if (hdb_binsrch_info->idx_llen > 0) {
+        count = (hdb_binsrch_info->idx_size - hdb_binsrch_info->idx_off) / hdb_binsrch_info->idx_llen;
+    }
+    int64_t idx_mtime;
+    uint8_t idx_sig[16];
+    if (hdb_binsrch_idx_sig(hdb_binsrch_info, &idx_mtime, idx_sig)) {
+        hdb_binsrch_unmap_bin_idx(hdb_binsrch_info);
+        return 1;
+    }
+    if ((memcmp(head->magic, BIDX_MAGIC, sizeof(BIDX_MAGIC)) == 0)
+        && (head->byte_order == BIDX_BYTE_ORDER)
+        && (head->hash_bytes == (uint32_t) (hdb_binsrch_info->hash_len / 2))
+        && (head->idx_size == (uint64_t) hdb_binsrch_info->idx_size)
+        && (head->idx_mtime == idx_mtime)
+        && (memcmp(head->idx_sig, idx_sig, sizeof(idx_sig)) == 0)
+        && (head->count == count)
+        && (map_size == BIDX_ENTRIES_OFF + count * ent_len)) {
+            return 0;
+    }
+
+    hdb_binsrch_unmap_bin_idx(hdb_binsrch_info);
+    if (a_rebuild == 0) {
+        if (tsk_verbose)
+            tsk_fprintf(stderr, "%s: ignoring out of date binary index\n", func_name);
+        return 0;
+    }
+
+    if (tsk_verbose)
+        tsk_fprintf(stderr, "%s: making out of date binary index again\n", func_name);
+    if (hdb_binsrch_make_bin_idx(hdb_binsrch_info)) {
+        // the text index can still be used (the directory may be read-only)
+        if (tsk_verbose)
+            tsk_error_print(stderr);
+        tsk_error_reset();
+        return 0;
+    }
+    return hdb_binsrch_map_bin_idx(hdb_binsrch_info, 0);
+}
+
 /** \internal
 * Setup the internal variables to read an index. This
 * opens the index and sets the needed size information.
@@ -591,6 +868,12 @@ uint8_t
         return 1;
     }
 
+    /* Map the binary copy of the index into memory, if there is one. */
+    if (hdb_binsrch_map_bin_idx(hdb_binsrch_info, 1)) {
+        tsk_release_lock(&hdb_binsrch_info->base.lock);
+        return 1;
+    }
+
     tsk_release_lock(&hdb_binsrch_info->base.lock);
 
     return 0;
@@ -939,6 +1222,177 @@ static uint8_t
     return ret_val;
 }
 
+/** \internal
+* Convert a hex digit to its value.
+* @return Value or -1 if it is not a hex digit
+*/
+static int
+    hdb_binsrch_hex_val(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    else if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    else if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    return -1;
+}
+
+/** \internal
+* Convert a hex hash to binary.
+* @return 1 if the string is not valid hex and 0 on success
+*/
+static uint8_t
+    hdb_binsrch_hex_to_bin(const char *hex, size_t hex_len, uint8_t *bin)
+{
+    for (size_t i = 0; i < hex_len / 2; i++) {
+        int hi = hdb_binsrch_hex_val(hex[2 * i]);
+        int lo = hdb_binsrch_hex_val(hex[2 * i + 1]);
+        if ((hi < 0) || (lo < 0))
+            return 1;
+        bin[i] = (uint8_t) ((hi << 4) | lo);
+    }
+    return 0;
+}
+
+/** \internal
+* Create the binary copy of the sorted text index (see BIDX_HEAD).  
+* The text index must be open.
+*
+* @param hdb_binsrch_info Hash database state info structure.
+* @return 1 on error and 0 on success
+*/
+static uint8_t
+    hdb_binsrch_make_bin_idx(TSK_HDB_BINSRCH_INFO *hdb_binsrch_info)
+{
+    const char *func_name = "hdb_binsrch_make_bin_idx";
+    FILE *bidx_file = NULL;
+
+    if ((hdb_binsrch_info->hIdx == NULL) || (hdb_binsrch_info->bidx_fname == NULL)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_HDB_ARG);
+        tsk_error_set_errstr("%s: index is not open", func_name);
+        return 1;
+    }
+
+#ifdef TSK_WIN32
+    {
+        HANDLE hWin;
+        if ((hWin = CreateFile(hdb_binsrch_info->bidx_fname, GENERIC_WRITE,
+            0, 0, CREATE_ALWAYS, 0, 0)) == INVALID_HANDLE_VALUE) {
+                int winErrNo = (int)GetLastError();
+                tsk_error_reset();
+                tsk_error_set_errno(TSK_ERR_HDB_CREATE);
+                tsk_error_set_errstr(
+                    "%s: error creating binary index file %" PRIttocTSK" - %d)",
+                    func_name, hdb_binsrch_info->bidx_fname, winErrNo);
+                return 1;
+        }
+
+        bidx_file =
+            _fdopen(_open_osfhandle((intptr_t) hWin, _O_WRONLY), "wb");
+        if (bidx_file == NULL) {
+            tsk_error_reset();
+            tsk_error_set_errno(TSK_ERR_HDB_OPEN);
+            tsk_error_set_errstr(
+                "%s: error converting file handle from Windows to C for: %" PRIttocTSK, 
+                func_name, hdb_binsrch_info->bidx_fname);
+            return 1;
+        }
+    }
+#else
+    if (NULL == (bidx_file = fopen(hdb_binsrch_info->bidx_fname, "wb"))) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_HDB_CREATE);
+        tsk_error_set_errstr(
+            "%s: error creating binary index file %" PRIttocTSK,
+            func_name, hdb_binsrch_info->bidx_fname);
+        return 1;
+    }
+#endif
+
+    uint64_t *prefix_table = (uint64_t *) tsk_malloc((BIDX_PREFIX_COUNT + 1) * sizeof(uint64_t));
+    if (prefix_table == NULL) {
+        fclose(bidx_file);
+        return 1;
+    }
+
+    BIDX_HEAD head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, BIDX_MAGIC, sizeof(BIDX_MAGIC));
+    head.byte_order = BIDX_BYTE_ORDER;
+    head.hash_bytes = hdb_binsrch_info->hash_len / 2;
+    head.idx_size = hdb_binsrch_info->idx_size;
+    if (hdb_binsrch_idx_sig(hdb_binsrch_info, &head.idx_mtime, head.idx_sig)) {
+        free(prefix_table);
+        fclose(bidx_file);
+        return 1;
+    }
+
+    // The header and table are written again at the end, once the counts
+    // are known.
+    uint8_t ret_val = 0;
+    if ((1 != fwrite(&head, sizeof(head), 1, bidx_file))
+        || (1 != fwrite(prefix_table, (BIDX_PREFIX_COUNT + 1) * sizeof(uint64_t), 1, bidx_file))) {
+            ret_val = 1;
+    }
+
+    if ((ret_val == 0) && (0 != fseeko(hdb_binsrch_info->hIdx, hdb_binsrch_info->idx_off, SEEK_SET))) {
+        ret_val = 1;
+    }
+
+    // Copy the entries and count the number with each prefix
+    uint8_t entry[TSK_HDB_HTYPE_SHA1_LEN / 2 + sizeof(uint64_t)];
+    size_t ent_len = head.hash_bytes + sizeof(uint64_t);
+    while ((ret_val == 0) &&
+        fgets(hdb_binsrch_info->idx_lbuf, (int)hdb_binsrch_info->idx_llen + 1, hdb_binsrch_info->hIdx)) {
+        if ((strlen(hdb_binsrch_info->idx_lbuf) < hdb_binsrch_info->idx_llen) ||
+            (hdb_binsrch_info->idx_lbuf[hdb_binsrch_info->hash_len] != '|') ||
+            hdb_binsrch_hex_to_bin(hdb_binsrch_info->idx_lbuf, hdb_binsrch_info->hash_len, entry)) {
+                tsk_error_reset();
+                tsk_error_set_errno(TSK_ERR_HDB_CORRUPT);
+                tsk_error_set_errstr("%s: Invalid line in index file: %s",
+                    func_name, hdb_binsrch_info->idx_lbuf);
+                free(prefix_table);
+                fclose(bidx_file);
+                return 1;
+        }
+
+        uint64_t db_off = strtoull(&hdb_binsrch_info->idx_lbuf[hdb_binsrch_info->hash_len + 1], NULL, 10);
+        memcpy(&entry[head.hash_bytes], &db_off, sizeof(db_off));
+        if (1 != fwrite(entry, ent_len, 1, bidx_file)) {
+            ret_val = 1;
+            break;
+        }
+
+        prefix_table[((entry[0] << 8) | entry[1]) + 1]++;
+        head.count++;
+    }
+
+    // Convert the counts to the number of the first entry with each prefix
+    for (size_t i = 1; i <= BIDX_PREFIX_COUNT; i++) {
+        prefix_table[i] += prefix_table[i - 1];
+    }
+
+    if ((ret_val == 0) &&
+        ((0 != fseeko(bidx_file, 0, SEEK_SET))
+        || (1 != fwrite(&head, sizeof(head), 1, bidx_file))
+        || (1 != fwrite(prefix_table, (BIDX_PREFIX_COUNT + 1) * sizeof(uint64_t), 1, bidx_file)))) {
+            ret_val = 1;
+    }
+    free(prefix_table);
+
+    if ((0 != fclose(bidx_file)) || (ret_val)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_HDB_WRITE);
+        tsk_error_set_errstr("%s: error writing binary index file %" PRIttocTSK,
+            func_name, hdb_binsrch_info->bidx_fname);
+        return 1;
+    }
+
+    return 0;
+}
+
 /**
 * Finalize index creation process by sorting the index and removing the
 * intermediate temp file.
@@ -963,6 +1417,7 @@ uint8_t
     hdb_binsrch_info->idx_llen = 0;
     free(hdb_binsrch_info->idx_lbuf);
     hdb_binsrch_info->idx_lbuf = NULL;
+    hdb_binsrch_unmap_bin_idx(hdb_binsrch_info);
 
     if (tsk_verbose)
         tsk_fprintf(stderr, "hdb_idxfinalize: Sorting index\n");
@@ -1075,9 +1530,113 @@ uint8_t
         return 1;
     }
 
+    // Make the binary copy of the index that is mapped for lookups
+    if (hdb_binsrch_make_bin_idx(hdb_binsrch_info)) {
+        tsk_error_set_errstr2(
+            "hdb_binsrch_idx_finalize: error creating binary index file");
+        return 1;
+    }
+
+    return hdb_binsrch_map_bin_idx(hdb_binsrch_info, 0);
+}
+
+/** \internal
+* Call the callback for each database entry of a hash value that was found
+* in the memory mapped binary index.
+*
+* @param hdb_binsrch_info Hash database with the binary index mapped
+* @param ent First binary index entry of the hash value
+* @param hash Binary hash value (hash_len / 2 bytes)
+* @param ucHash Upper case text version of the hash (for the callbacks)
+* @param flags Flags to use in lookup
+* @param action Callback function to call for each hash db entry 
+* @param ptr Pointer to data to pass to each callback
+*
+* @return 1 on error and 0 on success
+*/
+static uint8_t
+    hdb_binsrch_bin_idx_get_entries(TSK_HDB_BINSRCH_INFO *hdb_binsrch_info,
+    uint64_t ent, const uint8_t *hash, const char *ucHash,
+    TSK_HDB_FLAG_ENUM flags, TSK_HDB_LOOKUP_FN action, void *ptr)
+{
+    const uint8_t *map = hdb_binsrch_info->bidx_map;
+    const uint8_t *entries = map + BIDX_ENTRIES_OFF;
+    size_t hash_bytes = hdb_binsrch_info->hash_len / 2;
+    size_t ent_len = hash_bytes + sizeof(uint64_t);
+    uint64_t count = ((const BIDX_HEAD *) map)->count;
+
+    // the get_entry functions share the database handle
+    tsk_take_lock(&hdb_binsrch_info->base.lock);
+    for (; (ent < count) && (memcmp(&entries[ent * ent_len], hash, hash_bytes) == 0); ent++) {
+        uint64_t db_off;
+        memcpy(&db_off, &entries[ent * ent_len + hash_bytes], sizeof(db_off));
+        if (hdb_binsrch_info->get_entry(&hdb_binsrch_info->base, ucHash,
+            (TSK_OFF_T) db_off, flags, action, ptr)) {
+                tsk_release_lock(&hdb_binsrch_info->base.lock);
+                tsk_error_set_errstr2("hdb_lookup");
+                return 1;
+        }
+    }
+    tsk_release_lock(&hdb_binsrch_info->base.lock);
+
     return 0;
 }
 
+/** \internal
+* Search the memory mapped binary index for a hash value.  The first two
+* bytes of the hash select the range of entries and the range is binary
+* searched.
+*
+* @param hdb_binsrch_info Hash database with the binary index mapped
+* @param hash Binary hash value (hash_len / 2 bytes)
+* @param ucHash Upper case text version of the hash (for the callbacks)
+* @param flags Flags to use in lookup
+* @param action Callback function to call for each hash db entry 
+* (not called if QUICK flag is given)
+* @param ptr Pointer to data to pass to each callback
+*
+* @return -1 on error, 0 if hash value not found, and 1 if value was found.
+*/
+static int8_t
+    hdb_binsrch_bin_idx_lookup(TSK_HDB_BINSRCH_INFO *hdb_binsrch_info,
+    const uint8_t *hash, const char *ucHash, TSK_HDB_FLAG_ENUM flags,
+    TSK_HDB_LOOKUP_FN action, void *ptr)
+{
+    const uint8_t *map = hdb_binsrch_info->bidx_map;
+    const uint64_t *prefix_table = (const uint64_t *) (map + BIDX_TABLE_OFF);
+    const uint8_t *entries = map + BIDX_ENTRIES_OFF;
+    size_t hash_bytes = hdb_binsrch_info->hash_len / 2;
+    size_t ent_len = hash_bytes + sizeof(uint64_t);
+    size_t prefix = (hash[0] << 8) | hash[1];
+    uint64_t low = prefix_table[prefix];
+    uint64_t up = prefix_table[prefix + 1];
+
+    // find the first entry that is not smaller than the hash
+    while (low < up) {
+        uint64_t mid = low + (up - low) / 2;
+        if (memcmp(&entries[mid * ent_len], hash, hash_bytes) < 0)
+            low = mid + 1;
+        else
+            up = mid;
+    }
+
+    up = prefix_table[prefix + 1];
+    if ((low == up) || (memcmp(&entries[low * ent_len], hash, hash_bytes) != 0)) {
+        return 0;
+    }
+
+    if (flags & TSK_HDB_FLAG_QUICK) {
+        return 1;
+    }
+
+    if (hdb_binsrch_bin_idx_get_entries(hdb_binsrch_info, low, hash, ucHash,
+        flags, action, ptr)) {
+            return -1;
+    }
+
+    return 1;
+}
+
 /**
 * \ingroup hashdblib
 * Search the index for a text/ASCII hash value
@@ -1166,6 +1725,14 @@ int8_t
     }
     ucHash[strlen(hash)] = '\0';
 
+    // Use the memory mapped binary index if there is one
+    if (hdb_binsrch_info->bidx_map) {
+        uint8_t binHash[TSK_HDB_HTYPE_SHA1_LEN / 2];
+        hdb_binsrch_hex_to_bin(ucHash, hdb_binsrch_info->hash_len, binHash);
+        return hdb_binsrch_bin_idx_lookup(hdb_binsrch_info, binHash, ucHash,
+            flags, action, ptr);
+    }
+
     // Do a lookup in the index of the index file. The index of the index file is
     // a mapping of the first three digits of a hash to the offset in the index
     // file of the first index entry of the possibly empty set of index entries 
@@ -1501,9 +2068,11 @@ int8_t
     TSK_HDB_FLAG_ENUM flags,
     TSK_HDB_LOOKUP_FN action, void *ptr)
 {
+    TSK_HDB_BINSRCH_INFO *hdb_binsrch_info = (TSK_HDB_BINSRCH_INFO*)hdb_info; 
     char hashbuf[TSK_HDB_HTYPE_SHA1_LEN + 1];
     int i;
     static const char hex[] = "0123456789abcdef";
+    static const char uc_hex[] = "0123456789ABCDEF";
 
     if (2 * len > TSK_HDB_HTYPE_SHA1_LEN) {
         tsk_error_reset();
@@ -1513,6 +2082,24 @@ int8_t
         return -1;
     }
 
+    // Search the binary index directly, without converting to text and back
+    if ((2 * len == TSK_HDB_HTYPE_MD5_LEN) || (2 * len == TSK_HDB_HTYPE_SHA1_LEN)) {
+        if (hdb_binsrch_open_idx(hdb_info, (2 * len == TSK_HDB_HTYPE_MD5_LEN) ?
+            TSK_HDB_HTYPE_MD5_ID : TSK_HDB_HTYPE_SHA1_ID)) {
+                return -1;
+        }
+
+        if ((hdb_binsrch_info->bidx_map) && (hdb_binsrch_info->hash_len == 2 * len)) {
+            for (i = 0; i < len; i++) {
+                hashbuf[2 * i] = uc_hex[(hash[i] >> 4) & 0xf];
+                hashbuf[2 * i + 1] = uc_hex[hash[i] & 0xf];
+            }
+            hashbuf[2 * len] = '\0';
+            return hdb_binsrch_bin_idx_lookup(hdb_binsrch_info, hash, hashbuf,
+                flags, action, ptr);
+        }
+    }
+
     for (i = 0; i < len; i++) {
         hashbuf[2 * i] = hex[(hash[i] >> 4) & 0xf];
         hashbuf[2 * i + 1] = hex[hash[i] & 0xf];
@@ -1522,6 +2109,125 @@ int8_t
     return tsk_hdb_lookup_str(hdb_info, hashbuf, flags, action, ptr);
 }
 
+/** \internal
+* Compares two hash values of a batch lookup by their binary value.
+*/
+class BinsrchBatchLess {
+public:
+    BinsrchBatchLess(const uint8_t *a_hashes, size_t a_len)
+        : m_hashes(a_hashes), m_len(a_len) {}
+
+    bool operator()(size_t a, size_t b) const {
+        return memcmp(&m_hashes[a * m_len], &m_hashes[b * m_len], m_len) < 0;
+    }
+
+private:
+    const uint8_t *m_hashes;
+    size_t m_len;
+};
+
+/**
+* \ingroup hashdblib
+* Search the index for a set of binary hash values. If the memory mapped 
+* binary index is available, the hash values are sorted and the index is 
+* searched in a single pass, which starts each search where the previous
+* one ended. Otherwise, the values are looked up one at a time.
+*
+* @param hdb_info Open hash database (with index)
+* @param hashes Array with count binary hash values to search for
+* @param count Number of hash values in hashes
+* @param len Number of bytes in each binary hash value
+* @param flags Flags to use in lookup
+* @param hits Bitmap with a bit for each hash value that is set if it is 
+* found (or NULL)
+* @param action Callback function to call for each hash db entry 
+* (not called if QUICK flag is given)
+* @param ptr Pointer to data to pass to each callback
+*
+* @return -1 on error, 0 if no hash value was found, and 1 if at least one
+* value was found.
+*/
+int8_t
+    hdb_binsrch_lookup_batch(TSK_HDB_INFO * hdb_info, uint8_t * hashes, 
+    size_t count, uint8_t len, TSK_HDB_FLAG_ENUM flags, uint8_t * hits,
+    TSK_HDB_LOOKUP_FN action, void *ptr)
+{
+    TSK_HDB_BINSRCH_INFO *hdb_binsrch_info = (TSK_HDB_BINSRCH_INFO*)hdb_info; 
+    static const char uc_hex[] = "0123456789ABCDEF";
+
+    if ((2 * len != TSK_HDB_HTYPE_MD5_LEN) && (2 * len != TSK_HDB_HTYPE_SHA1_LEN)) {
+        return hdb_base_lookup_batch(hdb_info, hashes, count, len, flags,
+            hits, action, ptr);
+    }
+
+    if (hdb_binsrch_open_idx(hdb_info, (2 * len == TSK_HDB_HTYPE_MD5_LEN) ?
+        TSK_HDB_HTYPE_MD5_ID : TSK_HDB_HTYPE_SHA1_ID)) {
+            return -1;
+    }
+
+    if ((hdb_binsrch_info->bidx_map == NULL) || (hdb_binsrch_info->hash_len != 2 * len)) {
+        return hdb_base_lookup_batch(hdb_info, hashes, count, len, flags,
+            hits, action, ptr);
+    }
+
+    const uint8_t *map = hdb_binsrch_info->bidx_map;
+    const uint64_t *prefix_table = (const uint64_t *) (map + BIDX_TABLE_OFF);
+    const uint8_t *entries = map + BIDX_ENTRIES_OFF;
+    size_t ent_len = len + sizeof(uint64_t);
+    uint64_t pos = 0;
+    int8_t found = 0;
+
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), BinsrchBatchLess(hashes, len));
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *hash = &hashes[order[i] * len];
+        size_t prefix = (hash[0] << 8) | hash[1];
+        uint64_t low = prefix_table[prefix];
+        uint64_t up = prefix_table[prefix + 1];
+
+        // the values are sorted, so the entry is not before the last one
+        if (low < pos) {
+            low = pos;
+        }
+        while (low < up) {
+            uint64_t mid = low + (up - low) / 2;
+            if (memcmp(&entries[mid * ent_len], hash, len) < 0)
+                low = mid + 1;
+            else
+                up = mid;
+        }
+        pos = low;
+
+        if ((low == prefix_table[prefix + 1]) || (memcmp(&entries[low * ent_len], hash, len) != 0)) {
+            continue;
+        }
+
+        if (hits) {
+            hits[order[i] / 8] |= (1 << (order[i] % 8));
+        }
+        found = 1;
+
+        if ((flags & TSK_HDB_FLAG_QUICK) == 0) {
+            char hashbuf[TSK_HDB_HTYPE_SHA1_LEN + 1];
+            for (size_t j = 0; j < len; j++) {
+                hashbuf[2 * j] = uc_hex[(hash[j] >> 4) & 0xf];
+                hashbuf[2 * j + 1] = uc_hex[hash[j] & 0xf];
+            }
+            hashbuf[2 * len] = '\0';
+            if (hdb_binsrch_bin_idx_get_entries(hdb_binsrch_info, low, hash,
+                hashbuf, flags, action, ptr)) {
+                    return -1;
+            }
+        }
+    }
+
+    return found;
+}
+
 /**
 * \ingroup hashdblib
 * \internal 
@@ -1605,6 +2311,10 @@ void
     free(hdb_info->idx_offsets);
     hdb_info->idx_offsets = NULL;
 
+    hdb_binsrch_unmap_bin_idx(hdb_info);
+    free(hdb_info->bidx_fname);
+    hdb_info->bidx_fname = NULL;
+
     hdb_info_base_close(hdb_info_base);
 
     free(hdb_info);
@@ -106,6 +106,7 @@ uint8_t
     hdb_info->lookup_str = hdb_base_lookup_str;
     hdb_info->lookup_raw = hdb_base_lookup_bin;
     hdb_info->lookup_verbose_str = hdb_base_lookup_verbose_str;
+    hdb_info->lookup_batch = hdb_base_lookup_batch;
     hdb_info->accepts_updates = hdb_base_accepts_updates;
     hdb_info->add_entry = hdb_base_add_entry;
     hdb_info->begin_transaction = hdb_base_begin_transaction;
@@ -214,6 +215,28 @@ int8_t
     return -1;
 }
 
+int8_t
+    hdb_base_lookup_batch(TSK_HDB_INFO *hdb_info, uint8_t *hashes, size_t count, uint8_t hash_len, TSK_HDB_FLAG_ENUM flag, uint8_t *hits, TSK_HDB_LOOKUP_FN callback, void *data)
+{
+    // The "base class" implementation looks up the hashes one at a time,
+    // so that every database that supports binary lookups supports batches.
+    int8_t found = 0;
+    size_t i;
+    for (i = 0; i < count; i++) {
+        int8_t ret_val = hdb_info->lookup_raw(hdb_info, &hashes[i * hash_len], hash_len, flag, callback, data);
+        if (ret_val == -1) {
+            return -1;
+        }
+        else if (ret_val == 1) {
+            if (hits) {
+                hits[i / 8] |= (1 << (i % 8));
+            }
+            found = 1;
+        }
+    }
+    return found;
+}
+
 uint8_t
     hdb_base_accepts_updates()
 {
@@ -14,6 +14,8 @@
 
 #include "tsk/auto/sqlite3.h"
 
+#include <algorithm>
+
 /**
 * \file sqlite_hdb.cpp
 * Contains hash database functions for SQLite hash databases.
@@ -24,6 +26,7 @@ static const char *SCHEMA_VERSION_NO = "1";
 static const char *SQLITE_FILE_HEADER = "SQLite format 3";
 static const size_t MD5_BLOB_LEN = ((TSK_HDB_HTYPE_MD5_LEN) / 2);
 static const char hex_digits[] = "0123456789abcdef";
+static const int MD5_BATCH_SIZE = 256; ///< Number of hashes in each query of a batch lookup
 
 /**
  * Represents a TSK SQLite hash database (it doesn't need an external index).
@@ -38,6 +41,7 @@ typedef struct TSK_SQLITE_HDB_INFO {
     sqlite3_stmt *select_from_hashes_by_md5;
     sqlite3_stmt *select_from_file_names;
     sqlite3_stmt *select_from_comments;
+    sqlite3_stmt *select_from_hashes_by_md5_batch;
 } TSK_SQLITE_HDB_INFO;
 
 static uint8_t 
@@ -138,6 +142,15 @@ static uint8_t
         return 1;
     }
 
+    std::string batch_sql = "SELECT id, md5 from hashes where md5 in (?";
+    for (int i = 1; i < MD5_BATCH_SIZE; i++) {
+        batch_sql += ", ?";
+    }
+    batch_sql += ")";
+    if (sqlite_hdb_prepare_stmt(batch_sql.c_str(), &(hdb_info->select_from_hashes_by_md5_batch), hdb_info->db)) {
+        return 1;
+    }
+
     return 0;
 }
 
@@ -164,6 +177,7 @@ static void
     sqlite_hdb_finalize_stmt(&(hdb_info->select_from_hashes_by_md5), hdb_info->db);
     sqlite_hdb_finalize_stmt(&(hdb_info->select_from_file_names), hdb_info->db);
     sqlite_hdb_finalize_stmt(&(hdb_info->select_from_comments), hdb_info->db);
+    sqlite_hdb_finalize_stmt(&(hdb_info->select_from_hashes_by_md5_batch), hdb_info->db);
 }
 
 static sqlite3 *sqlite_hdb_open_db(TSK_TCHAR *db_file_path, bool create_tables)
@@ -297,6 +311,7 @@ TSK_HDB_INFO *sqlite_hdb_open(TSK_TCHAR *db_path)
     hdb_info->base.lookup_str = sqlite_hdb_lookup_str;
     hdb_info->base.lookup_raw = sqlite_hdb_lookup_bin;
     hdb_info->base.lookup_verbose_str = sqlite_hdb_lookup_verbose_str;
+    hdb_info->base.lookup_batch = sqlite_hdb_lookup_batch;
     hdb_info->base.add_entry = sqlite_hdb_add_entry;
     hdb_info->base.begin_transaction = sqlite_hdb_begin_transaction;
     hdb_info->base.commit_transaction = sqlite_hdb_commit_transaction;
@@ -595,6 +610,155 @@ static uint8_t
     return ret_val;
 }
 
+/** \internal
+* Compares two md5 hashes of a batch lookup by their binary value.
+*/
+class SqliteBatchLess {
+public:
+    SqliteBatchLess(const uint8_t *a_hashes) : m_hashes(a_hashes) {}
+
+    bool operator()(size_t a, size_t b) const {
+        return memcmp(&m_hashes[a * MD5_BLOB_LEN], &m_hashes[b * MD5_BLOB_LEN], MD5_BLOB_LEN) < 0;
+    }
+
+    bool operator()(size_t a, const uint8_t *b) const {
+        return memcmp(&m_hashes[a * MD5_BLOB_LEN], b, MD5_BLOB_LEN) < 0;
+    }
+
+    bool operator()(const uint8_t *a, size_t b) const {
+        return memcmp(a, &m_hashes[b * MD5_BLOB_LEN], MD5_BLOB_LEN) < 0;
+    }
+
+private:
+    const uint8_t *m_hashes;
+};
+
+/**
+* \ingroup hashdblib
+* \internal 
+* Looks up a set of hashes in a SQLite hash database.  The hashes are
+* looked up MD5_BATCH_SIZE at a time with an IN query.
+* @param hdb_info_base The struct that represents the database.
+* @param hashes Array with count hash values to search for (binary form).
+* @param count Number of hash values in hashes.
+* @param len Number of bytes in each binary hash value
+* @param flags Flags to use in lookup.
+* @param hits Bitmap with a bit for each hash value that is set if it is 
+* found (or NULL)
+* @param action Callback function (not called if QUICK flag is given)
+* @param ptr Pointer to data to pass to callback
+* @return -1 on error, 0 if no hash value was found, 1 if at least one hash 
+* value was found.
+*/
+int8_t
+    sqlite_hdb_lookup_batch(TSK_HDB_INFO *hdb_info_base, uint8_t *hashes, 
+    size_t count, uint8_t len, TSK_HDB_FLAG_ENUM flags, uint8_t *hits, 
+    TSK_HDB_LOOKUP_FN action, void *ptr)
+{
+    // Currently only supporting lookups of md5 hashes.
+    if (MD5_BLOB_LEN != len) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_HDB_ARG);
+        tsk_error_set_errstr("sqlite_hdb_lookup_batch: len=%" PRIu8", expected %" PRIuSIZE, len, MD5_BLOB_LEN);
+        return -1;
+    }
+
+    TSK_SQLITE_HDB_INFO *hdb_info = (TSK_SQLITE_HDB_INFO*)hdb_info_base;     
+    sqlite3_stmt *stmt = hdb_info->select_from_hashes_by_md5_batch;
+    int8_t found = 0;
+
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    SqliteBatchLess less(hashes);
+    std::sort(order.begin(), order.end(), less);
+
+    for (size_t start = 0; start < count; start += MD5_BATCH_SIZE) {
+        size_t end = std::min(count, start + MD5_BATCH_SIZE);
+        std::vector<std::pair<int64_t, std::string> > rows;
+        std::vector<std::vector<std::string> > fileNames;
+
+        tsk_take_lock(&hdb_info_base->lock);
+
+        // Fill the unused parameters of the last query with its last hash
+        for (int i = 0; i < MD5_BATCH_SIZE; i++) {
+            size_t q = order[std::min(start + i, end - 1)];
+            if (sqlite_hdb_attempt(sqlite3_bind_blob(stmt, i + 1, &hashes[q * MD5_BLOB_LEN], (int)MD5_BLOB_LEN, SQLITE_STATIC), SQLITE_OK, "sqlite_hdb_lookup_batch: error binding md5 hash blob: %s (result code %d)\n", hdb_info->db)) {
+                sqlite3_clear_bindings(stmt);
+                sqlite3_reset(stmt);
+                tsk_release_lock(&hdb_info_base->lock);
+                return -1;
+            }
+        }
+
+        while (1) {
+            int result_code = sqlite3_step(stmt);
+            if (SQLITE_ROW == result_code) {
+                if (sqlite3_column_bytes(stmt, 1) == (int)MD5_BLOB_LEN) {
+                    rows.push_back(std::make_pair(sqlite3_column_int64(stmt, 0), std::string((const char*)sqlite3_column_blob(stmt, 1), MD5_BLOB_LEN)));
+                }
+            }
+            else if (SQLITE_DONE == result_code) {
+                break;
+            }
+            else {
+                tsk_error_reset();
+                tsk_error_set_errno(TSK_ERR_AUTO_DB);
+                tsk_error_set_errstr("sqlite_hdb_lookup_batch: error executing SELECT: %s\n", sqlite3_errmsg(hdb_info->db));
+                sqlite3_clear_bindings(stmt);
+                sqlite3_reset(stmt);
+                tsk_release_lock(&hdb_info_base->lock);
+                return -1;
+            }
+        }
+        sqlite3_clear_bindings(stmt);
+        sqlite3_reset(stmt);
+
+        // Get any file names associated with the hashes for the callbacks
+        fileNames.resize(rows.size());
+        if (!(flags & TSK_HDB_FLAG_QUICK) && (NULL != action)) {
+            for (size_t r = 0; r < rows.size(); r++) {
+                if (sqlite_hdb_get_assoc_strings(hdb_info->db, hdb_info->select_from_file_names, rows[r].first, fileNames[r])) {
+                    tsk_release_lock(&hdb_info_base->lock);
+                    return -1;
+                }
+            }
+        }
+        tsk_release_lock(&hdb_info_base->lock);
+
+        for (size_t r = 0; r < rows.size(); r++) {
+            const uint8_t *md5 = (const uint8_t*)rows[r].second.data();
+            std::pair<std::vector<size_t>::iterator, std::vector<size_t>::iterator> range = 
+                std::equal_range(order.begin() + start, order.begin() + end, md5, less);
+            if (range.first == range.second) {
+                continue;
+            }
+            found = 1;
+
+            std::string hashMd5 = sqlite_hdb_blob_to_string(rows[r].second);
+            for (std::vector<size_t>::iterator it = range.first; it != range.second; ++it) {
+                if (hits) {
+                    hits[*it / 8] |= (1 << (*it % 8));
+                }
+                if ((flags & TSK_HDB_FLAG_QUICK) || (NULL == action)) {
+                    continue;
+                }
+                if (fileNames[r].size() > 0) {
+                    for (std::vector<std::string>::iterator name = fileNames[r].begin(); name != fileNames[r].end(); ++name) {
+                        action(hdb_info_base, hashMd5.c_str(), (*name).c_str(), ptr);
+                    }
+                }
+                else {
+                    action(hdb_info_base, hashMd5.c_str(), NULL, ptr);
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
 /**
 * \ingroup hashdblib
 * \internal 
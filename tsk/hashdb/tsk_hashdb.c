@@ -433,6 +433,60 @@ int8_t
     return hdb_info->lookup_raw(hdb_info, hash, len, flags, action, ptr);
 }
 
+/**
+* \ingroup hashdblib
+* Search the index for a set of hash values given (in binary form).  This 
+* is faster than looking up the values one at a time, because the backends
+* can sort the values and search the database in a single pass.  The 
+* callback is called for the found values in the order of the search, 
+* which is not the order of the array. 
+*
+* @param hdb_info Open hash database (with index)
+* @param hashes Array with count binary hash values to search for, one 
+* after the other
+* @param count Number of hash values in hashes
+* @param len Number of bytes in each binary hash value
+* @param flags Flags to use in lookup
+* @param hits Bitmap of (count + 7) / 8 bytes, or NULL.  Bit (i % 8) of
+* byte (i / 8) is set if the i-th hash value was found and cleared if not.
+* @param action Callback function to call for each hash db entry 
+* (not called if QUICK flag is given)
+* @param ptr Pointer to data to pass to each callback
+*
+* @return -1 on error, 0 if no hash value was found, and 1 if at least one
+* value was found.
+*/
+int8_t
+    tsk_hdb_lookup_batch(TSK_HDB_INFO * hdb_info, uint8_t * hashes,
+    size_t count, uint8_t len, TSK_HDB_FLAG_ENUM flags, uint8_t * hits,
+    TSK_HDB_LOOKUP_FN action, void *ptr)
+{
+    if (!hdb_info) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_HDB_ARG);
+        tsk_error_set_errstr("tsk_hdb_lookup_batch: NULL hdb_info");
+        return -1;
+    }
+
+    if ((!hashes) && (count > 0)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_HDB_ARG);
+        tsk_error_set_errstr("tsk_hdb_lookup_batch: NULL hashes");
+        return -1;
+    }
+
+    if (hits) {
+        memset(hits, 0, (count + 7) / 8);
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    return hdb_info->lookup_batch(hdb_info, hashes, count, len, flags, hits,
+        action, ptr);
+}
+
 int8_t
     tsk_hdb_lookup_verbose_str(TSK_HDB_INFO *hdb_info, const char *hash, void *result)
 {
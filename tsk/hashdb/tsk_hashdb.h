@@ -132,6 +132,7 @@ extern "C" {
         uint8_t(*commit_transaction)(TSK_HDB_INFO *);
         uint8_t(*rollback_transaction)(TSK_HDB_INFO *);
         void(*close_db)(TSK_HDB_INFO *);
+        int8_t(*lookup_batch)(TSK_HDB_INFO*, uint8_t *, size_t, uint8_t, TSK_HDB_FLAG_ENUM, uint8_t *, TSK_HDB_LOOKUP_FN, void*);
     };
 
     /** 
@@ -153,6 +154,10 @@ extern "C" {
         char *idx_lbuf;               ///< Buffer to hold a line from the index  (r/w shared - lock) 
         TSK_TCHAR *idx_idx_fname;     ///< Name of index of index file, may be NULL
         uint64_t *idx_offsets;        ///< Maps the first three bytes of a hash value to an offset in the index file
+        TSK_TCHAR *bidx_fname;        ///< Name of binary index file, may be NULL
+        uint8_t *bidx_map;            ///< Memory mapped binary index or NULL if there is none (read only, no lock needed)
+        size_t bidx_map_size;         ///< Size of bidx_map
+        void *bidx_map_handle;        ///< Windows file mapping handle of bidx_map
     } TSK_HDB_BINSRCH_INFO;    
 
     /**
@@ -180,6 +185,8 @@ extern "C" {
     extern int8_t tsk_hdb_lookup_raw(TSK_HDB_INFO *, uint8_t *, uint8_t, 
         TSK_HDB_FLAG_ENUM,  TSK_HDB_LOOKUP_FN, void *);
     extern int8_t tsk_hdb_lookup_verbose_str(TSK_HDB_INFO *, const char *, void *);
+    extern int8_t tsk_hdb_lookup_batch(TSK_HDB_INFO *, uint8_t *, size_t,
+        uint8_t, TSK_HDB_FLAG_ENUM, uint8_t *, TSK_HDB_LOOKUP_FN, void *);
     extern uint8_t tsk_hdb_accepts_updates(TSK_HDB_INFO *);
     extern uint8_t tsk_hdb_add_entry(TSK_HDB_INFO *, const char*, const char*, 
         const char*, const char*, const char*);
@@ -271,6 +278,32 @@ class TskHdbInfo{
                 return 0;
     };
 
+    /**
+    * Search the index for a set of hash values given (in binary form).
+    * See tsk_hdb_lookup_batch() for details.
+    * @param a_hashes Array with a_count binary hash values to search for
+    * @param a_count Number of hash values in a_hashes
+    * @param a_len Number of bytes in each binary hash value
+    * @param a_flags Flags to use in lookup
+    * @param a_hits Bitmap of (a_count + 7) / 8 bytes that is set to the 
+    * values that were found (or NULL)
+    * @param a_action Callback function to call for each hash db entry 
+    * (not called if QUICK flag is given)
+    * @param a_ptr Pointer to data to pass to each callback
+    *
+    * @return -1 on error, 0 if no hash value was found, and 1 if at least one 
+    * value was found.
+    */
+    int8_t lookupBatch(uint8_t * a_hashes, size_t a_count, uint8_t a_len,
+        TSK_HDB_FLAG_ENUM a_flags, uint8_t * a_hits, 
+        TSK_HDB_LOOKUP_FN a_action, void *a_ptr) {
+            if (m_hdbInfo != NULL)
+                return tsk_hdb_lookup_batch(m_hdbInfo, a_hashes, a_count,
+                a_len, a_flags, a_hits, a_action, a_ptr);
+            else
+                return 0;
+    };
+
     /**
     * Create an index for an open hash database.
     * See tsk_hdb_makeindex() for details.
@@ -32,6 +32,10 @@
 #ifdef TSK_WIN32
 #include <io.h>
 #include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 #ifdef __cplusplus
@@ -67,6 +71,7 @@ extern "C" {
     extern int8_t hdb_base_lookup_str(TSK_HDB_INFO *, const char *, TSK_HDB_FLAG_ENUM, TSK_HDB_LOOKUP_FN, void *);
     extern int8_t hdb_base_lookup_bin(TSK_HDB_INFO *, uint8_t *, uint8_t, TSK_HDB_FLAG_ENUM, TSK_HDB_LOOKUP_FN, void *);
     extern int8_t hdb_base_lookup_verbose_str(TSK_HDB_INFO *, const char *, void *);
+    extern int8_t hdb_base_lookup_batch(TSK_HDB_INFO *, uint8_t *, size_t, uint8_t, TSK_HDB_FLAG_ENUM, uint8_t *, TSK_HDB_LOOKUP_FN, void *);
     extern uint8_t hdb_base_accepts_updates();
     extern uint8_t hdb_base_add_entry(TSK_HDB_INFO *, const char *, const char *, const char *, const char *, const char *);
     extern uint8_t hdb_base_begin_transaction(TSK_HDB_INFO *);
@@ -93,6 +98,9 @@ extern "C" {
         uint8_t, TSK_HDB_FLAG_ENUM, 
         TSK_HDB_LOOKUP_FN, void *);
     extern int8_t hdb_binsrch_lookup_verbose_str(TSK_HDB_INFO *, const char *, void *);
+    extern int8_t hdb_binsrch_lookup_batch(TSK_HDB_INFO *, uint8_t *, 
+        size_t, uint8_t, TSK_HDB_FLAG_ENUM, uint8_t *,
+        TSK_HDB_LOOKUP_FN, void *);
     extern uint8_t hdb_binsrch_accepts_updates();
     extern void hdb_binsrch_close(TSK_HDB_INFO *) ;
 
@@ -145,6 +153,7 @@ extern "C" {
     extern int8_t sqlite_hdb_lookup_bin(TSK_HDB_INFO *, uint8_t *, uint8_t, TSK_HDB_FLAG_ENUM, TSK_HDB_LOOKUP_FN, void *);
     extern int8_t sqlite_hdb_lookup_verbose_str(TSK_HDB_INFO *, const char *, void *);
     extern int8_t sqlite_hdb_lookup_verbose_bin(TSK_HDB_INFO *, uint8_t *, uint8_t, void *);
+    extern int8_t sqlite_hdb_lookup_batch(TSK_HDB_INFO *, uint8_t *, size_t, uint8_t, TSK_HDB_FLAG_ENUM, uint8_t *, TSK_HDB_LOOKUP_FN, void *);
     extern uint8_t sqlite_hdb_add_entry(TSK_HDB_INFO *, const char *, 
         const char *, const char *, const char *, const char *);
     extern uint8_t sqlite_hdb_begin_transaction(TSK_HDB_INFO *);
@@ -0,0 +1,429 @@
+/*
+ * The Sleuth Kit
+ *
+ * Brian Carrier [carrier <at> sleuthkit [dot] org]
+ * Copyright (c) 2011 Brian Carrier.  All Rights reserved
+ *
+ * This software is distributed under the Common Public License 1.0
+ */
+
+/**
+ * \file img_cache.c
+ * Contains the sharded page cache that sits in front of the disk image
+ * read functions.  The pages are split into shards based on their offset
+ * and each shard has its own lock so that threads reading different parts
+ * of the image do not block each other.  The backend read happens outside
+ * of the shard lock (under cache_lock in TSK_IMG_INFO) so that cache hits
+ * are not blocked by a slow read for a different page.
+ */
+
+#include "tsk_img_i.h"
+
+/* Maximum number of shards.  The actual number is limited by the number
+ * of pages so that each shard has at least a couple of entries. */
+#define TSK_IMG_CACHE_SHARDS_MAX    16
+#define TSK_IMG_CACHE_MIN_PER_SHARD 2
+
+/* Flags for a cache page */
+#define TSK_IMG_CACHE_PAGE_VALID    0x01        ///< Page contains data for off
+#define TSK_IMG_CACHE_PAGE_LOADING  0x02        ///< Page is being filled by a reader (do not evict)
+#define TSK_IMG_CACHE_PAGE_REF      0x04        ///< CLOCK reference bit
+
+typedef struct {
+    TSK_OFF_T off;              ///< Page aligned byte offset of the data
+    size_t len;                 ///< Number of valid bytes in data
+    uint8_t flags;              ///< TSK_IMG_CACHE_PAGE_XXX values
+    int next;                   ///< Next page in the hash chain (or -1)
+    char *data;                 ///< Page data (page_len bytes)
+} TSK_IMG_CACHE_PAGE;
+
+typedef struct {
+    tsk_lock_t lock;            ///< Protects all of the values in the shard
+    TSK_IMG_CACHE_PAGE *pages;  ///< Pages in this shard
+    size_t num_pages;           ///< Number of entries in pages
+    int *buckets;               ///< Hash table of page indices (-1 if empty)
+    size_t num_buckets;         ///< Number of buckets (power of 2)
+    size_t hand;                ///< CLOCK hand for eviction
+} TSK_IMG_CACHE_SHARD;
+
+struct TSK_IMG_CACHE {
+    size_t page_len;            ///< Size of each page in bytes
+    size_t num_pages;           ///< Total number of pages in all shards
+    size_t num_shards;          ///< Number of entries in shards
+    TSK_IMG_CACHE_SHARD *shards;
+};
+
+
+/* Mix the page number so that sequential pages are spread
+ * over shards and buckets. */
+static uint64_t
+tsk_img_cache_hash(TSK_OFF_T a_page)
+{
+    uint64_t h = (uint64_t) a_page;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static TSK_IMG_CACHE_SHARD *
+tsk_img_cache_shard(TSK_IMG_CACHE * a_cache, TSK_OFF_T a_page_off)
+{
+    uint64_t h = tsk_img_cache_hash(a_page_off / a_cache->page_len);
+    return &a_cache->shards[h % a_cache->num_shards];
+}
+
+static size_t
+tsk_img_cache_bucket(TSK_IMG_CACHE * a_cache,
+    TSK_IMG_CACHE_SHARD * a_shard, TSK_OFF_T a_page_off)
+{
+    uint64_t h = tsk_img_cache_hash(a_page_off / a_cache->page_len);
+    return (size_t) ((h >> 32) & (a_shard->num_buckets - 1));
+}
+
+/* Unlink a page from its hash chain.
+ * Must be called while holding the shard lock. */
+static void
+tsk_img_cache_unlink(TSK_IMG_CACHE * a_cache,
+    TSK_IMG_CACHE_SHARD * a_shard, int a_idx)
+{
+    size_t b =
+        tsk_img_cache_bucket(a_cache, a_shard, a_shard->pages[a_idx].off);
+    int *prev = &a_shard->buckets[b];
+
+    while (*prev != -1) {
+        if (*prev == a_idx) {
+            *prev = a_shard->pages[a_idx].next;
+            break;
+        }
+        prev = &a_shard->pages[*prev].next;
+    }
+    a_shard->pages[a_idx].next = -1;
+}
+
+/* Find a valid page in the shard.
+ * Must be called while holding the shard lock.
+ * @returns index of page or -1 if not found */
+static int
+tsk_img_cache_find(TSK_IMG_CACHE * a_cache,
+    TSK_IMG_CACHE_SHARD * a_shard, TSK_OFF_T a_page_off)
+{
+    int idx =
+        a_shard->buckets[tsk_img_cache_bucket(a_cache, a_shard,
+            a_page_off)];
+
+    while (idx != -1) {
+        TSK_IMG_CACHE_PAGE *page = &a_shard->pages[idx];
+        if ((page->off == a_page_off)
+            && (page->flags & TSK_IMG_CACHE_PAGE_VALID))
+            return idx;
+        idx = page->next;
+    }
+    return -1;
+}
+
+/* Pick a page to replace using the CLOCK algorithm.  Pages that are
+ * being loaded by another thread are skipped.
+ * Must be called while holding the shard lock.
+ * @returns index of page or -1 if every page is busy */
+static int
+tsk_img_cache_evict(TSK_IMG_CACHE * a_cache,
+    TSK_IMG_CACHE_SHARD * a_shard)
+{
+    size_t i;
+
+    // two passes are enough to clear every reference bit
+    for (i = 0; i < 2 * a_shard->num_pages; i++) {
+        int idx = (int) a_shard->hand;
+        TSK_IMG_CACHE_PAGE *page = &a_shard->pages[idx];
+
+        a_shard->hand = (a_shard->hand + 1) % a_shard->num_pages;
+
+        if (page->flags & TSK_IMG_CACHE_PAGE_LOADING)
+            continue;
+
+        if (page->flags & TSK_IMG_CACHE_PAGE_REF) {
+            page->flags &= ~TSK_IMG_CACHE_PAGE_REF;
+            continue;
+        }
+
+        if (page->flags & TSK_IMG_CACHE_PAGE_VALID)
+            tsk_img_cache_unlink(a_cache, a_shard, idx);
+        page->flags = 0;
+        page->len = 0;
+        return idx;
+    }
+    return -1;
+}
+
+
+/**
+ * \internal
+ * Allocate a page cache.
+ * @param a_page_len Size of each page in bytes (multiple of 512)
+ * @param a_num_pages Total number of pages
+ * @returns NULL on error
+ */
+TSK_IMG_CACHE *
+tsk_img_cache_alloc(size_t a_page_len, size_t a_num_pages)
+{
+    TSK_IMG_CACHE *cache;
+    size_t i, s;
+
+    if ((a_page_len == 0) || (a_page_len % 512) || (a_num_pages == 0)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_IMG_ARG);
+        tsk_error_set_errstr("tsk_img_cache_alloc: invalid cache size (%"
+            PRIuSIZE " pages of %" PRIuSIZE " bytes)", a_num_pages,
+            a_page_len);
+        return NULL;
+    }
+
+    if ((cache =
+            (TSK_IMG_CACHE *) tsk_malloc(sizeof(TSK_IMG_CACHE))) == NULL)
+        return NULL;
+
+    cache->page_len = a_page_len;
+    cache->num_pages = a_num_pages;
+    cache->num_shards = a_num_pages / TSK_IMG_CACHE_MIN_PER_SHARD;
+    if (cache->num_shards > TSK_IMG_CACHE_SHARDS_MAX)
+        cache->num_shards = TSK_IMG_CACHE_SHARDS_MAX;
+    else if (cache->num_shards == 0)
+        cache->num_shards = 1;
+
+    if ((cache->shards =
+            (TSK_IMG_CACHE_SHARD *) tsk_malloc(cache->num_shards *
+                sizeof(TSK_IMG_CACHE_SHARD))) == NULL) {
+        free(cache);
+        return NULL;
+    }
+
+    for (s = 0; s < cache->num_shards; s++) {
+        TSK_IMG_CACHE_SHARD *shard = &cache->shards[s];
+
+        // spread the remainder over the first shards
+        shard->num_pages = a_num_pages / cache->num_shards;
+        if (s < a_num_pages % cache->num_shards)
+            shard->num_pages++;
+
+        shard->num_buckets = 1;
+        while (shard->num_buckets < 2 * shard->num_pages)
+            shard->num_buckets <<= 1;
+
+        tsk_init_lock(&shard->lock);
+
+        if (((shard->pages =
+                    (TSK_IMG_CACHE_PAGE *) tsk_malloc(shard->num_pages *
+                        sizeof(TSK_IMG_CACHE_PAGE))) == NULL)
+            || ((shard->buckets =
+                    (int *) tsk_malloc(shard->num_buckets *
+                        sizeof(int))) == NULL)) {
+            cache->num_shards = s + 1;
+            tsk_img_cache_free(cache);
+            return NULL;
+        }
+
+        for (i = 0; i < shard->num_buckets; i++)
+            shard->buckets[i] = -1;
+
+        for (i = 0; i < shard->num_pages; i++) {
+            shard->pages[i].next = -1;
+            if ((shard->pages[i].data =
+                    (char *) tsk_malloc(a_page_len)) == NULL) {
+                cache->num_shards = s + 1;
+                tsk_img_cache_free(cache);
+                return NULL;
+            }
+        }
+    }
+
+    return cache;
+}
+
+/**
+ * \internal
+ * Free a page cache and all of its pages.
+ * @param a_cache Cache to free (can be NULL)
+ */
+void
+tsk_img_cache_free(TSK_IMG_CACHE * a_cache)
+{
+    size_t s, i;
+
+    if (a_cache == NULL)
+        return;
+
+    if (a_cache->shards) {
+        for (s = 0; s < a_cache->num_shards; s++) {
+            TSK_IMG_CACHE_SHARD *shard = &a_cache->shards[s];
+            if (shard->pages) {
+                for (i = 0; i < shard->num_pages; i++)
+                    free(shard->pages[i].data);
+                free(shard->pages);
+            }
+            free(shard->buckets);
+            tsk_deinit_lock(&shard->lock);
+        }
+        free(a_cache->shards);
+    }
+    free(a_cache);
+}
+
+/**
+ * \internal
+ * Return the page size of the cache.
+ */
+size_t
+tsk_img_cache_page_len(TSK_IMG_CACHE * a_cache)
+{
+    return a_cache->page_len;
+}
+
+/**
+ * \internal
+ * Copy data from a single cache page into a buffer, loading the page
+ * from the image if it is not already in the cache.  The range must not
+ * cross a page boundary.
+ *
+ * @param a_img_info Image to read from
+ * @param a_off Byte offset to start reading from
+ * @param a_buf Buffer to copy data into
+ * @param a_len Number of bytes to copy
+ * @returns -1 on error or the number of bytes copied (which is smaller
+ * than a_len if the page is not full)
+ */
+ssize_t
+tsk_img_cache_read(TSK_IMG_INFO * a_img_info, TSK_OFF_T a_off,
+    char *a_buf, size_t a_len)
+{
+    TSK_IMG_CACHE *cache = a_img_info->cache;
+    TSK_OFF_T page_off = (a_off / cache->page_len) * cache->page_len;
+    size_t rel_off = (size_t) (a_off - page_off);
+    TSK_IMG_CACHE_SHARD *shard = tsk_img_cache_shard(cache, page_off);
+    TSK_IMG_CACHE_PAGE *page;
+    size_t read_size;
+    ssize_t cnt;
+    char *data;
+    int idx;
+
+    tsk_take_lock(&shard->lock);
+    idx = tsk_img_cache_find(cache, shard, page_off);
+    if (idx != -1) {
+        page = &shard->pages[idx];
+        page->flags |= TSK_IMG_CACHE_PAGE_REF;
+        if (rel_off >= page->len) {
+            cnt = 0;
+        }
+        else {
+            cnt = (ssize_t) ((rel_off + a_len > page->len) ?
+                page->len - rel_off : a_len);
+            memcpy(a_buf, &page->data[rel_off], cnt);
+        }
+        tsk_release_lock(&shard->lock);
+        return cnt;
+    }
+
+    /* Not in the cache.  Reserve a page so that nobody else evicts it
+     * while we fill it without holding the shard lock. */
+    idx = tsk_img_cache_evict(cache, shard);
+    if (idx != -1) {
+        shard->pages[idx].flags = TSK_IMG_CACHE_PAGE_LOADING;
+        data = shard->pages[idx].data;
+    }
+    tsk_release_lock(&shard->lock);
+
+    // every page in the shard is being loaded, so use a temp buffer
+    if (idx == -1) {
+        if ((data = (char *) tsk_malloc(cache->page_len)) == NULL)
+            return -1;
+    }
+
+    // Read a full cache page or the remaining data.
+    read_size = cache->page_len;
+    if (page_off + (TSK_OFF_T) read_size > a_img_info->size)
+        read_size = (size_t) (a_img_info->size - page_off);
+
+    /* cache_lock protects the shared variables in the img type
+     * specific INFO structs. */
+    tsk_take_lock(&(a_img_info->cache_lock));
+    cnt = a_img_info->read(a_img_info, page_off, data, read_size);
+    tsk_release_lock(&(a_img_info->cache_lock));
+
+    // Although a cnt of -1 indicates an error, it can not
+    // be used in the calculations below.
+    if (cnt > 0) {
+        if (rel_off >= (size_t) cnt) {
+            a_len = 0;
+        }
+        else if (rel_off + a_len > (size_t) cnt) {
+            a_len = (size_t) cnt - rel_off;
+        }
+        if (a_len > 0)
+            memcpy(a_buf, &data[rel_off], a_len);
+    }
+
+    if (idx == -1) {
+        free(data);
+    }
+    else {
+        tsk_take_lock(&shard->lock);
+        page = &shard->pages[idx];
+        /* Another thread may have loaded the same page while we were
+         * reading.  Keep only one copy in the hash table. */
+        if ((cnt > 0) && (tsk_img_cache_find(cache, shard, page_off) == -1)) {
+            size_t b = tsk_img_cache_bucket(cache, shard, page_off);
+            page->off = page_off;
+            page->len = (size_t) cnt;
+            page->flags =
+                TSK_IMG_CACHE_PAGE_VALID | TSK_IMG_CACHE_PAGE_REF;
+            page->next = shard->buckets[b];
+            shard->buckets[b] = idx;
+        }
+        else {
+            page->flags = 0;
+            page->len = 0;
+        }
+        tsk_release_lock(&shard->lock);
+    }
+
+    if (cnt <= 0)
+        return cnt;
+    return (ssize_t) a_len;
+}
+
+
+/**
+ * \ingroup imglib
+ * Changes the size of the read cache used by tsk_img_read().  This must be
+ * called before the image is shared between threads.  Any data that is
+ * currently cached is discarded.
+ *
+ * @param a_img_info Disk image to change
+ * @param a_page_len Size of each cache page in bytes (multiple of 512).
+ * Reads that are larger than this are not cached.
+ * @param a_num_pages Number of pages to keep in memory (0 to disable
+ * the cache)
+ * @returns 1 on error and 0 on success
+ */
+uint8_t
+tsk_img_set_cache_size(TSK_IMG_INFO * a_img_info, size_t a_page_len,
+    size_t a_num_pages)
+{
+    TSK_IMG_CACHE *cache = NULL;
+
+    if ((a_img_info == NULL) || (a_img_info->tag != TSK_IMG_INFO_TAG)) {
+        tsk_error_reset();
+        tsk_error_set_errno(TSK_ERR_IMG_ARG);
+        tsk_error_set_errstr("tsk_img_set_cache_size: invalid image");
+        return 1;
+    }
+
+    if (a_num_pages > 0) {
+        if ((cache = tsk_img_cache_alloc(a_page_len, a_num_pages)) == NULL)
+            return 1;
+    }
+
+    tsk_img_cache_free(a_img_info->cache);
+    a_img_info->cache = cache;
+    return 0;
+}
@@ -259,6 +259,13 @@ tsk_img_open(int num_img,
 
     /* we have a good img_info, set up the cache lock */
     tsk_init_lock(&(img_info->cache_lock));
+
+    if ((img_info->cache =
+            tsk_img_cache_alloc(TSK_IMG_INFO_CACHE_LEN,
+                TSK_IMG_INFO_CACHE_NUM)) == NULL) {
+        tsk_img_close(img_info);
+        return NULL;
+    }
     return img_info;
 }
 
@@ -454,6 +461,13 @@ tsk_img_open_external(
     img_info->imgstat = imgstat;
 
     tsk_init_lock(&(img_info->cache_lock));
+
+    if ((img_info->cache =
+            tsk_img_cache_alloc(TSK_IMG_INFO_CACHE_LEN,
+                TSK_IMG_INFO_CACHE_NUM)) == NULL) {
+        tsk_deinit_lock(&(img_info->cache_lock));
+        return NULL;
+    }
     return img_info;
 }
 
@@ -554,5 +568,7 @@ tsk_img_close(TSK_IMG_INFO * a_img_info)
         return;
     }
     tsk_deinit_lock(&(a_img_info->cache_lock));
+    tsk_img_cache_free(a_img_info->cache);
+    a_img_info->cache = NULL;
     a_img_info->close(a_img_info);
 }
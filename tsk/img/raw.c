@@ -780,5 +780,6 @@ tsk_img_free(void *a_ptr)
 {
     TSK_IMG_INFO *imgInfo = (TSK_IMG_INFO *) a_ptr;
     imgInfo->tag = 0;
+    tsk_img_cache_free(imgInfo->cache);
     free(imgInfo);
 }
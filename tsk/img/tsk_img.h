@@ -72,10 +72,11 @@ extern "C" {
         TSK_IMG_TYPE_UNSUPP = 0xffff   ///< Unsupported disk image type
     } TSK_IMG_TYPE_ENUM;
 
-#define TSK_IMG_INFO_CACHE_NUM  32
-#define TSK_IMG_INFO_CACHE_LEN  65536
+#define TSK_IMG_INFO_CACHE_NUM  32      ///< Default number of pages in the read cache (see tsk_img_set_cache_size())
+#define TSK_IMG_INFO_CACHE_LEN  65536   ///< Default size of a read cache page (see tsk_img_set_cache_size())
 
     typedef struct TSK_IMG_INFO TSK_IMG_INFO;
+    typedef struct TSK_IMG_CACHE TSK_IMG_CACHE;
 #define TSK_IMG_INFO_TAG 0x39204231
 
     /**
@@ -93,11 +94,8 @@ extern "C" {
         // the following are protected by cache_lock in IMG_INFO
         TSK_TCHAR **images;    ///< Image names
 
-        tsk_lock_t cache_lock;  ///< Lock for cache and associated values
-        char cache[TSK_IMG_INFO_CACHE_NUM][TSK_IMG_INFO_CACHE_LEN];     ///< read cache (r/w shared - lock) 
-        TSK_OFF_T cache_off[TSK_IMG_INFO_CACHE_NUM];    ///< starting byte offset of corresponding cache entry (r/w shared - lock) 
-        int cache_age[TSK_IMG_INFO_CACHE_NUM];  ///< "Age" of corresponding cache entry, higher means more recently used (r/w shared - lock) 
-        size_t cache_len[TSK_IMG_INFO_CACHE_NUM];       ///< Length of cache entry used (0 if never used) (r/w shared - lock) 
+        tsk_lock_t cache_lock;  ///< Lock for the read function and the img type specific values
+        TSK_IMG_CACHE *cache;   ///< \internal Sharded read cache (has its own locks, NULL if disabled)
 
         ssize_t(*read) (TSK_IMG_INFO * img, TSK_OFF_T off, char *buf, size_t len);     ///< \internal External progs should call tsk_img_read()
         void (*close) (TSK_IMG_INFO *); ///< \internal Progs should call tsk_img_close()
@@ -125,6 +123,8 @@ extern "C" {
     // read functions
     extern ssize_t tsk_img_read(TSK_IMG_INFO * img, TSK_OFF_T off,
         char *buf, size_t len);
+    extern uint8_t tsk_img_set_cache_size(TSK_IMG_INFO * img,
+        size_t page_len, size_t num_pages);
 
     // type conversion functions
     extern TSK_IMG_TYPE_ENUM tsk_img_type_toid_utf8(const char *);
@@ -37,6 +37,12 @@ extern "C" {
 #endif
 extern void *tsk_img_malloc(size_t);
 extern void tsk_img_free(void *);
+extern TSK_IMG_CACHE *tsk_img_cache_alloc(size_t a_page_len,
+    size_t a_num_pages);
+extern void tsk_img_cache_free(TSK_IMG_CACHE *);
+extern size_t tsk_img_cache_page_len(TSK_IMG_CACHE *);
+extern ssize_t tsk_img_cache_read(TSK_IMG_INFO * a_img_info,
+    TSK_OFF_T a_off, char *a_buf, size_t a_len);
 extern TSK_TCHAR **tsk_img_findFiles(const TSK_TCHAR * a_startingName,
     int *a_numFound);
 